@@ -243,6 +243,19 @@ UI_EXPORT void ui_pop_id(void);
 
 UI_EXPORT int ui_draw_circle(const char* id, float radius, int segments, int selected);
 
+/* Draw a grid of filled cells
+	colors: a color per cell, row major; 0xAABBGGRR
+	Returns: the index of the cell under the mouse. -1 if none */
+UI_EXPORT int ui_draw_cell_grid(const char* id, const uint32_t* colors, int columns, int rows, float cell_size);
+
+/* Virtualized list; only the rows in view are drawn. Not nested
+	row_count: the rows in the list */
+UI_EXPORT void ui_list_clipper_begin(int row_count);
+
+/* Get the next range of rows to draw; [start, end)
+	Returns: 1 if there are rows to draw. 0 when the list is done */
+UI_EXPORT int ui_list_clipper_step(int* start, int* end);
+
 UI_EXPORT void ui_set_tooltip(const char* fmt, ...);
 UI_EXPORT void ui_set_item_tooltip(const char* fmt, ...);
 
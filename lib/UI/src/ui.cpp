@@ -562,6 +562,47 @@ int ui_draw_circle(const char* id, float radius, int segments, int selected) {
 	return inside && IsMouseClicked(ImGuiMouseButton_Left);
 }
 
+int ui_draw_cell_grid(const char* id, const uint32_t* colors, int columns, int rows, float cell_size) {
+	ImVec2 pos = GetCursorScreenPos();
+	ImDrawList* dl = GetWindowDrawList();
+
+	InvisibleButton(id, { columns * cell_size, rows * cell_size });
+	int hovered = IsItemHovered();
+
+	for (int y = 0; y < rows; ++y) {
+		for (int x = 0; x < columns; ++x) {
+			ImVec2 min = { pos.x + x * cell_size, pos.y + y * cell_size };
+			ImVec2 max = { min.x + cell_size, min.y + cell_size };
+			dl->AddRectFilled(min, max, colors[y * columns + x]);
+		}
+	}
+
+	if (!hovered) {
+		return -1;
+	}
+	ImVec2 mouse = GetIO().MousePos;
+	int x = (int)((mouse.x - pos.x) / cell_size);
+	int y = (int)((mouse.y - pos.y) / cell_size);
+	if (x < 0 || x >= columns || y < 0 || y >= rows) {
+		return -1;
+	}
+	return y * columns + x;
+}
+
+static ImGuiListClipper clipper;
+
+void ui_list_clipper_begin(int row_count) {
+	clipper.Begin(row_count);
+}
+int ui_list_clipper_step(int* start, int* end) {
+	if (!clipper.Step()) {
+		return 0; /* Step() ends the clipper */
+	}
+	*start = clipper.DisplayStart;
+	*end = clipper.DisplayEnd;
+	return 1;
+}
+
 void ui_separator(void) {
 	Separator();
 }
@@ -0,0 +1,79 @@
+#!/bin/bash
+set -e
+
+# Run the benchmark suite; the results of each scenario are collected into one JSON array.
+# usage: scripts/bench.sh <ibm_pc> <out.json> [baseline.json] -- <args for every run; ROMs, -disk, -hdd ...>
+# The floppy and HDD scenarios are skipped if no -disk / -hdd is given.
+
+EXE="$1"
+OUT="$2"
+BASELINE="$3"
+shift 3 || true
+if [ "$1" == "--" ]; then
+	shift
+fi
+ARGS=("$@")
+
+if [ -z "$EXE" ] || [ -z "$OUT" ]; then
+	echo "usage: $0 <ibm_pc> <out.json> [baseline.json] -- <args>"
+	exit 1
+fi
+
+HAS_DISK=0
+HAS_HDD=0
+for ARG in "${ARGS[@]}"; do
+	case "$ARG" in
+		-disk|-d|[A-D]:*) HAS_DISK=1 ;;
+		-hdd) HAS_HDD=1 ;;
+	esac
+done
+
+RUNS=()
+for MODEL in 5150_16_64 5150_64_256 5160; do
+	RUNS+=("post -model $MODEL -video none")
+done
+RUNS+=("cpu_loop -video none")
+RUNS+=("render_cga_320")
+RUNS+=("render_cga_640")
+RUNS+=("render_mda")
+if [ $HAS_DISK == 1 ]; then
+	RUNS+=("boot_floppy -video none")
+	RUNS+=("floppy_read -video none")
+fi
+if [ $HAS_HDD == 1 ]; then
+	RUNS+=("boot_hdd -video none")
+fi
+
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+FAILED=0
+N=0
+for RUN in "${RUNS[@]}"; do
+	N=$((N + 1))
+	BENCH_ARGS=(-bench $RUN -bench-json "$TMP_DIR/$N.json")
+	if [ -n "$BASELINE" ]; then
+		BENCH_ARGS+=(-bench-baseline "$BASELINE")
+	fi
+	echo "== $RUN"
+	"$EXE" "${ARGS[@]}" "${BENCH_ARGS[@]}" || FAILED=1
+done
+
+# Collect the results
+{
+	echo "["
+	FIRST=1
+	for ((i = 1; i <= N; i++)); do
+		if [ -f "$TMP_DIR/$i.json" ]; then
+			if [ $FIRST == 0 ]; then
+				echo ","
+			fi
+			FIRST=0
+			cat "$TMP_DIR/$i.json"
+		fi
+	done
+	echo "]"
+} > "$OUT"
+
+echo "Wrote $OUT"
+exit $FAILED
@@ -15,6 +15,7 @@
 #include "frontend/sdl/sdl3_display.h"
 
 #include "backend/ibm_pc.h"
+#include "backend/utility/log.h"
 
 static const TOMI_ENUM model_def[] = {
 	{ "5150_16_64",  MODEL_5150_16_64 },
@@ -44,6 +45,32 @@ static const TOMI_ENUM display_view_def[] = {
 	{ "Full",    DISPLAY_SCALE_STRETCH },
 };
 
+static const TOMI_ENUM catch_up_def[] = {
+	{ "None",   TIMING_CATCH_UP_NONE   },
+	{ "Full",   TIMING_CATCH_UP_FULL   },
+	{ "Capped", TIMING_CATCH_UP_CAPPED },
+};
+
+static const TOMI_ENUM bench_scenario_def[] = {
+	{ "none",           BENCH_NONE           },
+	{ "post",           BENCH_POST           },
+	{ "boot_floppy",    BENCH_BOOT_FLOPPY    },
+	{ "boot_hdd",       BENCH_BOOT_HDD       },
+	{ "render_cga_320", BENCH_RENDER_CGA_320 },
+	{ "render_cga_640", BENCH_RENDER_CGA_640 },
+	{ "render_mda",     BENCH_RENDER_MDA     },
+	{ "cpu_loop",       BENCH_CPU_LOOP       },
+	{ "floppy_read",    BENCH_FLOPPY_READ    },
+};
+
+static const TOMI_ENUM log_level_def[] = {
+	{ "none",  LOG_LEVEL_NONE  },
+	{ "error", LOG_LEVEL_ERROR },
+	{ "warn",  LOG_LEVEL_WARN  },
+	{ "info",  LOG_LEVEL_INFO  },
+	{ "debug", LOG_LEVEL_DEBUG },
+};
+
 static const TOMI_FIELD rom_fields[] = {
 	TOMI_FIELD_STR("path", ROM, path),
 	TOMI_FIELD_U32("address", ROM, address)
@@ -55,6 +82,7 @@ static const TOMI_STRUCT rom_def = {
 
 static const TOMI_FIELD disk_fields[] = {
 	TOMI_FIELD_STR("path", DISK, path),
+	TOMI_FIELD_STR("overlay", DISK, overlay),
 	TOMI_FIELD_U8("drive", DISK, drive),
 	TOMI_FIELD_U8("write_protect", DISK, write_protect)
 };
@@ -83,6 +111,7 @@ static const TOMI_ENUM hdd_type_def[] = {
 
 static const TOMI_FIELD hdd_fields[] = {
 	TOMI_FIELD_STR("path", HDD, path),
+	TOMI_FIELD_STR("overlay", HDD, overlay),
 	TOMI_FIELD_U8("drive", HDD, drive),
 	TOMI_FIELD_STRUCT("geometry", HDD, geometry, &chs_def),
 	TOMI_FIELD_ENUM_U32("type", HDD, type, hdd_type_def),
@@ -94,6 +123,7 @@ static const TOMI_STRUCT hdd_def = {
 
 static const TOMI_SETTING setting_map[] = {
 	TOMI_SETTING_BOOL("dbg_ui"),
+	TOMI_SETTING_BOOL("audio"),
 
 	/* IBM PC */
 	TOMI_SETTING_ENUM_U8("model", model_def),
@@ -108,6 +138,36 @@ static const TOMI_SETTING setting_map[] = {
 	TOMI_SETTING_STRUCT_ARRAY("disk", IBM_PC_CONFIG, &disk_def, disks, disk_count),
 	TOMI_SETTING_STRUCT_ARRAY("rom", IBM_PC_CONFIG, &rom_def, roms, rom_count),
 	TOMI_SETTING_STRUCT_ARRAY("hdd", IBM_PC_CONFIG, &hdd_def, hdds, hdd_count),
+	TOMI_SETTING_BOOL("instant_disk"),
+	TOMI_SETTING_U32("int13_rom_address"),
+	TOMI_SETTING_STR("vblk", TOMI_FIELD_SIZE(IBM_PC_CONFIG, vblk_path)),
+	TOMI_SETTING_U32("vblk_rom_address"),
+	TOMI_SETTING_U32("time_slice_us"),
+	TOMI_SETTING_ENUM_U8("catch_up", catch_up_def),
+	TOMI_SETTING_STR("record", TOMI_FIELD_SIZE(IBM_PC_CONFIG, record_path)),
+	TOMI_SETTING_STR("replay", TOMI_FIELD_SIZE(IBM_PC_CONFIG, replay_path)),
+	TOMI_SETTING_U32("rewind_budget_kb"),
+	TOMI_SETTING_U32("rewind_interval_ms"),
+	TOMI_SETTING_STR("warm_boot", TOMI_FIELD_SIZE(IBM_PC_CONFIG, warm_boot_dir)),
+	TOMI_SETTING_U8("warm_boot_int"),
+	TOMI_SETTING_BOOL("perf"),
+	TOMI_SETTING_STR("perf_json", TOMI_FIELD_SIZE(IBM_PC_CONFIG, perf_path)),
+	TOMI_SETTING_STR("trace", TOMI_FIELD_SIZE(IBM_PC_CONFIG, trace_path)),
+	TOMI_SETTING_BOOL("trace_devices"),
+	TOMI_SETTING_STR("profile", TOMI_FIELD_SIZE(IBM_PC_CONFIG, profile_path)),
+	TOMI_SETTING_U32("profile_interval"),
+	TOMI_SETTING_STR("coverage", TOMI_FIELD_SIZE(IBM_PC_CONFIG, coverage_dir)),
+	TOMI_SETTING_BOOL("heatmap"),
+	TOMI_SETTING_STR("heatmap_csv", TOMI_FIELD_SIZE(IBM_PC_CONFIG, heatmap_path)),
+	TOMI_SETTING_ENUM_U8("bench", bench_scenario_def),
+	TOMI_SETTING_STR("bench_json", TOMI_FIELD_SIZE(IBM_PC_CONFIG, bench_path)),
+	TOMI_SETTING_STR("bench_baseline", TOMI_FIELD_SIZE(IBM_PC_CONFIG, bench_baseline)),
+	TOMI_SETTING_U32("bench_tolerance"),
+	TOMI_SETTING_STR("itrace", TOMI_FIELD_SIZE(IBM_PC_CONFIG, itrace_path)),
+	TOMI_SETTING_U32("itrace_kb"),
+	TOMI_SETTING_BOOL("itrace_stream"),
+	TOMI_SETTING_ENUM_U8("log_level", log_level_def),
+	TOMI_SETTING_STR("log", TOMI_FIELD_SIZE(IBM_PC_CONFIG, log_categories)),
 
 	/* DISPLAY */
 	TOMI_SETTING_ENUM_U8("texture_scale_mode", texture_scale_def),
@@ -162,7 +222,9 @@ static void str_to_num(const char* str, uint32_t* num) {
 
 void args_set_default(ARGS* args) {
 	args->dbg_ui = 0;
+	args->audio = 1;
 	args->config_filename = "ibm_pc.ini";
+	args->itrace_decode = NULL;
 
 	args->pc_config->video_adapter = VIDEO_ADAPTER_MDA_80X25;
 	args->pc_config->fdc_disks = 2;
@@ -179,6 +241,36 @@ void args_set_default(ARGS* args) {
 	args->pc_config->disk_count = 0;
 	args->pc_config->hdds = NULL;
 	args->pc_config->hdd_count = 0;
+	args->pc_config->instant_disk = 0;
+	args->pc_config->int13_rom_address = INT13_ROM_ADDRESS;
+	args->pc_config->vblk_path[0] = '\0';
+	args->pc_config->vblk_rom_address = VBLK_ROM_ADDRESS;
+	args->pc_config->time_slice_us = TIME_SLICE_US_DEFAULT;
+	args->pc_config->catch_up = TIMING_CATCH_UP_CAPPED;
+	args->pc_config->record_path[0] = '\0';
+	args->pc_config->replay_path[0] = '\0';
+	args->pc_config->rewind_budget_kb = REWIND_BUDGET_KB_DEFAULT;
+	args->pc_config->rewind_interval_ms = REWIND_INTERVAL_MS_DEFAULT;
+	args->pc_config->warm_boot_dir[0] = '\0';
+	args->pc_config->warm_boot_int = WARM_BOOT_INT_DEFAULT;
+	args->pc_config->perf = 0;
+	args->pc_config->perf_path[0] = '\0';
+	args->pc_config->trace_path[0] = '\0';
+	args->pc_config->trace_devices = 0;
+	args->pc_config->profile_path[0] = '\0';
+	args->pc_config->profile_interval = PROFILER_INTERVAL_DEFAULT;
+	args->pc_config->coverage_dir[0] = '\0';
+	args->pc_config->heatmap = 0;
+	args->pc_config->heatmap_path[0] = '\0';
+	args->pc_config->bench_scenario = BENCH_NONE;
+	args->pc_config->bench_path[0] = '\0';
+	args->pc_config->bench_baseline[0] = '\0';
+	args->pc_config->bench_tolerance = BENCH_TOLERANCE_DEFAULT;
+	args->pc_config->itrace_path[0] = '\0';
+	args->pc_config->itrace_kb = ITRACE_RING_KB_DEFAULT;
+	args->pc_config->itrace_stream = 0;
+	args->pc_config->log_level = LOG_LEVEL_DEFAULT;
+	args->pc_config->log_categories[0] = '\0';
 
 	args->display_config->correct_aspect_ratio = 1;
 	args->display_config->scanline_emu = 1;
@@ -205,6 +297,12 @@ int args_parse_cli(int argc, char** argv, ARGS* args) {
 			continue;
 		}
 
+		/* disable audio */
+		if (strncmp("-mute", arg, 6) == 0) {
+			args->audio = 0;
+			continue;
+		}
+
 		/* set config file */
 		if (strncmp("-c", arg, 3) == 0 || strncmp("-config", arg, 8) == 0) {
 
@@ -249,6 +347,7 @@ int args_parse_cli(int argc, char** argv, ARGS* args) {
 			strncpy_s(disk.path, sizeof(disk.path), arg, sizeof(disk.path) - 1);
 			ibm_pc_add_disk(&disk);
 			disk.write_protect = 0; /* reset write_protect flag */
+			disk.overlay[0] = '\0'; /* reset overlay */
 			continue;
 		}
 
@@ -264,6 +363,7 @@ int args_parse_cli(int argc, char** argv, ARGS* args) {
 			strncpy_s(disk.path, sizeof(disk.path), arg, sizeof(disk.path) - 1);
 			ibm_pc_add_disk(&disk);
 			disk.write_protect = 0; /* reset write_protect flag */
+			disk.overlay[0] = '\0'; /* reset overlay */
 			continue;
 		}
 
@@ -274,6 +374,304 @@ int args_parse_cli(int argc, char** argv, ARGS* args) {
 			continue;
 		}
 
+		/* Overlay the next loaded disk with a copy-on-write delta file */
+		if (strncmp("-dov", arg, 5) == 0 || strncmp("-disk-overlay", arg, 14) == 0) {
+			/* format: -disk-overlay <delta_path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(disk.overlay, sizeof(disk.overlay), arg, sizeof(disk.overlay) - 1);
+			continue;
+		}
+
+		/* Service INT 13h directly from the disk buffers */
+		if (strncmp("-id", arg, 4) == 0 || strncmp("-instant-disk", arg, 14) == 0) {
+			args->pc_config->instant_disk = 1;
+			continue;
+		}
+
+		/* Paravirtual block device image */
+		if (strncmp("-vblk", arg, 6) == 0) {
+			/* format: -vblk <image_path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->vblk_path, sizeof(args->pc_config->vblk_path), arg, sizeof(args->pc_config->vblk_path) - 1);
+			continue;
+		}
+
+		/* Emulation time slice */
+		if (strncmp("-slice", arg, 7) == 0) {
+			/* format: -slice <us> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			str_to_num(arg, &args->pc_config->time_slice_us);
+			continue;
+		}
+
+		/* Record the input journal */
+		if (strncmp("-record", arg, 8) == 0) {
+			/* format: -record <journal_path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->record_path, sizeof(args->pc_config->record_path), arg, sizeof(args->pc_config->record_path) - 1);
+			continue;
+		}
+
+		/* Replay the input journal */
+		if (strncmp("-replay", arg, 8) == 0) {
+			/* format: -replay <journal_path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->replay_path, sizeof(args->pc_config->replay_path), arg, sizeof(args->pc_config->replay_path) - 1);
+			continue;
+		}
+
+		/* Rewind memory budget */
+		if (strncmp("-rewind", arg, 8) == 0) {
+			/* format: -rewind <kb> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			str_to_num(arg, &args->pc_config->rewind_budget_kb);
+			continue;
+		}
+
+		/* Warm boot cache */
+		if (strncmp("-warm-boot", arg, 11) == 0) {
+			/* format: -warm-boot <cache_dir> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->warm_boot_dir, sizeof(args->pc_config->warm_boot_dir), arg, sizeof(args->pc_config->warm_boot_dir) - 1);
+			continue;
+		}
+
+		/* Performance counters */
+		if (strncmp("-perf", arg, 6) == 0) {
+			args->pc_config->perf = 1;
+			continue;
+		}
+
+		/* Performance counters; written as JSON at exit */
+		if (strncmp("-perf-json", arg, 11) == 0) {
+			/* format: -perf-json <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			args->pc_config->perf = 1;
+			strncpy_s(args->pc_config->perf_path, sizeof(args->pc_config->perf_path), arg, sizeof(args->pc_config->perf_path) - 1);
+			continue;
+		}
+
+		/* Trace; written as Chrome trace_event JSON at exit */
+		if (strncmp("-trace", arg, 7) == 0) {
+			/* format: -trace <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->trace_path, sizeof(args->pc_config->trace_path), arg, sizeof(args->pc_config->trace_path) - 1);
+			continue;
+		}
+
+		/* Guest profile; written as a text report and collapsed stacks at exit */
+		if (strncmp("-profile", arg, 9) == 0) {
+			/* format: -profile <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->profile_path, sizeof(args->pc_config->profile_path), arg, sizeof(args->pc_config->profile_path) - 1);
+			continue;
+		}
+
+		/* Guest profile sample interval */
+		if (strncmp("-profile-interval", arg, 18) == 0) {
+			/* format: -profile-interval <cycles> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			str_to_num(arg, &args->pc_config->profile_interval);
+			continue;
+		}
+
+		/* Code coverage; written per ROM at exit */
+		if (strncmp("-coverage", arg, 10) == 0) {
+			/* format: -coverage <dir> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->coverage_dir, sizeof(args->pc_config->coverage_dir), arg, sizeof(args->pc_config->coverage_dir) - 1);
+			continue;
+		}
+
+		/* Memory heatmap */
+		if (strncmp("-heatmap", arg, 9) == 0) {
+			args->pc_config->heatmap = 1;
+			continue;
+		}
+
+		/* Memory heatmap; written as CSV at exit */
+		if (strncmp("-heatmap-csv", arg, 13) == 0) {
+			/* format: -heatmap-csv <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			args->pc_config->heatmap = 1;
+			strncpy_s(args->pc_config->heatmap_path, sizeof(args->pc_config->heatmap_path), arg, sizeof(args->pc_config->heatmap_path) - 1);
+			continue;
+		}
+
+		/* Benchmark scenario */
+		if (strncmp("-bench", arg, 7) == 0) {
+			/* format: -bench <scenario> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			args->pc_config->bench_scenario = bench_find_scenario(arg);
+			if (args->pc_config->bench_scenario == BENCH_NONE) {
+				printf("Unknown benchmark '%s'. Expected post, boot_floppy, boot_hdd, render_cga_320, render_cga_640, render_mda, cpu_loop, floppy_read\n", arg);
+				return 1;
+			}
+			continue;
+		}
+
+		/* Benchmark results; written as JSON */
+		if (strncmp("-bench-json", arg, 12) == 0) {
+			/* format: -bench-json <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->bench_path, sizeof(args->pc_config->bench_path), arg, sizeof(args->pc_config->bench_path) - 1);
+			continue;
+		}
+
+		/* Benchmark baseline; the results are compared to it */
+		if (strncmp("-bench-baseline", arg, 16) == 0) {
+			/* format: -bench-baseline <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->bench_baseline, sizeof(args->pc_config->bench_baseline), arg, sizeof(args->pc_config->bench_baseline) - 1);
+			continue;
+		}
+
+		/* Benchmark regression tolerance */
+		if (strncmp("-bench-tolerance", arg, 17) == 0) {
+			/* format: -bench-tolerance <percent> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			str_to_num(arg, &args->pc_config->bench_tolerance);
+			continue;
+		}
+
+		/* Instruction trace; the ring is written at exit */
+		if (strncmp("-itrace", arg, 8) == 0) {
+			/* format: -itrace <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->itrace_path, sizeof(args->pc_config->itrace_path), arg, sizeof(args->pc_config->itrace_path) - 1);
+			continue;
+		}
+
+		/* Instruction trace ring size */
+		if (strncmp("-itrace-kb", arg, 11) == 0) {
+			/* format: -itrace-kb <kb> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			str_to_num(arg, &args->pc_config->itrace_kb);
+			continue;
+		}
+
+		/* Instruction trace; every block is streamed to the file */
+		if (strncmp("-itrace-stream", arg, 15) == 0) {
+			args->pc_config->itrace_stream = 1;
+			continue;
+		}
+
+		/* Print an instruction trace */
+		if (strncmp("-itrace-decode", arg, 15) == 0) {
+			/* format: -itrace-decode <path> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			args->itrace_decode = arg; /* command-line arguments (argv) are valid for the lifetime of the program. */
+			continue;
+		}
+
+		/* Log level of every category */
+		if (strncmp("-log-level", arg, 11) == 0) {
+			/* format: -log-level <level> */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			args->pc_config->log_level = log_find_level(arg);
+			if (args->pc_config->log_level == LOG_LEVEL_UNKNOWN) {
+				printf("Unknown log level '%s'. Expected none, error, warn, info, debug\n", arg);
+				return 1;
+			}
+			continue;
+		}
+
+		/* Log level per category */
+		if (strncmp("-log", arg, 5) == 0) {
+			/* format: -log <category>=<level>[,<category>=<level>...] */
+
+			if (!next_arg(argc, argv, &i, &arg)) {
+				break;
+			}
+
+			strncpy_s(args->pc_config->log_categories, sizeof(args->pc_config->log_categories), arg, sizeof(args->pc_config->log_categories) - 1);
+			continue;
+		}
+
 		/* set video adapter */
 		if (strncmp("-v", arg, 3) == 0 || strncmp("-video", arg, 7) == 0) {
 
@@ -416,6 +814,27 @@ int args_parse_cli(int argc, char** argv, ARGS* args) {
 			       "-disks <0-4>               - Amount of disk drives. 0-4.\n"
 			       "-disk [A-D:]<disk_path>    - Load disk into drive A,B,C,D.\n"
 			       "-disk-write-protect [A-D:] - Write protect the next loaded disk.\n"
+			       "-disk-overlay <delta_path> - Copy-on-write overlay for the next loaded disk.\n"
+			       "-instant-disk              - Service INT 13h directly from the disk buffers.\n"
+			       "-vblk <image_path>         - Attach a raw image to the paravirtual block device.\n"
+			       "-perf                      - Enable the performance counters.\n"
+			       "-perf-json <path>          - Enable the performance counters; write them as JSON at exit.\n"
+			       "-trace <path>              - Record a trace; write it as Chrome trace_event JSON at exit.\n"
+			       "-profile <path>            - Profile the guest CS:IP; write a report and <path>.folded at exit.\n"
+			       "-profile-interval <cycles> - Cycles between guest profile samples.\n"
+			       "-coverage <dir>            - Record code coverage; merge it into <dir> per ROM at exit.\n"
+			       "-heatmap                   - Enable the memory heatmap.\n"
+			       "-heatmap-csv <path>        - Enable the memory heatmap; write it as CSV at exit.\n"
+			       "-bench <scenario>          - Run a benchmark scenario on virtual time; write the results as JSON and exit.\n"
+			       "-bench-json <path>         - Write the benchmark results to a file instead of stdout.\n"
+			       "-bench-baseline <path>     - Compare the benchmark results to a baseline; exit code 1 if slower.\n"
+			       "-bench-tolerance <percent> - Percent slower than the baseline that is a regression.\n"
+			       "-itrace <path>             - Record an instruction trace; write the ring at exit.\n"
+			       "-itrace-kb <kb>            - Instruction trace ring size in KB.\n"
+			       "-itrace-stream             - Stream the whole instruction trace to the file as it is recorded.\n"
+			       "-itrace-decode <path>      - Print an instruction trace and exit.\n"
+			       "-log-level <level>         - Log level; 'none', 'error', 'warn', 'info', 'debug'.\n"
+			       "-log <category>=<level>,.. - Log level per category; main, mem, io, dma, pit, pic, kbd, fdc, hdc, disk, audio, tools, frontend.\n"
 			       "-video <video_adapter>     - The video adapter to use 'MDA', 'CGA', NONE.\n"
 			       "-ram <ram>                 - The amount of conventional ram. (16-64 in multiples of 16) or (64-768 in multiples of 32)\n"
 			       "-sw1 <sw1>                 - Override sw1 setting.\n"
@@ -467,6 +886,7 @@ int args_parse_ini(TOMI_VAR* var_map, ARGS* args) {
 	#define set_var(address) (var_map[i++].var = address)
 
 	set_var(&args->dbg_ui);
+	set_var(&args->audio);
 
 	set_var(&args->pc_config->model);
 	set_var(&args->pc_config->video_adapter);
@@ -480,6 +900,36 @@ int args_parse_ini(TOMI_VAR* var_map, ARGS* args) {
 	set_var(args->pc_config); /* disk struct array */
 	set_var(args->pc_config); /* rom struct array */
 	set_var(args->pc_config); /* hdd struct array */
+	set_var(&args->pc_config->instant_disk);
+	set_var(&args->pc_config->int13_rom_address);
+	set_var(&args->pc_config->vblk_path);
+	set_var(&args->pc_config->vblk_rom_address);
+	set_var(&args->pc_config->time_slice_us);
+	set_var(&args->pc_config->catch_up);
+	set_var(&args->pc_config->record_path);
+	set_var(&args->pc_config->replay_path);
+	set_var(&args->pc_config->rewind_budget_kb);
+	set_var(&args->pc_config->rewind_interval_ms);
+	set_var(&args->pc_config->warm_boot_dir);
+	set_var(&args->pc_config->warm_boot_int);
+	set_var(&args->pc_config->perf);
+	set_var(&args->pc_config->perf_path);
+	set_var(&args->pc_config->trace_path);
+	set_var(&args->pc_config->trace_devices);
+	set_var(&args->pc_config->profile_path);
+	set_var(&args->pc_config->profile_interval);
+	set_var(&args->pc_config->coverage_dir);
+	set_var(&args->pc_config->heatmap);
+	set_var(&args->pc_config->heatmap_path);
+	set_var(&args->pc_config->bench_scenario);
+	set_var(&args->pc_config->bench_path);
+	set_var(&args->pc_config->bench_baseline);
+	set_var(&args->pc_config->bench_tolerance);
+	set_var(&args->pc_config->itrace_path);
+	set_var(&args->pc_config->itrace_kb);
+	set_var(&args->pc_config->itrace_stream);
+	set_var(&args->pc_config->log_level);
+	set_var(&args->pc_config->log_categories);
 
 	set_var(&args->display_config->texture_scale_mode);
 	set_var(&args->display_config->display_scale_mode);
@@ -12,6 +12,8 @@ typedef struct TOMI_VAR TOMI_VAR;
 typedef struct ARGS {
 	const char* config_filename;
 	int dbg_ui;
+	int audio;
+	const char* itrace_decode; /* print this instruction trace and exit; NULL = run the emulator */
 	IBM_PC_CONFIG* pc_config;
 	DISPLAY_CONFIG* display_config;
 } ARGS;
@@ -0,0 +1,53 @@
+/* audio.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * audio
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio.h"
+
+static AUDIO_OUTPUT_CB output_cb = NULL;
+static AUDIO_GET_QUEUED_CB get_queued_cb = NULL;
+
+static double queued_avg_ms = AUDIO_TARGET_QUEUED_MS;
+
+void audio_set_cb_output(AUDIO_OUTPUT_CB cb) {
+	output_cb = cb;
+}
+
+void audio_set_cb_get_queued(AUDIO_GET_QUEUED_CB cb) {
+	get_queued_cb = cb;
+	queued_avg_ms = AUDIO_TARGET_QUEUED_MS;
+}
+
+int audio_is_enabled(void) {
+	return output_cb != NULL;
+}
+
+void audio_output(const int16_t* samples, uint32_t count) {
+	if (output_cb != NULL && count > 0) {
+		output_cb(samples, count);
+	}
+}
+
+double audio_get_rate(uint32_t sample_rate) {
+	/* The device plays at its own clock; the queue grows if the emulator runs fast and drains if it runs slow.
+	 * Steer the emulated rate by a fraction of a percent so the queue stays at the target; not heard as a pitch change */
+	if (output_cb == NULL || get_queued_cb == NULL || sample_rate == 0) {
+		return 1.0;
+	}
+
+	double queued_ms = get_queued_cb() * 1000.0 / sample_rate;
+	queued_avg_ms += (queued_ms - queued_avg_ms) * AUDIO_QUEUED_SMOOTHING;
+
+	double error = (AUDIO_TARGET_QUEUED_MS - queued_avg_ms) / AUDIO_TARGET_QUEUED_MS;
+	if (error > 1.0) {
+		error = 1.0;
+	}
+	else if (error < -1.0) {
+		error = -1.0;
+	}
+	return 1.0 + error * AUDIO_RATE_ADJUST_MAX;
+}
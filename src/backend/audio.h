@@ -0,0 +1,39 @@
+/* audio.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * audio
+ */
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdint.h>
+
+/* Pacing; the emulator is sped up or slowed down slightly to keep the device queue at the target */
+#define AUDIO_TARGET_QUEUED_MS 40.0
+#define AUDIO_RATE_ADJUST_MAX  0.005 /* +/- 0.5% */
+#define AUDIO_QUEUED_SMOOTHING 0.01  /* queue depth moving average weight */
+
+/* output samples callback; signed 16 bit mono */
+typedef void(*AUDIO_OUTPUT_CB)(const int16_t* samples, uint32_t count);
+
+/* get queued callback; samples waiting to be played */
+typedef uint32_t(*AUDIO_GET_QUEUED_CB)(void);
+
+/* Set audio_output() callback; NULL = audio disabled */
+void audio_set_cb_output(AUDIO_OUTPUT_CB output);
+
+/* Set the get queued callback */
+void audio_set_cb_get_queued(AUDIO_GET_QUEUED_CB get_queued);
+
+/* Is there an audio output */
+int audio_is_enabled(void);
+
+/* Output samples */
+void audio_output(const int16_t* samples, uint32_t count);
+
+/* Get the pacing rate from the device queue depth
+	sample_rate: the output sample rate
+	Returns: the host time scale; > 1 runs the emulator faster. 1.0 if there is no audio */
+double audio_get_rate(uint32_t sample_rate);
+
+#endif
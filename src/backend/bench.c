@@ -0,0 +1,434 @@
+/* bench.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Benchmark scenarios; run unpaced on virtual time and reported as JSON
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "ibm_pc.h"
+#include "timing.h"
+#include "keyboard.h"
+
+#include "frontend/utility/file.h"
+
+/* A scenario runs the machine one time slice at a time without pacing; the emulated time of a scenario is
+ * the same every run, only the host time it takes changes. Scenarios that run a guest program load it at the
+ * warm boot milestone (POST is done, the guest is about to execute INT 19h) in place of the boot.
+ *
+ * The boot scenarios read the text screen for the DOS prompt and answer the date and time prompts with enter. */
+
+#define LOG_CATEGORY LOG_CAT_MAIN
+#include "utility/log.h"
+
+#define SCREEN_SIZE 4000 /* 80x25 text */
+
+#define ANSWERED_DATE 0x01
+#define ANSWERED_TIME 0x02
+
+#define SCANCODE_ENTER 0x1C
+#define SCANCODE_RELEASE 0x80
+
+/* cld; mov ax,0004h; int 10h; mov ax,B800h; mov es,ax; xor bx,bx
+ * loop: xor di,di; mov cx,2000h; mov ax,bx; rep stosw; inc bx; jmp loop */
+static const uint8_t render_cga_320_program[] = {
+	0xFC, 0xB8, 0x04, 0x00, 0xCD, 0x10, 0xB8, 0x00, 0xB8, 0x8E, 0xC0, 0x31, 0xDB,
+	0x31, 0xFF, 0xB9, 0x00, 0x20, 0x89, 0xD8, 0xF3, 0xAB, 0x43, 0xEB, 0xF4
+};
+/* as above; mode 6 */
+static const uint8_t render_cga_640_program[] = {
+	0xFC, 0xB8, 0x06, 0x00, 0xCD, 0x10, 0xB8, 0x00, 0xB8, 0x8E, 0xC0, 0x31, 0xDB,
+	0x31, 0xFF, 0xB9, 0x00, 0x20, 0x89, 0xD8, 0xF3, 0xAB, 0x43, 0xEB, 0xF4
+};
+/* as above; mode 7, B000h, 80x25 words */
+static const uint8_t render_mda_program[] = {
+	0xFC, 0xB8, 0x07, 0x00, 0xCD, 0x10, 0xB8, 0x00, 0xB0, 0x8E, 0xC0, 0x31, 0xDB,
+	0x31, 0xFF, 0xB9, 0xD0, 0x07, 0x89, 0xD8, 0xF3, 0xAB, 0x43, 0xEB, 0xF4
+};
+/* xor ax,ax; xor bx,bx
+ * loop: inc ax; add bx,ax; mul bx; xor ax,bx; jmp loop */
+static const uint8_t cpu_loop_program[] = {
+	0x31, 0xC0, 0x31, 0xDB, 0x40, 0x01, 0xC3, 0xF7, 0xE3, 0x31, 0xD8, 0xEB, 0xF7
+};
+/* xor ax,ax; mov es,ax; mov ch,0
+ * track: mov dh,0
+ * head: mov ax,0208h; mov cl,1; mov dl,0; mov bx,1000h; int 13h; inc dh; cmp dh,2; jb head
+ * inc ch; cmp ch,40; jb track
+ * done: jmp done */
+static const uint8_t floppy_read_program[] = {
+	0x31, 0xC0, 0x8E, 0xC0, 0xB5, 0x00, 0xB6, 0x00, 0xB8, 0x08, 0x02, 0xB1, 0x01,
+	0xB2, 0x00, 0xBB, 0x00, 0x10, 0xCD, 0x13, 0xFE, 0xC6, 0x80, 0xFE, 0x02, 0x72,
+	0xED, 0xFE, 0xC5, 0x80, 0xFD, 0x28, 0x72, 0xE4, 0xEB, 0xFE
+};
+#define FLOPPY_READ_DONE (BENCH_PROGRAM_ADDRESS + sizeof(floppy_read_program) - 2)
+
+typedef struct {
+	const char* name;
+	uint32_t max_seconds;     /* emulated seconds before the scenario times out */
+	uint32_t run_seconds;     /* emulated seconds the program is measured for; 0 = the program runs to its end */
+	const uint8_t* program;   /* loaded at the warm boot milestone; NULL = none */
+	size_t program_size;
+} BENCH_SCENARIO;
+
+static const BENCH_SCENARIO scenarios[BENCH_SCENARIOS] = {
+	[BENCH_NONE]           = { "none",           0,   0, NULL, 0 },
+	[BENCH_POST]           = { "post",           60,  0, NULL, 0 },
+	[BENCH_BOOT_FLOPPY]    = { "boot_floppy",    180, 0, NULL, 0 },
+	[BENCH_BOOT_HDD]       = { "boot_hdd",       180, 0, NULL, 0 },
+	[BENCH_RENDER_CGA_320] = { "render_cga_320", 60,  5,  render_cga_320_program, sizeof(render_cga_320_program) },
+	[BENCH_RENDER_CGA_640] = { "render_cga_640", 60,  5,  render_cga_640_program, sizeof(render_cga_640_program) },
+	[BENCH_RENDER_MDA]     = { "render_mda",     60,  5,  render_mda_program, sizeof(render_mda_program) },
+	[BENCH_CPU_LOOP]       = { "cpu_loop",       60,  10, cpu_loop_program, sizeof(cpu_loop_program) },
+	[BENCH_FLOPPY_READ]    = { "floppy_read",    180, 0,  floppy_read_program, sizeof(floppy_read_program) },
+};
+
+static const char* model_name(uint8_t model) {
+	switch (model) {
+		case MODEL_5150_16_64:
+			return "5150_16_64";
+		case MODEL_5150_64_256:
+			return "5150_64_256";
+		case MODEL_5160:
+			return "5160";
+		default:
+			return "unknown";
+	}
+}
+
+uint8_t bench_find_scenario(const char* name) {
+	for (uint8_t i = BENCH_NONE + 1; i < BENCH_SCENARIOS; ++i) {
+		if (strcmp(scenarios[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return BENCH_NONE;
+}
+const char* bench_get_scenario_name(uint8_t scenario) {
+	if (scenario >= BENCH_SCENARIOS) {
+		return scenarios[BENCH_NONE].name;
+	}
+	return scenarios[scenario].name;
+}
+
+int bench_configure(void) {
+	IBM_PC_CONFIG* config = &ibm_pc->config;
+	switch (config->bench_scenario) {
+		case BENCH_BOOT_FLOPPY:
+		case BENCH_FLOPPY_READ:
+			if (config->disk_count == 0) {
+				log_error("[BENCH] %s needs a disk; use -disk A:<path>\n", bench_get_scenario_name(config->bench_scenario));
+				return 1;
+			}
+			break;
+		case BENCH_BOOT_HDD:
+			if (config->hdd_count == 0) {
+				log_error("[BENCH] %s needs a hard disk and the XEBEC ROM; use -hdd <path>\n", bench_get_scenario_name(config->bench_scenario));
+				return 1;
+			}
+			break;
+		case BENCH_RENDER_CGA_320:
+		case BENCH_RENDER_CGA_640:
+			config->video_adapter = VIDEO_ADAPTER_CGA_80X25;
+			break;
+		case BENCH_RENDER_MDA:
+			config->video_adapter = VIDEO_ADAPTER_MDA_80X25;
+			break;
+	}
+
+	/* the boot scenarios read the prompt off the screen */
+	if ((config->bench_scenario == BENCH_BOOT_FLOPPY || config->bench_scenario == BENCH_BOOT_HDD) && config->video_adapter == VIDEO_ADAPTER_NONE) {
+		config->video_adapter = VIDEO_ADAPTER_MDA_80X25;
+	}
+	return 0;
+}
+
+int bench_needs_window(void) {
+	switch (ibm_pc->config.bench_scenario) {
+		case BENCH_RENDER_CGA_320:
+		case BENCH_RENDER_CGA_640:
+		case BENCH_RENDER_MDA:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static void start_phase(BENCH* bench) {
+	bench->start_cycles = timing_virtual_get_cycles();
+	bench->host_ns = 0;
+	bench->render_ns = 0;
+	bench->render_frames = 0;
+}
+static void end_phase(BENCH* bench, uint8_t completed) {
+	bench->cycles = timing_virtual_get_cycles() - bench->start_cycles;
+	bench->completed = completed;
+	bench->enabled = 0; /* stop counting frames */
+}
+
+static void on_post_done(void) {
+	/* Emulation thread; the guest is about to execute INT 19h */
+	BENCH* bench = &ibm_pc->bench;
+	const BENCH_SCENARIO* scenario = &scenarios[bench->scenario];
+	bench->post_done = 1;
+
+	if (bench->scenario == BENCH_POST) {
+		end_phase(bench, 1);
+		return;
+	}
+
+	if (scenario->program == NULL) {
+		return; /* boot */
+	}
+
+	/* through the memory map; the pages are marked written for the snapshots and the views */
+	uint8_t* program = memory_map_get_range(&ibm_pc->mm, BENCH_PROGRAM_ADDRESS, (uint32_t)scenario->program_size, 1);
+	if (program == NULL) {
+		log_error("[BENCH] Failed to load the program at %05X\n", BENCH_PROGRAM_ADDRESS);
+		end_phase(bench, 0);
+		return;
+	}
+	memcpy(program, scenario->program, scenario->program_size);
+	ibm_pc->cpu.segments[SEG_CS] = 0;
+	ibm_pc->cpu.ip = BENCH_PROGRAM_ADDRESS;
+	if (bench->scenario == BENCH_FLOPPY_READ) {
+		ibm_pc->breakpoint = FLOPPY_READ_DONE;
+	}
+
+	/* measure the program only */
+	start_phase(bench);
+	if (scenario->run_seconds != 0) {
+		bench->max_cycles = bench->start_cycles + (uint64_t)(CPU_CLOCK * scenario->run_seconds);
+	}
+	else {
+		bench->max_cycles = bench->start_cycles + (uint64_t)(CPU_CLOCK * scenario->max_seconds);
+	}
+}
+
+void bench_start(void) {
+	BENCH* bench = &ibm_pc->bench;
+	memset(bench, 0, sizeof(BENCH));
+	bench->scenario = ibm_pc->config.bench_scenario;
+	bench->enabled = 1;
+
+	start_phase(bench);
+	bench->max_cycles = bench->start_cycles + (uint64_t)(CPU_CLOCK * scenarios[bench->scenario].max_seconds);
+	bench->next_check = bench->start_cycles;
+
+	ibm_pc_watch_post(on_post_done);
+	log_info("[BENCH] Running %s.%s\n", bench_get_scenario_name(bench->scenario), model_name(ibm_pc->config.model));
+}
+
+static int screen_find(const char* str) {
+	/* the characters of a text page; every other byte */
+	uint32_t address = (ibm_pc->config.video_adapter == VIDEO_ADAPTER_MDA_80X25) ? 0xB0000 : 0xB8000;
+	const uint8_t* screen = ibm_pc->mm.mem + address;
+	size_t len = strlen(str);
+	for (size_t i = 0; i + len * 2 <= SCREEN_SIZE; i += 2) {
+		size_t j = 0;
+		while (j < len && screen[i + j * 2] == (uint8_t)str[j]) {
+			j++;
+		}
+		if (j == len) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void press_enter(BENCH* bench, uint64_t cycles) {
+	kbd_deliver_key(&ibm_pc->kbd, SCANCODE_ENTER);
+	bench->key_release = SCANCODE_ENTER | SCANCODE_RELEASE;
+	bench->key_release_cycle = cycles + (uint64_t)(CPU_CLOCK / BENCH_KEY_HZ);
+}
+
+static int check_boot(BENCH* bench, uint64_t cycles) {
+	/* Returns: 1 at the DOS prompt */
+	if (screen_find((bench->scenario == BENCH_BOOT_HDD) ? "C>" : "A>")) {
+		return 1;
+	}
+	if (bench->key_release != 0) {
+		return 0;
+	}
+	if (!(bench->answered & ANSWERED_DATE) && screen_find("Enter new date")) {
+		bench->answered |= ANSWERED_DATE;
+		press_enter(bench, cycles);
+	}
+	else if (!(bench->answered & ANSWERED_TIME) && screen_find("Enter new time")) {
+		bench->answered |= ANSWERED_TIME;
+		press_enter(bench, cycles);
+	}
+	return 0;
+}
+
+int bench_update(void) {
+	BENCH* bench = &ibm_pc->bench;
+	if (!bench->enabled) {
+		return 1; /* ended in the post callback */
+	}
+
+	/* only the slice is timed; the slice a phase starts or ends in is counted whole */
+	uint64_t start = timing_get_ticks_ns();
+	ibm_pc_run_slice();
+	bench->host_ns += timing_get_ticks_ns() - start;
+	if (!bench->enabled) {
+		return 1;
+	}
+
+	uint64_t cycles = timing_virtual_get_cycles();
+	if (bench->key_release != 0 && cycles >= bench->key_release_cycle) {
+		kbd_deliver_key(&ibm_pc->kbd, bench->key_release);
+		bench->key_release = 0;
+	}
+
+	switch (bench->scenario) {
+		case BENCH_BOOT_FLOPPY:
+		case BENCH_BOOT_HDD:
+			if (cycles >= bench->next_check) {
+				bench->next_check = cycles + (uint64_t)(CPU_CLOCK / BENCH_CHECK_HZ);
+				if (check_boot(bench, cycles)) {
+					end_phase(bench, 1);
+					return 1;
+				}
+			}
+			break;
+		case BENCH_FLOPPY_READ:
+			if (bench->post_done && ibm_pc->step) {
+				end_phase(bench, 1);
+				return 1;
+			}
+			break;
+	}
+
+	if (cycles >= bench->max_cycles) {
+		/* the timed scenarios end here; the others time out */
+		end_phase(bench, bench->post_done && scenarios[bench->scenario].run_seconds != 0);
+		return 1;
+	}
+	return 0;
+}
+
+void bench_add_render_ns(BENCH* bench, uint64_t ns) {
+	if (bench->enabled) {
+		bench->render_ns += ns;
+		bench->render_frames++;
+	}
+}
+
+/* Find a number in the baseline; the first "key": after "name": "<name>"
+	Returns: 1 if found */
+static int baseline_get(const char* baseline, const char* name, const char* key, double* value) {
+	char pattern[128];
+	snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+	const char* entry = strstr(baseline, pattern);
+	if (entry == NULL) {
+		return 0;
+	}
+	const char* end = strchr(entry, '}');
+	snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+	const char* field = strstr(entry, pattern);
+	if (field == NULL || (end != NULL && field > end)) {
+		return 0;
+	}
+	*value = strtod(field + strlen(pattern), NULL);
+	return 1;
+}
+
+/* Compare the results to the baseline
+	Returns: 1 if slower than the baseline by more than the tolerance */
+static int compare_baseline(const char* name, double cycles_per_sec, double render_ms) {
+	size_t size = 0;
+	void* buffer = NULL;
+	if (file_read_alloc_buffer(ibm_pc->config.bench_baseline, &buffer, &size)) {
+		return 0; /* file_read_alloc_buffer() reports errors to console */
+	}
+
+	/* terminate the text */
+	char* baseline = malloc(size + 1);
+	if (baseline == NULL) {
+		free(buffer);
+		return 0;
+	}
+	memcpy(baseline, buffer, size);
+	baseline[size] = '\0';
+	free(buffer);
+
+	double tolerance = ibm_pc->config.bench_tolerance / 100.0;
+	int regression = 0;
+	double base = 0.0;
+	if (!baseline_get(baseline, name, "cycles_per_sec", &base)) {
+		log_warn("[BENCH] %s is not in the baseline %s\n", name, ibm_pc->config.bench_baseline);
+	}
+	else if (base > 0.0) {
+		double change = (cycles_per_sec - base) * 100.0 / base;
+		int slower = (cycles_per_sec < base * (1.0 - tolerance));
+		log_info("[BENCH] cycles/sec: %.0f; baseline %.0f (%+.1f%%)%s\n", cycles_per_sec, base, change, slower ? " REGRESSION" : "");
+		regression |= slower;
+	}
+
+	if (render_ms > 0.0 && baseline_get(baseline, name, "render_ms_per_frame", &base) && base > 0.0) {
+		double change = (render_ms - base) * 100.0 / base;
+		int slower = (render_ms > base * (1.0 + tolerance));
+		log_info("[BENCH] render ms/frame: %.3f; baseline %.3f (%+.1f%%)%s\n", render_ms, base, change, slower ? " REGRESSION" : "");
+		regression |= slower;
+	}
+
+	free(baseline);
+	return regression;
+}
+
+int bench_finish(void) {
+	BENCH* bench = &ibm_pc->bench;
+	if (bench->enabled) {
+		end_phase(bench, 0); /* quit before the end */
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "%s.%s", bench_get_scenario_name(bench->scenario), model_name(ibm_pc->config.model));
+
+	double seconds = bench->host_ns / 1000000000.0;
+	double cycles_per_sec = (seconds > 0.0) ? bench->cycles / seconds : 0.0;
+	double render_ms = (bench->render_frames != 0) ? bench->render_ns / 1000000.0 / bench->render_frames : 0.0;
+
+	FILE* file = stdout;
+	const char* path = ibm_pc->config.bench_path;
+	if (path[0] != '\0') {
+		file = fopen(path, "w");
+		if (file == NULL) {
+			log_error("[BENCH] Failed to open %s\n", path);
+			return 1;
+		}
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"name\": \"%s\",\n", name);
+	fprintf(file, "  \"scenario\": \"%s\",\n", bench_get_scenario_name(bench->scenario));
+	fprintf(file, "  \"model\": \"%s\",\n", model_name(ibm_pc->config.model));
+	fprintf(file, "  \"completed\": %s,\n", bench->completed ? "true" : "false");
+	fprintf(file, "  \"cycles\": %llu,\n", (unsigned long long)bench->cycles);
+	fprintf(file, "  \"emulated_ms\": %.3f,\n", bench->cycles * 1000.0 / CPU_CLOCK);
+	fprintf(file, "  \"host_ns\": %llu,\n", (unsigned long long)bench->host_ns);
+	fprintf(file, "  \"cycles_per_sec\": %.0f,\n", cycles_per_sec);
+	fprintf(file, "  \"realtime_ratio\": %.4f,\n", cycles_per_sec / CPU_CLOCK);
+	fprintf(file, "  \"frames_rendered\": %llu,\n", (unsigned long long)bench->render_frames);
+	fprintf(file, "  \"render_ms_per_frame\": %.4f\n", render_ms);
+	fprintf(file, "}\n");
+
+	if (file != stdout) {
+		fclose(file);
+		log_info("[BENCH] Wrote %s\n", path);
+	}
+
+	int error = 0;
+	if (!bench->completed) {
+		log_warn("[BENCH] %s did not complete\n", name);
+		error = 1;
+	}
+	if (ibm_pc->config.bench_baseline[0] != '\0' && compare_baseline(name, cycles_per_sec, render_ms)) {
+		error = 1;
+	}
+	return error;
+}
@@ -0,0 +1,79 @@
+/* bench.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Benchmark scenarios; run unpaced on virtual time and reported as JSON
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+/* Scenarios */
+#define BENCH_NONE           0 /* benchmark disabled */
+#define BENCH_POST           1 /* cold POST; reset to the warm boot milestone */
+#define BENCH_BOOT_FLOPPY    2 /* boot to the A> prompt */
+#define BENCH_BOOT_HDD       3 /* boot to the C> prompt from the XEBEC HDD */
+#define BENCH_RENDER_CGA_320 4 /* CGA 320x200 fill loop; rendered */
+#define BENCH_RENDER_CGA_640 5 /* CGA 640x200 fill loop; rendered */
+#define BENCH_RENDER_MDA     6 /* MDA text fill loop; rendered */
+#define BENCH_CPU_LOOP       7 /* synthetic ALU/MUL loop */
+#define BENCH_FLOPPY_READ    8 /* read every track of the disk in A: through INT 13h */
+#define BENCH_SCENARIOS      9
+
+#define BENCH_PROGRAM_ADDRESS   0x0600 /* guest programs run at 0000:0600; below the top of the smallest RAM config */
+#define BENCH_CHECK_HZ          20     /* screen checks per emulated second */
+#define BENCH_KEY_HZ            10     /* a key is held for 1/10 emulated second */
+#define BENCH_TOLERANCE_DEFAULT 10     /* % slower than the baseline that is a regression */
+
+typedef struct BENCH {
+	uint8_t enabled;
+	uint8_t scenario;          /* BENCH_XXX */
+	uint8_t post_done;         /* the warm boot milestone was reached */
+	uint8_t completed;         /* the scenario ran to its end; 0 if it timed out */
+	uint8_t answered;          /* date/time prompts answered; a bit each */
+	uint8_t key_release;       /* scancode to release at key_release_cycle; 0 = none */
+	uint64_t key_release_cycle;
+	uint64_t next_check;       /* virtual clock of the next screen check */
+	uint64_t max_cycles;       /* the scenario times out after */
+
+	uint64_t start_cycles;     /* virtual clock at the start of the measured phase */
+	uint64_t cycles;           /* cycles in the measured phase */
+	uint64_t host_ns;          /* host time running the slices of the measured phase; the frontend update between them is not counted */
+	uint64_t render_ns;        /* host time spent rendering frames */
+	uint64_t render_frames;    /* frames rendered */
+} BENCH;
+
+/* Get a scenario by name
+	name: the scenario name; 'post', 'boot_floppy', 'cpu_loop' ...
+	Returns: BENCH_XXX. BENCH_NONE if there is no such scenario */
+uint8_t bench_find_scenario(const char* name);
+
+/* Get the name of a scenario
+	Returns: the name */
+const char* bench_get_scenario_name(uint8_t scenario);
+
+/* Check the config can run the scenario and set the video adapter the scenario needs; after args are parsed
+	Returns: 0 if success. Otherwise 1 */
+int bench_configure(void);
+
+/* Check if the scenario renders; the other scenarios run headless
+	Returns: 1 if the scenario needs a window */
+int bench_needs_window(void);
+
+/* Start the scenario; after the hard reset */
+void bench_start(void);
+
+/* Run a time slice of the scenario; unpaced
+	Returns: 1 if the scenario is done. Otherwise 0 */
+int bench_update(void);
+
+/* Count a rendered frame; Render thread
+	bench: the bench instance
+	ns: the host time the frame took to render */
+void bench_add_render_ns(BENCH* bench, uint64_t ns);
+
+/* Write the results as JSON and compare them to the baseline
+	Returns: 0 if success. 1 if the scenario did not complete or is slower than the baseline */
+int bench_finish(void);
+
+#endif
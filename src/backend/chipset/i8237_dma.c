@@ -7,14 +7,10 @@
 
 #include "i8237_dma.h"
 #include "backend/utility/bit_utils.h"
+#include "backend/utility/trace.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_DMA
+#include "backend/utility/log.h"
 
 #define PORT_CHANNEL0_ADDRESS     0x00 /* RW */
 #define PORT_CHANNEL1_ADDRESS     0x02 /* RW */
@@ -144,12 +140,12 @@ static void page_write(I8237_DMA* dma, uint8_t channel, uint8_t value) {
 
 static void command_write(I8237_DMA* dma, uint8_t value) {
 
-#ifdef DBG_PRINT
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
 	if (IS_RISING_EDGE(COMMAND_DISABLE, dma->command, value)) {
-		dbg_print("[DMA] DMA Disabled\n");
+		log_debug("[DMA] DMA Disabled\n");
 	}
 	else if (IS_FALLING_EDGE(COMMAND_DISABLE, dma->command, value)) {
-		dbg_print("[DMA] DMA Enabled\n");
+		log_debug("[DMA] DMA Enabled\n");
 	}
 #endif
 
@@ -253,7 +249,7 @@ uint8_t i8237_dma_read_io_byte(I8237_DMA* dma, uint8_t io_address) {
 			return temp_read(dma);
 		
 		default:
-			dbg_print("[DMA] reading unimplemented IO\n");
+			log_warn("[DMA] reading unimplemented IO\n");
 			return 0;
 	}
 }
@@ -331,7 +327,7 @@ void i8237_dma_write_io_byte(I8237_DMA* dma, uint8_t io_address, uint8_t value)
 			break;
 
 		default:
-			dbg_print("[DMA] writing unimplemented IO\n");
+			log_warn("[DMA] writing unimplemented IO\n");
 			break;
 	}
 }
@@ -395,6 +391,7 @@ void i8237_dma_write_byte(I8237_DMA* dma, uint8_t channel, uint8_t value) {
 			dma->channels[channel].terminal_count = 1;
 		}
 		dma->status |= (1 << channel); /* Set TC bit in status register */
+		TRACE_INSTANT(TRACE_CAT_GUEST, "dma tc", "channel", channel);
 	}
 	else {
 		dma->channels[channel].current_word_count--;
@@ -428,6 +425,7 @@ uint8_t i8237_dma_read_byte(I8237_DMA* dma, uint8_t channel) {
 			dma->channels[channel].terminal_count = 1;
 		}
 		dma->status |= (1 << channel); /* Set TC bit in status register */
+		TRACE_INSTANT(TRACE_CAT_GUEST, "dma tc", "channel", channel);
 	}
 	else {
 		dma->channels[channel].current_word_count--;
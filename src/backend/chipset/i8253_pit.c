@@ -23,13 +23,8 @@
 #define LOAD_TYPE_INIT 0
 #define LOAD_TYPE_SEQU 1
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_PIT
+#include "backend/utility/log.h"
 
 static void i8253_timer_set_output(I8253_TIMER* timer, uint8_t out) {
 	if (timer->out != out) {
@@ -86,7 +81,7 @@ static void i8253_timer_update(I8253_TIMER* timer) {
 			break;
 
 		case I8253_PIT_MODE1: // programmable one-shot
-			dbg_print("[PIT] MODE1 not implemented\n");
+			log_warn("[PIT] MODE1 not implemented\n");
 			break;
 
 		case I8253_PIT_MODE2: // rate generator
@@ -110,15 +105,15 @@ static void i8253_timer_update(I8253_TIMER* timer) {
 			break;
 
 		case I8253_PIT_MODE4: // sw strobe
-			dbg_print("[PIT] MODE4 not implemented\n");
+			log_warn("[PIT] MODE4 not implemented\n");
 			break;
 
 		case I8253_PIT_MODE5: // hw strobe
-			dbg_print("[PIT] MODE5 not implemented\n");
+			log_warn("[PIT] MODE5 not implemented\n");
 			break;
 
 		default:
-			dbg_print("[PIT] unknown mode not implemented\n");
+			log_warn("[PIT] unknown mode not implemented\n");
 			break;
 	}
 }
@@ -9,6 +9,8 @@
 
 #include "i8086.h"
 
+#include "backend/utility/trace.h"
+
 #define ICW1_REQ_ICW4 0x01
 #define ICW1_SNGL     0x02
 #define ICW1_ADI      0x04
@@ -32,13 +34,9 @@
 #define OCW3_READ_IRR  0x02
 #define OCW3_READ_ISR  0x03
 
-//#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_PIC
+#define LOG_COMPILE_LEVEL LOG_LEVEL_WARN /* the INTR and EOI prints are per interrupt */
+#include "backend/utility/log.h"
 
 static uint8_t highest_priority_bit(uint8_t byte) {
 	for (uint8_t i = 0; i < 8; ++i) {
@@ -61,13 +59,13 @@ static void assert_intr(I8259_PIC* pic, uint8_t irq) {
 	uint8_t type = pic->icw[1] | irq;
 	pic->i8086->intr = 1;
 	pic->i8086->intr_type = type;
-	dbg_print("[PIC] Assert INTR (%d)\n", irq);
+	log_debug("[PIC] Assert INTR (%d)\n", irq);
 }
 
 static void deassert_intr(I8259_PIC* pic) {
 	pic->i8086->intr = 0;
 	pic->i8086->intr_type = 0;
-	dbg_print("[PIC] Deassert INTR (%d)\n", irq);
+	log_debug("[PIC] Deassert INTR\n");
 }
 
 static void icw1(I8259_PIC* pic, uint8_t value) {
@@ -75,12 +73,12 @@ static void icw1(I8259_PIC* pic, uint8_t value) {
 	deassert_intr(pic);
 	i8259_pic_reset(pic);
 	pic->icw[pic->icw_index++] = value;
-	dbg_print("[PIC] ICW1 = %02X\n", value);
+	log_debug("[PIC] ICW1 = %02X\n", value);
 }
 static void icwx(I8259_PIC* pic, uint8_t value) {
 	/* ICW[2/3/4] intitalization */
 
-	dbg_print("[PIC] ICW%d = %02X\n", pic->icw_index + 1, value);
+	log_debug("[PIC] ICW%d = %02X\n", pic->icw_index + 1, value);
 
 	switch (pic->icw_index) {
 
@@ -116,7 +114,7 @@ static void icwx(I8259_PIC* pic, uint8_t value) {
 	
 	if (pic->icw_index == I8259_PIC_ICW_COUNT) {
 		pic->initialized = 1;
-		dbg_print("[PIC] initialized\n");
+		log_debug("[PIC] initialized\n");
 	}	
 }
 
@@ -133,17 +131,17 @@ static void ocw2(I8259_PIC* pic, uint8_t value) {
 			if (ir != 0xFF) {
 				pic->isr &= ~(1 << ir);
 			}
-			dbg_print("[PIC] EOI %d\n", ir);
+			log_debug("[PIC] EOI %d\n", ir);
 		} break;
 
 		case OCW2_EOI_SPEC: {
 			/* Clear specific IR */
 			pic->isr &= ~(1 << (value & 0x07));
-			dbg_print("[PIC] EOI_SPEC %d\n", (value & 0x7));
+			log_debug("[PIC] EOI_SPEC %d\n", (value & 0x7));
 		} break;
 
 		default:
-			dbg_print("[PIC] cmd not implemented: OCW2 = %02X", value);
+			log_warn("[PIC] cmd not implemented: OCW2 = %02X\n", value);
 			break;
 	}
 }
@@ -229,6 +227,7 @@ void i8259_pic_request_interrupt(I8259_PIC* pic, uint8_t irq) {
 		uint8_t mask = 1 << (irq & 0x07);
 		if (!(pic->isr & mask) && !(pic->irr & mask) && !(pic->imr & mask)) {
 			pic->irr |= mask;
+			TRACE_INSTANT(TRACE_CAT_GUEST, "irq raise", "irq", irq);
 		}
 	}
 }
@@ -258,6 +257,7 @@ int i8259_pic_get_interrupt(I8259_PIC* pic) {
 
 	/* Assert INTR */
 	assert_intr(pic, irq);
+	TRACE_INSTANT(TRACE_CAT_GUEST, "irq ack", "irq", irq);
 	return 1;
 }
 
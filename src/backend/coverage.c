@@ -0,0 +1,307 @@
+/* coverage.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Guest code coverage; a bitmap of the executed instructions over the 1MB address space, exported per ROM
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "coverage.h"
+#include "i8086_mnem.h"
+#include "timing.h"
+#include "warm_boot.h"
+
+#include "frontend/utility/file.h"
+
+/* There is no block cache; an instruction is marked as it is executed. The bytes an instruction covers are
+ * found when the coverage is written, by disassembling the instructions marked.
+ *
+ * File format:
+ * "PCC1", address (u32), size (u32), rom hash (u64), instruction bitmap, byte bitmap. 1 bit per ROM byte; (size + 7) / 8 bytes each.
+ * Coverage of a ROM with another hash (another build) is not merged; it is replaced.
+ * Runs merge under <file>.lock; many headless runs may write to the same directory. */
+
+#define COVERAGE_MAGIC       "PCC1"
+#define COVERAGE_MAGIC_SIZE  4
+#define COVERAGE_HEADER_SIZE (COVERAGE_MAGIC_SIZE + 4 + 4 + 8)
+
+#define BITMAP_SIZE(x) (((x) + 7) / 8)
+#define BIT_SET(bitmap, i) ((bitmap)[(i) >> 3] & (1 << ((i) & 7)))
+#define SET_BIT(bitmap, i) ((bitmap)[(i) >> 3] |= (1 << ((i) & 7)))
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "utility/log.h"
+
+static void put_u32(uint8_t* buffer, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static void put_u64(uint8_t* buffer, uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static uint32_t get_u32(const uint8_t* buffer) {
+	uint32_t value = 0;
+	for (int i = 0; i < 4; ++i) {
+		value |= (uint32_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+static uint64_t get_u64(const uint8_t* buffer) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value |= (uint64_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+
+int coverage_create(COVERAGE* coverage) {
+	memset(coverage, 0, sizeof(COVERAGE));
+	coverage->starts = calloc(BITMAP_SIZE(COVERAGE_ADDRESS_SPACE), 1);
+	if (coverage->starts == NULL) {
+		log_error("[COVERAGE] Failed to allocate the bitmap\n");
+		return 1;
+	}
+	coverage->enabled = 1;
+	return 0;
+}
+void coverage_destroy(COVERAGE* coverage) {
+	coverage->enabled = 0;
+	if (coverage->starts != NULL) {
+		free(coverage->starts);
+		coverage->starts = NULL;
+	}
+}
+
+void coverage_mark(COVERAGE* coverage, uint32_t address) {
+	address &= (COVERAGE_ADDRESS_SPACE - 1);
+	SET_BIT(coverage->starts, address);
+}
+
+static uint16_t rom_segment(uint32_t address) {
+	/* the 64K segment the ROM is in; F000 for the BIOS */
+	return (uint16_t)((address & 0xF0000) >> 4);
+}
+
+/* Build the instruction and byte bitmaps of the ROM from this run */
+static void get_rom_bitmaps(COVERAGE* coverage, I8086_MNEM* mnem, uint32_t address, uint32_t size, uint8_t* starts, uint8_t* bytes) {
+	uint16_t segment = rom_segment(address);
+	for (uint32_t i = 0; i < size; ++i) {
+		uint32_t a = address + i;
+		if (!BIT_SET(coverage->starts, a)) {
+			continue;
+		}
+		SET_BIT(starts, i);
+		i8086_mnem_at(mnem, segment, (uint16_t)(a - ((uint32_t)segment << 4)));
+		for (uint32_t j = 0; j < mnem->counter && i + j < size; ++j) {
+			SET_BIT(bytes, i + j);
+		}
+	}
+}
+
+static int lock_file(const char* lock_path) {
+	uint64_t start = timing_get_ticks_ms();
+	for (;;) {
+		FILE* file = fopen(lock_path, "wx");
+		if (file != NULL) {
+			fclose(file);
+			return 0;
+		}
+
+		/* A stale lock is renamed to a name only this waiter uses, then removed. The rename is atomic, so of two
+		 * waiters that find it stale only one moves it; a lock taken since is checked again and put back */
+		time_t modified = 0;
+		if (file_get_modified_time(lock_path, &modified) && time(NULL) - modified >= COVERAGE_LOCK_STALE_S) {
+			char stale_path[560] = { 0 };
+			snprintf(stale_path, sizeof(stale_path), "%s.%llx.stale", lock_path, (unsigned long long)timing_get_ticks_ns());
+			if (rename(lock_path, stale_path) == 0) {
+				if (file_get_modified_time(stale_path, &modified) && time(NULL) - modified < COVERAGE_LOCK_STALE_S) {
+					rename(stale_path, lock_path);
+				}
+				else {
+					log_warn("[COVERAGE] %s is stale; removing it\n", lock_path);
+					remove(stale_path);
+				}
+			}
+			continue;
+		}
+
+		if (timing_get_ticks_ms() - start >= COVERAGE_LOCK_MS) {
+			log_error("[COVERAGE] %s is held; coverage not written\n", lock_path);
+			return 1;
+		}
+		timing_sleep_ns(COVERAGE_LOCK_POLL_MS * 1000000ull);
+	}
+}
+
+/* Merge the coverage already in the file, if it is of the same ROM */
+static void merge_file(const char* path, uint32_t address, uint32_t size, uint64_t hash, uint8_t* starts, uint8_t* bytes) {
+	size_t file_size = 0;
+	if (!file_get_file_size(path, &file_size)) {
+		return; /* first run */
+	}
+
+	void* buffer = NULL;
+	if (file_read_alloc_buffer(path, &buffer, &file_size)) {
+		return; /* file_read_alloc_buffer() reports errors to console */
+	}
+
+	const uint8_t* data = buffer;
+	uint32_t bitmap_size = BITMAP_SIZE(size);
+	if (file_size != COVERAGE_HEADER_SIZE + bitmap_size * 2 ||
+		memcmp(data, COVERAGE_MAGIC, COVERAGE_MAGIC_SIZE) != 0 ||
+		get_u32(data + COVERAGE_MAGIC_SIZE) != address ||
+		get_u32(data + COVERAGE_MAGIC_SIZE + 4) != size ||
+		get_u64(data + COVERAGE_MAGIC_SIZE + 8) != hash) {
+		log_warn("[COVERAGE] %s is of another ROM; replacing it\n", path);
+		free(buffer);
+		return;
+	}
+
+	const uint8_t* file_starts = data + COVERAGE_HEADER_SIZE;
+	const uint8_t* file_bytes = file_starts + bitmap_size;
+	for (uint32_t i = 0; i < bitmap_size; ++i) {
+		starts[i] |= file_starts[i];
+		bytes[i] |= file_bytes[i];
+	}
+	free(buffer);
+}
+
+static int write_bitmap(const char* path, uint32_t address, uint32_t size, uint64_t hash, const uint8_t* starts, const uint8_t* bytes) {
+	uint32_t bitmap_size = BITMAP_SIZE(size);
+	size_t file_size = COVERAGE_HEADER_SIZE + (size_t)bitmap_size * 2;
+	uint8_t* buffer = malloc(file_size);
+	if (buffer == NULL) {
+		log_error("[COVERAGE] Failed to allocate %zu bytes\n", file_size);
+		return 1;
+	}
+	memcpy(buffer, COVERAGE_MAGIC, COVERAGE_MAGIC_SIZE);
+	put_u32(buffer + COVERAGE_MAGIC_SIZE, address);
+	put_u32(buffer + COVERAGE_MAGIC_SIZE + 4, size);
+	put_u64(buffer + COVERAGE_MAGIC_SIZE + 8, hash);
+	memcpy(buffer + COVERAGE_HEADER_SIZE, starts, bitmap_size);
+	memcpy(buffer + COVERAGE_HEADER_SIZE + bitmap_size, bytes, bitmap_size);
+
+	int error = file_write_from_buffer(path, buffer, file_size);
+	free(buffer);
+	return error;
+}
+
+static int write_listing(const char* path, I8086_MNEM* mnem, const uint8_t* mem, const char* rom_path, uint32_t address, uint32_t size, const uint8_t* starts, const uint8_t* bytes) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		log_error("[COVERAGE] Failed to open %s\n", path);
+		return 1;
+	}
+
+	uint32_t executed = 0;
+	for (uint32_t i = 0; i < size; ++i) {
+		if (BIT_SET(bytes, i)) {
+			executed++;
+		}
+	}
+	fprintf(file, "; %s at %05X; %u bytes\n", rom_path, address, size);
+	fprintf(file, "; executed %u bytes (%.2f%%). '>' = executed\n\n", executed, (size != 0) ? executed * 100.0 / size : 0.0);
+
+	/* linear sweep; resynced at each executed instruction. Bytes that are not code are listed as db */
+	uint16_t segment = rom_segment(address);
+	uint32_t i = 0;
+	while (i < size) {
+		uint32_t a = address + i;
+		uint16_t offset = (uint16_t)(a - ((uint32_t)segment << 4));
+		i8086_mnem_at(mnem, segment, offset);
+		uint32_t len = mnem->counter;
+		if (len == 0) {
+			len = 1;
+		}
+
+		int overlaps = (i + len > size);
+		for (uint32_t j = 1; j < len && !overlaps; ++j) {
+			if (BIT_SET(starts, i + j)) {
+				overlaps = 1;
+			}
+		}
+		if (!BIT_SET(starts, i) && overlaps) {
+			fprintf(file, "  %04X:%04X  %02X            db %02Xh\n", segment, offset, mem[a], mem[a]);
+			i++;
+			continue;
+		}
+
+		fprintf(file, "%c %04X:%04X  ", BIT_SET(starts, i) ? '>' : ' ', segment, offset);
+		for (uint32_t j = 0; j < 6; ++j) {
+			if (j < len && i + j < size) {
+				fprintf(file, "%02X", mem[a + j]);
+			}
+			else {
+				fprintf(file, "  ");
+			}
+		}
+		fprintf(file, "  %s\n", mnem->str);
+		i += len;
+	}
+	fclose(file);
+	return 0;
+}
+
+int coverage_write_rom(COVERAGE* coverage, I8086_MNEM* mnem, const uint8_t* mem, const char* rom_path, uint32_t address, uint32_t size, const char* dir) {
+	if (address >= COVERAGE_ADDRESS_SPACE || size == 0) {
+		return 1;
+	}
+	if (size > COVERAGE_ADDRESS_SPACE - address) {
+		size = COVERAGE_ADDRESS_SPACE - address;
+	}
+
+	/* <dir>/<rom name>_<address> */
+	char name[256] = { 0 };
+	const char* filename = file_get_filename(rom_path);
+	size_t len = 0;
+	while (filename[len] != '\0' && filename[len] != '.' && len < 200) {
+		len++;
+	}
+	snprintf(name, sizeof(name), "%.*s_%05X", (int)len, filename, address);
+
+	char path[512] = { 0 };
+	char lock_path[512] = { 0 };
+	char listing_path[512] = { 0 };
+	snprintf(path, sizeof(path), "%s/%s.cov", dir, name);
+	snprintf(lock_path, sizeof(lock_path), "%s/%s.cov.lock", dir, name);
+	snprintf(listing_path, sizeof(listing_path), "%s/%s.lst", dir, name);
+
+	uint32_t bitmap_size = BITMAP_SIZE(size);
+	uint8_t* starts = calloc(bitmap_size, 1);
+	uint8_t* bytes = calloc(bitmap_size, 1);
+	if (starts == NULL || bytes == NULL) {
+		log_error("[COVERAGE] Failed to allocate the ROM bitmap\n");
+		free(starts);
+		free(bytes);
+		return 1;
+	}
+
+	uint64_t hash = warm_boot_hash(WARM_BOOT_HASH_INIT, mem + address, size);
+	get_rom_bitmaps(coverage, mnem, address, size, starts, bytes);
+
+	if (lock_file(lock_path)) {
+		free(starts);
+		free(bytes);
+		return 1;
+	}
+	merge_file(path, address, size, hash, starts, bytes);
+	int error = write_bitmap(path, address, size, hash, starts, bytes);
+	if (!error) {
+		error = write_listing(listing_path, mnem, mem, rom_path, address, size, starts, bytes);
+	}
+	remove(lock_path);
+
+	if (!error) {
+		log_info("[COVERAGE] Wrote %s\n", path);
+	}
+	free(starts);
+	free(bytes);
+	return error;
+}
@@ -0,0 +1,46 @@
+/* coverage.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Guest code coverage; a bitmap of the executed instructions over the 1MB address space, exported per ROM
+ */
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdint.h>
+
+#include "i8086_mnem.h"
+
+#define COVERAGE_ADDRESS_SPACE 0x100000
+#define COVERAGE_LOCK_MS       5000 /* wait for another run to merge its coverage; then the coverage is not written */
+#define COVERAGE_LOCK_POLL_MS  10   /* between attempts to take the lock */
+#define COVERAGE_LOCK_STALE_S  60   /* a lock older than this was left by a run that died while merging; it is removed */
+
+typedef struct COVERAGE {
+	uint8_t enabled;
+	uint8_t* starts;  /* 1 bit per byte; an instruction started at the address. COVERAGE_ADDRESS_SPACE / 8 */
+} COVERAGE;
+
+/* Create the coverage bitmap
+	coverage: the coverage instance
+	Returns: 0 if success. Otherwise 1 */
+int coverage_create(COVERAGE* coverage);
+void coverage_destroy(COVERAGE* coverage);
+
+/* Mark an instruction as executed; called per instruction
+	coverage: the coverage instance
+	address: the physical address of the instruction */
+void coverage_mark(COVERAGE* coverage, uint32_t address);
+
+/* Write the coverage of a ROM; merged with the coverage already in the directory from other runs of the same ROM.
+ * Writes <dir>/<rom>_<address>.cov; a bitmap of the instructions and bytes executed, and <dir>/<rom>_<address>.lst; the annotated disassembly
+	coverage: the coverage instance
+	mnem: the disassembler
+	mem: guest memory
+	rom_path: the ROM file; names the output
+	address: the ROM address
+	size: the ROM size
+	dir: the output directory
+	Returns: 0 if success. Otherwise 1 */
+int coverage_write_rom(COVERAGE* coverage, I8086_MNEM* mnem, const uint8_t* mem, const char* rom_path, uint32_t address, uint32_t size, const char* dir);
+
+#endif
@@ -0,0 +1,95 @@
+/* disasm_cache.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Disassembly cache; the instructions from CS:IP decoded once and kept until the memory they were decoded from is written
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "disasm_cache.h"
+
+#include "i8086.h"
+#include "i8086_mnem.h"
+#include "io/memory_map.h"
+
+/* Rows are decoded on demand, in order; a row's ip is the end of the row before it.
+ * The cache follows CS:IP; when CS:IP is a cached row the rows from it on are kept, so stepping decodes one row.
+ * Writes are found by the page written flags (MEMORY_MAP_DIRTY_VIEW); only then are the bytes compared, and the
+ * rows from the first one that changed are dropped. */
+
+void disasm_cache_reset(DISASM_CACHE* cache) {
+	cache->count = 0;
+}
+
+static int row_changed(const DISASM_ROW* row, MEMORY_MAP* mm, uint16_t cs) {
+	int size = (row->size < DISASM_CACHE_BYTES) ? row->size : DISASM_CACHE_BYTES;
+	for (int i = 0; i < size; ++i) {
+		if (memory_map_read_byte(mm, i8086_get_physical_address(cs, row->ip + i)) != row->bytes[i]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void disasm_cache_sync(DISASM_CACHE* cache, MEMORY_MAP* mm, uint16_t cs, uint16_t ip) {
+	if (cache->count > 0 && cache->cs != cs) {
+		cache->count = 0;
+	}
+
+	/* Keep the rows from ip on */
+	if (cache->count > 0 && cache->ip != ip) {
+		int found = 0;
+		for (int i = 1; i < cache->count; ++i) {
+			if (cache->rows[i].ip == ip) {
+				cache->count -= i;
+				memmove(cache->rows, cache->rows + i, cache->count * sizeof(DISASM_ROW));
+				found = 1;
+				break;
+			}
+		}
+		if (!found) {
+			cache->count = 0;
+		}
+	}
+	cache->cs = cs;
+	cache->ip = ip;
+
+	if (cache->count == 0) {
+		return;
+	}
+
+	/* Drop the rows from the first one written to */
+	const DISASM_ROW* last = &cache->rows[cache->count - 1];
+	uint32_t start = i8086_get_physical_address(cs, ip);
+	uint32_t end = i8086_get_physical_address(cs, last->ip) + last->size;
+	uint32_t size = (end > start) ? end - start : 0x10000; /* the rows wrap the segment */
+	if (memory_map_test_clear_dirty(mm, start, size, MEMORY_MAP_DIRTY_VIEW)) {
+		for (int i = 0; i < cache->count; ++i) {
+			if (row_changed(&cache->rows[i], mm, cs)) {
+				cache->count = i;
+				break;
+			}
+		}
+	}
+}
+
+const DISASM_ROW* disasm_cache_get(DISASM_CACHE* cache, I8086_MNEM* mnem, MEMORY_MAP* mm, int row) {
+	while (cache->count <= row) {
+		DISASM_ROW* prev = (cache->count > 0) ? &cache->rows[cache->count - 1] : NULL;
+		DISASM_ROW* next = &cache->rows[cache->count];
+		next->ip = (prev != NULL) ? (uint16_t)(prev->ip + prev->size) : cache->ip;
+
+		i8086_mnem_at(mnem, cache->cs, next->ip);
+		next->size = (mnem->counter > 0) ? (uint8_t)mnem->counter : 1;
+		next->has_ea = mnem->has_ea;
+		next->has_target = mnem->step_over_has_target || mnem->step_into_has_target;
+		strncpy_s(next->str, DISASM_CACHE_STR, mnem->str, DISASM_CACHE_STR - 1);
+
+		int size = (next->size < DISASM_CACHE_BYTES) ? next->size : DISASM_CACHE_BYTES;
+		for (int i = 0; i < size; ++i) {
+			next->bytes[i] = memory_map_read_byte(mm, i8086_get_physical_address(cache->cs, next->ip + i));
+		}
+		cache->count++;
+	}
+	return &cache->rows[row];
+}
@@ -0,0 +1,53 @@
+/* disasm_cache.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Disassembly cache; the instructions from CS:IP decoded once and kept until the memory they were decoded from is written
+ */
+
+#ifndef DISASM_CACHE_H
+#define DISASM_CACHE_H
+
+#include <stdint.h>
+
+#include "i8086_mnem.h"
+#include "io/memory_map.h"
+
+#define DISASM_CACHE_ROWS  256
+#define DISASM_CACHE_BYTES 8  /* instruction bytes kept per row; a write to a byte past this in a longer instruction is not seen */
+#define DISASM_CACHE_STR   64
+
+typedef struct DISASM_ROW {
+	uint16_t ip;
+	uint8_t size;                        /* the instruction size */
+	uint8_t has_ea;                      /* the instruction has an effective address; it depends on the registers */
+	uint8_t has_target;                  /* the instruction has a step into or step over target */
+	uint8_t bytes[DISASM_CACHE_BYTES];   /* the bytes decoded; compared when their page is written */
+	char str[DISASM_CACHE_STR];
+} DISASM_ROW;
+
+typedef struct DISASM_CACHE {
+	uint16_t cs;
+	uint16_t ip;                         /* the ip of row 0 */
+	int count;                           /* rows decoded */
+	DISASM_ROW rows[DISASM_CACHE_ROWS];
+} DISASM_CACHE;
+
+/* Drop every row
+	cache: the cache instance */
+void disasm_cache_reset(DISASM_CACHE* cache);
+
+/* Move row 0 to CS:IP; the rows from CS:IP on are kept. Rows decoded from memory written since the last sync are dropped
+	cache: the cache instance
+	mm: the memory map; the page written flags are tested and cleared
+	cs: the code segment
+	ip: the instruction pointer */
+void disasm_cache_sync(DISASM_CACHE* cache, MEMORY_MAP* mm, uint16_t cs, uint16_t ip);
+
+/* Get a row; the rows up to it are decoded if not cached
+	cache: the cache instance
+	mnem: the disassembler
+	mm: the memory map
+	row: the row; 0 - DISASM_CACHE_ROWS-1
+	Returns: the row */
+const DISASM_ROW* disasm_cache_get(DISASM_CACHE* cache, I8086_MNEM* mnem, MEMORY_MAP* mm, int row);
+
+#endif
@@ -15,6 +15,8 @@
 #include "backend/chipset/i8237_dma.h"
 #include "backend/chipset/i8259_pic.h"
 
+#include "backend/utility/trace.h"
+
 /* I/O Port Addresses */
 
 #define PORT_STATUS_A        0 // RO
@@ -141,13 +143,8 @@
 #define RECEIVE_DATA 0 /* Set FDC to receive data */
 #define SEND_DATA    1 /* Set FDC to send data */
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_FDC
+#include "backend/utility/log.h"
 
 /* FDC DMA Channel */
 #define FDC_DMA 2
@@ -299,6 +296,7 @@ static void command_reset(FDC* fdc) {
 static void command_set(FDC* fdc, uint8_t command) {
 	/* Set command */
 	fdc->command.byte = command;
+	TRACE_ASYNC_BEGIN(TRACE_CAT_GUEST, "fdc command", TRACE_ID_FDC, "cmd", command & CMD_BYTE);
 
 	switch (command & CMD_BYTE) {
 		case CMD_READ_DATA:
@@ -359,7 +357,7 @@ static void command_set(FDC* fdc, uint8_t command) {
 	}
 
 	if (!ring_buffer_is_empty(&fdc->data_register_out)) {
-		dbg_print("[FDC] Command started. OUT FIFO not empty!\n");
+		log_warn("[FDC] Command started. OUT FIFO not empty!\n");
 	}
 }
 static void command_set_parameter(FDC* fdc, uint8_t value) {
@@ -388,9 +386,10 @@ static void command_finalize(FDC* fdc, uint8_t irq, uint8_t data_direction) {
 	}
 
 	if (!ring_buffer_is_empty(&fdc->data_register_in)) {
-		dbg_print("[FDC] Command finalized. IN FIFO not empty!\n");
+		log_warn("[FDC] Command finalized. IN FIFO not empty!\n");
 	}
 
+	TRACE_ASYNC_END(TRACE_CAT_GUEST, "fdc command", TRACE_ID_FDC);
 	command_reset(fdc);
 }
 static void command_set_async(FDC* fdc) {
@@ -427,7 +426,7 @@ static void cmd_reset(FDC* fdc) {
 	/* Finalize command; set IRQ; receive data */
 	command_finalize(fdc, IRQ, RECEIVE_DATA);
 	
-	dbg_print("[FDC] reset\n");
+	log_debug("[FDC] reset\n");
 }
 static void cmd_read_data(FDC* fdc) {
 
@@ -453,7 +452,7 @@ static void cmd_read_data(FDC* fdc) {
 	uint32_t transfer_size = i8237_dma_get_transfer_size(fdc->dma_p, FDC_DMA);
 	uint32_t tranfer_sector_count = transfer_size / fdc->sector_size;
 
-	dbg_print("[FDC] Read data %s%s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u, t_addr=%x, t_size=%x, t_sectors=%d\n",
+	log_debug("[FDC] Read data %s%s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u, t_addr=%x, t_size=%x, t_sectors=%d\n",
 		(fdc->dma ? "DMA" : "PIO"), (fdc->command.byte & CMD_MT) ? " MT" : "", fdc->command.dhs, fdc->command.chs.c, fdc->command.chs.h, fdc->command.chs.s,
 		fdc->command.n, fdc->command.eot, fdc->command.gap_len, fdc->command.data_len, transfer_address, transfer_size, tranfer_sector_count);
 
@@ -480,7 +479,7 @@ static void cmd_read_track(FDC* fdc) {
 	fdc->byte_index = 0;
 	fdc->command.chs.s = 1; /* R is ignored on Read Track. Force s = 1. */
 
-	dbg_print("[FDC] Read track %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
+	log_debug("[FDC] Read track %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
 		(fdc->dma ? "DMA" : "PIO"), fdc->command.dhs, fdc->command.chs.c, fdc->command.chs.h, fdc->command.chs.s, 
 		fdc->command.n, fdc->command.eot, fdc->command.gap_len, fdc->command.data_len);
 
@@ -503,7 +502,7 @@ static void cmd_read_deleted_data(FDC* fdc) {
 
 	set_polling_mode(fdc);
 
-	dbg_print("[FDC] Read deleted data (NOT IMPLEMENTED) %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
+	log_warn("[FDC] Read deleted data (NOT IMPLEMENTED) %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
 		(fdc->dma ? "DMA" : "PIO"), fdc->command.dhs, fdc->command.chs.c, fdc->command.chs.h, fdc->command.chs.s, 
 		fdc->command.n, fdc->command.eot, fdc->command.gap_len, fdc->command.data_len);
 
@@ -529,7 +528,7 @@ static void cmd_write_data(FDC* fdc) {
 	fdc->sector_size = n_to_sector_size(fdc->command.n);
 	fdc->byte_index = 0;
 
-	dbg_print("[FDC] Write data %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
+	log_debug("[FDC] Write data %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
 		(fdc->dma ? "DMA" : "PIO"), fdc->command.dhs, fdc->command.chs.c, fdc->command.chs.h, fdc->command.chs.s, 
 		fdc->command.n, fdc->command.eot, fdc->command.gap_len, fdc->command.data_len);
 
@@ -552,7 +551,7 @@ static void cmd_format_track(FDC* fdc) {
 	fdc->sector_size = n_to_sector_size(fdc->command.n);
 	fdc->byte_index = 0;
 
-	dbg_print("[FDC] Format track %s dhs=%u, n=%u, sc=%u, gpl=%u, d=%u\n",
+	log_debug("[FDC] Format track %s dhs=%u, n=%u, sc=%u, gpl=%u, d=%u\n",
 		(fdc->dma ? "DMA" : "PIO"), fdc->command.dhs, fdc->command.n, sc, fdc->command.gap_len, d);
 
 	command_set_async(fdc);
@@ -576,7 +575,7 @@ static void cmd_write_deleted_data(FDC* fdc) {
 
 	command_results(fdc, ST0_NT, NO_IRQ);
 
-	dbg_print("[FDC] Write deleted data (NOT IMPLEMENTED) %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
+	log_warn("[FDC] Write deleted data (NOT IMPLEMENTED) %s dhs=%u, c=%u, h=%u, s=%u, n=%u, eot=%u, gpl=%u, dtl=%u\n",
 		(fdc->dma ? "DMA" : "PIO"), fdc->command.dhs, fdc->command.chs.c, fdc->command.chs.h, fdc->command.chs.s, 
 		fdc->command.n, fdc->command.eot, fdc->command.gap_len, fdc->command.data_len);
 }
@@ -596,7 +595,7 @@ static void cmd_scan_e(FDC* fdc) {
 
 	command_results(fdc, ST0_NT, NO_IRQ);
 
-	dbg_print("[FDC] scan e (NOT IMPLEMENTED)\n");
+	log_warn("[FDC] scan e (NOT IMPLEMENTED)\n");
 }
 static void cmd_scan_le(FDC* fdc) {
 
@@ -613,7 +612,7 @@ static void cmd_scan_le(FDC* fdc) {
 
 	command_results(fdc, ST0_NT, NO_IRQ);
 
-	dbg_print("[FDC] scan le (NOT IMPLEMENTED)\n");
+	log_warn("[FDC] scan le (NOT IMPLEMENTED)\n");
 }
 static void cmd_scan_he(FDC* fdc) {
 
@@ -630,7 +629,7 @@ static void cmd_scan_he(FDC* fdc) {
 
 	command_results(fdc, ST0_NT, NO_IRQ);
 
-	dbg_print("[FDC] scan he (NOT IMPLEMENTED)\n");
+	log_warn("[FDC] scan he (NOT IMPLEMENTED)\n");
 }
 
 static void cmd_recalibrate(FDC* fdc) {
@@ -652,7 +651,7 @@ static void cmd_recalibrate(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, IRQ, RECEIVE_DATA);
 
-	dbg_print("[FDC] Recalibrate dhs=%u\n", fdc->command.dhs);
+	log_debug("[FDC] Recalibrate dhs=%u\n", fdc->command.dhs);
 }
 static void cmd_seek(FDC* fdc) {
 
@@ -677,7 +676,7 @@ static void cmd_seek(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, IRQ, RECEIVE_DATA);
 
-	dbg_print("[FDC] Seek dhs=%u, ncn=%d\n", fdc->command.dhs, fdc->command.chs.c);
+	log_debug("[FDC] Seek dhs=%u, ncn=%d\n", fdc->command.dhs, fdc->command.chs.c);
 }
 
 static void cmd_sense_interrupt(FDC* fdc) {
@@ -689,7 +688,7 @@ static void cmd_sense_interrupt(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, NO_IRQ, SEND_DATA);
 
-	dbg_print("[FDC] Sense interrupt st0=%x, pcn=%d\n", fdc->st0, fdc->command.chs.c);
+	log_debug("[FDC] Sense interrupt st0=%x, pcn=%d\n", fdc->st0, fdc->command.chs.c);
 }
 static void cmd_sense_drive_status(FDC* fdc) {
 
@@ -708,7 +707,7 @@ static void cmd_sense_drive_status(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, NO_IRQ, SEND_DATA);
 
-	dbg_print("[FDC] Sense drive status\n");
+	log_debug("[FDC] Sense drive status\n");
 }
 
 static void cmd_read_id(FDC* fdc) {
@@ -722,7 +721,7 @@ static void cmd_read_id(FDC* fdc) {
 	
 	command_results(fdc, ST0_NT, IRQ);
 
-	dbg_print("[FDC] Read id dhs=%u, c=%d\n", fdc->command.dhs, fdc->command.chs.c);
+	log_debug("[FDC] Read id dhs=%u, c=%d\n", fdc->command.dhs, fdc->command.chs.c);
 
 	chs_advance_sector(fdc->fdd[fdc->fdd_select].geometry, &fdc->command.chs);
 }
@@ -752,7 +751,7 @@ static void cmd_specify(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, NO_IRQ, RECEIVE_DATA);
 
-	dbg_print("[FDC] Specify srt=%d, hut=%d, hlt=%d, nd=%d \n", srt, hut, hlt, nd);
+	log_debug("[FDC] Specify srt=%d, hut=%d, hlt=%d, nd=%d \n", srt, hut, hlt, nd);
 }
 static void cmd_nop(FDC* fdc) {
 	
@@ -765,13 +764,13 @@ static void cmd_nop(FDC* fdc) {
 	/* Finish command */
 	command_finalize(fdc, NO_IRQ, SEND_DATA);
 
-	dbg_print("[FDC] nop %02X\n", fdc->command.byte & CMD_BYTE);
+	log_debug("[FDC] nop %02X\n", fdc->command.byte & CMD_BYTE);
 }
 
 /* Asynchronous commands */
 static void cmd_read_data_async(FDC* fdc) {
 	if (!fdc->dma) {
-		dbg_print("[FDC] Read data. PIO mode not implemented\n");
+		log_warn("[FDC] Read data. PIO mode not implemented\n");
 		command_results(fdc, ST0_AT, IRQ);
 		return;
 	}
@@ -804,7 +803,7 @@ static void cmd_read_data_async(FDC* fdc) {
 }
 static void cmd_read_track_async(FDC* fdc) {
 	if (!fdc->dma) {
-		dbg_print("[FDC] Read track. PIO mode not implemented\n");
+		log_warn("[FDC] Read track. PIO mode not implemented\n");
 		command_results(fdc, ST0_AT, IRQ);
 		return;
 	}
@@ -842,7 +841,7 @@ static void cmd_read_track_async(FDC* fdc) {
 }
 static void cmd_write_data_async(FDC* fdc) {
 	if (!fdc->dma) {
-		dbg_print("[FDC] Write data. PIO mode not implemented\n");
+		log_warn("[FDC] Write data. PIO mode not implemented\n");
 		command_results(fdc, ST0_AT, IRQ);
 		return;
 	}
@@ -868,8 +867,11 @@ static void cmd_write_data_async(FDC* fdc) {
 			/* Read data from dma */
 			uint8_t byte = i8237_dma_read_byte(fdc->dma_p, FDC_DMA);
 
-			/* Write data to fdd */
-			fdd_write_byte(&fdc->fdd[fdc->fdd_select], offset, byte);
+			/* Write data to fdd; the command fails if the write was lost */
+			if (fdd_write_byte(&fdc->fdd[fdc->fdd_select], offset, byte)) {
+				command_results(fdc, ST0_AT, IRQ);
+				return;
+			}
 
 			/* Advance byte index */
 			advance_byte_index(fdc);
@@ -881,7 +883,7 @@ static void cmd_write_data_async(FDC* fdc) {
 }
 static void cmd_format_track_async(FDC* fdc) {
 	if (!fdc->dma) {
-		dbg_print("[FDC] Write track. PIO mode not implemented\n");
+		log_warn("[FDC] Write track. PIO mode not implemented\n");
 		command_results(fdc, ST0_AT, IRQ);
 		return;
 	}
@@ -907,8 +909,11 @@ static void cmd_format_track_async(FDC* fdc) {
 			/* Read data from dma */
 			uint8_t byte = i8237_dma_read_byte(fdc->dma_p, FDC_DMA);
 
-			/* Write data to fdd */
-			fdd_write_byte(&fdc->fdd[fdc->fdd_select], offset, byte);
+			/* Write data to fdd; the command fails if the write was lost */
+			if (fdd_write_byte(&fdc->fdd[fdc->fdd_select], offset, byte)) {
+				command_results(fdc, ST0_AT, IRQ);
+				return;
+			}
 
 			/* Advance byte index */
 			advance_byte_index(fdc);
@@ -995,31 +1000,31 @@ static void write_dor(FDC* fdc, uint8_t v) {
 	 control drive motors, drive selection, and feature enable. All bits are
 	 cleared by the I/O interface reset line */
 
-#ifdef DBG_PRINT
-	 //dbg_print("[FDC] WRITE DOR=%02X\n", v);
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
+	 //log_debug("[FDC] WRITE DOR=%02X\n", v);
 
 	if (IS_RISING_EDGE(DOR_ENABLE, fdc->dor, v)) {
-		dbg_print("[FDC] DOR ENABLE FDC\n");
+		log_debug("[FDC] DOR ENABLE FDC\n");
 	}
 	else if (IS_FALLING_EDGE(DOR_ENABLE, fdc->dor, v)) {
-		dbg_print("[FDC] DOR DISABLE FDC\n");
+		log_debug("[FDC] DOR DISABLE FDC\n");
 	}
 
 	if (IS_RISING_EDGE(DOR_DMA_INT_MASK, fdc->dor, v)) {
-		dbg_print("[FDC] DOR ENABLE DMA/INT\n");
+		log_debug("[FDC] DOR ENABLE DMA/INT\n");
 	}
 	else if (IS_FALLING_EDGE(DOR_DMA_INT_MASK, fdc->dor, v)) {
-		dbg_print("[FDC] DOR DISABLE DMA/INT\n");
+		log_debug("[FDC] DOR DISABLE DMA/INT\n");
 	}
 
 	if (HAS_BITS_CHANGED(DOR_FDD_SELECT_MASK, fdc->dor, v)) {
-		dbg_print("[FDC] DOR SELECT FDD%d\n", v & DOR_FDD_SELECT_MASK);
+		log_debug("[FDC] DOR SELECT FDD%d\n", v & DOR_FDD_SELECT_MASK);
 	}
 
 	if (HAS_BITS_CHANGED(DOR_FDD_MOTOR_ON_MASK, fdc->dor, v)) {
 		for (int i = 0; i < FDD_MAX; ++i) {
 			if (HAS_BITS_CHANGED(1 << (4 + i), fdc->dor, v)) {
-				dbg_print("[FDC] DOR MOTOR %s FDD%d\n", (v & (1 << (4 + i))) ? "ON" : "OFF", i);
+				log_debug("[FDC] DOR MOTOR %s FDD%d\n", (v & (1 << (4 + i))) ? "ON" : "OFF", i);
 			}
 		}
 	}
@@ -1075,24 +1080,28 @@ static uint8_t read_data(FDC* fdc) {
 	return 0; /* shouldnt hit */
 }
 static uint8_t read_msr(FDC* fdc) {
-	//dbg_print("[FDC] READ MSR=%02X\n", fdc->msr);
+	//log_debug("[FDC] READ MSR=%02X\n", fdc->msr);
 	return fdc->msr;
 }
 
 int upd765_fdc_create(FDC* fdc) {
 	if (ring_buffer_create(&fdc->data_register_out, 10)) {
-		dbg_print("[FDC] Failed to allocate data register out ring buffer\n");
+		log_error("[FDC] Failed to allocate data register out ring buffer\n");
 		return 1;
 	}
 	if (ring_buffer_create(&fdc->data_register_in, 10)) {
-		dbg_print("[FDC] Failed to allocate data register in ring buffer\n");
+		log_error("[FDC] Failed to allocate data register in ring buffer\n");
 		return 1;
 	}
 
 	for (uint8_t i = 0; i < FDD_MAX; ++i) {
 		fdc->fdd[i].path = calloc(1, 256);
 		if (fdc->fdd[i].path == NULL) {
-			dbg_print("[FDC] Failed to allocate path buffer\n");
+			log_error("[FDC] Failed to allocate path buffer\n");
+			return 1;
+		}
+		if (overlay_create(&fdc->fdd[i].overlay)) {
+			log_error("[FDC] Failed to allocate overlay\n");
 			return 1;
 		}
 	}
@@ -1105,6 +1114,7 @@ void upd765_fdc_destroy(FDC* fdc) {
 
 	for (uint8_t i = 0; i < FDD_MAX; ++i) {
 		fdd_eject_disk(&fdc->fdd[i]);
+		overlay_destroy(&fdc->fdd[i].overlay);
 		if (fdc->fdd[i].path != NULL) {
 			free(fdc->fdd[i].path);
 			fdc->fdd[i].path = NULL;
@@ -1138,6 +1148,47 @@ void upd765_fdc_reset(FDC* fdc) {
 	ring_buffer_reset(&fdc->data_register_in);
 }
 
+void upd765_fdc_save_state(FDC* fdc, FDC_STATE* state) {
+	state->msr = fdc->msr;
+	state->dor = fdc->dor;
+	state->st0 = fdc->st0;
+	state->st1 = fdc->st1;
+	state->st2 = fdc->st2;
+	state->st3 = fdc->st3;
+	state->fdd_select = fdc->fdd_select;
+	state->dma = fdc->dma;
+	state->command = fdc->command;
+	state->sector_size = fdc->sector_size;
+	state->byte_index = fdc->byte_index;
+	ring_buffer_save_state(&fdc->data_register_out, &state->data_register_out);
+	ring_buffer_save_state(&fdc->data_register_in, &state->data_register_in);
+	for (int i = 0; i < FDD_MAX; ++i) {
+		state->motor_on[i] = fdc->fdd[i].status.motor_on;
+	}
+	state->accum = fdc->accum;
+}
+void upd765_fdc_load_state(FDC* fdc, const FDC_STATE* state) {
+	fdc->msr = state->msr;
+	fdc->dor = state->dor;
+	fdc->st0 = state->st0;
+	fdc->st1 = state->st1;
+	fdc->st2 = state->st2;
+	fdc->st3 = state->st3;
+	fdc->fdd_select = state->fdd_select;
+	fdc->dma = state->dma;
+	fdc->command = state->command;
+	fdc->sector_size = state->sector_size;
+	fdc->byte_index = state->byte_index;
+	ring_buffer_load_state(&fdc->data_register_out, &state->data_register_out);
+	ring_buffer_load_state(&fdc->data_register_in, &state->data_register_in);
+	for (int i = 0; i < FDD_MAX; ++i) {
+		/* the ready signal follows the motor and the disk in the drive now */
+		fdc->fdd[i].status.motor_on = state->motor_on[i];
+		fdc->fdd[i].status.ready = fdc->fdd[i].status.motor_on && fdc->fdd[i].status.inserted;
+	}
+	fdc->accum = state->accum;
+}
+
 uint8_t upd765_fdc_read_io_byte(FDC* fdc, uint8_t address) {
 	switch (address) {
 		case PORT_STATUS_REGISTER:
@@ -1145,7 +1196,7 @@ uint8_t upd765_fdc_read_io_byte(FDC* fdc, uint8_t address) {
 		case PORT_DATA_REGISTER:
 			return read_data(fdc);
 		default:
-			dbg_print("[FDC] read byte %x\n", address);
+			log_debug("[FDC] read byte %x\n", address);
 			break;
 	}
 	return 0;
@@ -1159,13 +1210,15 @@ void upd765_fdc_write_io_byte(FDC* fdc, uint8_t address, uint8_t value) {
 			write_data(fdc, value);
 			break;
 		default:
-			dbg_print("[FDC] write byte %x\n", address);
+			log_debug("[FDC] write byte %x\n", address);
 			break;
 	}
 }
 
 void upd765_fdc_update(FDC* fdc) {
 	if (fdc->command.state == (COMMAND_STATE_EXECUTING | COMMAND_STATE_ASYNC)) {
+		TRACE_BEGIN(TRACE_CAT_DEVICE, "upd765_fdc_update");
 		command_execute_async(fdc);
+		TRACE_END(TRACE_CAT_DEVICE, "upd765_fdc_update");
 	}
 }
@@ -69,6 +69,25 @@ typedef struct FDC {
 	I8259_PIC* pic_p; /* PIC pointer */
 } FDC;
 
+/* Controller state for a snapshot; the disks in the drives are not part of it */
+typedef struct FDC_STATE {
+	uint8_t msr;
+	uint8_t dor;
+	uint8_t st0;
+	uint8_t st1;
+	uint8_t st2;
+	uint8_t st3;
+	uint8_t fdd_select;
+	uint8_t dma;
+	FDC_COMMAND command;
+	uint16_t sector_size;
+	size_t byte_index;
+	RING_BUFFER_STATE data_register_out;
+	RING_BUFFER_STATE data_register_in;
+	uint8_t motor_on[FDD_MAX];
+	uint64_t accum;
+} FDC_STATE;
+
 int upd765_fdc_create(FDC* fdc);
 void upd765_fdc_destroy(FDC* fdc);
 void upd765_fdc_init(FDC* fdc, I8237_DMA* dma, I8259_PIC* pic);
@@ -79,4 +98,7 @@ void upd765_fdc_write_io_byte(FDC* fdc, const uint8_t address, const uint8_t val
 
 void upd765_fdc_update(FDC* fdc);
 
+void upd765_fdc_save_state(FDC* fdc, FDC_STATE* state);
+void upd765_fdc_load_state(FDC* fdc, const FDC_STATE* state);
+
 #endif
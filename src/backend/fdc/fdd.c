@@ -5,20 +5,17 @@
 
 #include <malloc.h>
 #include <string.h>
+#include <stdio.h>
 
 #include "fdd.h"
 #include "frontend/utility/file.h"
 #include "backend/utility/lba.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_FDC
+#include "backend/utility/log.h"
 
 #define FDD_NAME_SIZE 256
+#define FDD_DIRECTORY_MAX_SIZE (720 * 1024) /* largest floppy a host directory is mounted as */
 
 const DISK_GEOMETRY disk_geometry[] = {
 	{ .size = ( 160 * 1024), .chs = { .c = 40, .h = 1, .s =  8 } }, /* 160KB */
@@ -41,7 +38,7 @@ static int set_geometry(FDD_DISK* fdd, size_t size) {
 	}
 
 	chs_reset(&fdd->geometry);
-	dbg_print("[FDC] Unknown floppy disk %zu KB\n", size >> 10);
+	log_warn("[FDC] Unknown floppy disk %zu KB\n", size >> 10);
 	return FDD_INSERT_DISK_ERROR_UNK_FLOPPY;
 }
 
@@ -74,6 +71,9 @@ static void reset_disk(FDD_DISK* fdd) {
 			fdd->buffer = NULL;
 		}
 		fdd->buffer_size = 0;
+		fat_dir_close(&fdd->fat_dir);
+		overlay_detach(&fdd->overlay);
+		fdd->overlay.path[0] = '\0';
 		fdd->status.inserted = 0;
 		fdd->status.dirty = 0;
 
@@ -111,7 +111,7 @@ int fdd_new_disk(FDD_DISK* fdd, size_t buffer_size) {
 
 	fdd->buffer = calloc(1, buffer_size);
 	if (fdd->buffer == NULL) {
-		dbg_print("Error: could not alloc memory for new disk\n");
+		log_error("Error: could not alloc memory for new disk\n");
 		return FDD_INSERT_DISK_ERROR_FILE;
 	}
 	fdd->buffer_size = buffer_size;
@@ -126,7 +126,44 @@ int fdd_new_disk(FDD_DISK* fdd, size_t buffer_size) {
 
 	fdd->status.dirty = 1;
 
-	printf("[FDD] NEW DISK: %s\n", fdd->path);
+	log_info("[FDD] NEW DISK: %s\n", fdd->path);
+	return FDD_INSERT_DISK_OK;
+}
+
+static int insert_directory(FDD_DISK* fdd, const char* path) {
+	if (fat_dir_open(&fdd->fat_dir, path)) {
+		return FDD_INSERT_DISK_ERROR_FILE;
+	}
+
+	/* Smallest floppy the files fit on; up to 720K, the largest format the 5150/5160 BIOS and the FDC can use */
+	for (uint32_t i = 0; i < disk_geometry_count && disk_geometry[i].size <= FDD_DIRECTORY_MAX_SIZE; ++i) {
+		if (fat_dir_format(&fdd->fat_dir, disk_geometry[i].chs, 0) == 0) {
+			fdd->buffer_size = disk_geometry[i].size;
+			break;
+		}
+	}
+
+	if (fdd->buffer_size == 0) {
+		log_error("[FDD] Directory does not fit on a floppy: %s\n", path);
+		reset_disk(fdd);
+		return FDD_INSERT_DISK_ERROR_UNK_FLOPPY;
+	}
+
+	strncpy_s(fdd->path, FDD_NAME_SIZE, path, FDD_NAME_SIZE - 1);
+
+	int result = insert_disk(fdd, fdd->buffer_size);
+	if (result != FDD_INSERT_DISK_OK) {
+		reset_disk(fdd);
+		return result;
+	}
+
+	/* Host files are never written; guest writes are kept in the overlay */
+	if (overlay_attach(&fdd->overlay, "", fdd->buffer_size)) {
+		reset_disk(fdd);
+		return FDD_INSERT_DISK_ERROR_FILE;
+	}
+
+	log_info("[FDD] INSERT DIRECTORY: %s\n", fdd->path);
 	return FDD_INSERT_DISK_OK;
 }
 
@@ -135,6 +172,10 @@ int fdd_insert_disk(FDD_DISK* fdd, const char* file) {
 		return FDD_INSERT_DISK_ERROR_IN_USE;
 	}
 
+	if (file_is_directory(file)) {
+		return insert_directory(fdd, file);
+	}
+
 	if (file_read_alloc_buffer(file, &fdd->buffer, &fdd->buffer_size)) {
 		return FDD_INSERT_DISK_ERROR_FILE;
 	}
@@ -147,28 +188,56 @@ int fdd_insert_disk(FDD_DISK* fdd, const char* file) {
 		return result;
 	}
 
-	printf("[FDD] INSERT DISK: %s\n", fdd->path);
+	log_info("[FDD] INSERT DISK: %s\n", fdd->path);
 	return FDD_INSERT_DISK_OK;
 }
 void fdd_eject_disk(FDD_DISK* fdd) {
 	if (fdd->status.inserted) {
-		printf("[FDD] EJECT DISK: %s\n", fdd->path);
+		log_info("[FDD] EJECT DISK: %s\n", fdd->path);
 		reset_disk(fdd);
 	}
 }
 void fdd_save_disk(FDD_DISK* fdd) {
-	if (fdd->status.inserted) {
+	if (fdd->status.inserted && fdd->fat_dir.enabled && fdd->overlay.path[0] == '\0') {
+		log_info("[FDD] HOST DIRECTORY IS READ-ONLY: %s. Use save as to write an image\n", fdd->path);
+	}
+	else if (fdd->status.inserted && fdd->overlay.enabled) {
+		/* Base image is read-only; save the delta */
+		if (overlay_save(&fdd->overlay)) {
+			log_error("[FDD] FAILED TO SAVE OVERLAY: %s\n", fdd->overlay.path);
+		}
+		else {
+			fdd->status.dirty = 0;
+			log_info("[FDD] SAVE OVERLAY: %s\n", fdd->overlay.path);
+		}
+	}
+	else if (fdd->status.inserted) {
 		if (file_write_from_buffer(fdd->path, fdd->buffer, fdd->buffer_size)) {
-			printf("[FDD] FAILED TO SAVE DISK: %s\n", fdd->path);
+			log_error("[FDD] FAILED TO SAVE DISK: %s\n", fdd->path);
 		}
 		else {
 			fdd->status.dirty = 0;
-			printf("[FDD] SAVE DISK: %s\n", fdd->path);
+			log_info("[FDD] SAVE DISK: %s\n", fdd->path);
 		}
 	}
 }
 void fdd_save_as_disk(FDD_DISK* fdd, const char* filename) {
 	if (fdd->status.inserted) {
+		if (fdd->fat_dir.enabled) {
+			/* Synthesize the whole volume; the disk becomes a plain image */
+			fdd->buffer = malloc(fdd->buffer_size);
+			if (fdd->buffer == NULL) {
+				log_error("Error: could not alloc memory for disk\n");
+				return;
+			}
+			fat_dir_read(&fdd->fat_dir, fdd->buffer, fdd->buffer_size);
+			fat_dir_close(&fdd->fat_dir);
+		}
+		if (fdd->overlay.enabled) {
+			/* Flatten base + delta into a standalone image */
+			overlay_apply(&fdd->overlay, fdd->buffer, fdd->buffer_size);
+			overlay_detach(&fdd->overlay);
+		}
 		strncpy_s(fdd->path, FDD_NAME_SIZE, filename, FDD_NAME_SIZE - 1);
 		fdd_save_disk(fdd);
 	}
@@ -178,18 +247,78 @@ void fdd_write_protect(FDD_DISK* fdd, uint8_t write_protect) {
 	fdd->status.write_protect = write_protect;
 }
 
+int fdd_attach_overlay(FDD_DISK* fdd, const char* file) {
+	if (!fdd->status.inserted) {
+		return 1;
+	}
+
+	if (overlay_attach(&fdd->overlay, file, fdd->buffer_size)) {
+		log_error("[FDD] FAILED TO ATTACH OVERLAY: %s\n", file);
+		return 1;
+	}
+
+	fdd->status.dirty = 0;
+	return 0;
+}
+void fdd_commit_overlay(FDD_DISK* fdd) {
+	if (fdd->status.inserted && fdd->fat_dir.enabled) {
+		log_info("[FDD] HOST DIRECTORY IS READ-ONLY: %s\n", fdd->path);
+	}
+	else if (fdd->status.inserted && fdd->overlay.enabled) {
+		/* Merge the delta into the base image and write it back */
+		overlay_apply(&fdd->overlay, fdd->buffer, fdd->buffer_size);
+		if (file_write_from_buffer(fdd->path, fdd->buffer, fdd->buffer_size)) {
+			log_error("[FDD] FAILED TO COMMIT OVERLAY: %s\n", fdd->overlay.path);
+			return;
+		}
+		overlay_discard(&fdd->overlay);
+		overlay_save(&fdd->overlay);
+		fdd->status.dirty = 0;
+		log_info("[FDD] COMMIT OVERLAY: %s -> %s\n", fdd->overlay.path, fdd->path);
+	}
+}
+void fdd_discard_overlay(FDD_DISK* fdd) {
+	if (fdd->status.inserted && fdd->overlay.enabled) {
+		overlay_discard(&fdd->overlay);
+		overlay_save(&fdd->overlay);
+		fdd->status.dirty = 0;
+		log_info("[FDD] DISCARD OVERLAY: %s\n", fdd->overlay.path);
+	}
+}
+
 uint8_t fdd_read_byte(FDD_DISK* fdd, size_t offset) {
 	if (fdd->status.inserted && offset < fdd->buffer_size) {
+		if (fdd->fat_dir.enabled) {
+			return fat_dir_read_byte(&fdd->fat_dir, &fdd->overlay, offset);
+		}
+		if (fdd->overlay.enabled) {
+			return overlay_read_byte(&fdd->overlay, fdd->buffer, offset);
+		}
 		return fdd->buffer[offset];
 	}
-	dbg_print("[FDD] Error: Out of bounds read. offset = %zx\n", offset);
+	log_error("[FDD] Error: Out of bounds read. offset = %zx\n", offset);
 	return 0xFF;
 }
-void fdd_write_byte(FDD_DISK* fdd, size_t offset, uint8_t value) {
+int fdd_write_byte(FDD_DISK* fdd, size_t offset, uint8_t value) {
 	if (fdd->status.inserted && offset < fdd->buffer_size) {
 		fdd->status.dirty = 1;
+		if (fdd->fat_dir.enabled) {
+			if (fat_dir_write_byte(&fdd->fat_dir, &fdd->overlay, offset, value)) {
+				log_error("[FDD] Error: could not write the overlay. offset = %zx\n", offset);
+				return 1;
+			}
+			return 0;
+		}
+		if (fdd->overlay.enabled) {
+			if (overlay_write_byte(&fdd->overlay, fdd->buffer, offset, value)) {
+				log_error("[FDD] Error: could not grow the overlay. offset = %zx\n", offset);
+				return 1;
+			}
+			return 0;
+		}
 		fdd->buffer[offset] = value;
-		return;
+		return 0;
 	}
-	dbg_print("[FDD] Error: Out of bounds write. offset = %zx\n", offset);
+	log_error("[FDD] Error: Out of bounds write. offset = %zx\n", offset);
+	return 1;
 }
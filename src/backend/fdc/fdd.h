@@ -9,6 +9,8 @@
 #include <stdint.h>
 
 #include "backend/utility/lba.h"
+#include "backend/utility/overlay.h"
+#include "backend/utility/fat_dir.h"
 
 #define FDD_INSERT_DISK_OK                 0
 #define FDD_INSERT_DISK_ERROR_DRIVE_LETTER 1
@@ -38,6 +40,8 @@ typedef struct FDD_DISK {
 	char* path;
 	uint8_t* buffer;
 	size_t buffer_size;
+	DISK_OVERLAY overlay; /* copy-on-write delta; buffer is the read-only base when enabled */
+	FAT_DIR fat_dir;      /* host directory; replaces buffer as the base when enabled */
 } FDD_DISK;
 
 int char_to_drive(char ch, uint8_t* disk);
@@ -51,8 +55,13 @@ void fdd_save_as_disk(FDD_DISK* fdd, const char* filename);
 void fdd_write_protect(FDD_DISK* fdd, uint8_t write_protect);
 
 uint8_t fdd_read_byte(FDD_DISK* fdd, size_t offset);
-void fdd_write_byte(FDD_DISK* fdd, size_t offset, uint8_t value);
+/* Returns: 0 if success. Otherwise 1; the write was lost */
+int fdd_write_byte(FDD_DISK* fdd, size_t offset, uint8_t value);
 
 int fdd_new_disk(FDD_DISK* fdd, size_t buffer_size);
 
+int fdd_attach_overlay(FDD_DISK* fdd, const char* file);
+void fdd_commit_overlay(FDD_DISK* fdd);
+void fdd_discard_overlay(FDD_DISK* fdd);
+
 #endif
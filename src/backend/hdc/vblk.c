@@ -0,0 +1,579 @@
+/* vblk.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Paravirtual Block Device
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <malloc.h>
+#include <string.h>
+
+#include "vblk.h"
+
+#include "backend/io/memory_map.h"
+#include "backend/utility/lba.h"
+
+#include "frontend/utility/file.h"
+
+#define LOG_CATEGORY LOG_CAT_HDC
+#include "backend/utility/log.h"
+
+#define VBLK_PATH_SIZE 256
+
+#define IVT_INT13      0x4C  /* 00:4C - INT 13h vector */
+#define BDA_HDD_STATUS 0x474 /* 40:74 - fixed disk status */
+#define BDA_HDD_COUNT  0x475 /* 40:75 - number of fixed disks */
+
+/* CHS translation for the legacy INT 13h functions */
+#define VBLK_HEADS         16
+#define VBLK_SECTORS       63
+#define VBLK_MAX_CYLINDERS 1024
+
+/* Option ROM offsets */
+#define ROM_INSTALL_PORT  0x06 /* mov dx, port + VBLK_PORT_COMMAND */
+#define ROM_CHAIN         0x10 /* previous INT 13h vector */
+#define ROM_HANDLER       0x18 /* INT 13h handler */
+#define ROM_DRIVE         0x1A /* cmp dl, drive */
+#define ROM_ADDRESS_PORT  0x40 /* mov dx, port + VBLK_PORT_ADDRESS0 */
+#define ROM_COMMAND_PORT  0x4C /* mov dx, port + VBLK_PORT_COMMAND */
+
+/* Option ROM; init at offset 3 asks the device to hook INT 13h. The handler chains
+   other drives; for its own drive it pushes the registers as a frame and hands the
+   frame address to the device, which services the request and sets CF in the
+   FLAGS pushed by the INT. */
+static const uint8_t vblk_rom[] = {
+	0x55, 0xAA, VBLK_ROM_SIZE / 512, /* option ROM signature, size in 512 byte blocks */
+
+	/* init: */
+	0x50,                         /* push ax                */
+	0x52,                         /* push dx                */
+	0xBA, 0x00, 0x00,             /* mov dx, port + COMMAND */
+	0xB0, VBLK_CMD_INSTALL,       /* mov al, CMD_INSTALL    */
+	0xEE,                         /* out dx, al             */
+	0x5A,                         /* pop dx                 */
+	0x58,                         /* pop ax                 */
+	0xCB,                         /* retf                   */
+	0x00, 0x00,
+
+	/* chain: */
+	0x00, 0x00, 0x00, 0x00,       /* dd previous INT 13h    */
+	0x00, 0x00, 0x00, 0x00,
+
+	/* int13: */
+	0x80, 0xFA, 0x80,             /* cmp dl, drive          */
+	0x74, 0x05,                   /* je frame               */
+	0x2E, 0xFF, 0x2E, 0x10, 0x00, /* jmp far [cs:chain]     */
+
+	/* frame: */
+	0x1E,                         /* push ds                */
+	0x06,                         /* push es                */
+	0x57,                         /* push di                */
+	0x56,                         /* push si                */
+	0x52,                         /* push dx                */
+	0x51,                         /* push cx                */
+	0x53,                         /* push bx                */
+	0x50,                         /* push ax                */
+	0x89, 0xE3,                   /* mov bx, sp             */
+	0x8C, 0xD0,                   /* mov ax, ss             */
+	0x89, 0xC2,                   /* mov dx, ax             */
+	0xB1, 0x04,                   /* mov cl, 4              */
+	0xD3, 0xE0,                   /* shl ax, cl             */
+	0xB1, 0x0C,                   /* mov cl, 12             */
+	0xD3, 0xEA,                   /* shr dx, cl             */
+	0x01, 0xD8,                   /* add ax, bx             */
+	0x80, 0xD2, 0x00,             /* adc dl, 0              */
+	0x88, 0xD3,                   /* mov bl, dl             */
+	0xBA, 0x00, 0x00,             /* mov dx, port + ADDRESS0 */
+	0xEE,                         /* out dx, al             */
+	0x42,                         /* inc dx                 */
+	0x88, 0xE0,                   /* mov al, ah             */
+	0xEE,                         /* out dx, al             */
+	0x42,                         /* inc dx                 */
+	0x88, 0xD8,                   /* mov al, bl             */
+	0xEE,                         /* out dx, al             */
+	0xBA, 0x00, 0x00,             /* mov dx, port + COMMAND */
+	0xB0, VBLK_CMD_INT13,         /* mov al, CMD_INT13      */
+	0xEE,                         /* out dx, al             */
+	0x58,                         /* pop ax                 */
+	0x5B,                         /* pop bx                 */
+	0x59,                         /* pop cx                 */
+	0x5A,                         /* pop dx                 */
+	0x5E,                         /* pop si                 */
+	0x5F,                         /* pop di                 */
+	0x07,                         /* pop es                 */
+	0x1F,                         /* pop ds                 */
+	0xCF,                         /* iret                   */
+};
+
+/* INT 13h register frame pushed by the option ROM, followed by the INT return frame */
+enum {
+	FRAME_AX, FRAME_BX, FRAME_CX, FRAME_DX, FRAME_SI, FRAME_DI, FRAME_ES, FRAME_DS,
+	FRAME_IP, FRAME_CS, FRAME_FLAGS,
+	FRAME_COUNT
+};
+
+#define FRAME_SIZE (FRAME_COUNT * 2)
+
+#define HI(x) (((x) >> 8) & 0xFF)
+#define LO(x) ((x) & 0xFF)
+#define SET_HI(x, v) ((x) = ((x) & 0x00FF) | ((uint16_t)(v) << 8))
+#define SET_LO(x, v) ((x) = ((x) & 0xFF00) | (uint8_t)(v))
+
+#define PHYSICAL(segment, offset) ((((uint32_t)(segment) << 4) + (offset)) & 0xFFFFF)
+
+static void read_guest(VBLK* vblk, uint32_t address, uint8_t* dest, uint32_t size) {
+	uint8_t* src = memory_map_get_range(vblk->map, address, size, 0);
+	if (src != NULL) {
+		memcpy(dest, src, size);
+		return;
+	}
+	for (uint32_t i = 0; i < size; ++i) {
+		dest[i] = memory_map_read_byte(vblk->map, (address + i) & 0xFFFFF);
+	}
+}
+static void write_guest(VBLK* vblk, uint32_t address, const uint8_t* src, uint32_t size) {
+	uint8_t* dest = memory_map_get_range(vblk->map, address, size, 1);
+	if (dest != NULL) {
+		memcpy(dest, src, size);
+		return;
+	}
+	for (uint32_t i = 0; i < size; ++i) {
+		memory_map_write_byte(vblk->map, (address + i) & 0xFFFFF, src[i]);
+	}
+}
+
+static uint16_t read_word(const uint8_t* buffer) {
+	return buffer[0] | (buffer[1] << 8);
+}
+static void write_word(uint8_t* buffer, uint16_t value) {
+	buffer[0] = value & 0xFF;
+	buffer[1] = (value >> 8) & 0xFF;
+}
+static uint32_t read_dword(const uint8_t* buffer) {
+	return read_word(buffer) | ((uint32_t)read_word(buffer + 2) << 16);
+}
+static void write_dword(uint8_t* buffer, uint32_t value) {
+	write_word(buffer, value & 0xFFFF);
+	write_word(buffer + 2, (value >> 16) & 0xFFFF);
+}
+static uint64_t read_qword(const uint8_t* buffer) {
+	return read_dword(buffer) | ((uint64_t)read_dword(buffer + 4) << 32);
+}
+static void write_qword(uint8_t* buffer, uint64_t value) {
+	write_dword(buffer, value & 0xFFFFFFFF);
+	write_dword(buffer + 4, (value >> 32) & 0xFFFFFFFF);
+}
+
+static uint8_t transfer(VBLK* vblk, uint8_t op, uint64_t lba, uint16_t count, uint32_t buffer, uint16_t* transferred) {
+	*transferred = 0;
+
+	if (!vblk->inserted) {
+		return VBLK_STATUS_NOT_READY;
+	}
+	if (lba >= vblk->sector_count || count > vblk->sector_count - lba) {
+		return VBLK_STATUS_SECTOR_NOT_FOUND;
+	}
+
+	/* The whole request is a single copy between the image and guest memory */
+	uint8_t* image = vblk->buffer + (lba * VBLK_SECTOR_SIZE);
+	uint32_t size = (uint32_t)count * VBLK_SECTOR_SIZE;
+
+	switch (op) {
+		case VBLK_OP_READ:
+			write_guest(vblk, buffer, image, size);
+			break;
+		case VBLK_OP_WRITE:
+			read_guest(vblk, buffer, image, size);
+			vblk->dirty = 1;
+			break;
+		case VBLK_OP_VERIFY:
+			break;
+		default:
+			return VBLK_STATUS_BAD_COMMAND;
+	}
+
+	*transferred = count;
+	return VBLK_STATUS_OK;
+}
+
+static void rom_checksum(uint8_t* rom) {
+	uint8_t sum = 0;
+	rom[VBLK_ROM_SIZE - 1] = 0;
+	for (uint32_t i = 0; i < VBLK_ROM_SIZE; ++i) {
+		sum += rom[i];
+	}
+	rom[VBLK_ROM_SIZE - 1] = (uint8_t)(0x100 - sum);
+}
+
+static void install(VBLK* vblk) {
+	if (vblk->rom_address == 0 || !vblk->inserted) {
+		vblk->status = VBLK_STATUS_NOT_READY;
+		return;
+	}
+
+	/* The ROM is write protected to the guest; patch it directly */
+	uint8_t* rom = vblk->map->mem + vblk->rom_address;
+
+	/* Chain the previous INT 13h handler */
+	uint8_t vector[4] = { 0 };
+	read_guest(vblk, IVT_INT13, vector, sizeof(vector));
+	memcpy(rom + ROM_CHAIN, vector, sizeof(vector));
+
+	/* Take the next fixed disk drive number */
+	uint8_t hdd_count = memory_map_read_byte(vblk->map, BDA_HDD_COUNT);
+	memory_map_write_byte(vblk->map, BDA_HDD_COUNT, hdd_count + 1);
+	vblk->drive = 0x80 + hdd_count;
+	rom[ROM_DRIVE] = vblk->drive;
+	rom_checksum(rom);
+
+	write_word(vector, ROM_HANDLER);
+	write_word(vector + 2, (vblk->rom_address >> 4) & 0xFFFF);
+	write_guest(vblk, IVT_INT13, vector, sizeof(vector));
+
+	vblk->status = VBLK_STATUS_OK;
+	log_info("[VBLK] INT 13h drive %02Xh; %llu sectors\n", vblk->drive, (unsigned long long)vblk->sector_count);
+}
+
+static void execute_descriptor(VBLK* vblk) {
+	uint8_t descriptor[sizeof(VBLK_DESCRIPTOR)] = { 0 };
+	read_guest(vblk, vblk->address, descriptor, sizeof(descriptor));
+
+	uint8_t op = descriptor[offsetof(VBLK_DESCRIPTOR, op)];
+	uint16_t count = read_word(descriptor + offsetof(VBLK_DESCRIPTOR, count));
+	uint32_t buffer = read_dword(descriptor + offsetof(VBLK_DESCRIPTOR, buffer)) & 0xFFFFF;
+	uint64_t lba = read_qword(descriptor + offsetof(VBLK_DESCRIPTOR, lba));
+
+	uint16_t transferred = 0;
+	vblk->status = transfer(vblk, op, lba, count, buffer, &transferred);
+
+	descriptor[offsetof(VBLK_DESCRIPTOR, status)] = vblk->status;
+	write_word(descriptor + offsetof(VBLK_DESCRIPTOR, count), transferred);
+	write_guest(vblk, vblk->address, descriptor, sizeof(descriptor));
+}
+
+static uint8_t int13_chs(VBLK* vblk, uint16_t* frame, uint8_t op) {
+	/* AL = count, CH = cylinder, CL = sector | cylinder b8,b9, DH = head, ES:BX = buffer */
+	uint16_t count = LO(frame[FRAME_AX]);
+	CHS chs = { 0 };
+	chs.c = HI(frame[FRAME_CX]) | ((LO(frame[FRAME_CX]) & 0xC0) << 2);
+	chs.h = HI(frame[FRAME_DX]);
+	chs.s = LO(frame[FRAME_CX]) & 0x3F;
+
+	SET_LO(frame[FRAME_AX], 0);
+
+	if (chs.s == 0 || chs.s > vblk->geometry.s || chs.h >= vblk->geometry.h || chs.c >= vblk->geometry.c) {
+		return VBLK_STATUS_SECTOR_NOT_FOUND;
+	}
+
+	uint16_t transferred = 0;
+	uint8_t status = transfer(vblk, op, chs_to_lba(vblk->geometry, chs), count, PHYSICAL(frame[FRAME_ES], frame[FRAME_BX]), &transferred);
+	SET_LO(frame[FRAME_AX], transferred);
+	return status;
+}
+
+static uint8_t int13_lba(VBLK* vblk, uint16_t* frame, uint8_t op) {
+	/* DS:SI = disk address packet */
+	uint8_t packet[16] = { 0 };
+	uint32_t address = PHYSICAL(frame[FRAME_DS], frame[FRAME_SI]);
+	read_guest(vblk, address, packet, sizeof(packet));
+
+	if (packet[0] < sizeof(packet)) {
+		return VBLK_STATUS_BAD_COMMAND;
+	}
+
+	uint16_t count = read_word(packet + 2);
+	uint32_t buffer = PHYSICAL(read_word(packet + 6), read_word(packet + 4));
+	uint64_t lba = read_qword(packet + 8);
+
+	uint16_t transferred = 0;
+	uint8_t status = transfer(vblk, op, lba, count, buffer, &transferred);
+
+	write_word(packet + 2, transferred);
+	write_guest(vblk, address, packet, sizeof(packet));
+	return status;
+}
+
+static uint8_t int13_get_ext_parameters(VBLK* vblk, uint16_t* frame) {
+	/* DS:SI = result buffer */
+	uint8_t params[0x1A] = { 0 };
+	uint32_t address = PHYSICAL(frame[FRAME_DS], frame[FRAME_SI]);
+	read_guest(vblk, address, params, 2);
+
+	if (read_word(params) < sizeof(params)) {
+		return VBLK_STATUS_BAD_COMMAND;
+	}
+
+	write_word(params + 0x00, sizeof(params));
+	write_word(params + 0x02, 0x0002); /* CHS information is valid */
+	write_dword(params + 0x04, vblk->geometry.c);
+	write_dword(params + 0x08, vblk->geometry.h);
+	write_dword(params + 0x0C, vblk->geometry.s);
+	write_qword(params + 0x10, vblk->sector_count);
+	write_word(params + 0x18, VBLK_SECTOR_SIZE);
+	write_guest(vblk, address, params, sizeof(params));
+	return VBLK_STATUS_OK;
+}
+
+static void execute_int13(VBLK* vblk) {
+	uint8_t buffer[FRAME_SIZE] = { 0 };
+	uint16_t frame[FRAME_COUNT] = { 0 };
+
+	read_guest(vblk, vblk->address, buffer, sizeof(buffer));
+	for (int i = 0; i < FRAME_COUNT; ++i) {
+		frame[i] = read_word(buffer + (i * 2));
+	}
+
+	uint8_t function = HI(frame[FRAME_AX]);
+	uint8_t status = VBLK_STATUS_OK;
+	uint8_t extended = 0; /* AH is a return value, not a status */
+
+	switch (function) {
+		case 0x00: /* reset */
+		case 0x0C: /* seek */
+		case 0x0D: /* alternate reset */
+		case 0x10: /* test drive ready */
+		case 0x11: /* recalibrate */
+			status = vblk->inserted ? VBLK_STATUS_OK : VBLK_STATUS_NOT_READY;
+			break;
+
+		case 0x01: /* get status of last operation */
+			status = vblk->status;
+			break;
+
+		case 0x02: /* read */
+			status = int13_chs(vblk, frame, VBLK_OP_READ);
+			break;
+		case 0x03: /* write */
+			status = int13_chs(vblk, frame, VBLK_OP_WRITE);
+			break;
+		case 0x04: /* verify */
+			status = int13_chs(vblk, frame, VBLK_OP_VERIFY);
+			break;
+
+		case 0x08: { /* get drive parameters */
+			if (!vblk->inserted) {
+				status = VBLK_STATUS_NOT_READY;
+				break;
+			}
+			uint16_t max_cylinder = vblk->geometry.c - 1;
+			SET_HI(frame[FRAME_CX], max_cylinder & 0xFF);
+			SET_LO(frame[FRAME_CX], ((max_cylinder >> 2) & 0xC0) | (vblk->geometry.s & 0x3F));
+			SET_HI(frame[FRAME_DX], vblk->geometry.h - 1);
+			SET_LO(frame[FRAME_DX], memory_map_read_byte(vblk->map, BDA_HDD_COUNT));
+			SET_LO(frame[FRAME_AX], 0);
+		} break;
+
+		case 0x15: /* get disk type */
+			if (!vblk->inserted) {
+				status = VBLK_STATUS_NOT_READY;
+				break;
+			}
+			/* AH = 03h fixed disk; CX:DX = sectors */
+			frame[FRAME_CX] = (vblk->sector_count >> 16) & 0xFFFF;
+			frame[FRAME_DX] = vblk->sector_count & 0xFFFF;
+			SET_HI(frame[FRAME_AX], 0x03);
+			extended = 1;
+			break;
+
+		case 0x41: /* extensions installation check */
+			if (frame[FRAME_BX] != 0x55AA) {
+				status = VBLK_STATUS_BAD_COMMAND;
+				break;
+			}
+			/* AH = 01h EDD 1.x, BX = AA55h, CX = 0001h fixed disk access subset */
+			frame[FRAME_BX] = 0xAA55;
+			frame[FRAME_CX] = 0x0001;
+			SET_HI(frame[FRAME_AX], 0x01);
+			extended = 1;
+			break;
+
+		case 0x42: /* extended read */
+			status = int13_lba(vblk, frame, VBLK_OP_READ);
+			break;
+		case 0x43: /* extended write */
+			status = int13_lba(vblk, frame, VBLK_OP_WRITE);
+			break;
+		case 0x44: /* extended verify */
+			status = int13_lba(vblk, frame, VBLK_OP_VERIFY);
+			break;
+
+		case 0x48: /* extended get drive parameters */
+			status = int13_get_ext_parameters(vblk, frame);
+			break;
+
+		default:
+			log_warn("[VBLK] Unsupported INT 13h function %02Xh\n", function);
+			status = VBLK_STATUS_BAD_COMMAND;
+			break;
+	}
+
+	/* AH = status, CF = error */
+	if (function != 0x01) {
+		vblk->status = status;
+	}
+	memory_map_write_byte(vblk->map, BDA_HDD_STATUS, vblk->status);
+	if (!extended) {
+		SET_HI(frame[FRAME_AX], status);
+	}
+
+	/* CF is returned through the FLAGS pushed by the INT; the ROM returns with IRET */
+	frame[FRAME_FLAGS] = (frame[FRAME_FLAGS] & ~0x0001) | (status != VBLK_STATUS_OK);
+
+	for (int i = 0; i < FRAME_COUNT; ++i) {
+		write_word(buffer + (i * 2), frame[i]);
+	}
+	write_guest(vblk, vblk->address, buffer, sizeof(buffer));
+}
+
+int vblk_create(VBLK* vblk) {
+	vblk->path = calloc(1, VBLK_PATH_SIZE);
+	if (vblk->path == NULL) {
+		log_error("[VBLK] Failed to allocate path buffer\n");
+		return 1;
+	}
+	vblk->buffer = NULL;
+	vblk->buffer_size = 0;
+	vblk->inserted = 0;
+	vblk->rom_address = 0;
+	return 0;
+}
+void vblk_destroy(VBLK* vblk) {
+	vblk_eject(vblk);
+	if (vblk->path != NULL) {
+		free(vblk->path);
+		vblk->path = NULL;
+	}
+}
+
+void vblk_init(VBLK* vblk, MEMORY_MAP* map) {
+	vblk->map = map;
+}
+
+void vblk_reset(VBLK* vblk) {
+	vblk->drive = 0;
+	vblk->status = VBLK_STATUS_OK;
+	vblk->address = 0;
+}
+
+uint8_t vblk_read_io_byte(VBLK* vblk, uint8_t address) {
+	switch (address) {
+		case VBLK_PORT_STATUS:
+			return vblk->status;
+		case VBLK_PORT_ADDRESS0:
+			return vblk->address & 0xFF;
+		case VBLK_PORT_ADDRESS1:
+			return (vblk->address >> 8) & 0xFF;
+		case VBLK_PORT_ADDRESS2:
+			return (vblk->address >> 16) & 0x0F;
+	}
+	return 0xFF;
+}
+void vblk_write_io_byte(VBLK* vblk, uint8_t address, uint8_t value) {
+	switch (address) {
+		case VBLK_PORT_COMMAND:
+			switch (value) {
+				case VBLK_CMD_INSTALL:
+					install(vblk);
+					break;
+				case VBLK_CMD_DESCRIPTOR:
+					execute_descriptor(vblk);
+					break;
+				case VBLK_CMD_INT13:
+					execute_int13(vblk);
+					break;
+				default:
+					log_warn("[VBLK] Unknown command %02X\n", value);
+					vblk->status = VBLK_STATUS_BAD_COMMAND;
+					break;
+			}
+			break;
+		case VBLK_PORT_ADDRESS0:
+			vblk->address = (vblk->address & 0xFFF00) | value;
+			break;
+		case VBLK_PORT_ADDRESS1:
+			vblk->address = (vblk->address & 0xF00FF) | (value << 8);
+			break;
+		case VBLK_PORT_ADDRESS2:
+			vblk->address = (vblk->address & 0x0FFFF) | ((value & 0x0F) << 16);
+			break;
+	}
+}
+
+int vblk_insert(VBLK* vblk, const char* path) {
+	if (vblk->inserted) {
+		vblk_eject(vblk);
+	}
+
+	if (file_read_alloc_buffer(path, &vblk->buffer, &vblk->buffer_size)) {
+		return 1;
+	}
+	if (vblk->path != path) {
+		strncpy_s(vblk->path, VBLK_PATH_SIZE, path, VBLK_PATH_SIZE - 1);
+	}
+
+	vblk->sector_count = vblk->buffer_size / VBLK_SECTOR_SIZE;
+	if (vblk->sector_count == 0) {
+		log_error("[VBLK] Image is smaller than a sector: %s\n", path);
+		vblk_eject(vblk);
+		return 1;
+	}
+
+	/* Legacy CHS functions see at most 1024 cylinders; the rest is reachable by LBA */
+	uint64_t cylinders = vblk->sector_count / (VBLK_HEADS * VBLK_SECTORS);
+	if (cylinders == 0) {
+		cylinders = 1;
+	}
+	if (cylinders > VBLK_MAX_CYLINDERS) {
+		cylinders = VBLK_MAX_CYLINDERS;
+	}
+	vblk->geometry.c = (uint16_t)cylinders;
+	vblk->geometry.h = VBLK_HEADS;
+	vblk->geometry.s = VBLK_SECTORS;
+
+	vblk->inserted = 1;
+	vblk->dirty = 0;
+	log_info("[VBLK] Inserted %s; %llu sectors, C=%d, H=%d, S=%d\n", path, (unsigned long long)vblk->sector_count, vblk->geometry.c, vblk->geometry.h, vblk->geometry.s);
+	return 0;
+}
+void vblk_eject(VBLK* vblk) {
+	if (vblk->buffer != NULL) {
+		free(vblk->buffer);
+		vblk->buffer = NULL;
+	}
+	vblk->buffer_size = 0;
+	vblk->sector_count = 0;
+	vblk->inserted = 0;
+	vblk->dirty = 0;
+}
+int vblk_save(VBLK* vblk) {
+	if (!vblk->inserted) {
+		return 1;
+	}
+	if (file_write_from_buffer(vblk->path, vblk->buffer, vblk->buffer_size)) {
+		return 1;
+	}
+	vblk->dirty = 0;
+	return 0;
+}
+
+int vblk_install_rom(VBLK* vblk, uint32_t rom_address, uint16_t port) {
+	if ((rom_address & (VBLK_ROM_SIZE - 1)) != 0 || rom_address < 0xC0000 || rom_address + VBLK_ROM_SIZE > 0xF6000) {
+		log_warn("[VBLK] Invalid option ROM address %05X\n", rom_address);
+		return 1;
+	}
+
+	uint8_t* rom = vblk->map->mem + rom_address;
+	if (rom[0] == 0x55 && rom[1] == 0xAA) {
+		log_warn("[VBLK] Warning: option ROM at %05X overwrites an existing ROM\n", rom_address);
+	}
+
+	memset(rom, 0, VBLK_ROM_SIZE);
+	memcpy(rom, vblk_rom, sizeof(vblk_rom));
+	write_word(rom + ROM_INSTALL_PORT, port + VBLK_PORT_COMMAND);
+	write_word(rom + ROM_ADDRESS_PORT, port + VBLK_PORT_ADDRESS0);
+	write_word(rom + ROM_COMMAND_PORT, port + VBLK_PORT_COMMAND);
+	rom_checksum(rom);
+
+	vblk->rom_address = rom_address;
+	return 0;
+}
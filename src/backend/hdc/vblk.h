@@ -0,0 +1,90 @@
+/* vblk.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Paravirtual Block Device
+ */
+
+#ifndef VBLK_H
+#define VBLK_H
+
+#include <stdint.h>
+
+#include "backend/utility/lba.h"
+
+typedef struct MEMORY_MAP MEMORY_MAP;
+
+#define VBLK_SECTOR_SIZE 512
+
+#define VBLK_ROM_ADDRESS 0xD0000 /* default option ROM address */
+#define VBLK_ROM_SIZE    0x800   /* option ROM size; 2K */
+
+/* I/O Port offsets */
+#define VBLK_PORT_COMMAND  0 // W  - Execute command
+#define VBLK_PORT_STATUS   0 // R  - Status of the last command
+#define VBLK_PORT_ADDRESS0 1 // RW - Descriptor address b0-b7
+#define VBLK_PORT_ADDRESS1 2 // RW - Descriptor address b8-b15
+#define VBLK_PORT_ADDRESS2 3 // RW - Descriptor address b16-b19
+
+/* Commands */
+#define VBLK_CMD_INSTALL    0x01 /* Option ROM init; hook INT 13h and assign a drive number */
+#define VBLK_CMD_DESCRIPTOR 0x02 /* Execute the descriptor at the descriptor address */
+#define VBLK_CMD_INT13      0x03 /* Execute the INT 13h register frame at the descriptor address */
+
+/* Descriptor operations */
+#define VBLK_OP_READ   0x01
+#define VBLK_OP_WRITE  0x02
+#define VBLK_OP_VERIFY 0x03
+
+/* Status; INT 13h status codes */
+#define VBLK_STATUS_OK               0x00
+#define VBLK_STATUS_BAD_COMMAND      0x01
+#define VBLK_STATUS_SECTOR_NOT_FOUND 0x04
+#define VBLK_STATUS_NOT_READY        0xAA
+
+/* Descriptor; lives in guest memory. */
+typedef struct VBLK_DESCRIPTOR {
+	uint8_t op;      /* VBLK_OP_XXX */
+	uint8_t status;  /* written by the device; VBLK_STATUS_XXX */
+	uint16_t count;  /* sectors to transfer; written by the device with the sectors transferred */
+	uint32_t buffer; /* guest-physical buffer address */
+	uint64_t lba;    /* start sector */
+} VBLK_DESCRIPTOR;
+
+typedef struct VBLK {
+	uint8_t inserted;
+	uint8_t dirty;
+	uint8_t drive;        /* INT 13h drive number assigned on install; 0 if not installed */
+	uint8_t status;       /* status of the last command */
+	uint32_t address;     /* descriptor address */
+	uint32_t rom_address; /* option ROM address; 0 if no option ROM */
+	CHS geometry;         /* CHS translation for the legacy INT 13h functions */
+	uint64_t sector_count;
+	char* path;
+	uint8_t* buffer;
+	size_t buffer_size;
+	MEMORY_MAP* map;
+} VBLK;
+
+int vblk_create(VBLK* vblk);
+void vblk_destroy(VBLK* vblk);
+void vblk_init(VBLK* vblk, MEMORY_MAP* map);
+void vblk_reset(VBLK* vblk);
+
+uint8_t vblk_read_io_byte(VBLK* vblk, uint8_t address);
+void vblk_write_io_byte(VBLK* vblk, uint8_t address, uint8_t value);
+
+/* Insert a raw disk image. Any size; sectors past the CHS translation are reachable through the LBA functions.
+	vblk: the vblk instance
+	path: the image path
+	Returns: 0 if success. Otherwise 1 */
+int vblk_insert(VBLK* vblk, const char* path);
+void vblk_eject(VBLK* vblk);
+int vblk_save(VBLK* vblk);
+
+/* Generate the option ROM into memory. The ROM hooks INT 13h for the drive number assigned on install
+	vblk: the vblk instance
+	rom_address: the ROM address; must be on a 2K boundary in the expansion ROM area
+	port: the base I/O port of the card
+	Returns: 0 if success. Otherwise 1 */
+int vblk_install_rom(VBLK* vblk, uint32_t rom_address, uint16_t port);
+
+#endif
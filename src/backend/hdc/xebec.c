@@ -16,14 +16,10 @@
 #include "backend/utility/ring_buffer.h"
 #include "backend/utility/lba.h"
 #include "backend/utility/vhd.h"
+#include "backend/utility/trace.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_HDC
+#include "backend/utility/log.h"
 
  /* I/O Port Addresses */
 
@@ -258,7 +254,7 @@ static void command_set(XEBEC_HDC* hdc, uint8_t command) {
 	}
 
 	if (!ring_buffer_is_empty(&hdc->data_register_out)) {
-		dbg_print("[XEBEC] Command started. OUT FIFO not empty!\n");
+		log_warn("[XEBEC] Command started. OUT FIFO not empty!\n");
 	}
 }
 static void command_set_parameter(XEBEC_HDC* hdc, uint8_t value) {
@@ -294,7 +290,7 @@ static void command_finalize(XEBEC_HDC* hdc, uint8_t send, uint8_t irq) {
 	}
 
 	if (!ring_buffer_is_empty(&hdc->data_register_in)) {
-		dbg_print("[XEBEC] Command finalized. IN FIFO not empty!\n");
+		log_warn("[XEBEC] Command finalized. IN FIFO not empty!\n");
 	}
 
 	command_reset(hdc);
@@ -303,7 +299,7 @@ static void command_finalize(XEBEC_HDC* hdc, uint8_t send, uint8_t irq) {
 /* Synchronous commands */
 static void cmd_reset(XEBEC_HDC* hdc) {
 	xebec_hdc_reset(hdc);
-	dbg_print("[XEBEC] reset\n");
+	log_debug("[XEBEC] reset\n");
 }
 static void cmd_test_drive(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -313,14 +309,14 @@ static void cmd_test_drive(XEBEC_HDC* hdc) {
 	/* BIOS issues a 1701 error if i send ERROR_READY_SIGNAL when theres no hard disk. */
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Test Drive\n");
+	log_debug("[XEBEC] Test Drive\n");
 }
 static void cmd_init_drive(XEBEC_HDC* hdc) {
 	ring_buffer_discard(&hdc->data_register_in, 13);
 
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Init drive\n");
+	log_debug("[XEBEC] Init drive\n");
 }
 
 static void cmd_recalibrate(XEBEC_HDC* hdc) {
@@ -334,7 +330,7 @@ static void cmd_recalibrate(XEBEC_HDC* hdc) {
 	/* BIOS issues a 1701 error if i send ERROR_READY_SIGNAL when theres no hard disk. */
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Recalibrate\n");
+	log_debug("[XEBEC] Recalibrate\n");
 }
 static void cmd_seek(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -353,7 +349,7 @@ static void cmd_seek(XEBEC_HDC* hdc) {
 	}
 
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Seek\n");
+	log_debug("[XEBEC] Seek\n");
 }
 
 static void cmd_sense(XEBEC_HDC* hdc) {
@@ -362,7 +358,7 @@ static void cmd_sense(XEBEC_HDC* hdc) {
 	hdc->hdd_select = dcb.drive_select;
 
 	command_finalize(hdc, SENSE, IRQ);
-	dbg_print("[XEBEC] Sense status\n");
+	log_debug("[XEBEC] Sense status\n");
 }
 
 static void cmd_format_drive(XEBEC_HDC* hdc) {
@@ -381,7 +377,7 @@ static void cmd_format_drive(XEBEC_HDC* hdc) {
 	}
 
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Format drive\n");
+	log_debug("[XEBEC] Format drive\n");
 }
 
 static void cmd_check_track(XEBEC_HDC* hdc) {
@@ -400,7 +396,7 @@ static void cmd_check_track(XEBEC_HDC* hdc) {
 	}
 
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Check track\n");
+	log_debug("[XEBEC] Check track\n");
 }
 static void cmd_format_track(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -418,7 +414,7 @@ static void cmd_format_track(XEBEC_HDC* hdc) {
 	}
 
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Format track\n");
+	log_debug("[XEBEC] Format track\n");
 }
 static void cmd_format_bad_track(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -436,7 +432,7 @@ static void cmd_format_bad_track(XEBEC_HDC* hdc) {
 	}
 
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Format bad track\n");
+	log_debug("[XEBEC] Format bad track\n");
 }
 
 static void cmd_read_ecc(XEBEC_HDC* hdc) {
@@ -444,7 +440,7 @@ static void cmd_read_ecc(XEBEC_HDC* hdc) {
 
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Read ECC\n");
+	log_debug("[XEBEC] Read ECC\n");
 }
 
 static void cmd_read(XEBEC_HDC* hdc) {
@@ -470,7 +466,7 @@ static void cmd_read(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Read data address=%x, size=%x, sector_count=%d\n", transfer_address, transfer_size, hdc->sector_count);
+	log_debug("[XEBEC] Read data address=%x, size=%x, sector_count=%d\n", transfer_address, transfer_size, hdc->sector_count);
 }
 static void cmd_write(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -495,7 +491,7 @@ static void cmd_write(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Write data address=%x, size=%x, sector_count=%d\n", transfer_address, transfer_size, hdc->sector_count);
+	log_debug("[XEBEC] Write data address=%x, size=%x, sector_count=%d\n", transfer_address, transfer_size, hdc->sector_count);
 }
 static void cmd_read_buffer(XEBEC_HDC* hdc) {
 	discard_dcb(hdc);
@@ -509,7 +505,7 @@ static void cmd_read_buffer(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Read buffer transfer_address=%x, size=%x\n", transfer_address, transfer_size);
+	log_debug("[XEBEC] Read buffer transfer_address=%x, size=%x\n", transfer_address, transfer_size);
 }
 static void cmd_write_buffer(XEBEC_HDC* hdc) {
 	discard_dcb(hdc);
@@ -523,7 +519,7 @@ static void cmd_write_buffer(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Write buffer transfer_address=%x, size=%x\n", transfer_address, transfer_size);
+	log_debug("[XEBEC] Write buffer transfer_address=%x, size=%x\n", transfer_address, transfer_size);
 }
 static void cmd_read_long(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -548,7 +544,7 @@ static void cmd_read_long(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Read long transfer_address=%x, size=%x\n", transfer_address, transfer_size);
+	log_debug("[XEBEC] Read long transfer_address=%x, size=%x\n", transfer_address, transfer_size);
 }
 static void cmd_write_long(XEBEC_HDC* hdc) {
 	XEBEC_DCB dcb = decode_dcb(hdc);
@@ -573,7 +569,7 @@ static void cmd_write_long(XEBEC_HDC* hdc) {
 
 	command_set_async(hdc);
 
-	dbg_print("[XEBEC] Write long transfer_address=%x, size=%x\n", transfer_address, transfer_size);
+	log_debug("[XEBEC] Write long transfer_address=%x, size=%x\n", transfer_address, transfer_size);
 }
 
 static void cmd_ram_diag(XEBEC_HDC* hdc) {
@@ -581,21 +577,21 @@ static void cmd_ram_diag(XEBEC_HDC* hdc) {
 
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Ram Diag\n");
+	log_debug("[XEBEC] Ram Diag\n");
 }
 static void cmd_drive_diag(XEBEC_HDC* hdc) {
 	discard_dcb(hdc);
 
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Drive Diag\n");
+	log_debug("[XEBEC] Drive Diag\n");
 }
 static void cmd_controller_diag(XEBEC_HDC* hdc) {
 	discard_dcb(hdc);
 
 	hdc->error = ERROR_OK;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Controller Diag\n");
+	log_debug("[XEBEC] Controller Diag\n");
 }
 
 static void cmd_nop(XEBEC_HDC* hdc) {
@@ -603,7 +599,7 @@ static void cmd_nop(XEBEC_HDC* hdc) {
 
 	hdc->error = ERROR_INVALID_COMMAND;
 	command_finalize(hdc, STATUS, IRQ);
-	dbg_print("[XEBEC] Invalid command\n");
+	log_warn("[XEBEC] Invalid command\n");
 }
 
 /* Asynchronous commands */
@@ -614,7 +610,7 @@ static void cmd_read_async(XEBEC_HDC* hdc) {
 			size_t offset = chs_to_offset(hdc->hdd[hdc->hdd_select].geometry->chs, hdc->hdd[hdc->hdd_select].chs, 512, hdc->byte_index);
 
 			if (hdc->byte_index == 0) {
-				dbg_print("[XEBEC] Read data (sector) HDD%d - c = %d, h = %d, s = %d\n",
+				log_debug("[XEBEC] Read data (sector) HDD%d - c = %d, h = %d, s = %d\n",
 					hdc->hdd_select, hdc->hdd[hdc->hdd_select].chs.c, hdc->hdd[hdc->hdd_select].chs.h, hdc->hdd[hdc->hdd_select].chs.s);
 			}
 			/* Read data from hdd */
@@ -640,15 +636,19 @@ static void cmd_write_async(XEBEC_HDC* hdc) {
 			size_t offset = chs_to_offset(hdc->hdd[hdc->hdd_select].geometry->chs, hdc->hdd[hdc->hdd_select].chs, 512, hdc->byte_index);
 
 			if (hdc->byte_index == 0) {
-				dbg_print("[XEBEC] Write data (sector) HDD%d - c = %d, h = %d, s = %d\n",
+				log_debug("[XEBEC] Write data (sector) HDD%d - c = %d, h = %d, s = %d\n",
 					hdc->hdd_select, hdc->hdd[hdc->hdd_select].chs.c, hdc->hdd[hdc->hdd_select].chs.h, hdc->hdd[hdc->hdd_select].chs.s);
 			}
 
 			/* Read data from dma */
 			uint8_t byte = i8237_dma_read_byte(hdc->dma_p, HDC_DMA);
 
-			/* Write data to fdd */
-			xebec_hdd_write_byte(&hdc->hdd[hdc->hdd_select], offset, byte);
+			/* Write data to hdd; the command fails if the write was lost */
+			if (xebec_hdd_write_byte(&hdc->hdd[hdc->hdd_select], offset, byte)) {
+				hdc->error = ERROR_WRITE_FAULT;
+				command_finalize(hdc, STATUS, IRQ);
+				return;
+			}
 
 			/* Advance byte index */
 			advance_byte_index(hdc);
@@ -812,7 +812,7 @@ static uint8_t read_data(XEBEC_HDC* hdc) {
 	return hdc->status_byte;
 }
 static uint8_t read_dipswitch(XEBEC_HDC* hdc) {
-	dbg_print("[XEBEC] read dipswitch\n");
+	log_debug("[XEBEC] read dipswitch\n");
 	return hdc->dipswitch;
 }
 static uint8_t read_status(XEBEC_HDC* hdc) {
@@ -843,18 +843,22 @@ static void select_controller(XEBEC_HDC* hdc, uint8_t value) {
 
 int xebec_hdc_create(XEBEC_HDC* hdc) {
 	if (ring_buffer_create(&hdc->data_register_out, 10)) {
-		dbg_print("[HDC] Failed to allocate data register out ring buffer\n");
+		log_error("[HDC] Failed to allocate data register out ring buffer\n");
 		return 1;
 	}
 	if (ring_buffer_create(&hdc->data_register_in, 18)) {
-		dbg_print("[HDC] Failed to allocate data register in ring buffer\n");
+		log_error("[HDC] Failed to allocate data register in ring buffer\n");
 		return 1;
 	}
 
 	for (uint8_t i = 0; i < HDD_MAX; ++i) {
 		hdc->hdd[i].path = calloc(1, 256);
 		if (hdc->hdd[i].path == NULL) {
-			dbg_print("[HDC] Failed to allocate path buffer\n");
+			log_error("[HDC] Failed to allocate path buffer\n");
+			return 1;
+		}
+		if (overlay_create(&hdc->hdd[i].overlay)) {
+			log_error("[HDC] Failed to allocate overlay\n");
 			return 1;
 		}
 	}
@@ -866,6 +870,8 @@ void xebec_hdc_destroy(XEBEC_HDC* hdc) {
 	ring_buffer_destroy(&hdc->data_register_in);
 
 	for (uint8_t i = 0; i < HDD_MAX; ++i) {
+		xebec_hdd_eject(&hdc->hdd[i]);
+		overlay_destroy(&hdc->hdd[i].overlay);
 		if (hdc->hdd[i].path != NULL) {
 			free(hdc->hdd[i].path);
 			hdc->hdd[i].path = NULL;
@@ -888,6 +894,37 @@ void xebec_hdc_reset(XEBEC_HDC* hdc) {
 	ring_buffer_reset(&hdc->data_register_out);
 }
 
+void xebec_hdc_save_state(XEBEC_HDC* hdc, XEBEC_HDC_STATE* state) {
+	state->hdd_select = hdc->hdd_select;
+	state->status_byte = hdc->status_byte;
+	state->status_register = hdc->status_register;
+	state->error = hdc->error;
+	state->int_enabled = hdc->int_enabled;
+	state->dma_enabled = hdc->dma_enabled;
+	state->command = hdc->command;
+	state->byte_index = hdc->byte_index;
+	state->sector_index = hdc->sector_index;
+	state->sector_count = hdc->sector_count;
+	ring_buffer_save_state(&hdc->data_register_out, &state->data_register_out);
+	ring_buffer_save_state(&hdc->data_register_in, &state->data_register_in);
+	state->accum = hdc->accum;
+}
+void xebec_hdc_load_state(XEBEC_HDC* hdc, const XEBEC_HDC_STATE* state) {
+	hdc->hdd_select = state->hdd_select;
+	hdc->status_byte = state->status_byte;
+	hdc->status_register = state->status_register;
+	hdc->error = state->error;
+	hdc->int_enabled = state->int_enabled;
+	hdc->dma_enabled = state->dma_enabled;
+	hdc->command = state->command;
+	hdc->byte_index = state->byte_index;
+	hdc->sector_index = state->sector_index;
+	hdc->sector_count = state->sector_count;
+	ring_buffer_load_state(&hdc->data_register_out, &state->data_register_out);
+	ring_buffer_load_state(&hdc->data_register_in, &state->data_register_in);
+	hdc->accum = state->accum;
+}
+
 uint8_t xebec_hdc_read_io_byte(XEBEC_HDC* hdc, uint8_t address) {
 	switch (address) {
 		case PORT_READ_DATA:
@@ -897,7 +934,7 @@ uint8_t xebec_hdc_read_io_byte(XEBEC_HDC* hdc, uint8_t address) {
 		case PORT_READ_STATUS:
 			return read_status(hdc);
 		default:
-			dbg_print("[XEBEC_HDC] read byte %x\n", address);
+			log_debug("[XEBEC_HDC] read byte %x\n", address);
 			break;
 	}
 	return 0;
@@ -917,14 +954,16 @@ void xebec_hdc_write_io_byte(XEBEC_HDC* hdc, uint8_t address, uint8_t value) {
 			write_mask(hdc, value);
 			break;
 		default:
-			dbg_print("[XEBEC_HDC] write byte %x\n", address);
+			log_debug("[XEBEC_HDC] write byte %x\n", address);
 			break;
 	}
 }
 
 void xebec_hdc_update(XEBEC_HDC* hdc) {
 	if (hdc->command.state == (COMMAND_STATE_EXECUTING | COMMAND_STATE_ASYNC)) {
+		TRACE_BEGIN(TRACE_CAT_DEVICE, "xebec_hdc_update");
 		command_execute_async(hdc);
+		TRACE_END(TRACE_CAT_DEVICE, "xebec_hdc_update");
 	}
 }
 
@@ -970,13 +1009,13 @@ int xebec_hdc_insert_hdd(XEBEC_HDC* hdc, int hdd, const char* path) {
 	}
 
 	if (xebec_hdd_insert(&hdc->hdd[hdd], path)) {
-		dbg_print("[XEBEC] Failed to Insert HDD%d: %s\n", hdd, path);
+		log_error("[XEBEC] Failed to Insert HDD%d: %s\n", hdd, path);
 		return 1;
 	}
 
 	xebec_hdc_set_dipswitch(hdc, hdd, hdc->hdd[hdd].geometry->type);
 
-	dbg_print("[XEBEC] Insert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+	log_info("[XEBEC] Insert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	return 0;
 }
 void xebec_hdc_eject_hdd(XEBEC_HDC* hdc, int hdd) {
@@ -988,7 +1027,7 @@ void xebec_hdc_eject_hdd(XEBEC_HDC* hdc, int hdd) {
 		return;
 	}
 
-	dbg_print("[XEBEC] Eject HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+	log_info("[XEBEC] Eject HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 
 	xebec_hdd_eject(&hdc->hdd[hdd]);
 }
@@ -1002,14 +1041,14 @@ int xebec_hdc_reinsert_hdd(XEBEC_HDC* hdc, int hdd) {
 	}
 
 	if (xebec_hdd_reinsert(&hdc->hdd[hdd])) {
-		dbg_print("[XEBEC] Failed to Reinsert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+		log_error("[XEBEC] Failed to Reinsert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 		return 1;
 	}
 
 	/* set dip (4 bits) */
 	xebec_hdc_set_dipswitch(hdc, hdd, hdc->hdd[hdd].geometry->type);
 
-	dbg_print("[XEBEC] Reinsert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+	log_info("[XEBEC] Reinsert HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	return 0;
 }
 
@@ -1023,10 +1062,10 @@ void xebec_hdc_save_hdd(XEBEC_HDC* hdc, int hdd) {
 	}
 
 	if (xebec_hdd_save(&hdc->hdd[hdd])) {
-		dbg_print("[XEBEC] Failed to save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+		log_error("[XEBEC] Failed to save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	}
 	else {
-		dbg_print("[XEBEC] Save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+		log_info("[XEBEC] Save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	}
 }
 void xebec_hdc_save_as_hdd(XEBEC_HDC* hdc, int hdd, const char* filename) {
@@ -1039,10 +1078,10 @@ void xebec_hdc_save_as_hdd(XEBEC_HDC* hdc, int hdd, const char* filename) {
 	}
 
 	if (xebec_hdd_save_as(&hdc->hdd[hdd], filename)) {
-		dbg_print("[XEBEC] Failed to save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+		log_error("[XEBEC] Failed to save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	}
 	else {
-		dbg_print("[XEBEC] Save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+		log_info("[XEBEC] Save HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	}
 }
 
@@ -1061,7 +1100,7 @@ int xebec_hdc_new_hdd(XEBEC_HDC* hdc, int hdd, CHS geometry, XEBEC_FILE_TYPE fil
 
 	xebec_hdc_set_dipswitch(hdc, hdd, hdc->hdd[hdd].geometry->type);
 
-	dbg_print("[XEBEC] New HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
+	log_info("[XEBEC] New HDD%d: %s\n", hdd, hdc->hdd[hdd].path);
 	return 0;
 }
 
@@ -1077,3 +1116,45 @@ int xebec_hdc_set_geometry_hdd(XEBEC_HDC* hdc, int hdd, CHS geometry) {
 	}
 	return xebec_hdd_set_geometry(&hdc->hdd[hdd], geometry);
 }
+
+int xebec_hdc_attach_overlay_hdd(XEBEC_HDC* hdc, int hdd, const char* path) {
+	if (hdd > 1) {
+		return 1;
+	}
+
+	if (!hdc->hdd[hdd].inserted) {
+		return 1;
+	}
+
+	if (xebec_hdd_attach_overlay(&hdc->hdd[hdd], path)) {
+		log_error("[XEBEC] Failed to attach overlay HDD%d: %s\n", hdd, path);
+		return 1;
+	}
+
+	log_info("[XEBEC] Attach overlay HDD%d: %s\n", hdd, hdc->hdd[hdd].overlay.path);
+	return 0;
+}
+void xebec_hdc_commit_overlay_hdd(XEBEC_HDC* hdc, int hdd) {
+	if (hdd > 1) {
+		return;
+	}
+
+	if (xebec_hdd_commit_overlay(&hdc->hdd[hdd])) {
+		log_error("[XEBEC] Failed to commit overlay HDD%d: %s\n", hdd, hdc->hdd[hdd].overlay.path);
+	}
+	else {
+		log_info("[XEBEC] Commit overlay HDD%d: %s -> %s\n", hdd, hdc->hdd[hdd].overlay.path, hdc->hdd[hdd].path);
+	}
+}
+void xebec_hdc_discard_overlay_hdd(XEBEC_HDC* hdc, int hdd) {
+	if (hdd > 1) {
+		return;
+	}
+
+	if (xebec_hdd_discard_overlay(&hdc->hdd[hdd])) {
+		log_error("[XEBEC] Failed to discard overlay HDD%d: %s\n", hdd, hdc->hdd[hdd].overlay.path);
+	}
+	else {
+		log_info("[XEBEC] Discard overlay HDD%d: %s\n", hdd, hdc->hdd[hdd].overlay.path);
+	}
+}
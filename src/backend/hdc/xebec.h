@@ -62,6 +62,23 @@ typedef struct XEBEC_HDC {
 	uint64_t accum;
 } XEBEC_HDC;
 
+/* Controller state for a snapshot; the disks in the drives are not part of it */
+typedef struct XEBEC_HDC_STATE {
+	uint8_t hdd_select;
+	uint8_t status_byte;
+	uint8_t status_register;
+	uint8_t error;
+	uint8_t int_enabled;
+	uint8_t dma_enabled;
+	XEBEC_HDC_COMMAND command;
+	uint32_t byte_index;
+	uint32_t sector_index;
+	uint32_t sector_count;
+	RING_BUFFER_STATE data_register_out;
+	RING_BUFFER_STATE data_register_in;
+	uint64_t accum;
+} XEBEC_HDC_STATE;
+
 int xebec_hdc_create(XEBEC_HDC* hdc);
 void xebec_hdc_destroy(XEBEC_HDC* hdc);
 void xebec_hdc_init(XEBEC_HDC* hdc, I8237_DMA* dma, I8259_PIC* pic);
@@ -71,6 +88,9 @@ uint8_t xebec_hdc_read_io_byte(XEBEC_HDC* hdc, uint8_t address);
 void xebec_hdc_write_io_byte(XEBEC_HDC* hdc, uint8_t address, uint8_t value);
 void xebec_hdc_update(XEBEC_HDC* hdc);
 
+void xebec_hdc_save_state(XEBEC_HDC* hdc, XEBEC_HDC_STATE* state);
+void xebec_hdc_load_state(XEBEC_HDC* hdc, const XEBEC_HDC_STATE* state);
+
 int xebec_hdc_insert_hdd(XEBEC_HDC* hdc, int hdd, const char* path);
 void xebec_hdc_eject_hdd(XEBEC_HDC* hdc, int hdd);
 int xebec_hdc_reinsert_hdd(XEBEC_HDC* hdc, int hdd);
@@ -80,5 +100,8 @@ int xebec_hdc_new_hdd(XEBEC_HDC* hdc, int hdd, CHS geometry, XEBEC_FILE_TYPE fil
 void xebec_hdc_set_geometry_override_hdd(XEBEC_HDC* hdc, int hdd, CHS geometry, XEBEC_HDD_TYPE type);
 int xebec_hdc_set_geometry_hdd(XEBEC_HDC* hdc, int hdd, CHS geometry);
 void xebec_hdc_set_dipswitch(XEBEC_HDC* hdc, int hdd, uint8_t type);
+int xebec_hdc_attach_overlay_hdd(XEBEC_HDC* hdc, int hdd, const char* path);
+void xebec_hdc_commit_overlay_hdd(XEBEC_HDC* hdc, int hdd);
+void xebec_hdc_discard_overlay_hdd(XEBEC_HDC* hdc, int hdd);
 
 #endif
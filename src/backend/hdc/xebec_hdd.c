@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <malloc.h>
 #include <string.h>
+#include <stdio.h>
 
 #include "xebec_hdd.h"
 
@@ -13,13 +14,8 @@
 #include "backend/utility/lba.h"
 #include "backend/utility/vhd.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_HDC
+#include "backend/utility/log.h"
 
 const XEBEC_HDD_GEOMETRY xebec_hdd_geometry[] = {
 	{ .chs = { .c = 0,   .h = 0, .s = 0  }, XEBEC_HDD_TYPE_NONE, "None"                    },
@@ -39,11 +35,12 @@ int xebec_hdd_set_geometry(XEBEC_HDD* hdd, CHS geometry) {
 
 		switch (hdd->file_type) {
 			case XEBEC_FILE_TYPE_VHD:
+			case XEBEC_FILE_TYPE_VHD_DYNAMIC:
 				if (xebec_hdd_geometry[i].chs.c == geometry.c &&
 					xebec_hdd_geometry[i].chs.h == geometry.h &&
 					xebec_hdd_geometry[i].chs.s == geometry.s) {
 					hdd->geometry = &xebec_hdd_geometry[i];
-					dbg_print("[XEBEC] HDD File Type=VHD, C=%d, H=%d, S=%d, %s\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
+					log_info("[XEBEC] HDD File Type=VHD, C=%d, H=%d, S=%d, %s\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
 					return 0;
 				}
 				break;
@@ -54,26 +51,26 @@ int xebec_hdd_set_geometry(XEBEC_HDD* hdd, CHS geometry) {
 						xebec_hdd_geometry[i].chs.s == hdd->override_geometry.chs.s) {
 						hdd->geometry = &xebec_hdd_geometry[i];
 						hdd->override_geometry.type = xebec_hdd_geometry[i].type;
-						dbg_print("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s A\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
+						log_info("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s A\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
 						return 0;
 					}
 				}
 				else if (hdd->override_geometry.type != XEBEC_HDD_TYPE_NONE) {
 					if (xebec_hdd_geometry[i].type == hdd->override_geometry.type) {
 						hdd->geometry = &xebec_hdd_geometry[i];
-						dbg_print("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s B\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
+						log_info("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s B\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
 						return 0;
 					}
 				}
 				else if (chs_get_total_byte_count(xebec_hdd_geometry[i].chs, 512) == hdd->file_size) {
 					hdd->geometry = &xebec_hdd_geometry[i];
 					hdd->override_geometry.type = xebec_hdd_geometry[i].type;
-					dbg_print("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s C\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
+					log_info("[XEBEC] HDD File Type=RAW, C=%d, H=%d, S=%d, %s C\n", hdd->geometry->chs.c, hdd->geometry->chs.h, hdd->geometry->chs.s, hdd->geometry->name);
 					match_count++;
 				}
 				break;
 			default:
-				dbg_print("[XEBEC] Unknown HDD File Type, cannot determine geometry\n");
+				log_warn("[XEBEC] Unknown HDD File Type, cannot determine geometry\n");
 				break;
 		}
 	}
@@ -82,10 +79,10 @@ int xebec_hdd_set_geometry(XEBEC_HDD* hdd, CHS geometry) {
 		return 0;
 	}
 	else if (match_count > 1) {
-		dbg_print("[XEBEC] Ambiguous HDD RAW size, cannot determine geometry\n");
+		log_warn("[XEBEC] Ambiguous HDD RAW size, cannot determine geometry\n");
 	}
 	else {
-		dbg_print("[XEBEC] Unknown HDD geometry: C=%d, H=%d, S=%d\n", geometry.c, geometry.h, geometry.s);
+		log_warn("[XEBEC] Unknown HDD geometry: C=%d, H=%d, S=%d\n", geometry.c, geometry.h, geometry.s);
 	}
 
 	hdd->geometry = &xebec_hdd_geometry[0];
@@ -100,8 +97,10 @@ void xebec_hdd_set_geometry_override(XEBEC_HDD* hdd, CHS geometry, XEBEC_HDD_TYP
 }
 
 static void set_file_type(XEBEC_HDD* hdd, XEBEC_FILE_TYPE type) {
+	hdd->buffer_capacity = hdd->buffer_size;
 	switch (type) {
 		case XEBEC_FILE_TYPE_VHD:
+		case XEBEC_FILE_TYPE_VHD_DYNAMIC:
 			hdd->file_size = vhd_get_file_size(hdd->buffer, hdd->buffer_size);
 			hdd->file_type = type;
 			break;
@@ -145,15 +144,19 @@ static void reset_hdd_keep_path_and_overrides(XEBEC_HDD* hdd) {
 			hdd->buffer = NULL;
 		}
 		hdd->buffer_size = 0;
+		hdd->buffer_capacity = 0;
 		hdd->inserted = 0;
 		hdd->dirty = 0;
 		hdd->geometry = &xebec_hdd_geometry[0];
+		fat_dir_close(&hdd->fat_dir);
+		overlay_detach(&hdd->overlay);
 	}
 }
 static void reset_hdd(XEBEC_HDD* hdd) {
 	if (hdd != NULL) {
 		reset_hdd_keep_path_and_overrides(hdd);
 		hdd->path[0] = '\0';
+		hdd->overlay.path[0] = '\0';
 		chs_reset(&hdd->override_geometry.chs);
 		hdd->override_geometry.type = XEBEC_HDD_TYPE_NONE;
 		set_file_type(hdd, XEBEC_FILE_TYPE_NONE);
@@ -172,14 +175,65 @@ static int insert_hdd(XEBEC_HDD* hdd, CHS geometry) {
 	return 0;
 }
 
+static int insert_directory(XEBEC_HDD* hdd) {
+	if (fat_dir_open(&hdd->fat_dir, hdd->path)) {
+		return 1;
+	}
+
+	/* Smallest drive type the files fit on; or the type override */
+	const XEBEC_HDD_GEOMETRY* geometry = NULL;
+	for (uint32_t i = 1; i < xebec_hdd_geometry_count; ++i) {
+		if (hdd->override_geometry.type != XEBEC_HDD_TYPE_NONE && hdd->override_geometry.type != xebec_hdd_geometry[i].type) {
+			continue;
+		}
+		if (fat_dir_format(&hdd->fat_dir, xebec_hdd_geometry[i].chs, 1) == 0) {
+			geometry = &xebec_hdd_geometry[i];
+			break;
+		}
+	}
+
+	if (geometry == NULL) {
+		log_error("[XEBEC] Directory does not fit on a hard disk: %s\n", hdd->path);
+		reset_hdd(hdd);
+		return 1;
+	}
+
+	/* The volume has no buffer; sectors are synthesized from the directory */
+	hdd->buffer = NULL;
+	hdd->buffer_size = chs_get_total_byte_count(geometry->chs, 512);
+	hdd->override_geometry.type = geometry->type;
+	set_file_type(hdd, XEBEC_FILE_TYPE_RAW);
+
+	int result = insert_hdd(hdd, geometry->chs);
+	if (result != 0) {
+		reset_hdd(hdd);
+		return result;
+	}
+
+	/* Host files are never written; guest writes are kept in the overlay */
+	if (overlay_attach(&hdd->overlay, "", hdd->file_size)) {
+		reset_hdd(hdd);
+		return 1;
+	}
+
+	return 0;
+}
+
 int xebec_hdd_insert(XEBEC_HDD* hdd, const char* filename) {
 	if (hdd->inserted) {
 		return 1;
 	}
 
+	if (file_is_directory(filename != NULL ? filename : hdd->path)) {
+		if (filename != NULL) {
+			strncpy_s(hdd->path, HDD_NAME_SIZE, filename, HDD_NAME_SIZE - 1);
+		}
+		return insert_directory(hdd);
+	}
+
 	if (filename == NULL) {
 		if (hdd->path == NULL || hdd->path[0] == '\0') {
-			dbg_print("[XEBEC] Invalid filename on insert\n");
+			log_warn("[XEBEC] Invalid filename on insert\n");
 			return 1;
 		}
 
@@ -201,16 +255,19 @@ int xebec_hdd_insert(XEBEC_HDD* hdd, const char* filename) {
 	switch (type) {
 		case XEBEC_FILE_TYPE_VHD:
 			if (vhd_verify(hdd->buffer, hdd->buffer_size)) {
-				dbg_print("[XEBEC] Invalid VHD\n");
+				log_warn("[XEBEC] Invalid VHD\n");
 				return 1;
 			}
 			chs_set(&vhd_geometry, vhd_get_geometry(hdd->buffer, hdd->buffer_size));
+			if (vhd_is_dynamic(hdd->buffer, hdd->buffer_size)) {
+				type = XEBEC_FILE_TYPE_VHD_DYNAMIC;
+			}
 			break;
 		case XEBEC_FILE_TYPE_RAW:
 			/* geometry is set by the file size or overrides */
 			break;
 		default:
-			dbg_print("[XEBEC] Unknown file type\n");
+			log_warn("[XEBEC] Unknown file type\n");
 			return 1;
 	}
 	
@@ -229,11 +286,19 @@ int xebec_hdd_reinsert(XEBEC_HDD* hdd) {
 		return 1;
 	}
 
+	/* A host directory always has a memory overlay; only reattach a delta file */
+	uint8_t has_overlay = hdd->overlay.enabled && hdd->overlay.path[0] != '\0';
+
 	reset_hdd_keep_path_and_overrides(hdd);
 	if (xebec_hdd_insert(hdd, NULL)) {
 		return 1;
 	}
 
+	/* Reattach the delta on top of the reloaded base image */
+	if (has_overlay) {
+		xebec_hdd_attach_overlay(hdd, hdd->overlay.path);
+	}
+
 	return 0;
 }
 
@@ -248,10 +313,23 @@ int xebec_hdd_save(XEBEC_HDD* hdd) {
 		return 1;
 	}
 
-	if (file_write_from_buffer(hdd->path, hdd->buffer, hdd->buffer_size)) {
+	if (hdd->fat_dir.enabled && hdd->overlay.path[0] == '\0') {
+		log_warn("[XEBEC] Host directory is read-only. Use save as to write an image\n");
 		return 1;
 	}
 
+	if (hdd->overlay.enabled) {
+		/* Base image is read-only; save the delta */
+		if (overlay_save(&hdd->overlay)) {
+			return 1;
+		}
+	}
+	else {
+		if (file_write_from_buffer(hdd->path, hdd->buffer, hdd->buffer_size)) {
+			return 1;
+		}
+	}
+
 	hdd->dirty = 0;
 	return 0;
 }
@@ -260,6 +338,24 @@ int xebec_hdd_save_as(XEBEC_HDD* hdd, const char* filename) {
 		return 1;
 	}
 
+	if (hdd->fat_dir.enabled) {
+		/* Synthesize the whole volume; the disk becomes a plain image */
+		hdd->buffer = malloc(hdd->buffer_size);
+		if (hdd->buffer == NULL) {
+			log_error("[XEBEC] Error: could not alloc memory for hdd\n");
+			return 1;
+		}
+		hdd->buffer_capacity = hdd->buffer_size;
+		fat_dir_read(&hdd->fat_dir, hdd->buffer, hdd->buffer_size);
+		fat_dir_close(&hdd->fat_dir);
+	}
+
+	if (hdd->overlay.enabled) {
+		/* Flatten base + delta into a standalone image */
+		overlay_apply(&hdd->overlay, hdd->buffer, hdd->file_size);
+		overlay_detach(&hdd->overlay);
+	}
+
 	strncpy_s(hdd->path, HDD_NAME_SIZE, filename, HDD_NAME_SIZE - 1);
 	return xebec_hdd_save(hdd);
 }
@@ -272,22 +368,30 @@ int xebec_hdd_new(XEBEC_HDD* hdd, CHS geometry, XEBEC_FILE_TYPE file_type) {
 	switch (file_type) {
 		case XEBEC_FILE_TYPE_VHD:
 			if (vhd_create(geometry, &hdd->buffer, &hdd->buffer_size)) {
-				dbg_print("[XEBEC] Error: could not create vhd for new hdd\n");
+				log_error("[XEBEC] Error: could not create vhd for new hdd\n");
 				return 1;
 			}
 			sprintf(hdd->path, "hdd_%zuMB.vhd", vhd_get_file_size(hdd->buffer, hdd->buffer_size) / 1024 / 1024);
 			break;
 
+		case XEBEC_FILE_TYPE_VHD_DYNAMIC:
+			if (vhd_create_dynamic(geometry, &hdd->buffer, &hdd->buffer_size)) {
+				log_error("[XEBEC] Error: could not create dynamic vhd for new hdd\n");
+				return 1;
+			}
+			sprintf(hdd->path, "hdd_%zuMB_dyn.vhd", vhd_get_file_size(hdd->buffer, hdd->buffer_size) / 1024 / 1024);
+			break;
+
 		case XEBEC_FILE_TYPE_RAW:
 			if (hdd_create_raw(geometry, &hdd->buffer, &hdd->buffer_size)) {
-				dbg_print("[XEBEC] Error: could not create raw for new hdd\n");
+				log_error("[XEBEC] Error: could not create raw for new hdd\n");
 				return 1;
 			}
 			sprintf(hdd->path, "hdd_%zuMB.img", hdd->buffer_size / 1024 / 1024);
 			break;
 
 		default:
-			dbg_print("[XEBEC] Error: unknown file type\n");
+			log_error("[XEBEC] Error: unknown file type\n");
 			break;
 	}
 
@@ -304,26 +408,116 @@ int xebec_hdd_new(XEBEC_HDD* hdd, CHS geometry, XEBEC_FILE_TYPE file_type) {
 	return 0;
 }
 
+int xebec_hdd_attach_overlay(XEBEC_HDD* hdd, const char* filename) {
+	if (!hdd->inserted) {
+		return 1;
+	}
+
+	/* The overlay reads the base image flat; a dynamic VHD is not */
+	if (hdd->file_type == XEBEC_FILE_TYPE_VHD_DYNAMIC) {
+		log_warn("[XEBEC] Overlays are not supported on dynamic VHDs\n");
+		return 1;
+	}
+
+	/* The delta covers the disk data only; VHD footer stays in the base image */
+	if (overlay_attach(&hdd->overlay, filename, hdd->file_size)) {
+		return 1;
+	}
+
+	hdd->dirty = 0;
+	return 0;
+}
+int xebec_hdd_commit_overlay(XEBEC_HDD* hdd) {
+	if (!hdd->inserted || !hdd->overlay.enabled) {
+		return 1;
+	}
+
+	if (hdd->fat_dir.enabled) {
+		log_warn("[XEBEC] Host directory is read-only\n");
+		return 1;
+	}
+
+	/* Merge the delta into the base image and write it back */
+	overlay_apply(&hdd->overlay, hdd->buffer, hdd->file_size);
+	if (file_write_from_buffer(hdd->path, hdd->buffer, hdd->buffer_size)) {
+		return 1;
+	}
+
+	overlay_discard(&hdd->overlay);
+	overlay_save(&hdd->overlay);
+	hdd->dirty = 0;
+	return 0;
+}
+int xebec_hdd_discard_overlay(XEBEC_HDD* hdd) {
+	if (!hdd->inserted || !hdd->overlay.enabled) {
+		return 1;
+	}
+
+	overlay_discard(&hdd->overlay);
+	overlay_save(&hdd->overlay);
+	hdd->dirty = 0;
+	return 0;
+}
+
 uint8_t xebec_hdd_read_byte(XEBEC_HDD* hdd, size_t offset) {
 	if (!hdd->inserted) {
 		return 0xFF;
 	}
 	if (offset >= hdd->file_size) {
-		dbg_print("[XEBEC] Error: Out of bounds read. offset = %zx\n", offset);
+		log_error("[XEBEC] Error: Out of bounds read. offset = %zx\n", offset);
 		return 0xFF;
 	}
 
+	if (hdd->fat_dir.enabled) {
+		return fat_dir_read_byte(&hdd->fat_dir, &hdd->overlay, offset);
+	}
+
+	if (hdd->overlay.enabled) {
+		return overlay_read_byte(&hdd->overlay, hdd->buffer, offset);
+	}
+
+	if (hdd->file_type == XEBEC_FILE_TYPE_VHD_DYNAMIC) {
+		return vhd_read_byte(hdd->buffer, hdd->buffer_size, offset);
+	}
+
 	return hdd->buffer[offset];
 }
-void xebec_hdd_write_byte(XEBEC_HDD* hdd, size_t offset, uint8_t value) {
+int xebec_hdd_write_byte(XEBEC_HDD* hdd, size_t offset, uint8_t value) {
 	if (!hdd->inserted) {
-		return;
+		return 1;
 	}
 	if (offset >= hdd->file_size) {
-		dbg_print("[XEBEC] Error: Out of bounds write. offset = %zx\n", offset);
-		return;
+		log_error("[XEBEC] Error: Out of bounds write. offset = %zx\n", offset);
+		return 1;
 	}
 
 	hdd->dirty = 1;
+
+	if (hdd->fat_dir.enabled) {
+		if (fat_dir_write_byte(&hdd->fat_dir, &hdd->overlay, offset, value)) {
+			log_error("[XEBEC] Error: could not write the overlay. offset = %zx\n", offset);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (hdd->overlay.enabled) {
+		if (overlay_write_byte(&hdd->overlay, hdd->buffer, offset, value)) {
+			log_error("[XEBEC] Error: could not grow the overlay. offset = %zx\n", offset);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (hdd->file_type == XEBEC_FILE_TYPE_VHD_DYNAMIC) {
+		/* May allocate a new block and move the buffer */
+		if (vhd_write_byte(&hdd->buffer, &hdd->buffer_size, &hdd->buffer_capacity, offset, value)) {
+			log_error("[XEBEC] Error: could not allocate vhd block. offset = %zx\n", offset);
+			return 1;
+		}
+		return 0;
+	}
+
 	hdd->buffer[offset] = value;
+	return 0;
 }
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 #include "backend/utility/lba.h"
+#include "backend/utility/overlay.h"
+#include "backend/utility/fat_dir.h"
 
 typedef enum XEBEC_HDD_TYPE {
 	XEBEC_HDD_TYPE_NONE,
@@ -21,6 +23,7 @@ typedef enum XEBEC_FILE_TYPE {
 	XEBEC_FILE_TYPE_NONE,
 	XEBEC_FILE_TYPE_VHD,
 	XEBEC_FILE_TYPE_RAW,
+	XEBEC_FILE_TYPE_VHD_DYNAMIC, /* sparse; disk data is resolved through the BAT */
 } XEBEC_FILE_TYPE;
 
 typedef struct XEBEC_HDD_GEOMETRY {
@@ -40,6 +43,9 @@ typedef struct XEBEC_HDD {
 	char* path;
 	uint8_t* buffer;
 	size_t buffer_size;
+	size_t buffer_capacity; /* allocated size of buffer; a dynamic vhd grows into it */
+	DISK_OVERLAY overlay; /* copy-on-write delta; buffer is the read-only base when enabled */
+	FAT_DIR fat_dir;      /* host directory; replaces buffer as the base when enabled */
 } XEBEC_HDD;
 
 extern const XEBEC_HDD_GEOMETRY xebec_hdd_geometry[];
@@ -55,10 +61,15 @@ int xebec_hdd_save_as(XEBEC_HDD* hdd, const char* filename);
 
 int xebec_hdd_new(XEBEC_HDD* hdd, CHS geometry, XEBEC_FILE_TYPE file_type);
 
+int xebec_hdd_attach_overlay(XEBEC_HDD* hdd, const char* filename);
+int xebec_hdd_commit_overlay(XEBEC_HDD* hdd);
+int xebec_hdd_discard_overlay(XEBEC_HDD* hdd);
+
 void xebec_hdd_set_geometry_override(XEBEC_HDD* hdd, CHS geometry, XEBEC_HDD_TYPE type);
 int xebec_hdd_set_geometry(XEBEC_HDD* hdd, CHS geometry);
 
 uint8_t xebec_hdd_read_byte(XEBEC_HDD* hdd, size_t offset);
-void xebec_hdd_write_byte(XEBEC_HDD* hdd, size_t offset, uint8_t value);
+/* Returns: 0 if success. Otherwise 1; the write was lost */
+int xebec_hdd_write_byte(XEBEC_HDD* hdd, size_t offset, uint8_t value);
 
 #endif
@@ -0,0 +1,96 @@
+/* heatmap.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Memory heatmap; reads, writes and executes counted per 256 byte block of the 1MB address space, decayed over time
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "heatmap.h"
+
+/* An access is one increment of the decayed count. The totals catch up at each decay */
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "utility/log.h"
+
+void heatmap_create(HEATMAP* heatmap, double clock_hz) {
+	memset(heatmap, 0, sizeof(HEATMAP));
+	heatmap->decay_cycles = (uint64_t)(clock_hz / HEATMAP_DECAY_HZ);
+	heatmap->next_decay = heatmap->decay_cycles;
+	heatmap->enabled = 1;
+}
+void heatmap_destroy(HEATMAP* heatmap) {
+	heatmap->enabled = 0;
+}
+
+static void add_totals(HEATMAP* heatmap) {
+	for (int kind = 0; kind < HEATMAP_KINDS; ++kind) {
+		for (int i = 0; i < HEATMAP_BLOCKS; ++i) {
+			heatmap->totals[kind][i] += heatmap->counts[kind][i] - heatmap->base[kind][i];
+			heatmap->base[kind][i] = heatmap->counts[kind][i];
+		}
+	}
+}
+
+static void decay(HEATMAP* heatmap) {
+	add_totals(heatmap);
+	for (int kind = 0; kind < HEATMAP_KINDS; ++kind) {
+		for (int i = 0; i < HEATMAP_BLOCKS; ++i) {
+			uint32_t count = heatmap->counts[kind][i];
+			count -= count >> HEATMAP_DECAY_SHIFT;
+			if (count < (1 << HEATMAP_DECAY_SHIFT)) {
+				count = (count != 0) ? count - 1 : 0; /* the shift alone never reaches 0 */
+			}
+			heatmap->counts[kind][i] = count;
+			heatmap->base[kind][i] = count;
+		}
+	}
+}
+
+void heatmap_update(HEATMAP* heatmap, uint64_t cycles) {
+	if (cycles + heatmap->decay_cycles < heatmap->next_decay) {
+		heatmap->next_decay = cycles + heatmap->decay_cycles; /* the virtual clock jumps back on a rewind */
+	}
+	if (cycles >= heatmap->next_decay) {
+		decay(heatmap);
+		heatmap->next_decay = cycles + heatmap->decay_cycles;
+	}
+}
+
+uint32_t heatmap_get_max(const HEATMAP* heatmap, int kind) {
+	uint32_t max = 0;
+	for (int i = 0; i < HEATMAP_BLOCKS; ++i) {
+		if (heatmap->counts[kind][i] > max) {
+			max = heatmap->counts[kind][i];
+		}
+	}
+	return max;
+}
+
+int heatmap_write_csv(HEATMAP* heatmap, const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		log_error("[HEATMAP] Failed to open %s\n", path);
+		return 1;
+	}
+
+	add_totals(heatmap);
+	fprintf(file, "address,reads,writes,executes,reads_decayed,writes_decayed,executes_decayed\n");
+	for (int i = 0; i < HEATMAP_BLOCKS; ++i) {
+		if (heatmap->totals[HEATMAP_READ][i] == 0 && heatmap->totals[HEATMAP_WRITE][i] == 0 && heatmap->totals[HEATMAP_EXECUTE][i] == 0) {
+			continue;
+		}
+		fprintf(file, "0x%05X,%llu,%llu,%llu,%u,%u,%u\n", i << HEATMAP_BLOCK_SHIFT,
+			(unsigned long long)heatmap->totals[HEATMAP_READ][i],
+			(unsigned long long)heatmap->totals[HEATMAP_WRITE][i],
+			(unsigned long long)heatmap->totals[HEATMAP_EXECUTE][i],
+			heatmap->counts[HEATMAP_READ][i],
+			heatmap->counts[HEATMAP_WRITE][i],
+			heatmap->counts[HEATMAP_EXECUTE][i]);
+	}
+	fclose(file);
+	log_info("[HEATMAP] Wrote %s\n", path);
+	return 0;
+}
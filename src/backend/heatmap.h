@@ -0,0 +1,64 @@
+/* heatmap.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Memory heatmap; reads, writes and executes counted per 256 byte block of the 1MB address space, decayed over time
+ */
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <stdint.h>
+
+#define HEATMAP_BLOCK_SHIFT 8
+#define HEATMAP_BLOCK_SIZE  (1 << HEATMAP_BLOCK_SHIFT)
+#define HEATMAP_BLOCKS      (0x100000 >> HEATMAP_BLOCK_SHIFT)
+#define HEATMAP_DECAY_HZ    10 /* decays per emulated second */
+#define HEATMAP_DECAY_SHIFT 3  /* each decay takes 1/8 off; a half life of about 0.5s */
+
+/* Access kinds */
+enum {
+	HEATMAP_READ = 0,
+	HEATMAP_WRITE,
+	HEATMAP_EXECUTE,
+	HEATMAP_KINDS
+};
+
+typedef struct HEATMAP {
+	uint8_t enabled;
+	uint64_t decay_cycles;       /* cycles between decays */
+	uint64_t next_decay;         /* virtual clock of the next decay */
+	uint32_t fetch;              /* the next instruction byte; the instruction is fetched in order from CS:IP, a read of it is not counted */
+	uint32_t counts[HEATMAP_KINDS][HEATMAP_BLOCKS]; /* decayed */
+	uint32_t base[HEATMAP_KINDS][HEATMAP_BLOCKS];   /* counts after the last decay; the totals are behind by counts - base */
+	uint64_t totals[HEATMAP_KINDS][HEATMAP_BLOCKS]; /* since create */
+} HEATMAP;
+
+/* Start counting
+	heatmap: the heatmap instance
+	clock_hz: the virtual clock rate the decay runs off */
+void heatmap_create(HEATMAP* heatmap, double clock_hz);
+void heatmap_destroy(HEATMAP* heatmap);
+
+/* Count an access
+	heatmap: the heatmap instance
+	kind: HEATMAP_XXX
+	address: the physical address */
+#define heatmap_count(heatmap, kind, address) ((heatmap)->counts[kind][((address) & 0xFFFFF) >> HEATMAP_BLOCK_SHIFT]++)
+
+/* Decay the counts; called once per time slice
+	heatmap: the heatmap instance
+	cycles: the virtual clock */
+void heatmap_update(HEATMAP* heatmap, uint64_t cycles);
+
+/* Get the highest decayed count of a kind
+	heatmap: the heatmap instance
+	kind: HEATMAP_XXX
+	Returns: the count */
+uint32_t heatmap_get_max(const HEATMAP* heatmap, int kind);
+
+/* Write the blocks with accesses as CSV; the totals and the decayed counts
+	heatmap: the heatmap instance
+	path: the file to write
+	Returns: 0 if success. Otherwise 1 */
+int heatmap_write_csv(HEATMAP* heatmap, const char* path);
+
+#endif
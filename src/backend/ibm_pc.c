@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <malloc.h>
 #include <string.h>
+#include <stdio.h>
 
 #include "ibm_pc.h"
 
@@ -13,6 +14,7 @@
 #include "i8086_mnem.h"
 #include "io/memory_map.h"
 #include "io/isa_bus.h"
+#include "io/isa_cards.h"
 #include "chipset/i8253_pit.h"
 #include "chipset/i8255_ppi.h"
 #include "chipset/i8259_pic.h"
@@ -20,13 +22,23 @@
 #include "chipset/nmi.h"
 #include "fdc/fdc.h"
 #include "hdc/xebec.h"
+#include "hdc/vblk.h"
+#include "int13.h"
+#include "journal.h"
+#include "rewind.h"
+#include "warm_boot.h"
+#include "pc_speaker.h"
+#include "audio.h"
+#include "perf.h"
 
 #include "isa_cards/mda_isa_card.h"
 #include "isa_cards/cga_isa_card.h"
 #include "isa_cards/fdc_isa_card.h"
 #include "isa_cards/xebec_isa_card.h"
+#include "isa_cards/vblk_isa_card.h"
 
 #include "utility/bit_utils.h"
+#include "utility/trace.h"
 
 #include "frontend/utility/file.h"
 
@@ -63,13 +75,8 @@
 #define PORTB_KB_ENABLE          0x40 // b6 - hold keyboard low
 #define PORTB_READ_SW1_KB        0x80 // b7 - Enable read SW1 or scan code; enable SW1 read = 1, enable scan code read = 0
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_MAIN
+#include "utility/log.h"
 
 /* PIT IRQ */
 enum {
@@ -249,7 +256,7 @@ void ibm_pc_set_config(void) {
 	
 	switch (ibm_pc->config.model) {
 		case MODEL_5150_16_64:
-			dbg_print("Model: 5150 16-64KB\n");
+			log_info("Model: 5150 16-64KB\n");
 			if (ibm_pc->config.sw1 & SW1_HAS_FDC) {
 				ibm_pc->config.fdc_disks = ((ibm_pc->config.sw1 & SW1_DISKS_MASK) >> 6) + 1;
 			}
@@ -258,7 +265,7 @@ void ibm_pc_set_config(void) {
 			}
 			break;
 		case MODEL_5150_64_256:
-			dbg_print("Model: 5150 64-256KB\n");
+			log_info("Model: 5150 64-256KB\n");
 			if (ibm_pc->config.sw1 & SW1_HAS_FDC) {
 				ibm_pc->config.fdc_disks = ((ibm_pc->config.sw1 & SW1_DISKS_MASK) >> 6) + 1;
 			}
@@ -267,7 +274,7 @@ void ibm_pc_set_config(void) {
 			}
 			break;
 		case MODEL_5160:
-			dbg_print("Model: 5160\n");
+			log_info("Model: 5160\n");
 			if (ibm_pc->config.sw1 & SW1_CONTINUOUSLY_POST) {
 				ibm_pc->config.continuously_post = 0;
 			}
@@ -282,22 +289,135 @@ void ibm_pc_set_config(void) {
 	uint20_t io_mem = determine_io_ram_size(ibm_pc->config.sw1, ibm_pc->config.sw2);
 	ibm_pc->config.total_memory = planar_mem + io_mem;
 
-	dbg_print("Planar RAM: %u Kb\n", planar_mem / 1024);
-	dbg_print("IO RAM:     %u Kb\n", io_mem / 1024);
-	dbg_print("Total RAM:  %u Kb\n", ibm_pc->config.total_memory / 1024);
+	log_info("Planar RAM: %u Kb\n", planar_mem / 1024);
+	log_info("IO RAM:     %u Kb\n", io_mem / 1024);
+	log_info("Total RAM:  %u Kb\n", ibm_pc->config.total_memory / 1024);
 
 	MEMORY_REGION* region = memory_map_get_mregion(&ibm_pc->mm, ibm_pc->ram_mregion_index);
 	region->size = ibm_pc->config.total_memory;
+
+	ibm_pc->int13.fdd_count = ibm_pc->config.fdc_disks;
+}
+
+/* Perf Callbacks; accesses are counted. In a timed step the cpu accesses are timed */
+static uint8_t dispatch_read_io_byte(uint16_t port);
+static void dispatch_write_io_byte(uint16_t port, uint8_t value);
+
+static uint8_t perf_read_mm_byte(uint20_t addr) {
+	PERF* perf = &ibm_pc->perf;
+	perf_count_mem(perf, &ibm_pc->mm, addr, 0);
+	if (!perf->timing) {
+		return memory_map_read_byte(&ibm_pc->mm, addr);
+	}
+	uint64_t start = timing_get_ticks_ns();
+	uint8_t value = memory_map_read_byte(&ibm_pc->mm, addr);
+	perf_add_ns(perf, PERF_MEM, start);
+	perf->nested++;
+	return value;
+}
+static void perf_write_mm_byte(uint20_t addr, uint8_t value) {
+	PERF* perf = &ibm_pc->perf;
+	perf_count_mem(perf, &ibm_pc->mm, addr, 1);
+	if (!perf->timing) {
+		memory_map_write_byte(&ibm_pc->mm, addr, value);
+		return;
+	}
+	uint64_t start = timing_get_ticks_ns();
+	memory_map_write_byte(&ibm_pc->mm, addr, value);
+	perf_add_ns(perf, PERF_MEM, start);
+	perf->nested++;
+}
+static uint8_t perf_read_io_byte(uint16_t port) {
+	PERF* perf = &ibm_pc->perf;
+	perf_count_io(perf, port, 0);
+	if (!perf->timing) {
+		return dispatch_read_io_byte(port);
+	}
+	/* memory the device touches is io time */
+	perf->timing = 0;
+	uint64_t start = timing_get_ticks_ns();
+	uint8_t value = dispatch_read_io_byte(port);
+	perf_add_ns(perf, PERF_IO, start);
+	perf->nested++;
+	perf->timing = 1;
+	return value;
+}
+static void perf_write_io_byte(uint16_t port, uint8_t value) {
+	PERF* perf = &ibm_pc->perf;
+	perf_count_io(perf, port, 1);
+	if (!perf->timing) {
+		dispatch_write_io_byte(port, value);
+		return;
+	}
+	perf->timing = 0;
+	uint64_t start = timing_get_ticks_ns();
+	dispatch_write_io_byte(port, value);
+	perf_add_ns(perf, PERF_IO, start);
+	perf->nested++;
+	perf->timing = 1;
+}
+
+/* Heatmap Callbacks; installed in place of the memory callbacks if the heatmap is enabled */
+static uint8_t read_mm_byte(uint20_t addr);
+static void write_mm_byte(uint20_t addr, uint8_t value);
+
+static uint8_t heatmap_read_mm_byte(uint20_t addr) {
+	/* Only data reads are counted; the fetches are counted once per instruction as an execute */
+	if (addr == ibm_pc->heatmap.fetch) {
+		ibm_pc->heatmap.fetch = (addr + 1) & 0xFFFFF;
+	}
+	else {
+		heatmap_count(&ibm_pc->heatmap, HEATMAP_READ, addr);
+	}
+	return read_mm_byte(addr);
+}
+static void heatmap_write_mm_byte(uint20_t addr, uint8_t value) {
+	heatmap_count(&ibm_pc->heatmap, HEATMAP_WRITE, addr);
+	write_mm_byte(addr, value);
+}
+
+/* Instruction trace Callbacks; installed in place of the memory write callback if the instruction trace is enabled */
+static void itrace_write_mm_byte(uint20_t addr, uint8_t value) {
+	itrace_add_write(&ibm_pc->itrace, addr, value);
+	if (ibm_pc->heatmap.enabled) {
+		heatmap_write_mm_byte(addr, value);
+		return;
+	}
+	write_mm_byte(addr, value);
+}
+
+uint8_t ibm_pc_peek_mem_byte(uint20_t addr) {
+	return memory_map_read_byte(&ibm_pc->mm, addr);
 }
 
 /* I8086 Callbacks */
 static uint8_t read_mm_byte(uint20_t addr) {
+	if (ibm_pc->perf.enabled) {
+		return perf_read_mm_byte(addr);
+	}
 	return memory_map_read_byte(&ibm_pc->mm, addr);
 }
 static void write_mm_byte(uint20_t addr, uint8_t value) {
+	if (ibm_pc->perf.enabled) {
+		perf_write_mm_byte(addr, value);
+		return;
+	}
 	memory_map_write_byte(&ibm_pc->mm, addr, value);
 }
 static uint8_t read_io_byte(uint16_t port) {
+	if (ibm_pc->perf.enabled) {
+		return perf_read_io_byte(port);
+	}
+	return dispatch_read_io_byte(port);
+}
+static void write_io_byte(uint16_t port, uint8_t value) {
+	if (ibm_pc->perf.enabled) {
+		perf_write_io_byte(port, value);
+		return;
+	}
+	dispatch_write_io_byte(port, value);
+}
+static uint8_t dispatch_read_io_byte(uint16_t port) {
 	
 	uint8_t v = 0;
 	if (isa_bus_read_io_byte(&ibm_pc->isa_bus, port, &v)) {
@@ -350,12 +470,12 @@ static uint8_t read_io_byte(uint16_t port) {
 			return 0xFF;
 
 		default:
-			dbg_print("read byte from port: %04X\n", port);
+			log_debug("read byte from port: %04X\n", port);
 			break;
 	}
 	return 0xFF;
 }
-static void write_io_byte(uint16_t port, uint8_t value) {
+static void dispatch_write_io_byte(uint16_t port, uint8_t value) {
 	
 	if (isa_bus_write_io_byte(&ibm_pc->isa_bus, port, value)) {
 		return;
@@ -410,7 +530,7 @@ static void write_io_byte(uint16_t port, uint8_t value) {
 			break;
 
 		default:
-			dbg_print("write byte to port: %04X = %02X\n", port, value);
+			log_debug("write byte to port: %04X = %02X\n", port, value);
 			break;
 	}
 }
@@ -439,6 +559,7 @@ static uint8_t ppi_port_b_read(I8255_PPI* ppi) {
 static void ppi_port_b_write(I8255_PPI* ppi, uint8_t value) {
 	/* Port B (device control register)  */
 	ibm_pc->timer2_gate  = (value & PORTB_TIMER2_GATE);
+	pc_speaker_set_data(&ibm_pc->pc_speaker, (value & PORTB_SPEAKER_DATA) != 0, timing_virtual_get_cycles());
 
 	if (IS_RISING_EDGE(PORTB_KB_ENABLE, ppi->port_b, value)) {
 		kbd_set_clk(&ibm_pc->kbd, 1);
@@ -478,10 +599,6 @@ static uint8_t ppi_port_c_read(I8255_PPI* ppi) {
 	return 0; /* not handled */
 }
 
-static void pcspeaker_set(PC_SPEAKER* pc_speaker, uint8_t input) {
-	pc_speaker->input = input;
-}
-
 /* PIT Callbacks */
 static void pit_on_timer0(I8253_TIMER* timer) {
 	/* PIT channel 0 is connected to the system timer interrupt line (IRQ0) on the i8259 PIC */
@@ -516,28 +633,103 @@ static void pit_on_timer2(I8253_TIMER* timer) {
 	
 	switch (timer->ctrl & I8253_PIT_CTRL_MODE) {
 		case I8253_PIT_MODE0: // interrupt on terminal count
-			pcspeaker_set(&ibm_pc->pc_speaker, 0);
+			pc_speaker_set_input(&ibm_pc->pc_speaker, 0, timing_virtual_get_cycles());
 			break;
 
 		case I8253_PIT_MODE2: // rate generator
 		case I8253_PIT_MODE6: // rate generator
-			pcspeaker_set(&ibm_pc->pc_speaker, 0);
+			pc_speaker_set_input(&ibm_pc->pc_speaker, 0, timing_virtual_get_cycles());
 			break;
 
 		case I8253_PIT_MODE3: // square wave generator
 		case I8253_PIT_MODE7: // square wave generator
-			pcspeaker_set(&ibm_pc->pc_speaker, timer->out);
+			pc_speaker_set_input(&ibm_pc->pc_speaker, timer->out, timing_virtual_get_cycles());
+			break;
+	}
+}
+
+static void publish_video_frame(void) {
+	/* Snapshot the active video adapter and its VRAM for the render thread */
+	VIDEO_FRAME* frame = video_frame_buffer_get_back(&ibm_pc->video_frames);
+	uint32_t base = 0;
+	uint32_t size = 0;
+
+	frame->video_adapter = ibm_pc->config.video_adapter;
+	frame->frame = ibm_pc->video_frames.published + 1;
+	frame->ticks_ms = timing_virtual_get_ticks_ms();
+
+	switch (frame->video_adapter) {
+		case VIDEO_ADAPTER_MDA_80X25:
+			frame->mda = ibm_pc->mda;
+			base = MDA_MM_BASE_ADDRESS;
+			size = MDA_MM_ADDRESS_MASK + 1;
 			break;
+		case VIDEO_ADAPTER_CGA_40X25:
+		case VIDEO_ADAPTER_CGA_80X25:
+			frame->cga = ibm_pc->cga;
+			base = CGA_MM_BASE_ADDRESS;
+			size = CGA_MM_ADDRESS_MASK + 1;
+			break;
+	}
+
+	if (size != 0) {
+		const uint8_t* vram = memory_map_get_range(&ibm_pc->mm, base, size, 0);
+		if (vram != NULL) {
+			memcpy(frame->vram, vram, size);
+		}
+		else {
+			for (uint32_t i = 0; i < size; ++i) {
+				frame->vram[i] = memory_map_read_byte(&ibm_pc->mm, base + i);
+			}
+		}
 	}
+
+	video_frame_buffer_publish(&ibm_pc->video_frames);
+}
+static void video_on_vsync(void* adapter) {
+	(void)adapter;
+	publish_video_frame();
 }
 
+static void kbd_replay_keys(void) {
+	/* Keys are replayed at the keyboard tick they were delivered at */
+	if (ibm_pc->rewinding) {
+		const REWIND_KEY* key = NULL;
+		while ((key = rewind_next_key(&ibm_pc->rewind, timing_virtual_get_cycles())) != NULL) {
+			kbd_deliver_key(&ibm_pc->kbd, key->scancode);
+		}
+	}
+	else {
+		const JOURNAL_EVENT* e = NULL;
+		while ((e = journal_peek(&ibm_pc->journal, timing_virtual_get_cycles())) != NULL && e->type == JOURNAL_EVENT_KEY) {
+			kbd_deliver_key(&ibm_pc->kbd, e->scancode);
+			journal_pop(&ibm_pc->journal);
+		}
+
+		/* The journal stops when its last event is popped; journal_update() is not called again, so hand the keys back here */
+		ibm_pc->kbd.queue_disabled = (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY);
+	}
+}
 static void kbd_update(void) {
 	const uint64_t cycle_target = 35400;
 	ibm_pc->kbd_accum += ibm_pc->cpu.cycles;
 	while (ibm_pc->kbd_accum >= cycle_target) {
 		ibm_pc->kbd_accum -= cycle_target;
 		ibm_pc->kbd_cycles++;
-		kbd_tick(&ibm_pc->kbd);
+		kbd_tick(&ibm_pc->kbd, timing_virtual_get_cycles());
+		if (ibm_pc->kbd.queue_disabled) {
+			kbd_replay_keys();
+		}
+	}
+}
+static void kbd_on_key(uint8_t scancode) {
+	/* a key during POST changes what the guest does; the snapshot would not be a clean boot */
+	ibm_pc->warm_boot_armed = 0;
+
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_KEY, .cycle = timing_virtual_get_cycles(), .scancode = scancode };
+	journal_add(&ibm_pc->journal, &e);
+	if (!ibm_pc->rewinding) {
+		rewind_add_key(&ibm_pc->rewind, e.cycle, scancode);
 	}
 }
 static void dma_update(void) {
@@ -567,18 +759,88 @@ static void pit_update(void) {
 		i8253_pit_update(&ibm_pc->pit);
 	}
 }
+static void warm_boot_update(void) {
+	/* POST is done when the guest is about to execute INT warm_boot_int */
+	uint20_t addr = i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip);
+	if (read_mm_byte(addr) != 0xCD || read_mm_byte((addr + 1) & 0xFFFFF) != ibm_pc->config.warm_boot_int) {
+		return;
+	}
+	ibm_pc->warm_boot_armed = 0;
+
+	if (ibm_pc->on_post_done != NULL) {
+		ibm_pc->on_post_done();
+		return;
+	}
+
+	char path[PATH_LEN] = { 0 };
+	warm_boot_get_path(path, sizeof(path), ibm_pc->config.warm_boot_dir, ibm_pc->warm_boot_key);
+
+	IBM_PC_STATE state;
+	ibm_pc_save_state(&state);
+	warm_boot_save(path, ibm_pc->warm_boot_key, &state, sizeof(IBM_PC_STATE), ibm_pc->mm.mem, MEM_SIZE);
+}
+
+static void profile_cycles(uint64_t cycles) {
+	/* Sample the guest CS:IP every N cycles */
+	PROFILER* profiler = &ibm_pc->profiler;
+	profiler->countdown -= (int64_t)cycles;
+	if (profiler->countdown <= 0) {
+		profiler_sample(profiler, ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip, ibm_pc->mm.mem);
+	}
+}
+
 static void cpu_update(void) {
 
 	ibm_pc->cpu.cycles = 0;
-	if (i8086_execute(&ibm_pc->cpu) == I8086_DECODE_UNDEFINED) {
-		dbg_print("ERROR: undef op: %02X", ibm_pc->cpu.opcode);
+
+	if (ibm_pc->warm_boot_armed) {
+		warm_boot_update();
+	}
+
+	if (ibm_pc->coverage.enabled) {
+		coverage_mark(&ibm_pc->coverage, i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip));
+	}
+	if (ibm_pc->heatmap.enabled) {
+		ibm_pc->heatmap.fetch = i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip);
+		heatmap_count(&ibm_pc->heatmap, HEATMAP_EXECUTE, ibm_pc->heatmap.fetch);
+	}
+
+	if (ibm_pc->itrace.enabled) {
+		itrace_begin(&ibm_pc->itrace, &ibm_pc->cpu, ibm_pc->mm.mem);
+	}
+
+	if (ibm_pc->config.instant_disk && int13_trap(&ibm_pc->int13, &ibm_pc->cpu)) {
+		/* INT 13h was serviced from the disk buffers; account for the IRET */
+		if (ibm_pc->itrace.enabled) {
+			itrace_end(&ibm_pc->itrace, &ibm_pc->cpu);
+		}
+		ibm_pc->cpu.cycles = INT13_TRAP_CYCLES;
+		ibm_pc->cpu_cycles += ibm_pc->cpu.cycles;
+		timing_virtual_advance(ibm_pc->cpu.cycles);
+		if (ibm_pc->profiler.enabled) {
+			profile_cycles(ibm_pc->cpu.cycles);
+		}
+		return;
+	}
+
+	int decode = i8086_execute(&ibm_pc->cpu);
+	if (ibm_pc->itrace.enabled) {
+		itrace_end(&ibm_pc->itrace, &ibm_pc->cpu);
+	}
+	if (decode == I8086_DECODE_UNDEFINED) {
 		if (ibm_pc->cpu.modrm.byte != 0) {
-			dbg_print(" /%02X", ibm_pc->cpu.modrm.reg);
+			log_error("ERROR: undef op: %02X /%02X\n", ibm_pc->cpu.opcode, ibm_pc->cpu.modrm.reg);
+		}
+		else {
+			log_error("ERROR: undef op: %02X\n", ibm_pc->cpu.opcode);
 		}
-		dbg_print("\n");
 		return;
 	}
 	ibm_pc->cpu_cycles += ibm_pc->cpu.cycles;
+	timing_virtual_advance(ibm_pc->cpu.cycles);
+	if (ibm_pc->profiler.enabled) {
+		profile_cycles(ibm_pc->cpu.cycles);
+	}
 
 	if (ibm_pc->breakpoint != 0 && ibm_pc->breakpoint == i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip)) {
 		ibm_pc->step = 1;
@@ -596,69 +858,69 @@ static void cpu_update(void) {
 	switch ((ibm_pc->cpu.segments[1] << 4) + ibm_pc->cpu.ip) {
 
 		case 0xFE05B: // TEST.01
-			dbg_print("test.01\n");
+			log_debug("test.01\n");
 			break;
 
 		case 0xFE0F9: //
-			dbg_print("timer1 failure (01) (bits did not turn off)\n");
+			log_debug("timer1 failure (01) (bits did not turn off)\n");
 			break;
 
 		case 0xFE10D: //
-			dbg_print("timer1 failure (02) (bits did not stay on)\n");
+			log_debug("timer1 failure (02) (bits did not stay on)\n");
 			break;
 
 		case 0xFE0B0: // TEST.02
-			dbg_print("test.02\n");
+			log_debug("test.02\n");
 			break;
 
 		case 0xFE0DA: // TEST.03 (dma test)
-			dbg_print("test.03\n");
+			log_debug("test.03\n");
 			//ibm_pc->cpu.ip = 0xE158; // skip test 3; goto test 4.
 			break;
 
 		case 0xFE132: //
-			dbg_print("dma error; pattern not read as written\n");
+			log_debug("dma error; pattern not read as written\n");
 			break;
 
 		case 0xFE158: // TEST.04
-			dbg_print("test.04\n");
+			log_debug("test.04\n");
 			break;
 
 		case 0xFE1EF: //
-			dbg_print("stgtest error\n");
+			log_debug("stgtest error\n");
 			break;
 
 		case 0xFE27D: // 
-			dbg_print("error beep\n");
+			log_debug("error beep\n");
 			break;
 
 		case 0xFE2DC: // 
-			dbg_print("error msg\n");
+			log_debug("error msg\n");
 			break;
 
 		case 0xFE33B: // TEST.05
-			dbg_print("test.05\n");
+			log_debug("test.05\n");
 			break;
 
 		case 0xFE235: // TEST.06
-			dbg_print("test.06\n");
+			log_debug("test.06\n");
 			break;
 
 		case 0xFE250: // TEST.06
 			if (!ibm_pc->cpu.status.zf)
-				dbg_print("test.06 error imr not 0\n");
+				log_debug("test.06 error imr not 0\n");
 			break;
 
 		case 0xFE25A: // TEST.06
 			if (!ibm_pc->cpu.status.zf)
-				dbg_print("test.06 error imr not 0xFF\n");
+				log_debug("test.06 error imr not 0xFF\n");
 			break;
 
 		case 0xFE27B: // TEST.06
 			if (!ibm_pc->cpu.status.zf)
-				dbg_print("test.06 error INT occcured\n");
+				log_debug("test.06 error INT occcured\n");
 			else
-				dbg_print("test.06 passed\n");
+				log_debug("test.06 passed\n");
 			break;
 
 		case 0xFE270: // TEST.06
@@ -670,153 +932,129 @@ static void cpu_update(void) {
 			break;
 
 		case 0xFE285: // TEST.07 (timer test)
-			dbg_print("test.07\n");
+			log_debug("test.07\n");
 			//ibm_pc->cpu.ip = 0xE2B3; // skip test 7; goto test 8.
 			break;
 
 		case 0xFE29E: // TEST.07 (timer too slow)
-			dbg_print("test.07 error timer too slow\n");
+			log_debug("test.07 error timer too slow\n");
 			break;
 
 		case 0xFE2AF: // TEST.07 (timer too fast)
 			if (!ibm_pc->cpu.status.zf)
-				dbg_print("test.07 error timer too fast\n");
+				log_debug("test.07 error timer too fast\n");
 			break;
 
 		case 0xFE2B3: // TEST.07 (passed)
-			dbg_print("test.07 timer speed passed\n");
+			log_debug("test.07 timer speed passed\n");
 			break;
 
 		case 0xFE34C: //
-			dbg_print("ROS II error checksum\n");
+			log_debug("ROS II error checksum\n");
 			break;
 
 		case 0xFE352: // TEST.08
-			dbg_print("test.08\n");
+			log_debug("test.08\n");
 			break;
 
 		case 0xFE3AF: // TEST.09
-			dbg_print("test.09\n");
+			log_debug("test.09\n");
 			break;
 
 		case 0xFE3C0: // TEST.10
-			dbg_print("test.10\n"); 
+			log_debug("test.10\n"); 
 			//ibm_pc->cpu.ip = 0xE3F8; // skip test 10; TEST 11
 			break;
 
 		case 0xFE3F0: //
-			dbg_print("test.10 err beep\n"); 
+			log_debug("test.10 err beep\n"); 
 			break;
 
 		case 0xFE3F8: // TEST.11
-			dbg_print("test.11\n");
+			log_debug("test.11\n");
 			break;
 
 		case 0xFE42B: // TEST.11
-			dbg_print("test.11 (skip mem test)\n");
+			log_debug("test.11 (skip mem test)\n");
 			ibm_pc->cpu.ip = 0xE47A; // skip mem test; goto TEST 12
 			break;
 
 		case 0xFE4C7: // TEST.12
-			dbg_print("test.12\n");
+			log_debug("test.12\n");
 			break;
 
 		case 0xFE51E: // TEST.13
-			dbg_print("test.13\n");
+			log_debug("test.13\n");
 			//ibm_pc->cpu.status.cf = 0;
 			//ibm_pc->cpu.ip = 0xE551; // skip test 13; TEST 14. (JNC)
 			break;
 
 		case 0xFE553: // TEST.13 ERR
-			dbg_print("test.13 ERR E553\n");
+			log_debug("test.13 ERR E553\n");
 			break;
 
 		case 0xFE59D: // TEST.13 ERR
-			dbg_print("test.13 ERR E59D\n");
+			log_debug("test.13 ERR E59D\n");
 			break;
 
 		case 0xFE55C: // TEST.14
-			dbg_print("test.14\n");
+			log_debug("test.14\n");
 			break;
 
 		case 0xFE5A6: // JMP BOOT
-			dbg_print("jmp boot\n");
+			log_debug("jmp boot\n");
 			break;
 		case 0xFE620: // JMP BOOT
-			dbg_print("jmp boot_strap\n");
+			log_debug("jmp boot_strap\n");
 			break;
 		case 0xFE722: // JMP BOOT
-			dbg_print("jmp basic_boot\n");
+			log_debug("jmp basic_boot\n");
 			break;
 		case 0xFE724: // JMP BOOT
-			dbg_print("jmp boot_locn\n");
+			log_debug("jmp boot_locn\n");
 			break;
 
 		//case 0xFF98D:
 		//	// LOOPE
 		//	if (ibm_pc->cpu.status.zf == 0) {
-		//		dbg_print("cass value changed\n");
+		//		log_debug("cass value changed\n");
 		//	}
 		//	else if (ibm_pc->cpu.registers[REG_CX].r16 == 1) { 
 		//		// cx going to be 0 
-		//		dbg_print("cass value time out\n");
+		//		log_debug("cass value time out\n");
 		//	}
 		//	break;
 
 		//case 0xFE545:
 		//	if (ibm_pc->cpu.registers[REG_CX].r16 == 0) {
-		//		dbg_print("cass err1 (JCXZ)\n");
+		//		log_debug("cass err1 (JCXZ)\n");
 		//	}
 		//	break;
 
 		case 0xFF065:
-			dbg_print("INT 10 (VIDEO_IO) ah=%x\n", ibm_pc->cpu.registers[REG_AX].h);
+			log_debug("INT 10 (VIDEO_IO) ah=%x\n", ibm_pc->cpu.registers[REG_AX].h);
 			break;
 		 
 		//case 0xFE54B:
 		//	if (ibm_pc->cpu.status.cf == 0) {
-		//		dbg_print("cass err2 (JNC)\n");
+		//		log_debug("cass err2 (JNC)\n");
 		//	}
 		//	break;
 
 		/*case 0xFEE4E:
-			dbg_print("FDC check direction bit (0x40) - ");
-			if (ibm_pc->cpu.status.zf) {
-				dbg_print("OK\n");
-			}
-			else {
-				dbg_print("ERR\n");
-			}
+			log_debug("FDC check direction bit (0x40) - %s\n", ibm_pc->cpu.status.zf ? "OK" : "ERR");
 			break;
 
 		case 0xFEE61:
-			dbg_print("FDC check ready bit (0x80) - ");
-			if (ibm_pc->cpu.status.zf) {
-				dbg_print("ERR\n");
-			}
-			else {
-				dbg_print("OK\n");
-			}
+			log_debug("FDC check ready bit (0x80) - %s\n", ibm_pc->cpu.status.zf ? "ERR" : "OK");
 			break;
 
 		case 0xFEF7C:
-			dbg_print("FDC check ready bit (0x80) - ");
-			if (ibm_pc->cpu.status.zf) {
-				dbg_print("ERR\n");
-			}
-			else {
-				dbg_print("OK\n");
-			}
+			log_debug("FDC check ready bit (0x80) - %s\n", ibm_pc->cpu.status.zf ? "ERR" : "OK");
 			break;
 
 		case 0xFEF8D:
-			dbg_print("FDC check direction bit (0x40) - ");
-			if (ibm_pc->cpu.status.zf) {
-				dbg_print("ERR\n");
-			}
-			else {
-				dbg_print("OK\n");
-			}
+			log_debug("FDC check direction bit (0x40) - %s\n", ibm_pc->cpu.status.zf ? "ERR" : "OK");
 			break;*/
 	}
 #endif
@@ -841,11 +1079,11 @@ static void cpu_update(void) {
 			break;
 
 		case 0xFE018:
-			dbg_print("STGTST\n");
+			log_debug("STGTST\n");
 			break;
 
 		case 0xFE3EA: // TEST.11
-			dbg_print("test.11 (skip mem test)\n");
+			log_debug("test.11 (skip mem test)\n");
 			ibm_pc->cpu.ip = 0xE43B; // skip mem test; goto TEST 12
 			break;
 
@@ -855,43 +1093,521 @@ static void cpu_update(void) {
 	}
 #endif
 }
+static void perf_timed_step(void) {
+	/* a step with each part timed; the frame time is scaled up from the timed steps */
+	PERF* perf = &ibm_pc->perf;
+	uint64_t t = timing_get_ticks_ns();
+
+	for (int i = 0; i < ibm_pc->isa_bus.card_index; ++i) {
+		isa_bus_update_card(&ibm_pc->isa_bus, i, ibm_pc->cpu.cycles);
+		int id = ibm_pc->isa_bus.cards[i].id;
+		t = perf_add_ns(perf, (id == ISA_CARD_MDA || id == ISA_CARD_CGA) ? PERF_CRTC : PERF_DISK, t);
+	}
+	dma_update();
+	t = perf_add_ns(perf, PERF_DMA, t);
+	pit_update();
+	t = perf_add_ns(perf, PERF_PIT, t);
+	kbd_update();
+	pic_update();
+	t = perf_add_ns(perf, PERF_OTHER, t);
+
+	/* memory and io are timed inside the cpu step; the cpu gets what is left */
+	uint64_t inner = perf->frame.ns[PERF_MEM] + perf->frame.ns[PERF_IO];
+	perf->nested = 0;
+	perf->timing = 1;
+	cpu_update();
+	perf->timing = 0;
+	uint64_t ns = timing_get_ticks_ns() - t;
+	inner = perf->frame.ns[PERF_MEM] + perf->frame.ns[PERF_IO] - inner + (perf->nested + 1) * perf->timer_ns;
+	perf->frame.ns[PERF_CPU] += (ns > inner) ? ns - inner : 0;
+}
+
+static void insert_disk(uint8_t drive, const char* path) {
+	/* rewind snapshots do not hold the disks; they can not be rewound past a disk change */
+	rewind_clear(&ibm_pc->rewind);
+	if (drive < FDD_MAX) {
+		fdd_eject_disk(&ibm_pc->fdc.fdd[drive]);
+		fdd_insert_disk(&ibm_pc->fdc.fdd[drive], path);
+	}
+}
+static void eject_disk(uint8_t drive) {
+	rewind_clear(&ibm_pc->rewind);
+	if (drive < FDD_MAX) {
+		fdd_eject_disk(&ibm_pc->fdc.fdd[drive]);
+	}
+}
+static void new_disk(uint8_t drive, uint32_t size) {
+	rewind_clear(&ibm_pc->rewind);
+	if (drive < FDD_MAX) {
+		fdd_eject_disk(&ibm_pc->fdc.fdd[drive]);
+		fdd_new_disk(&ibm_pc->fdc.fdd[drive], size);
+	}
+}
+static void insert_hdd(uint8_t drive, const char* path) {
+	rewind_clear(&ibm_pc->rewind);
+	if (drive < HDD_MAX) {
+		xebec_hdc_eject_hdd(&ibm_pc->xebec, drive);
+		xebec_hdc_insert_hdd(&ibm_pc->xebec, drive, path);
+	}
+}
+static void eject_hdd(uint8_t drive) {
+	rewind_clear(&ibm_pc->rewind);
+	if (drive < HDD_MAX) {
+		xebec_hdc_eject_hdd(&ibm_pc->xebec, drive);
+	}
+}
+
+static void journal_update(void) {
+	/* Replay the events due at this cycle; before the next instruction, as they were recorded between slices */
+	const JOURNAL_EVENT* e = NULL;
+	while ((e = journal_peek(&ibm_pc->journal, timing_virtual_get_cycles())) != NULL && e->type != JOURNAL_EVENT_KEY) {
+		switch (e->type) {
+			case JOURNAL_EVENT_RESET:
+				ibm_pc_reset();
+				break;
+			case JOURNAL_EVENT_DISK_INSERT:
+				insert_disk(e->drive, e->path);
+				break;
+			case JOURNAL_EVENT_DISK_EJECT:
+				eject_disk(e->drive);
+				break;
+			case JOURNAL_EVENT_DISK_NEW:
+				new_disk(e->drive, e->size);
+				break;
+			case JOURNAL_EVENT_HDD_INSERT:
+				insert_hdd(e->drive, e->path);
+				break;
+			case JOURNAL_EVENT_HDD_EJECT:
+				eject_hdd(e->drive);
+				break;
+		}
+		journal_pop(&ibm_pc->journal);
+	}
+
+	/* Keys from the frontend are ignored until the journal runs out */
+	ibm_pc->kbd.queue_disabled = (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY);
+}
+
+static int record_event(JOURNAL_EVENT* e) {
+	if (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY) {
+		log_warn("[JOURNAL] Replaying; event ignored\n");
+		return 1;
+	}
+	e->cycle = timing_virtual_get_cycles();
+	journal_add(&ibm_pc->journal, e);
+	return 0;
+}
+
+int ibm_pc_event_reset(void) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_RESET };
+	if (record_event(&e)) {
+		return 1;
+	}
+	ibm_pc_reset();
+	return 0;
+}
+int ibm_pc_event_insert_disk(uint8_t drive, const char* path) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_DISK_INSERT, .drive = drive };
+	strncpy_s(e.path, sizeof(e.path), path, sizeof(e.path) - 1);
+	if (record_event(&e)) {
+		return 1;
+	}
+	insert_disk(drive, path);
+	return 0;
+}
+int ibm_pc_event_eject_disk(uint8_t drive) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_DISK_EJECT, .drive = drive };
+	if (record_event(&e)) {
+		return 1;
+	}
+	eject_disk(drive);
+	return 0;
+}
+int ibm_pc_event_new_disk(uint8_t drive, uint32_t size) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_DISK_NEW, .drive = drive, .size = size };
+	if (record_event(&e)) {
+		return 1;
+	}
+	new_disk(drive, size);
+	return 0;
+}
+int ibm_pc_event_insert_hdd(uint8_t drive, const char* path) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_HDD_INSERT, .drive = drive };
+	strncpy_s(e.path, sizeof(e.path), path, sizeof(e.path) - 1);
+	if (record_event(&e)) {
+		return 1;
+	}
+	insert_hdd(drive, path);
+	return 0;
+}
+int ibm_pc_event_eject_hdd(uint8_t drive) {
+	JOURNAL_EVENT e = { .type = JOURNAL_EVENT_HDD_EJECT, .drive = drive };
+	if (record_event(&e)) {
+		return 1;
+	}
+	eject_hdd(drive);
+	return 0;
+}
+
+void ibm_pc_start_journal(void) {
+	/* Events are stamped with the emulated cycle; the run must start from the same state to replay */
+	if (ibm_pc->config.replay_path[0] != '\0') {
+		journal_replay(&ibm_pc->journal, ibm_pc->config.replay_path);
+	}
+	else if (ibm_pc->config.record_path[0] != '\0') {
+		journal_record(&ibm_pc->journal, ibm_pc->config.record_path);
+	}
+	ibm_pc->kbd.queue_disabled = (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY);
+}
+
+void ibm_pc_save_state(IBM_PC_STATE* state) {
+	memset(state, 0, sizeof(IBM_PC_STATE));
+	state->cycles = timing_virtual_get_cycles();
+	state->cpu = ibm_pc->cpu;
+	state->dma = ibm_pc->dma;
+	state->pit = ibm_pc->pit;
+	state->pic = ibm_pc->pic;
+	state->ppi = ibm_pc->ppi;
+	state->nmi = ibm_pc->nmi;
+	state->mda = ibm_pc->mda;
+	state->cga = ibm_pc->cga;
+	state->int13 = ibm_pc->int13;
+	upd765_fdc_save_state(&ibm_pc->fdc, &state->fdc);
+	xebec_hdc_save_state(&ibm_pc->xebec, &state->xebec);
+	kbd_save_state(&ibm_pc->kbd, &state->kbd);
+	state->vblk_drive = ibm_pc->vblk.drive;
+	state->vblk_status = ibm_pc->vblk.status;
+	state->vblk_address = ibm_pc->vblk.address;
+	pc_speaker_save_state(&ibm_pc->pc_speaker, &state->pc_speaker);
+	state->timer2_gate = ibm_pc->timer2_gate;
+	state->pit_accum = ibm_pc->pit_accum;
+	state->dma_accum = ibm_pc->dma_accum;
+	state->kbd_accum = ibm_pc->kbd_accum;
+	memcpy(state->regions, ibm_pc->mm.regions, sizeof(MEMORY_REGION) * IBM_PC_MREGIONS);
+}
+void ibm_pc_load_state(const IBM_PC_STATE* state) {
+	/* The device structs only point at other devices and callbacks; these do not change after init */
+	timing_virtual_set_cycles(state->cycles);
+	ibm_pc->cpu = state->cpu;
+	ibm_pc->dma = state->dma;
+	ibm_pc->pit = state->pit;
+	ibm_pc->pic = state->pic;
+	ibm_pc->ppi = state->ppi;
+	ibm_pc->nmi = state->nmi;
+	ibm_pc->mda = state->mda;
+	ibm_pc->cga = state->cga;
+	ibm_pc->int13 = state->int13;
+	upd765_fdc_load_state(&ibm_pc->fdc, &state->fdc);
+	xebec_hdc_load_state(&ibm_pc->xebec, &state->xebec);
+	kbd_load_state(&ibm_pc->kbd, &state->kbd);
+	ibm_pc->vblk.drive = state->vblk_drive;
+	ibm_pc->vblk.status = state->vblk_status;
+	ibm_pc->vblk.address = state->vblk_address;
+	pc_speaker_load_state(&ibm_pc->pc_speaker, &state->pc_speaker, state->cycles);
+	ibm_pc->timer2_gate = state->timer2_gate;
+	ibm_pc->pit_accum = state->pit_accum;
+	ibm_pc->dma_accum = state->dma_accum;
+	ibm_pc->kbd_accum = state->kbd_accum;
+	memcpy(ibm_pc->mm.regions, state->regions, sizeof(MEMORY_REGION) * IBM_PC_MREGIONS);
+}
+
+static void link_state(IBM_PC_STATE* state) {
+	/* A state from another run holds its function and device pointers; use the pointers of this run */
+	state->cpu.funcs = ibm_pc->cpu.funcs;
+	state->dma.read_mem_byte = ibm_pc->dma.read_mem_byte;
+	state->dma.write_mem_byte = ibm_pc->dma.write_mem_byte;
+	for (int i = 0; i < I8253_PIT_NUM_TIMERS; ++i) {
+		state->pit.timer[i].on_timer = ibm_pc->pit.timer[i].on_timer;
+		state->pit.timer[i].gate_ptr = ibm_pc->pit.timer[i].gate_ptr;
+	}
+	state->pic.i8086 = ibm_pc->pic.i8086;
+	state->ppi.port_a_read = ibm_pc->ppi.port_a_read;
+	state->ppi.port_b_read = ibm_pc->ppi.port_b_read;
+	state->ppi.port_c_read = ibm_pc->ppi.port_c_read;
+	state->ppi.port_a_write = ibm_pc->ppi.port_a_write;
+	state->ppi.port_b_write = ibm_pc->ppi.port_b_write;
+	state->ppi.port_c_write = ibm_pc->ppi.port_c_write;
+	state->mda.on_vsync = ibm_pc->mda.on_vsync;
+	state->cga.on_vsync = ibm_pc->cga.on_vsync;
+	state->int13.fdd = ibm_pc->int13.fdd;
+	state->int13.hdd = ibm_pc->int13.hdd;
+	state->int13.read_mem_byte = ibm_pc->int13.read_mem_byte;
+	state->int13.write_mem_byte = ibm_pc->int13.write_mem_byte;
+}
+
+static uint64_t warm_boot_get_key(void) {
+	/* Everything POST sees; the disks in the drives are not part of the key, they are attached after the restore */
+	uint64_t key = WARM_BOOT_HASH_INIT;
+	uint32_t value = sizeof(IBM_PC_STATE);
+	key = warm_boot_hash(key, &value, sizeof(value));
+	key = warm_boot_hash(key, &ibm_pc->config.model, sizeof(ibm_pc->config.model));
+	key = warm_boot_hash(key, &ibm_pc->config.sw1, sizeof(ibm_pc->config.sw1));
+	key = warm_boot_hash(key, &ibm_pc->config.sw2, sizeof(ibm_pc->config.sw2));
+	key = warm_boot_hash(key, &ibm_pc->config.total_memory, sizeof(ibm_pc->config.total_memory));
+	key = warm_boot_hash(key, &ibm_pc->config.video_adapter, sizeof(ibm_pc->config.video_adapter));
+	key = warm_boot_hash(key, &ibm_pc->config.fdc_disks, sizeof(ibm_pc->config.fdc_disks));
+	key = warm_boot_hash(key, &ibm_pc->config.warm_boot_int, sizeof(ibm_pc->config.warm_boot_int));
+
+	/* ROM contents; not the paths */
+	for (size_t i = 0; i < ibm_pc->config.rom_count; ++i) {
+		void* buffer = NULL;
+		size_t size = 0;
+		key = warm_boot_hash(key, &ibm_pc->config.roms[i].address, sizeof(ibm_pc->config.roms[i].address));
+		if (file_read_alloc_buffer(ibm_pc->config.roms[i].path, &buffer, &size) == 0) {
+			key = warm_boot_hash(key, buffer, size);
+			free(buffer);
+		}
+	}
+
+	/* The HDC BIOS sets up the drives during POST */
+	for (size_t i = 0; i < ibm_pc->config.hdd_count; ++i) {
+		key = warm_boot_hash(key, &ibm_pc->config.hdds[i].drive, sizeof(ibm_pc->config.hdds[i].drive));
+		key = warm_boot_hash(key, &ibm_pc->config.hdds[i].geometry, sizeof(ibm_pc->config.hdds[i].geometry));
+		key = warm_boot_hash(key, &ibm_pc->config.hdds[i].type, sizeof(ibm_pc->config.hdds[i].type));
+	}
+
+	/* The instant disk option ROM hooks INT 13h during POST */
+	key = warm_boot_hash(key, &ibm_pc->config.instant_disk, sizeof(ibm_pc->config.instant_disk));
+	value = ibm_pc->config.instant_disk ? ibm_pc->config.int13_rom_address : 0;
+	key = warm_boot_hash(key, &value, sizeof(value));
+
+	/* The VBLK option ROM is generated; it is installed if an image is set */
+	value = (ibm_pc->config.vblk_path[0] != '\0') ? ibm_pc->config.vblk_rom_address : 0;
+	key = warm_boot_hash(key, &value, sizeof(value));
+	return key;
+}
+
+void ibm_pc_warm_boot(void) {
+	ibm_pc->warm_boot_armed = 0;
+	if (ibm_pc->config.warm_boot_dir[0] == '\0') {
+		return;
+	}
+	if (ibm_pc->config.record_path[0] != '\0' || ibm_pc->config.replay_path[0] != '\0') {
+		/* journal events are stamped from the cold boot */
+		log_warn("[WARM BOOT] Not used with a journal\n");
+		return;
+	}
+
+	ibm_pc->warm_boot_key = warm_boot_get_key();
+
+	char path[PATH_LEN] = { 0 };
+	warm_boot_get_path(path, sizeof(path), ibm_pc->config.warm_boot_dir, ibm_pc->warm_boot_key);
+
+	IBM_PC_STATE state;
+	if (warm_boot_load(path, ibm_pc->warm_boot_key, &state, sizeof(IBM_PC_STATE), ibm_pc->mm.mem, MEM_SIZE) == 0) {
+		/* The disks inserted at init stay in the drives; the restored controller state sees them */
+		link_state(&state);
+		ibm_pc_load_state(&state);
+		memory_map_mark_dirty(&ibm_pc->mm);
+		memory_map_clear_dirty(&ibm_pc->mm, MEMORY_MAP_DIRTY_SNAPSHOT);
+		publish_video_frame();
+	}
+	else {
+		ibm_pc->warm_boot_armed = 1;
+	}
+}
+
+void ibm_pc_watch_post(void(*on_post_done)(void)) {
+	ibm_pc->on_post_done = on_post_done;
+	ibm_pc->warm_boot_armed = 1;
+}
+
+static uint64_t rewind_interval_cycles(void) {
+	return (uint64_t)(CPU_CLOCK * ibm_pc->config.rewind_interval_ms / 1000.0);
+}
+
+static void rewind_update(void) {
+	/* Snapshot every rewind_interval_ms of emulated time; not while a journal owns the input */
+	if (ibm_pc->rewind.base == NULL || ibm_pc->journal.mode != JOURNAL_MODE_NONE) {
+		return;
+	}
+	uint64_t cycles = timing_virtual_get_cycles();
+	if (cycles < ibm_pc->rewind_next_cycle) {
+		return;
+	}
+	IBM_PC_STATE state;
+	ibm_pc_save_state(&state);
+	rewind_snapshot(&ibm_pc->rewind, cycles, &ibm_pc->mm, &state);
+	ibm_pc->rewind_next_cycle = cycles + rewind_interval_cycles();
+}
+
+static int rewind_step(void) {
+	/* One instruction; keys come from the rewind log */
+	isa_bus_update(&ibm_pc->isa_bus, ibm_pc->cpu.cycles);
+	dma_update();
+	pit_update();
+	kbd_update();
+	pic_update();
+	cpu_update();
+	return ibm_pc->cpu.cycles == 0; /* undefined opcode; the cpu is stuck */
+}
+
+static int rewind_restore_before(uint64_t cycle) {
+	int index = rewind_find(&ibm_pc->rewind, cycle);
+	if (index < 0 || ibm_pc->journal.mode != JOURNAL_MODE_NONE) {
+		return 1;
+	}
+	IBM_PC_STATE state;
+	rewind_restore(&ibm_pc->rewind, index, &ibm_pc->mm, &state);
+	ibm_pc_load_state(&state);
+	ibm_pc->rewind_next_cycle = state.cycles + rewind_interval_cycles();
+	return 0;
+}
 
-void ibm_pc_update(void) {
+int ibm_pc_rewind_to(uint64_t cycle) {
+	if (rewind_restore_before(cycle)) {
+		return 1;
+	}
+
+	ibm_pc->rewinding = 1;
+	ibm_pc->kbd.queue_disabled = 1;
+	while (timing_virtual_get_cycles() < cycle) {
+		if (rewind_step()) {
+			break;
+		}
+	}
+	ibm_pc->rewinding = 0;
+	ibm_pc->kbd.queue_disabled = 0;
+
+	/* the re-executed edges were heard the first time */
+	pc_speaker_restart(&ibm_pc->pc_speaker, timing_virtual_get_cycles());
+
+	/* the guest takes a new path from here */
+	rewind_truncate_keys(&ibm_pc->rewind, timing_virtual_get_cycles());
+
+	ibm_pc->step = 1;
+	ibm_pc->step_over_target = 0;
+	publish_video_frame();
+	return 0;
+}
+
+int ibm_pc_step_back(void) {
+	/* Instructions take a varying number of cycles; re-execute to find where the previous one started */
+	uint64_t current = timing_virtual_get_cycles();
+	if (current == 0 || rewind_restore_before(current - 1)) {
+		return 1;
+	}
+
+	uint64_t start = timing_virtual_get_cycles();
+	ibm_pc->rewinding = 1;
+	ibm_pc->kbd.queue_disabled = 1;
+	while (1) {
+		uint64_t cycle = timing_virtual_get_cycles();
+		if (rewind_step() || timing_virtual_get_cycles() >= current) {
+			start = cycle;
+			break;
+		}
+	}
+	ibm_pc->rewinding = 0;
+	ibm_pc->kbd.queue_disabled = 0;
+
+	return ibm_pc_rewind_to(start);
+}
+
+static void run_slice(void) {
+	ibm_pc->cpu_cycles = ibm_pc->cpu_accum;
+	ibm_pc->dma_cycles = 0;
+	ibm_pc->pit_cycles = 0;
+	ibm_pc->kbd_cycles = 0;
+	while (ibm_pc->cpu_cycles < ibm_pc->cpu_cycles_per_slice && !ibm_pc->step) {
+		if (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY) {
+			journal_update();
+		}
+		if (ibm_pc->perf.enabled && perf_sample_step(&ibm_pc->perf)) {
+			perf_timed_step();
+			continue;
+		}
+		isa_bus_update(&ibm_pc->isa_bus, ibm_pc->cpu.cycles);
+		dma_update();
+		pit_update();
+		kbd_update();
+		pic_update();
+		cpu_update();
+	}
+	if (ibm_pc->cpu_cycles >= ibm_pc->cpu_cycles_per_slice) {
+		ibm_pc->cpu_accum = ibm_pc->cpu_cycles - ibm_pc->cpu_cycles_per_slice;
+	}
+
+	rewind_update();
+}
+static void end_slice(void) {
+	/* Synthesize the speaker edges of this slice */
+	pc_speaker_update(&ibm_pc->pc_speaker, timing_virtual_get_cycles());
+
+	if (ibm_pc->perf.enabled) {
+		perf_update(&ibm_pc->perf, timing_virtual_get_cycles());
+	}
+	if (ibm_pc->heatmap.enabled) {
+		heatmap_update(&ibm_pc->heatmap, timing_virtual_get_cycles());
+	}
+}
+
+void ibm_pc_run_slice(void) {
+	/* No pacing; the benchmark runs on virtual time */
+	if (!ibm_pc->step) {
+		run_slice();
+	}
+	end_slice();
+}
+
+uint64_t ibm_pc_update(void) {
 	/* IBM PC Update loop; */
 
 	timing_new_frame(&ibm_pc->time);
 
 	if (timing_check_frame(&ibm_pc->time)) {
+		TRACE_BEGIN(TRACE_CAT_FRAME, "ibm_pc_update");
+
+		/* Key events queued during the last slice are spread over this one */
+		kbd_sync(&ibm_pc->kbd, timing_get_ticks_ns(), timing_virtual_get_cycles(), ibm_pc->cpu_cycles_per_slice);
 	
 		if (ibm_pc->step) {
 			if (ibm_pc->step == 2) {
 				ibm_pc->step = 1;
+				if (ibm_pc->journal.mode == JOURNAL_MODE_REPLAY) {
+					journal_update();
+				}
 				isa_bus_update(&ibm_pc->isa_bus, ibm_pc->cpu.cycles);
 				dma_update();
 				pit_update();
 				kbd_update();
 				pic_update();
 				cpu_update();
+
+				/* Show the result of the step; vsync may be frames away */
+				publish_video_frame();
 			}
 		}
 		else {
-			ibm_pc->cpu_cycles = ibm_pc->cpu_accum;
-			ibm_pc->dma_cycles = 0;
-			ibm_pc->pit_cycles = 0;
-			ibm_pc->kbd_cycles = 0;
-			while (ibm_pc->cpu_cycles < cpu_cycles_per_frame && !ibm_pc->step) {
-				isa_bus_update(&ibm_pc->isa_bus, ibm_pc->cpu.cycles);
-				dma_update();
-				pit_update();
-				kbd_update();
-				pic_update();
-				cpu_update();
-			}
-			if (ibm_pc->cpu_cycles >= cpu_cycles_per_frame) {
-				ibm_pc->cpu_accum = ibm_pc->cpu_cycles - cpu_cycles_per_frame;
-			}
+			run_slice();
+		}
+
+		end_slice();
+
+		/* Pace against the audio device queue when there is audio; the performance counter otherwise */
+		if (!ibm_pc->step) {
+			ibm_pc->time.rate = audio_get_rate(PC_SPEAKER_SAMPLE_RATE);
 		}
+		TRACE_END(TRACE_CAT_FRAME, "ibm_pc_update");
 	}
+
+	return timing_frame_remaining_ns(&ibm_pc->time);
+}
+
+void ibm_pc_set_time_slice(uint32_t slice_us) {
+	/* Run the emulator in short slices rather than a whole frame at a time; 
+	 * input is seen and vsync is published within a slice of the host time it happens at */
+	if (slice_us == 0 || slice_us > TIME_SLICE_US_MAX) {
+		slice_us = TIME_SLICE_US_MAX;
+	}
+	else if (slice_us < TIME_SLICE_US_MIN) {
+		slice_us = TIME_SLICE_US_MIN;
+	}
+
+	ibm_pc->config.time_slice_us = slice_us;
+	ibm_pc->cpu_cycles_per_slice = (uint64_t)(CPU_CLOCK * slice_us / 1000000.0);
+	timing_init_frame(&ibm_pc->time, slice_us / 1000.0);
+	ibm_pc->time.catch_up = ibm_pc->config.catch_up;
 }
 
 void ibm_pc_reset(void) {
@@ -899,6 +1615,10 @@ void ibm_pc_reset(void) {
 
 	ibm_pc->cpu_cycles = 0;
 	ibm_pc->cpu_accum = 0;
+	timing_virtual_reset();
+
+	rewind_clear(&ibm_pc->rewind);
+	ibm_pc->rewind_next_cycle = 0;
 
 	ibm_pc->pit_cycles = 0;
 	ibm_pc->pit_accum = 0;
@@ -917,6 +1637,8 @@ void ibm_pc_reset(void) {
 	i8255_ppi_reset(&ibm_pc->ppi);
 	i8259_pic_reset(&ibm_pc->pic);
 	kbd_reset(&ibm_pc->kbd);
+	int13_reset(&ibm_pc->int13);
+	pc_speaker_reset(&ibm_pc->pc_speaker);
 
 	isa_bus_reset(&ibm_pc->isa_bus);
 
@@ -964,6 +1686,9 @@ void ibm_pc_load_disks(void) {
 				fdd_eject_disk(&ibm_pc->fdc.fdd[drive]);
 				fdd_insert_disk(&ibm_pc->fdc.fdd[drive], ibm_pc->config.disks[i].path);
 				fdd_write_protect(&ibm_pc->fdc.fdd[drive], ibm_pc->config.disks[i].write_protect);
+				if (ibm_pc->config.disks[i].overlay[0] != '\0') {
+					fdd_attach_overlay(&ibm_pc->fdc.fdd[drive], ibm_pc->config.disks[i].overlay);
+				}
 			}
 		}
 	}
@@ -992,11 +1717,44 @@ void ibm_pc_load_hdds(void) {
 				xebec_hdc_eject_hdd(&ibm_pc->xebec, drive);
 				xebec_hdc_set_geometry_override_hdd(&ibm_pc->xebec, drive, ibm_pc->config.hdds[i].geometry, ibm_pc->config.hdds[i].type);
 				xebec_hdc_insert_hdd(&ibm_pc->xebec, drive, ibm_pc->config.hdds[i].path);
+				if (ibm_pc->config.hdds[i].overlay[0] != '\0') {
+					xebec_hdc_attach_overlay_hdd(&ibm_pc->xebec, drive, ibm_pc->config.hdds[i].overlay);
+				}
 			}
 		}
 	}
 }
 
+void ibm_pc_load_instant_disk(void) {
+	if (!ibm_pc->config.instant_disk) {
+		return;
+	}
+
+	/* The VBLK ROM is installed after this one; refuse rather than be overwritten by it */
+	uint32_t address = ibm_pc->config.int13_rom_address;
+	uint32_t vblk_address = ibm_pc->config.vblk_rom_address;
+	if (ibm_pc->config.vblk_path[0] != '\0' && address < vblk_address + VBLK_ROM_SIZE && vblk_address < address + INT13_ROM_SIZE) {
+		log_error("[INT13] Option ROM at %05X overlaps the VBLK option ROM at %05X; instant disk disabled\n", address, vblk_address);
+		ibm_pc->config.instant_disk = 0;
+		return;
+	}
+
+	if (int13_install_rom(&ibm_pc->int13, ibm_pc->mm.mem, address)) {
+		log_error("[INT13] Instant disk disabled\n");
+		ibm_pc->config.instant_disk = 0;
+	}
+}
+
+void ibm_pc_load_vblk(void) {
+	if (ibm_pc->config.vblk_path[0] == '\0') {
+		return;
+	}
+	if (vblk_insert(&ibm_pc->vblk, ibm_pc->config.vblk_path)) {
+		return;
+	}
+	vblk_install_rom(&ibm_pc->vblk, ibm_pc->config.vblk_rom_address, VBLK_BASE_ADDRESS);
+}
+
 void ibm_pc_init(void) {
 	/* IBM PC Initialize */
 
@@ -1011,8 +1769,11 @@ void ibm_pc_init(void) {
 
 	/* Setup 8086 CPU */
 	i8086_init(&ibm_pc->cpu);
-	ibm_pc->cpu.funcs.read_mem_byte  = read_mm_byte;
-	ibm_pc->cpu.funcs.write_mem_byte = write_mm_byte;
+	ibm_pc->cpu.funcs.read_mem_byte  = ibm_pc->config.heatmap ? heatmap_read_mm_byte : read_mm_byte;
+	ibm_pc->cpu.funcs.write_mem_byte = ibm_pc->config.heatmap ? heatmap_write_mm_byte : write_mm_byte;
+	if (ibm_pc->config.itrace_path[0] != '\0') {
+		ibm_pc->cpu.funcs.write_mem_byte = itrace_write_mm_byte;
+	}
 	ibm_pc->cpu.funcs.read_io_byte   = read_io_byte;
 	ibm_pc->cpu.funcs.write_io_byte  = write_io_byte;
 
@@ -1039,11 +1800,23 @@ void ibm_pc_init(void) {
 	/* Setup XEBEC */
 	xebec_hdc_init(&ibm_pc->xebec, &ibm_pc->dma, &ibm_pc->pic);
 
-	/* Setup KBD */
+	/* Setup VBLK */
+	vblk_init(&ibm_pc->vblk, &ibm_pc->mm);
+
+	/* Setup Video; a frame is published to the render thread at each vsync */
+	video_frame_buffer_reset(&ibm_pc->video_frames);
+	mda_set_vsync_cb(&ibm_pc->mda, video_on_vsync);
+	cga_set_vsync_cb(&ibm_pc->cga, video_on_vsync);
+
+	/* Setup KBD; delivered keys are recorded to the journal */
 	kbd_init(&ibm_pc->kbd, &ibm_pc->pic);
+	kbd_set_key_cb(&ibm_pc->kbd, kbd_on_key);
+
+	/* Setup Instant Disk; INT 13h. The trap peeks at the IVT and the stack; its reads are not counted by the heatmap */
+	int13_init(&ibm_pc->int13, ibm_pc->fdc.fdd, ibm_pc->config.fdc_disks, ibm_pc->xebec.hdd, HDD_MAX, read_mm_byte, ibm_pc->cpu.funcs.write_mem_byte);
 
-	/* Setup DMA */
-	i8237_dma_init(&ibm_pc->dma, read_mm_byte, write_mm_byte);
+	/* Setup DMA; the transfers are data reads and writes */
+	i8237_dma_init(&ibm_pc->dma, ibm_pc->cpu.funcs.read_mem_byte, ibm_pc->cpu.funcs.write_mem_byte);
 	
 	/* Setup Memory Map Regions */
 
@@ -1075,6 +1848,11 @@ void ibm_pc_init(void) {
 	/* XEBEC Card; */
 	isa_card_add_xebec(&ibm_pc->isa_bus, &ibm_pc->xebec);
 
+	/* VBLK Card; option ROM - 0xD0000 - 0xD07FF (0x800 2K) by default. Only if an image is set; the port is free otherwise */
+	if (ibm_pc->config.vblk_path[0] != '\0') {
+		isa_card_add_vblk(&ibm_pc->isa_bus, &ibm_pc->vblk);
+	}
+
 	/* After all mregions are set; validate the memory map */
 	memory_map_validate(&ibm_pc->mm);
 	
@@ -1089,8 +1867,53 @@ void ibm_pc_init(void) {
 	/* Load Hdds */
 	ibm_pc_load_hdds();
 
-	/* Setup timing; we base all timing off 60 HZ */
-	timing_init_frame(&ibm_pc->time, HZ_TO_MS(FRAME_RATE_HZ));
+	/* Load Instant Disk; after the ROMs so the generated option ROM is not overwritten */
+	ibm_pc_load_instant_disk();
+
+	/* Load VBLK; after the ROMs so the generated option ROM is not overwritten */
+	ibm_pc_load_vblk();
+
+	/* Setup Rewind; snapshots of the device state and the memory pages written since the last snapshot */
+	if (ibm_pc->config.rewind_budget_kb != 0) {
+		if (ibm_pc->config.rewind_interval_ms == 0) {
+			ibm_pc->config.rewind_interval_ms = REWIND_INTERVAL_MS_DEFAULT;
+		}
+		rewind_create(&ibm_pc->rewind, MEM_SIZE, sizeof(IBM_PC_STATE), (size_t)ibm_pc->config.rewind_budget_kb * 1024);
+	}
+
+	/* Setup tracing; the trace points cost a branch if disabled */
+	if (ibm_pc->config.trace_path[0] != '\0') {
+		trace_create(TRACE_CAT_FRAME | TRACE_CAT_GUEST | (ibm_pc->config.trace_devices ? TRACE_CAT_DEVICE : 0));
+	}
+
+	/* Setup performance counters; nothing is counted or timed if disabled */
+	if (ibm_pc->config.perf) {
+		perf_create(&ibm_pc->perf, CPU_CLOCK);
+	}
+
+	/* Setup the guest profiler; a countdown per instruction if enabled, the work is per sample */
+	if (ibm_pc->config.profile_path[0] != '\0') {
+		profiler_create(&ibm_pc->profiler, ibm_pc->config.profile_interval);
+	}
+
+	/* Setup code coverage; a bit set per instruction if enabled */
+	if (ibm_pc->config.coverage_dir[0] != '\0') {
+		coverage_create(&ibm_pc->coverage);
+	}
+
+	/* Setup the memory heatmap; the memory callbacks count through the heatmap path if enabled */
+	if (ibm_pc->config.heatmap) {
+		heatmap_create(&ibm_pc->heatmap, CPU_CLOCK);
+	}
+
+	/* Setup the instruction trace; a record per instruction into the ring if enabled */
+	if (ibm_pc->config.itrace_path[0] != '\0') {
+		itrace_create(&ibm_pc->itrace, ibm_pc->config.itrace_kb, ibm_pc->config.itrace_stream ? ibm_pc->config.itrace_path : NULL);
+	}
+
+	/* Setup timing; devices run off the cpu clock, the emulator runs in time slices of up to one 60 HZ frame */
+	timing_virtual_init(CPU_CLOCK);
+	ibm_pc_set_time_slice(ibm_pc->config.time_slice_us);
 }
 
 void ibm_pc_destroy_config(void) {
@@ -1113,12 +1936,12 @@ int ibm_pc_create(void) {
 
 	ibm_pc = calloc(1, sizeof(IBM_PC));
 	if (ibm_pc == NULL) {
-		dbg_print("Failed to allocate memory for IBM_PC\n");
+		log_error("Failed to allocate memory for IBM_PC\n");
 		return 1;
 	}
 
 	/* Create Memory Map; 6 MRegions */
-	if (memory_map_create(&ibm_pc->mm, MEM_SIZE, 6)) {
+	if (memory_map_create(&ibm_pc->mm, MEM_SIZE, IBM_PC_MREGIONS)) {
 		return 1; /* memory_map_create() reports errors to console */
 	}
 	
@@ -1137,20 +1960,88 @@ int ibm_pc_create(void) {
 		return 1; /* xebec_hdc_create() reports errors to console */
 	}
 
+	/* Create vblk */
+	if (vblk_create(&ibm_pc->vblk)) {
+		return 1; /* vblk_create() reports errors to console */
+	}
+
 	/* Create kbd */
 	if (kbd_create(&ibm_pc->kbd)) {
 		return 1; /* kbd_create() reports errors to console */
 	}
 
+	/* Create pc speaker; edges are stamped with the cpu clock */
+	if (pc_speaker_create(&ibm_pc->pc_speaker, CPU_CLOCK)) {
+		return 1; /* pc_speaker_create() reports errors to console */
+	}
+
 	return 0; /* success */
 }
 void ibm_pc_destroy(void) {
 	/* IBM PC Destroy */
 	if (ibm_pc != NULL) {
 
+		/* Destroy rewind */
+		rewind_destroy(&ibm_pc->rewind);
+
+		/* Stop journal; a recording is written out */
+		journal_stop(&ibm_pc->journal);
+
+		/* Write the performance counters; to stdout when headless */
+		if (ibm_pc->perf.enabled) {
+			if (ibm_pc->config.perf_path[0] != '\0') {
+				perf_write_json(&ibm_pc->perf, &ibm_pc->mm, ibm_pc->config.perf_path);
+			}
+			else if (ibm_pc->config.video_adapter == VIDEO_ADAPTER_NONE) {
+				perf_write_json(&ibm_pc->perf, &ibm_pc->mm, NULL);
+			}
+		}
+		perf_destroy(&ibm_pc->perf);
+
+		/* Write the memory heatmap; before the disassembly below reads through the counting callbacks */
+		if (ibm_pc->heatmap.enabled && ibm_pc->config.heatmap_path[0] != '\0') {
+			heatmap_write_csv(&ibm_pc->heatmap, ibm_pc->config.heatmap_path);
+		}
+		heatmap_destroy(&ibm_pc->heatmap);
+
+		/* Write the guest profile */
+		if (ibm_pc->profiler.enabled) {
+			profiler_write_report(&ibm_pc->profiler, &ibm_pc->mnem, ibm_pc->config.profile_path);
+		}
+		profiler_destroy(&ibm_pc->profiler);
+
+		/* Write the code coverage of each ROM; merged with other runs in the directory */
+		if (ibm_pc->coverage.enabled) {
+			for (size_t i = 0; i < ibm_pc->config.rom_count; ++i) {
+				size_t size = 0;
+				if (file_get_file_size(ibm_pc->config.roms[i].path, &size)) {
+					coverage_write_rom(&ibm_pc->coverage, &ibm_pc->mnem, ibm_pc->mm.mem, ibm_pc->config.roms[i].path, ibm_pc->config.roms[i].address, (uint32_t)size, ibm_pc->config.coverage_dir);
+				}
+			}
+		}
+		coverage_destroy(&ibm_pc->coverage);
+
+		/* Write the instruction trace; the ring, or the rest of the stream */
+		if (ibm_pc->itrace.enabled) {
+			itrace_write(&ibm_pc->itrace, ibm_pc->config.itrace_path);
+		}
+		itrace_destroy(&ibm_pc->itrace);
+
+		/* Write the trace; the emulation and render threads have stopped */
+		if (trace_mask != 0) {
+			trace_write_json(ibm_pc->config.trace_path);
+		}
+		trace_destroy();
+
+		/* Destroy pc speaker */
+		pc_speaker_destroy(&ibm_pc->pc_speaker);
+
 		/* Destroy kbd */
 		kbd_destroy(&ibm_pc->kbd);
 
+		/* Destroy vblk */
+		vblk_destroy(&ibm_pc->vblk);
+
 		/* Destroy hdc */
 		xebec_hdc_destroy(&ibm_pc->xebec);
 
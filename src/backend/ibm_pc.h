@@ -19,9 +19,22 @@
 #include "chipset/nmi.h"
 #include "video/mda.h"
 #include "video/cga.h"
+#include "video/video_frame.h"
 #include "fdc/fdc.h"
 #include "hdc/xebec.h"
+#include "hdc/vblk.h"
 #include "keyboard.h"
+#include "int13.h"
+#include "journal.h"
+#include "rewind.h"
+#include "warm_boot.h"
+#include "pc_speaker.h"
+#include "perf.h"
+#include "profiler.h"
+#include "coverage.h"
+#include "heatmap.h"
+#include "bench.h"
+#include "itrace.h"
 
 #include "timing.h"
 
@@ -39,6 +52,15 @@
 /* cycles per frame */
 #define CYCLES_PER_FRAME(clock_hz) (clock_hz / FRAME_RATE_HZ)
 
+/* Emulation time slice in us; the emulator runs in slices paced against the host clock */
+#define TIME_SLICE_US_DEFAULT 1000
+#define TIME_SLICE_US_MIN     100
+#define TIME_SLICE_US_MAX     ((uint32_t)(1000000.0 / FRAME_RATE_HZ)) /* one frame */
+
+/* Rewind; snapshot interval in emulated ms and memory budget in KB */
+#define REWIND_INTERVAL_MS_DEFAULT 100
+#define REWIND_BUDGET_KB_DEFAULT   16384
+
 /* CPU Clock */
 #define CPU_CLOCK_DIVISOR 3.0                         /* cpu clock divsor */
 #define CPU_CLOCK (CYSTRAL_14MHZ / CPU_CLOCK_DIVISOR) /* cpu clock in Hz */
@@ -88,17 +110,13 @@
 #define MODEL_5150_64_256 1 /* 5150 64-256 KB Motherboard */
 #define MODEL_5160        2 /* 5160 Motherboard */
 
-#define ISA_BUS_SLOTS 5 /* number of Card Slots on ISA BUS */
+#define ISA_BUS_SLOTS 6 /* number of Card Slots on ISA BUS */
 
 static uint64_t const cpu_cycles_per_frame = (uint64_t)CYCLES_PER_FRAME(CPU_CLOCK);
 static uint64_t const pit_cycles_per_frame = (uint64_t)CYCLES_PER_FRAME(PIT_CLOCK);
 static uint64_t const dma_cycles_per_frame = (uint64_t)CYCLES_PER_FRAME(DMA_CLOCK);
 static uint64_t const fdc_cycles_per_frame = (uint64_t)CYCLES_PER_FRAME(FDC_CLOCK);
 
-typedef struct PC_SPEAKER {
-	uint8_t input;
-} PC_SPEAKER;
-
 #define PATH_LEN 256
 
 typedef struct {
@@ -108,12 +126,14 @@ typedef struct {
 
 typedef struct {
 	char path[PATH_LEN];
+	char overlay[PATH_LEN];
 	uint8_t drive;
 	uint8_t write_protect;
 } DISK;
 
 typedef struct {
 	char path[PATH_LEN];
+	char overlay[PATH_LEN];
 	uint8_t drive;
 	CHS geometry;
 	XEBEC_HDD_TYPE type;
@@ -135,8 +155,66 @@ typedef struct IBM_PC_CONFIG {
 	size_t rom_count;
 	HDD* hdds;
 	size_t hdd_count;
+	uint8_t instant_disk; /* service INT 13h directly from the disk buffers */
+	uint32_t int13_rom_address; /* instant disk option ROM address */
+	char vblk_path[PATH_LEN];  /* paravirtual block device image */
+	uint32_t vblk_rom_address; /* paravirtual block device option ROM address */
+	uint32_t time_slice_us;    /* emulation time slice in us; 0 = one frame */
+	uint8_t catch_up;          /* TIMING_CATCH_UP_XXX; late time slices */
+	char record_path[PATH_LEN];  /* record the input journal to this file */
+	char replay_path[PATH_LEN];  /* replay the input journal from this file */
+	uint32_t rewind_budget_kb;   /* rewind memory budget in KB; 0 = rewind disabled */
+	uint32_t rewind_interval_ms; /* emulated time between rewind snapshots */
+	char warm_boot_dir[PATH_LEN]; /* warm boot cache directory; empty = warm boot disabled */
+	uint8_t warm_boot_int;        /* snapshot when the guest is about to execute INT warm_boot_int */
+	uint8_t perf;                 /* performance counters */
+	char perf_path[PATH_LEN];     /* write the performance counters as JSON to this file at exit */
+	char trace_path[PATH_LEN];    /* write a Chrome trace_event JSON to this file at exit; empty = tracing disabled */
+	uint8_t trace_devices;        /* trace the device updates of every step */
+	char profile_path[PATH_LEN];  /* write the guest profile to this file at exit; empty = profiler disabled */
+	uint32_t profile_interval;    /* cycles between guest profile samples; 0 = default */
+	char coverage_dir[PATH_LEN];  /* write the code coverage of each ROM to this directory at exit; empty = coverage disabled */
+	uint8_t heatmap;              /* memory heatmap */
+	char heatmap_path[PATH_LEN];  /* write the memory heatmap as CSV to this file at exit */
+	uint8_t bench_scenario;         /* BENCH_XXX; BENCH_NONE = run the emulator */
+	char bench_path[PATH_LEN];      /* write the benchmark results as JSON to this file; empty = stdout */
+	char bench_baseline[PATH_LEN];  /* compare the benchmark results to this file; empty = no compare */
+	uint32_t bench_tolerance;       /* % slower than the baseline that is a regression */
+	char itrace_path[PATH_LEN];     /* write the instruction trace to this file; empty = instruction trace disabled */
+	uint32_t itrace_kb;             /* instruction trace ring size in KB */
+	uint8_t itrace_stream;          /* stream every block of the instruction trace to the file; not just the ring at exit */
+	uint8_t log_level;              /* LOG_LEVEL_XXX; the level of every category */
+	char log_categories[256];       /* category levels over log_level; "fdc=debug,io=none" */
 } IBM_PC_CONFIG;
 
+#define IBM_PC_MREGIONS 6
+
+/* Device state; everything but memory and the disks in the drives */
+typedef struct IBM_PC_STATE {
+	uint64_t cycles; /* virtual clock */
+	I8086 cpu;
+	I8237_DMA dma;
+	I8253_PIT pit;
+	I8259_PIC pic;
+	I8255_PPI ppi;
+	NMI nmi;
+	MDA mda;
+	CGA cga;
+	INT13 int13;
+	FDC_STATE fdc;
+	XEBEC_HDC_STATE xebec;
+	KBD_STATE kbd;
+	uint8_t vblk_drive;
+	uint8_t vblk_status;
+	uint32_t vblk_address;
+	PC_SPEAKER_STATE pc_speaker;
+	uint8_t timer2_gate;
+	uint64_t pit_accum;
+	uint64_t dma_accum;
+	uint64_t kbd_accum;
+	MEMORY_REGION regions[IBM_PC_MREGIONS];
+} IBM_PC_STATE;
+
 typedef struct IBM_PC {
 	I8086 cpu;
 	I8086_MNEM mnem;
@@ -150,6 +228,8 @@ typedef struct IBM_PC {
 	I8255_PPI ppi;
 	FDC fdc;
 	XEBEC_HDC xebec;
+	INT13 int13;
+	VBLK vblk;
 	MDA mda;
 	CGA cga;
 
@@ -157,6 +237,7 @@ typedef struct IBM_PC {
 
 	uint64_t cpu_accum;
 	uint64_t cpu_cycles;
+	uint64_t cpu_cycles_per_slice;
 	
 	uint64_t pit_accum;
 	uint64_t pit_cycles;
@@ -172,7 +253,26 @@ typedef struct IBM_PC {
 	NMI nmi;
 	PC_SPEAKER pc_speaker;
 
+	VIDEO_FRAME_BUFFER video_frames; /* video snapshots published at vsync; read by the render thread */
+
+	JOURNAL journal; /* external events; recorded or replayed at the emulated cycle they happen at */
+
+	REWIND rewind;               /* snapshots to step back to; base is NULL if rewind is disabled */
+	uint64_t rewind_next_cycle;  /* take the next snapshot at */
+	uint8_t rewinding;           /* re-executing from a snapshot; keys come from the rewind log */
+
+	uint8_t warm_boot_armed;     /* POST is running; snapshot at the warm boot milestone */
+	void(*on_post_done)(void);   /* called at the warm boot milestone instead of the snapshot; NULL = snapshot */
+	uint64_t warm_boot_key;      /* hash of the machine config */
+
 	uint8_t timer2_gate;       /* timer2 gate */
+
+	PERF perf; /* performance counters; enabled is 0 if disabled */
+	PROFILER profiler; /* guest profiler; enabled is 0 if disabled */
+	COVERAGE coverage; /* guest code coverage; enabled is 0 if disabled */
+	HEATMAP heatmap;   /* memory heatmap; enabled is 0 if disabled */
+	BENCH bench;       /* benchmark; enabled while a scenario is measured */
+	ITRACE itrace;     /* instruction trace; enabled is 0 if disabled */
 	
 	IBM_PC_CONFIG config;
 
@@ -190,7 +290,12 @@ void ibm_pc_destroy(void);
 
 void ibm_pc_init(void);
 void ibm_pc_reset(void);
-void ibm_pc_update(void);
+/* Run the next time slice if it is due
+	Returns: the host time in ns until the next time slice is due */
+uint64_t ibm_pc_update(void);
+
+/* Run a time slice now; no pacing. For running on virtual time */
+void ibm_pc_run_slice(void);
 
 void ibm_pc_add_rom(ROM* rom);
 void ibm_pc_load_roms(void);
@@ -201,8 +306,54 @@ void ibm_pc_load_disks(void);
 void ibm_pc_add_hdd(HDD* hdd);
 void ibm_pc_load_hdds(void);
 
+void ibm_pc_load_instant_disk(void);
+void ibm_pc_load_vblk(void);
+
+/* Start recording or replaying the input journal from the config; from the current (reset) state */
+void ibm_pc_start_journal(void);
+
+/* Resume from the warm boot cache if it has a snapshot for this config. Otherwise take one when
+ * the guest reaches the milestone. Call after the hard reset. Not used with a journal */
+void ibm_pc_warm_boot(void);
+
+/* Call a function when POST is done; the guest is about to execute INT warm_boot_int. Call after the hard reset
+	on_post_done: the function; called on the emulation thread. It may redirect the cpu */
+void ibm_pc_watch_post(void(*on_post_done)(void));
+
+/* Save/Load the device state
+	state: the state */
+void ibm_pc_save_state(IBM_PC_STATE* state);
+void ibm_pc_load_state(const IBM_PC_STATE* state);
+
+/* Restore the nearest rewind snapshot and re-execute to a cycle; stops in single step
+	cycle: the target cycle
+	Returns: 0 if success. 1 if there is no snapshot at or before the cycle */
+int ibm_pc_rewind_to(uint64_t cycle);
+
+/* Rewind to the start of the previous instruction; stops in single step
+	Returns: 0 if success. Otherwise 1 */
+int ibm_pc_step_back(void);
+
+/* External events. Recorded to the journal when recording; ignored while replaying
+	Returns: 0 if success. Otherwise 1 */
+int ibm_pc_event_reset(void);
+int ibm_pc_event_insert_disk(uint8_t drive, const char* path);
+int ibm_pc_event_eject_disk(uint8_t drive);
+int ibm_pc_event_new_disk(uint8_t drive, uint32_t size);
+int ibm_pc_event_insert_hdd(uint8_t drive, const char* path);
+int ibm_pc_event_eject_hdd(uint8_t drive);
+
 void ibm_pc_set_config(void);
 
+/* Set the emulation time slice
+	slice_us: the slice time in us; 0 = one frame. Clamped to TIME_SLICE_US_MIN - TIME_SLICE_US_MAX */
+void ibm_pc_set_time_slice(uint32_t slice_us);
+
+/* Read a memory byte for the debugger; not counted by the perf counters or the heatmap
+	addr: the physical address
+	Returns: the byte */
+uint8_t ibm_pc_peek_mem_byte(uint20_t addr);
+
 uint8_t determine_planar_ram_sw(uint20_t planar_ram);
 uint8_t determine_io_ram_sw(uint20_t planar_ram, uint20_t io_ram);
 uint20_t determine_planar_ram_size(uint8_t sw1);
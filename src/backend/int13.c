@@ -0,0 +1,340 @@
+/* int13.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Instant disk; BIOS disk services (INT 13h) serviced directly from the disk buffers
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "int13.h"
+
+#include "i8086.h"
+#include "fdc/fdd.h"
+#include "hdc/xebec_hdd.h"
+#include "utility/lba.h"
+
+#define LOG_CATEGORY LOG_CAT_DISK
+#include "utility/log.h"
+
+#define SECTOR_SIZE 512
+
+#define BDA_FDD_STATUS 0x441 /* 40:41 - diskette status */
+#define BDA_HDD_STATUS 0x474 /* 40:74 - fixed disk status */
+
+#define IS_HDD(drive) ((drive) & 0x80)
+
+/* INT 13h functions (AH) */
+#define INT13_RESET          0x00
+#define INT13_GET_STATUS     0x01
+#define INT13_READ           0x02
+#define INT13_WRITE          0x03
+#define INT13_VERIFY         0x04
+#define INT13_GET_PARAMETERS 0x08
+#define INT13_SEEK           0x0C
+#define INT13_ALT_RESET      0x0D
+#define INT13_TEST_READY     0x10
+#define INT13_RECALIBRATE    0x11
+
+#define IVT_INT13 0x4C /* 00:4C - INT 13h vector */
+
+/* Option ROM offsets */
+#define ROM_INIT    0x03 /* trapped; hooks INT 13h, then the retf executes */
+#define ROM_HANDLER 0x04 /* trapped; the handler never executes the iret */
+
+/* Option ROM; the code is trapped before it executes */
+static const uint8_t int13_rom[] = {
+	0x55, 0xAA, INT13_ROM_SIZE / 512, /* option ROM signature, size in 512 byte blocks */
+	0xCB,                             /* init: retf              */
+	0xCF,                             /* int13: iret             */
+};
+
+static void set_status(INT13* int13, I8086* cpu, uint8_t drive, uint8_t status) {
+	cpu->registers[REG_AX].h = status;
+	cpu->status.cf = (status != INT13_STATUS_OK);
+
+	if (IS_HDD(drive)) {
+		int13->hdd_status = status;
+		int13->write_mem_byte(BDA_HDD_STATUS, status);
+	}
+	else {
+		int13->fdd_status = status;
+		int13->write_mem_byte(BDA_FDD_STATUS, status);
+	}
+}
+
+static uint8_t get_hdd_count(INT13* int13) {
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < int13->hdd_count; ++i) {
+		if (int13->hdd[i].inserted) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static uint8_t disk_read_byte(INT13* int13, uint8_t drive, size_t offset) {
+	if (IS_HDD(drive)) {
+		return xebec_hdd_read_byte(&int13->hdd[drive & 0x7F], offset);
+	}
+	else {
+		return fdd_read_byte(&int13->fdd[drive], offset);
+	}
+}
+static int disk_write_byte(INT13* int13, uint8_t drive, size_t offset, uint8_t value) {
+	if (IS_HDD(drive)) {
+		return xebec_hdd_write_byte(&int13->hdd[drive & 0x7F], offset, value);
+	}
+	else {
+		return fdd_write_byte(&int13->fdd[drive], offset, value);
+	}
+}
+
+static uint8_t transfer(INT13* int13, I8086* cpu, uint8_t drive, CHS geometry, uint8_t function) {
+	/* AL = sector count, CH = cylinder, CL = sector, DH = head, ES:BX = buffer;
+	   fixed disks take cylinder bits 8,9 from CL bits 6,7 */
+	uint8_t count = cpu->registers[REG_AX].l;
+	CHS chs = { 0 };
+	chs.c = cpu->registers[REG_CX].h;
+	chs.h = cpu->registers[REG_DX].h;
+	chs.s = cpu->registers[REG_CX].l;
+	if (IS_HDD(drive)) {
+		chs.c |= (chs.s & 0xC0) << 2;
+		chs.s &= 0x3F;
+	}
+
+	cpu->registers[REG_AX].l = 0;
+
+	if (chs.s == 0 || chs.s > geometry.s || chs.h >= geometry.h || chs.c >= geometry.c) {
+		return INT13_STATUS_SECTOR_NOT_FOUND;
+	}
+
+	LBA lba = chs_to_lba(geometry, chs);
+	LBA total = (LBA)geometry.c * geometry.h * geometry.s;
+	uint16_t segment = cpu->segments[SEG_ES];
+	uint16_t address = cpu->registers[REG_BX].r16;
+
+	for (uint8_t i = 0; i < count; ++i) {
+		if (lba + i >= total) {
+			return INT13_STATUS_SECTOR_NOT_FOUND;
+		}
+
+		size_t offset = lba_to_offset(lba + i, SECTOR_SIZE, 0);
+
+		/* Transfer directly between the disk buffer and guest RAM; no DMA, no IRQ */
+		switch (function) {
+			case INT13_READ:
+				for (uint16_t j = 0; j < SECTOR_SIZE; ++j) {
+					int13->write_mem_byte(i8086_get_physical_address(segment, address++), disk_read_byte(int13, drive, offset + j));
+				}
+				break;
+			case INT13_WRITE:
+				for (uint16_t j = 0; j < SECTOR_SIZE; ++j) {
+					if (disk_write_byte(int13, drive, offset + j, int13->read_mem_byte(i8086_get_physical_address(segment, address++)))) {
+						return INT13_STATUS_CONTROLLER_FAIL;
+					}
+				}
+				break;
+		}
+
+		cpu->registers[REG_AX].l++;
+	}
+
+	return INT13_STATUS_OK;
+}
+
+static int service_fdd(INT13* int13, I8086* cpu, uint8_t drive) {
+	if (drive >= int13->fdd_count) {
+		return 0; /* no such drive; let the guest BIOS report it */
+	}
+
+	FDD_DISK* fdd = &int13->fdd[drive];
+	uint8_t function = cpu->registers[REG_AX].h;
+
+	switch (function) {
+		case INT13_RESET:
+			set_status(int13, cpu, drive, INT13_STATUS_OK);
+			return 1;
+
+		case INT13_GET_STATUS:
+			cpu->registers[REG_AX].l = int13->fdd_status;
+			set_status(int13, cpu, drive, INT13_STATUS_OK);
+			return 1;
+
+		case INT13_READ:
+		case INT13_WRITE:
+		case INT13_VERIFY:
+			if (!fdd->status.inserted) {
+				cpu->registers[REG_AX].l = 0;
+				set_status(int13, cpu, drive, INT13_STATUS_TIMEOUT);
+				return 1;
+			}
+			if (function == INT13_WRITE && fdd->status.write_protect) {
+				cpu->registers[REG_AX].l = 0;
+				set_status(int13, cpu, drive, INT13_STATUS_WRITE_PROTECTED);
+				return 1;
+			}
+			set_status(int13, cpu, drive, transfer(int13, cpu, drive, fdd->geometry, function));
+			return 1;
+	}
+
+	return 0; /* format, get parameters, etc; let the guest BIOS handle it */
+}
+
+static int service_hdd(INT13* int13, I8086* cpu, uint8_t drive) {
+	uint8_t index = drive & 0x7F;
+	if (index >= int13->hdd_count || !int13->hdd[index].inserted || int13->hdd[index].geometry == NULL) {
+		return 0; /* no such drive; let the guest BIOS report it */
+	}
+
+	XEBEC_HDD* hdd = &int13->hdd[index];
+	CHS geometry = hdd->geometry->chs;
+	uint8_t function = cpu->registers[REG_AX].h;
+
+	switch (function) {
+		case INT13_RESET:
+		case INT13_SEEK:
+		case INT13_ALT_RESET:
+		case INT13_TEST_READY:
+		case INT13_RECALIBRATE:
+			set_status(int13, cpu, drive, INT13_STATUS_OK);
+			return 1;
+
+		case INT13_GET_STATUS:
+			cpu->registers[REG_AX].l = int13->hdd_status;
+			set_status(int13, cpu, drive, INT13_STATUS_OK);
+			return 1;
+
+		case INT13_READ:
+		case INT13_WRITE:
+		case INT13_VERIFY:
+			set_status(int13, cpu, drive, transfer(int13, cpu, drive, geometry, function));
+			return 1;
+
+		case INT13_GET_PARAMETERS: {
+			/* CH = max cylinder, CL = max sector | max cylinder bits 8,9, DH = max head, DL = drive count */
+			uint16_t max_cylinder = geometry.c - 1;
+			cpu->registers[REG_CX].h = max_cylinder & 0xFF;
+			cpu->registers[REG_CX].l = ((max_cylinder >> 2) & 0xC0) | (geometry.s & 0x3F);
+			cpu->registers[REG_DX].h = geometry.h - 1;
+			cpu->registers[REG_DX].l = get_hdd_count(int13);
+			cpu->registers[REG_AX].l = 0;
+			set_status(int13, cpu, drive, INT13_STATUS_OK);
+		} return 1;
+	}
+
+	return 0; /* format, diagnostics, etc; let the guest BIOS handle it */
+}
+
+void int13_init(INT13* int13, FDD_DISK* fdd, uint8_t fdd_count, XEBEC_HDD* hdd, uint8_t hdd_count,
+	uint8_t(*read_mem_byte)(uint32_t), void(*write_mem_byte)(uint32_t, uint8_t)) {
+	int13->fdd = fdd;
+	int13->fdd_count = fdd_count;
+	int13->hdd = hdd;
+	int13->hdd_count = hdd_count;
+	int13->read_mem_byte = read_mem_byte;
+	int13->write_mem_byte = write_mem_byte;
+	int13_reset(int13);
+}
+
+void int13_reset(INT13* int13) {
+	int13->fdd_status = INT13_STATUS_OK;
+	int13->hdd_status = INT13_STATUS_OK;
+	int13->requests = 0;
+}
+
+int int13_service(INT13* int13, I8086* cpu) {
+	uint8_t drive = cpu->registers[REG_DX].l;
+	int serviced = 0;
+
+	if (IS_HDD(drive)) {
+		serviced = service_hdd(int13, cpu, drive);
+	}
+	else {
+		serviced = service_fdd(int13, cpu, drive);
+	}
+
+	if (serviced) {
+		int13->requests++;
+	}
+	return serviced;
+}
+
+static uint16_t read_word(INT13* int13, uint32_t address) {
+	return int13->read_mem_byte(address & 0xFFFFF) | (int13->read_mem_byte((address + 1) & 0xFFFFF) << 8);
+}
+static void write_word(INT13* int13, uint32_t address, uint16_t value) {
+	int13->write_mem_byte(address & 0xFFFFF, value & 0xFF);
+	int13->write_mem_byte((address + 1) & 0xFFFFF, (value >> 8) & 0xFF);
+}
+
+static void hook(INT13* int13) {
+	/* Chain the previous INT 13h handler; the XEBEC and VBLK option ROMs hook INT 13h before this one */
+	int13->chain[0] = read_word(int13, IVT_INT13);
+	int13->chain[1] = read_word(int13, IVT_INT13 + 2);
+	write_word(int13, IVT_INT13, ROM_HANDLER);
+	write_word(int13, IVT_INT13 + 2, (int13->rom_address >> 4) & 0xFFFF);
+	log_info("[INT13] INT 13h hooked; chains %04X:%04X\n", int13->chain[1], int13->chain[0]);
+}
+
+static void iret(INT13* int13, I8086* cpu) {
+	/* Return to the caller; CF is the result, the other flags are the caller's */
+	uint32_t sp = i8086_get_physical_address(cpu->segments[SEG_SS], cpu->registers[REG_SP].r16);
+	uint16_t ip = read_word(int13, sp);
+	uint16_t cs = read_word(int13, sp + 2);
+	uint16_t flags = read_word(int13, sp + 4);
+	cpu->status.word = (flags & ~0x0001) | cpu->status.cf;
+	cpu->registers[REG_SP].r16 += 6;
+	cpu->segments[SEG_CS] = cs;
+	cpu->ip = ip;
+}
+
+int int13_install_rom(INT13* int13, uint8_t* mem, uint32_t rom_address) {
+	if ((rom_address & 0x7FF) != 0 || rom_address < 0xC0000 || rom_address + INT13_ROM_SIZE > 0xF6000) {
+		log_warn("[INT13] Invalid option ROM address %05X\n", rom_address);
+		return 1;
+	}
+
+	/* The ROM is write protected to the guest; write it directly */
+	uint8_t* rom = mem + rom_address;
+	if (rom[0] == 0x55 && rom[1] == 0xAA) {
+		log_error("[INT13] Option ROM at %05X would overwrite an existing ROM\n", rom_address);
+		return 1;
+	}
+
+	memset(rom, 0, INT13_ROM_SIZE);
+	memcpy(rom, int13_rom, sizeof(int13_rom));
+
+	uint8_t sum = 0;
+	for (uint32_t i = 0; i < INT13_ROM_SIZE; ++i) {
+		sum += rom[i];
+	}
+	rom[INT13_ROM_SIZE - 1] = (uint8_t)(0x100 - sum);
+
+	int13->rom_address = rom_address;
+	return 0;
+}
+
+int int13_trap(INT13* int13, I8086* cpu) {
+	/* Two compares per instruction; guest memory is not read until the ROM is reached */
+	if (int13->rom_address == 0 || cpu->segments[SEG_CS] != (int13->rom_address >> 4)) {
+		return 0;
+	}
+
+	switch (cpu->ip) {
+		case ROM_INIT:
+			hook(int13);
+			return 0; /* execute the retf */
+
+		case ROM_HANDLER:
+			if (int13_service(int13, cpu)) {
+				iret(int13, cpu); /* the result is already in AH, AL, CF */
+			}
+			else {
+				/* format, get parameters, etc; jump to the previous handler */
+				cpu->segments[SEG_CS] = int13->chain[1];
+				cpu->ip = int13->chain[0];
+			}
+			return 1;
+	}
+	return 0;
+}
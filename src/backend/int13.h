@@ -0,0 +1,78 @@
+/* int13.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Instant disk; BIOS disk services (INT 13h) serviced directly from the disk buffers
+ */
+
+#ifndef INT13_H
+#define INT13_H
+
+#include <stdint.h>
+
+#include "i8086.h"
+
+#include "fdc/fdd.h"
+#include "hdc/xebec_hdd.h"
+
+/* INT 13h status codes (AH) */
+#define INT13_STATUS_OK               0x00
+#define INT13_STATUS_BAD_COMMAND      0x01
+#define INT13_STATUS_WRITE_PROTECTED  0x03
+#define INT13_STATUS_SECTOR_NOT_FOUND 0x04
+#define INT13_STATUS_CONTROLLER_FAIL  0x20
+#define INT13_STATUS_TIMEOUT          0x80
+
+/* cycles accounted for a trapped INT 13h handler; the INT has executed. IRET (24) */
+#define INT13_TRAP_CYCLES 24
+
+#define INT13_ROM_ADDRESS 0xD0800 /* default option ROM address; after the default VBLK option ROM */
+#define INT13_ROM_SIZE    0x200   /* option ROM size; 512 */
+
+typedef struct INT13 {
+	FDD_DISK* fdd;      /* floppy drives; 00h-03h */
+	uint8_t fdd_count;  /* number of floppy drives present */
+	XEBEC_HDD* hdd;     /* hard drives; 80h-81h */
+	uint8_t hdd_count;
+	uint8_t fdd_status; /* last floppy status; mirrored to BDA 40:41 */
+	uint8_t hdd_status; /* last hard disk status; mirrored to BDA 40:74 */
+	uint64_t requests;  /* requests serviced */
+	uint32_t rom_address; /* option ROM address; 0 if no option ROM */
+	uint16_t chain[2];  /* previous INT 13h vector; offset, segment. Hooked by the option ROM init */
+
+	uint8_t(*read_mem_byte)(uint32_t);         // read mem byte
+	void(*write_mem_byte)(uint32_t, uint8_t);  // write mem byte
+} INT13;
+
+/* Initialize instant disk
+	int13: the int13 instance
+	fdd: the floppy drives
+	fdd_count: the number of floppy drives present
+	hdd: the hard drives
+	hdd_count: the number of hard drives
+	read_mem_byte: guest memory read callback
+	write_mem_byte: guest memory write callback */
+void int13_init(INT13* int13, FDD_DISK* fdd, uint8_t fdd_count, XEBEC_HDD* hdd, uint8_t hdd_count,
+	uint8_t(*read_mem_byte)(uint32_t), void(*write_mem_byte)(uint32_t, uint8_t));
+
+void int13_reset(INT13* int13);
+
+/* Service the INT 13h request in the cpu registers
+	int13: the int13 instance
+	cpu: the cpu; AH = function, DL = drive
+	Returns: 1 if the request was serviced. 0 if the request should go to the guest BIOS */
+int int13_service(INT13* int13, I8086* cpu);
+
+/* Generate the option ROM into memory. Its init hooks INT 13h during POST; hooks the guest installs later chain to it
+	int13: the int13 instance
+	mem: guest memory
+	rom_address: the ROM address; must be on a 2K boundary in the expansion ROM area
+	Returns: 0 if success. Otherwise 1 (bad address, a ROM is already there) */
+int int13_install_rom(INT13* int13, uint8_t* mem, uint32_t rom_address);
+
+/* Trap the option ROM at CS:IP; the init hooks INT 13h, the handler services the request and returns to the caller,
+	or jumps to the previous handler
+	int13: the int13 instance
+	cpu: the cpu
+	Returns: 1 if the handler was trapped. Otherwise 0 */
+int int13_trap(INT13* int13, I8086* cpu);
+
+#endif
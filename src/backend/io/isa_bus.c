@@ -7,17 +7,15 @@
 #include <malloc.h>
 #include <memory.h>
 #include <string.h>
+#include <stdio.h>
 
 #include "isa_bus.h"
 #include "memory_map.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#include "backend/utility/trace.h"
+
+#define LOG_CATEGORY LOG_CAT_IO
+#include "backend/utility/log.h"
 
 #define ISA_CARD_NAME_SIZE 256
 
@@ -34,7 +32,7 @@ int isa_bus_create(ISA_BUS* bus, MEMORY_MAP* map, int slots) {
 	if (bus != NULL) {
 		bus->cards = calloc(slots, sizeof(ISA_CARD));
 		if (bus->cards == NULL) {
-			dbg_print("Failed to create isa bus; Calloc failed. slot_count = %x, isa_card_size = %zu\n", slots, sizeof(ISA_CARD));
+			log_error("Failed to create isa bus; Calloc failed. slot_count = %x, isa_card_size = %zu\n", slots, sizeof(ISA_CARD));
 			return 1;
 		}
 		bus->card_count = slots;
@@ -44,14 +42,14 @@ int isa_bus_create(ISA_BUS* bus, MEMORY_MAP* map, int slots) {
 		for (int i = 0; i < slots; ++i) {
 			bus->cards[i].name = calloc(1, ISA_CARD_NAME_SIZE);
 			if (bus->cards[i].name == NULL) {
-				dbg_print("Failed to create isa card; Calloc failed. slots = %x, slot = %x\n", slots, i);
+				log_error("Failed to create isa card; Calloc failed. slots = %x, slot = %x\n", slots, i);
 				return 1;
 			}
 		}
 
 		return 0;
 	}
-	dbg_print("Failed to create isa bus; bus was NULL.\n");
+	log_error("Failed to create isa bus; bus was NULL.\n");
 	return 1;
 }
 void isa_bus_destroy(ISA_BUS* bus) {
@@ -90,7 +88,7 @@ int isa_bus_add_card(ISA_BUS* bus, const char* name, int id) {
 	if (index < 0) {
 		index = bus->card_index;
 		if (index >= bus->card_count) {
-			dbg_print("Failed to add isa card; Index out of range. index = %d\n", index);
+			log_error("Failed to add isa card; Index out of range. index = %d\n", index);
 			return -1;
 		}
 		bus->card_index++;
@@ -128,7 +126,7 @@ int isa_bus_remove_card(ISA_BUS* bus, int index) {
 		bus->cards[index].name[0] = '\0';
 		return 0;
 	}
-	dbg_print("Failed to remove isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_bus_remove_all_cards(ISA_BUS* bus) {
@@ -150,7 +148,7 @@ int isa_bus_enable_card(ISA_BUS* bus, int index) {
 		}
 		return 0;
 	}
-	dbg_print("Failed to enable isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to enable isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_bus_disable_card(ISA_BUS* bus, int index) {
@@ -162,7 +160,7 @@ int isa_bus_disable_card(ISA_BUS* bus, int index) {
 		}
 		return 0;
 	}
-	dbg_print("Failed to disable isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to disable isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -214,11 +212,19 @@ void isa_bus_reset(ISA_BUS* bus) {
 }
 
 void isa_bus_update(ISA_BUS* bus, uint64_t cycles) {
+	TRACE_BEGIN(TRACE_CAT_DEVICE, "isa_bus_update");
 	for (int i = 0; i < bus->card_index; ++i) {
 		if (!IS_REMOVED(i) && IS_ENABLED(i) && HAS_UPDATE(i)) {
 			bus->cards[i].update(bus->cards[i].param, cycles);
 		}
 	}
+	TRACE_END(TRACE_CAT_DEVICE, "isa_bus_update");
+}
+void isa_bus_update_card(ISA_BUS* bus, int index, uint64_t cycles) {
+	int i = index;
+	if (IS_IN_RANGE(i) && !IS_REMOVED(i) && IS_ENABLED(i) && HAS_UPDATE(i)) {
+		bus->cards[i].update(bus->cards[i].param, cycles);
+	}
 }
 
 int isa_card_add_mm(ISA_BUS* bus, int index, uint32_t start, uint32_t size, uint32_t mask, uint32_t flags) {
@@ -230,7 +236,7 @@ int isa_card_add_mm(ISA_BUS* bus, int index, uint32_t start, uint32_t size, uint
 		}
 		return 0;
 	}
-	dbg_print("Failed to add MM to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to add MM to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_card_remove_mm(ISA_BUS* bus, int index) {
@@ -240,7 +246,7 @@ int isa_card_remove_mm(ISA_BUS* bus, int index) {
 		bus->cards[index].mregion_index = -1;
 		return r;
 	}
-	dbg_print("Failed to remove MM from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove MM from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -251,7 +257,7 @@ int isa_card_add_io(ISA_BUS* bus, int index, ISA_BUS_WRITE_IO write_io_byte, ISA
 		bus->cards[index].read_io_byte = read_io_byte;
 		return 0;
 	}
-	dbg_print("Failed to add IO to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to add IO to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_card_remove_io(ISA_BUS* bus, int index) {
@@ -261,7 +267,7 @@ int isa_card_remove_io(ISA_BUS* bus, int index) {
 		bus->cards[index].read_io_byte = NULL;
 		return 0;
 	}
-	dbg_print("Failed to remove IO from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove IO from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -271,7 +277,7 @@ int isa_card_add_reset(ISA_BUS* bus, int index, ISA_BUS_RESET reset) {
 		bus->cards[index].reset = reset;
 		return 0;
 	}
-	dbg_print("Failed to add RESET to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to add RESET to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_card_remove_reset(ISA_BUS* bus, int index) {
@@ -280,7 +286,7 @@ int isa_card_remove_reset(ISA_BUS* bus, int index) {
 		bus->cards[index].reset = NULL;
 		return 0;
 	}
-	dbg_print("Failed to remove RESET from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove RESET from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -290,7 +296,7 @@ int isa_card_add_update(ISA_BUS* bus, int index, ISA_BUS_UPDATE update) {
 		bus->cards[index].update = update;
 		return 0;
 	}
-	dbg_print("Failed to add UPDATE to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to add UPDATE to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_card_remove_update(ISA_BUS* bus, int index) {
@@ -299,7 +305,7 @@ int isa_card_remove_update(ISA_BUS* bus, int index) {
 		bus->cards[index].update = NULL;
 		return 0;
 	}
-	dbg_print("Failed to remove UPDATE from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove UPDATE from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -308,7 +314,7 @@ int isa_card_add_param(ISA_BUS* bus, int index, void* param) {
 		bus->cards[index].param = param;
 		return 0;
 	}
-	dbg_print("Failed to add PARAM to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to add PARAM to isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 int isa_card_remove_param(ISA_BUS* bus, int index) {
@@ -316,7 +322,7 @@ int isa_card_remove_param(ISA_BUS* bus, int index) {
 		bus->cards[index].param = NULL;
 		return 0;
 	}
-	dbg_print("Failed to remove PARAM from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
+	log_error("Failed to remove PARAM from isa card; Index out of range or card removed. index = %d, removed = %d\n", index, IS_REMOVED(index));
 	return 1;
 }
 
@@ -110,6 +110,12 @@ void isa_bus_reset(ISA_BUS* bus);
 /* ISA Bus reset; Call reset on all ISA Cards */
 void isa_bus_update(ISA_BUS* bus, uint64_t cycles);
 
+/* Call update on one ISA Card
+   bus:     the isa bus instance
+   index:   the isa card index
+   cycles:  the cpu cycles of the last step */
+void isa_bus_update_card(ISA_BUS* bus, int index, uint64_t cycles);
+
 /* Remove an ISA Card from the bus
    bus:     the isa bus instance
    index:   the isa card index
@@ -11,5 +11,6 @@
 #define ISA_CARD_MDA   0x02
 #define ISA_CARD_CGA   0x03
 #define ISA_CARD_XEBEC 0x04
+#define ISA_CARD_VBLK  0x05
 
 #endif
@@ -6,16 +6,12 @@
 #include <stdint.h>
 #include <malloc.h>
 #include <memory.h>
+#include <stdio.h>
 
 #include "memory_map.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_MEM
+#include "backend/utility/log.h"
 
 /* Mregion Start */
 #define MR_START     (map->regions[i].start)
@@ -56,7 +52,7 @@ int memory_map_create(MEMORY_MAP* map, uint32_t buffer_size, int region_count) {
 		/* alloc mregions */
 		map->regions = calloc(region_count, sizeof(MEMORY_REGION));
 		if (map->regions == NULL) {
-			dbg_print("Failed to create memory map; Calloc failed. region_count = %x, region_size = %zu\n", region_count, sizeof(MEMORY_REGION));
+			log_error("Failed to create memory map; Calloc failed. region_count = %x, region_size = %zu\n", region_count, sizeof(MEMORY_REGION));
 			return 1;
 		}
 		map->region_count = region_count;
@@ -65,14 +61,22 @@ int memory_map_create(MEMORY_MAP* map, uint32_t buffer_size, int region_count) {
 		/* alloc memory buffer */
 		map->mem = calloc(1, buffer_size);
 		if (map->mem == NULL) {
-			dbg_print("Failed to create memory map; Calloc failed. buffer_size = %x\n", buffer_size);
+			log_error("Failed to create memory map; Calloc failed. buffer_size = %x\n", buffer_size);
 			return 1;
 		}
 		map->mem_size = buffer_size;
 
+		/* alloc page written flags */
+		map->page_count = (buffer_size + MEMORY_MAP_PAGE_SIZE - 1) >> MEMORY_MAP_PAGE_SHIFT;
+		map->dirty = calloc(1, map->page_count);
+		if (map->dirty == NULL) {
+			log_error("Failed to create memory map; Calloc failed. page_count = %x\n", map->page_count);
+			return 1;
+		}
+
 		return 0;
 	}
-	dbg_print("Failed to create memory map; Map was NULL.\n");
+	log_error("Failed to create memory map; Map was NULL.\n");
 	return 1;
 }
 void memory_map_destroy(MEMORY_MAP* map) {
@@ -91,6 +95,13 @@ void memory_map_destroy(MEMORY_MAP* map) {
 			map->mem = NULL;
 			map->mem_size = 0;
 		}
+
+		/* free page written flags */
+		if (map->dirty != NULL) {
+			free(map->dirty);
+			map->dirty = NULL;
+			map->page_count = 0;
+		}
 	}
 }
 
@@ -103,7 +114,7 @@ uint8_t memory_map_read_byte(MEMORY_MAP* map, uint32_t address) {
 		}
 	}
 
-	dbg_print("reading from %x\n", address);
+	log_debug("reading from %x\n", address);
 	return 0;
 }
 void memory_map_write_byte(MEMORY_MAP* map, uint32_t address, uint8_t value) {
@@ -112,13 +123,73 @@ void memory_map_write_byte(MEMORY_MAP* map, uint32_t address, uint8_t value) {
 	for (int i = 0; i < map->region_index; ++i) {
 		if (IS_ACTIVE(i) && IS_IN_RANGE(address, MR_START, MR_END)) {
 			if (IS_WRITABLE(i)) {
-				*(uint8_t*)(map->mem + MR_START + ((address - MR_START) & map->regions[i].mask)) = value;
+				uint32_t offset = MR_START + ((address - MR_START) & map->regions[i].mask);
+				map->mem[offset] = value;
+				map->dirty[offset >> MEMORY_MAP_PAGE_SHIFT] = MEMORY_MAP_DIRTY_ALL;
 			}
 			return;
 		}
 	}
 
-	dbg_print("writing %x to %x\n", value, address);
+	log_debug("writing %x to %x\n", value, address);
+}
+uint8_t* memory_map_get_range(MEMORY_MAP* map, uint32_t address, uint32_t size, int write) {
+
+	/* Handle mregion */
+	for (int i = 0; i < map->region_index; ++i) {
+		if (IS_ACTIVE(i) && IS_IN_RANGE(address, MR_START, MR_END)) {
+			if (address + size > MR_END || (write && IS_WRITE_PROTECTED(i))) {
+				return NULL;
+			}
+			uint32_t offset = (address - MR_START) & MR_MASK;
+			if (offset + size > MR_MASK + 1) {
+				return NULL; /* range wraps a mirror */
+			}
+			if (write && size > 0) {
+				uint32_t first = (MR_START + offset) >> MEMORY_MAP_PAGE_SHIFT;
+				uint32_t last = (MR_START + offset + size - 1) >> MEMORY_MAP_PAGE_SHIFT;
+				memset(map->dirty + first, MEMORY_MAP_DIRTY_ALL, last - first + 1);
+			}
+			return MR_PTR;
+		}
+	}
+	return NULL;
+}
+int memory_map_find_mregion(MEMORY_MAP* map, uint32_t address) {
+	for (int i = 0; i < map->region_index; ++i) {
+		if (IS_ACTIVE(i) && IS_IN_RANGE(address, MR_START, MR_END)) {
+			return i;
+		}
+	}
+	return -1;
+}
+void memory_map_clear_dirty(MEMORY_MAP* map, uint8_t flags) {
+	for (uint32_t i = 0; i < map->page_count; ++i) {
+		map->dirty[i] &= ~flags;
+	}
+}
+void memory_map_mark_dirty(MEMORY_MAP* map) {
+	memset(map->dirty, MEMORY_MAP_DIRTY_ALL, map->page_count);
+}
+int memory_map_test_clear_dirty(MEMORY_MAP* map, uint32_t address, uint32_t size, uint8_t flags) {
+	int dirty = 0;
+	uint32_t end = address + size;
+
+	/* a page at a time; a mirror is tracked at the page it mirrors */
+	while (address < end) {
+		for (int i = 0; i < map->region_index; ++i) {
+			if (IS_ACTIVE(i) && IS_IN_RANGE(address, MR_START, MR_END)) {
+				uint32_t page = (MR_START + ((address - MR_START) & map->regions[i].mask)) >> MEMORY_MAP_PAGE_SHIFT;
+				if (map->dirty[page] & flags) {
+					map->dirty[page] &= ~flags;
+					dirty = 1;
+				}
+				break;
+			}
+		}
+		address = (address & ~(MEMORY_MAP_PAGE_SIZE - 1)) + MEMORY_MAP_PAGE_SIZE;
+	}
+	return dirty;
 }
 void memory_map_set_writeable_region(MEMORY_MAP* map, uint8_t value) {
 	for (int i = 0; i < map->region_index; ++i) {
@@ -126,14 +197,14 @@ void memory_map_set_writeable_region(MEMORY_MAP* map, uint8_t value) {
 			for (uint32_t j = 0; j < MR_SIZE; ++j) {
 				memory_map_write_byte(map, MR_START + j, value);
 			}
-			//dbg_print("mregion set %x - %x = %x\n", MR_START, map->regions[i].end, value);
+			//log_info("mregion set %x - %x = %x\n", MR_START, map->regions[i].end, value);
 		}
 	}
 }
 
 int memory_map_validate(MEMORY_MAP* map) {
 	if (!map || !map->regions) {
-		dbg_print("Memory map not initialized.\n");
+		log_error("Memory map not initialized.\n");
 		return 1;
 	}
 
@@ -146,11 +217,11 @@ int memory_map_validate(MEMORY_MAP* map) {
 			uint32_t mask = MR_MASK;
 
 			if (size == 0) {
-				dbg_print("Memory Map warning: region[%d] has zero size.\n", i);
+				log_warn("Memory Map warning: region[%d] has zero size.\n", i);
 			}			
 
 			if (mask == 0) {
-				dbg_print("Memory Map warning: region[%d] has zero mask.\n", i);
+				log_warn("Memory Map warning: region[%d] has zero mask.\n", i);
 			}
 
 			/* Overlap check */
@@ -161,7 +232,7 @@ int memory_map_validate(MEMORY_MAP* map) {
 					uint32_t other_end = other_start + map->regions[j].size;
 
 					if (!(end <= other_start || start >= other_end)) {
-						dbg_print("Memory Map warning: region[%d] (%x-%x) overlaps region[%d] (%x-%x).\n", i, start, end - 1, j, other_start, other_end - 1);
+						log_warn("Memory Map warning: region[%d] (%x-%x) overlaps region[%d] (%x-%x).\n", i, start, end - 1, j, other_start, other_end - 1);
 					}
 				}
 			}
@@ -186,7 +257,7 @@ int memory_map_add_mregion(MEMORY_MAP* map, uint32_t start, uint32_t size, uint3
 	if (index < 0) {
 		index = map->region_index;
 		if (index >= map->region_count) {
-			dbg_print("Failed to add mregion; Index out of range. start = %x, size = %x, mask = %x, flags = %x\n", start, size, mask, flags);
+			log_error("Failed to add mregion; Index out of range. start = %x, size = %x, mask = %x, flags = %x\n", start, size, mask, flags);
 			return -1;
 		}
 		map->region_index++;
@@ -206,7 +277,7 @@ int memory_map_remove_mregion(MEMORY_MAP* map, int index) {
 		map->regions[index].flags = MREGION_FLAG_REMOVED;
 		return 0;
 	}
-	dbg_print("Failed to remove mregion; Index out of range. index = %d\n", index);
+	log_error("Failed to remove mregion; Index out of range. index = %d\n", index);
 	return 1;
 }
 int memory_map_enable_mregion(MEMORY_MAP* map, int index) {
@@ -214,7 +285,7 @@ int memory_map_enable_mregion(MEMORY_MAP* map, int index) {
 		map->regions[index].flags |= MREGION_FLAG_ENABLED;
 		return 0;
 	}
-	dbg_print("Failed to enable mregion; Index out of range or mregion removed. index = %d, removed = %x\n", index, IS_REMOVED(index));
+	log_error("Failed to enable mregion; Index out of range or mregion removed. index = %d, removed = %x\n", index, IS_REMOVED(index));
 	return 1;
 }
 int memory_map_disable_mregion(MEMORY_MAP* map, int index) {
@@ -222,19 +293,19 @@ int memory_map_disable_mregion(MEMORY_MAP* map, int index) {
 		map->regions[index].flags &= ~MREGION_FLAG_ENABLED;
 		return 0;
 	}
-	dbg_print("Failed to disable mregion; Index out of range or mregion removed. index = %d, removed = %x\n", index, IS_REMOVED(index));
+	log_error("Failed to disable mregion; Index out of range or mregion removed. index = %d, removed = %x\n", index, IS_REMOVED(index));
 	return 1;
 }
 
 MEMORY_REGION* memory_map_get_mregion(MEMORY_MAP* map, int i) {
 
 	if (!IS_IN_RANGE(i, 0, map->region_index)) {
-		dbg_print("Failed to get mregion; Index out of range. index = %x\n", i);
+		log_error("Failed to get mregion; Index out of range. index = %x\n", i);
 		return NULL;
 	}
 
 	if (IS_REMOVED(i)) {
-		dbg_print("Failed to get mregion; mregion has been removed. index = %x\n", i);
+		log_error("Failed to get mregion; mregion has been removed. index = %x\n", i);
 		return NULL;
 	}
 
@@ -12,6 +12,15 @@ typedef struct MEMORY_REGION MEMORY_REGION;
 
  /* --- Memory Map --- */
 
+/* Memory is tracked for writes in pages; 4K */
+#define MEMORY_MAP_PAGE_SHIFT 12
+#define MEMORY_MAP_PAGE_SIZE  (1 << MEMORY_MAP_PAGE_SHIFT)
+
+/* Page written flags; a write sets every flag, each user clears its own */
+#define MEMORY_MAP_DIRTY_SNAPSHOT 0x01 /* written since the last rewind snapshot */
+#define MEMORY_MAP_DIRTY_VIEW     0x02 /* written since the debugger views last looked */
+#define MEMORY_MAP_DIRTY_ALL      0xFF
+
 /* Memory Map */
 typedef struct MEMORY_MAP {
 	MEMORY_REGION* regions;
@@ -19,6 +28,8 @@ typedef struct MEMORY_MAP {
 	int region_index;
 	uint8_t* mem;
 	uint32_t mem_size;
+	uint8_t* dirty;      /* page written flags; MEMORY_MAP_DIRTY_XXX. set on a write, cleared by memory_map_clear_dirty() */
+	uint32_t page_count;
 } MEMORY_MAP;
 
 /* Creates a memory map; allocates memory for the mregions, memory buffer
@@ -44,6 +55,38 @@ uint8_t memory_map_read_byte(MEMORY_MAP* map, uint32_t address);
 	value:   the value to write at the address */
 void memory_map_write_byte(MEMORY_MAP* map, uint32_t address, uint8_t value);
 
+/* Get a pointer to a range of memory for a direct copy
+	map:     the map instance
+	address: the start address of the range
+	size:    the size of the range
+	write:   1 if the range is written to
+	Returns: NULL if the range does not lie in a single mregion, wraps a mirror of the mregion (or it is write protected and write is set).
+	         Otherwise a pointer to the range in the memory buffer */
+uint8_t* memory_map_get_range(MEMORY_MAP* map, uint32_t address, uint32_t size, int write);
+
+/* Find the mregion an address is in
+	map:     the map instance
+	address: the address
+	Returns: -1 if the address is not mapped or the index of the mregion */
+int memory_map_find_mregion(MEMORY_MAP* map, uint32_t address);
+
+/* Clear page written flags of every page
+	map:     the map instance
+	flags:   MEMORY_MAP_DIRTY_XXX */
+void memory_map_clear_dirty(MEMORY_MAP* map, uint8_t flags);
+
+/* Set the page written flags of every page; the memory buffer was replaced without a write
+	map:     the map instance */
+void memory_map_mark_dirty(MEMORY_MAP* map);
+
+/* Test and clear page written flags of a range
+	map:     the map instance
+	address: the start address of the range
+	size:    the size of the range
+	flags:   MEMORY_MAP_DIRTY_XXX
+	Returns: 1 if a page of the range had one of flags. Otherwise 0 */
+int memory_map_test_clear_dirty(MEMORY_MAP* map, uint32_t address, uint32_t size, uint8_t flags);
+
 /* Set all writable memory regions to value
 	map:     the map instance
 	value:   the value to write */
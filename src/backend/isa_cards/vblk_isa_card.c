@@ -0,0 +1,48 @@
+/* vblk_isa_card.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Paravirtual Block Device ISA Card
+ */
+
+#include <stdint.h>
+#include "vblk_isa_card.h"
+#include "backend/hdc/vblk.h"
+#include "backend/io/isa_bus.h"
+#include "backend/io/isa_cards.h"
+
+#define VBLK_COMMAND  (VBLK_BASE_ADDRESS + VBLK_PORT_COMMAND)  // (WO)
+#define VBLK_STATUS   (VBLK_BASE_ADDRESS + VBLK_PORT_STATUS)   // (RO)
+#define VBLK_ADDRESS0 (VBLK_BASE_ADDRESS + VBLK_PORT_ADDRESS0) // (RW)
+#define VBLK_ADDRESS1 (VBLK_BASE_ADDRESS + VBLK_PORT_ADDRESS1) // (RW)
+#define VBLK_ADDRESS2 (VBLK_BASE_ADDRESS + VBLK_PORT_ADDRESS2) // (RW)
+
+static int isa_vblk_write_io_byte(VBLK* vblk, uint16_t port, uint8_t value) {
+	switch (port) {
+		case VBLK_COMMAND:
+		case VBLK_ADDRESS0:
+		case VBLK_ADDRESS1:
+		case VBLK_ADDRESS2:
+			vblk_write_io_byte(vblk, (uint8_t)(port - VBLK_BASE_ADDRESS), value);
+			return 1;
+	}
+	return 0;
+}
+
+static int isa_vblk_read_io_byte(VBLK* vblk, uint16_t port, uint8_t* value) {
+	switch (port) {
+		case VBLK_STATUS:
+		case VBLK_ADDRESS0:
+		case VBLK_ADDRESS1:
+		case VBLK_ADDRESS2:
+			*value = vblk_read_io_byte(vblk, (uint8_t)(port - VBLK_BASE_ADDRESS));
+			return 1;
+	}
+	return 0;
+}
+
+int isa_card_add_vblk(ISA_BUS* bus, VBLK* vblk) {
+	int card = isa_bus_add_card(bus, "VBLK Card", ISA_CARD_VBLK);
+	isa_card_add_param(bus, card, vblk);
+	isa_card_add_io(bus, card, isa_vblk_write_io_byte, isa_vblk_read_io_byte);
+	isa_card_add_reset(bus, card, vblk_reset);
+	return card;
+}
@@ -0,0 +1,16 @@
+/* vblk_isa_card.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Paravirtual Block Device ISA Card
+ */
+
+#ifndef VBLK_ISA_CARD_H
+#define VBLK_ISA_CARD_H
+
+#define VBLK_BASE_ADDRESS 0x300 // Base port address of the VBLK Card
+
+typedef struct ISA_BUS ISA_BUS;
+typedef struct VBLK VBLK;
+
+int isa_card_add_vblk(ISA_BUS* bus, VBLK* vblk);
+
+#endif
@@ -0,0 +1,484 @@
+/* itrace.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Instruction trace; CS:IP, the instruction bytes, the registers changed and the memory written per instruction,
+ * recorded into a ring of blocks and optionally streamed to a compressed file
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "itrace.h"
+#include "i8086.h"
+#include "i8086_mnem.h"
+#include "utility/lz.h"
+
+/* Record: flags (u8), [CS (u16)], IP (u16), instruction bytes (ITRACE_BYTES), [register state before (ITRACE_REGS * u16)],
+ * changed mask (u16), the changed registers after (u16 each), [write count (u8), writes (address u24, value u8)].
+ * Every block starts with a key record; a block decodes on its own, so the ring can drop the oldest block.
+ *
+ * File format:
+ * "ITR2", block size (u32); then per block: size (u32), stored size (u32), the block. LZ compressed if stored size < size. */
+
+#define ITRACE_MAGIC      "ITR2" /* ITR1 recorded 6 instruction bytes */
+#define ITRACE_MAGIC_SIZE 4
+
+#define BLOCK(i) (itrace->ring + (size_t)(i) * ITRACE_BLOCK_SIZE)
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "utility/log.h"
+
+static const char* reg_names[ITRACE_REGS] = {
+	"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI", "ES", "SS", "DS", "FL"
+};
+
+static void put_u16(uint8_t* buffer, uint16_t value) {
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+}
+static void put_u32(uint8_t* buffer, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static void put_u64(uint8_t* buffer, uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static uint16_t get_u16(const uint8_t* buffer) {
+	return buffer[0] | (buffer[1] << 8);
+}
+static uint32_t get_u32(const uint8_t* buffer) {
+	uint32_t value = 0;
+	for (int i = 0; i < 4; ++i) {
+		value |= (uint32_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+static uint64_t get_u64(const uint8_t* buffer) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value |= (uint64_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+
+static void get_regs(const I8086* cpu, uint16_t* regs) {
+	for (int i = 0; i < 8; ++i) {
+		regs[i] = cpu->registers[i].r16;
+	}
+	regs[8] = cpu->segments[SEG_ES];
+	regs[9] = cpu->segments[SEG_SS];
+	regs[10] = cpu->segments[SEG_DS];
+	regs[11] = cpu->status.word;
+}
+static void set_regs(I8086* cpu, const uint16_t* regs) {
+	for (int i = 0; i < 8; ++i) {
+		cpu->registers[i].r16 = regs[i];
+	}
+	cpu->segments[SEG_ES] = regs[8];
+	cpu->segments[SEG_SS] = regs[9];
+	cpu->segments[SEG_DS] = regs[10];
+	cpu->status.word = regs[11];
+}
+
+static int write_header(FILE* file) {
+	uint8_t header[ITRACE_MAGIC_SIZE + 4];
+	memcpy(header, ITRACE_MAGIC, ITRACE_MAGIC_SIZE);
+	put_u32(header + ITRACE_MAGIC_SIZE, ITRACE_BLOCK_SIZE);
+	return fwrite(header, sizeof(header), 1, file) != 1;
+}
+static int write_block(ITRACE* itrace, FILE* file, const uint8_t* block) {
+	uint32_t size = get_u32(block);
+	uint32_t stored = (uint32_t)lz_compress(block, size, itrace->compressed);
+	const uint8_t* data = itrace->compressed;
+	if (stored >= size) {
+		stored = size;
+		data = block;
+	}
+	uint8_t sizes[8];
+	put_u32(sizes, size);
+	put_u32(sizes + 4, stored);
+	return fwrite(sizes, sizeof(sizes), 1, file) != 1 || fwrite(data, stored, 1, file) != 1;
+}
+
+int itrace_create(ITRACE* itrace, uint32_t ring_kb, const char* stream_path) {
+	memset(itrace, 0, sizeof(ITRACE));
+
+	itrace->block_count = (uint32_t)(((uint64_t)ring_kb * 1024 + ITRACE_BLOCK_SIZE - 1) / ITRACE_BLOCK_SIZE);
+	if (itrace->block_count == 0) {
+		itrace->block_count = 1;
+	}
+	itrace->ring = malloc((size_t)itrace->block_count * ITRACE_BLOCK_SIZE);
+	itrace->compressed = malloc(LZ_BOUND(ITRACE_BLOCK_SIZE));
+	if (itrace->ring == NULL || itrace->compressed == NULL) {
+		log_error("[ITRACE] Failed to allocate the ring; %u blocks\n", itrace->block_count);
+		itrace_destroy(itrace);
+		return 1;
+	}
+
+	if (stream_path != NULL) {
+		itrace->stream = fopen(stream_path, "wb");
+		if (itrace->stream == NULL || write_header(itrace->stream)) {
+			log_error("[ITRACE] Failed to open %s\n", stream_path);
+			itrace_destroy(itrace);
+			return 1;
+		}
+	}
+
+	itrace->used = ITRACE_BLOCK_HEADER;
+	itrace->enabled = 1;
+	return 0;
+}
+void itrace_destroy(ITRACE* itrace) {
+	itrace->enabled = 0;
+	itrace->recording = 0;
+	if (itrace->stream != NULL) {
+		fclose(itrace->stream);
+		itrace->stream = NULL;
+	}
+	if (itrace->ring != NULL) {
+		free(itrace->ring);
+		itrace->ring = NULL;
+	}
+	if (itrace->compressed != NULL) {
+		free(itrace->compressed);
+		itrace->compressed = NULL;
+	}
+}
+
+static void next_block(ITRACE* itrace) {
+	if (itrace->stream != NULL && write_block(itrace, itrace->stream, BLOCK(itrace->block))) {
+		log_error("[ITRACE] Failed to write the stream; streaming stopped\n");
+		fclose(itrace->stream);
+		itrace->stream = NULL;
+	}
+	itrace->block = (itrace->block + 1) % itrace->block_count;
+	if (itrace->blocks_full < itrace->block_count - 1) {
+		itrace->blocks_full++;
+	}
+	itrace->used = ITRACE_BLOCK_HEADER;
+}
+
+void itrace_begin(ITRACE* itrace, const I8086* cpu, const uint8_t* mem) {
+	if (itrace->used + ITRACE_RECORD_MAX > ITRACE_BLOCK_SIZE) {
+		next_block(itrace);
+	}
+
+	uint8_t* block = BLOCK(itrace->block);
+	uint16_t regs[ITRACE_REGS];
+	get_regs(cpu, regs);
+
+	uint8_t flags = 0;
+	if (itrace->used == ITRACE_BLOCK_HEADER) {
+		put_u64(block + 4, itrace->instructions);
+		flags = ITRACE_KEY;
+	}
+	else if (memcmp(regs, itrace->regs, sizeof(regs)) != 0) {
+		flags = ITRACE_KEY; /* loaded outside of an instruction; a snapshot or the debugger */
+	}
+	uint16_t cs = cpu->segments[SEG_CS];
+	if ((flags & ITRACE_KEY) || cs != itrace->cs) {
+		flags |= ITRACE_CS;
+	}
+
+	uint8_t* p = block + itrace->used;
+	itrace->record = p;
+	*p++ = flags;
+	if (flags & ITRACE_CS) {
+		put_u16(p, cs);
+		p += 2;
+	}
+	put_u16(p, cpu->ip);
+	p += 2;
+	uint32_t address = i8086_get_physical_address(cs, cpu->ip);
+	for (int i = 0; i < ITRACE_BYTES; ++i) {
+		*p++ = mem[(address + i) & 0xFFFFF];
+	}
+	if (flags & ITRACE_KEY) {
+		for (int i = 0; i < ITRACE_REGS; ++i) {
+			put_u16(p, regs[i]);
+			p += 2;
+		}
+		memcpy(itrace->regs, regs, sizeof(regs));
+	}
+
+	itrace->cs = cs;
+	itrace->cursor = p;
+	itrace->write_count = 0;
+	itrace->overflow = 0;
+	itrace->recording = 1;
+}
+
+void itrace_add_write(ITRACE* itrace, uint32_t address, uint8_t value) {
+	if (!itrace->recording) {
+		return; /* DMA */
+	}
+	if (itrace->write_count == ITRACE_MAX_WRITES) {
+		itrace->overflow = 1;
+		return;
+	}
+	uint8_t* w = itrace->writes[itrace->write_count++];
+	w[0] = (uint8_t)address;
+	w[1] = (uint8_t)(address >> 8);
+	w[2] = (uint8_t)(address >> 16);
+	w[3] = value;
+}
+
+void itrace_end(ITRACE* itrace, const I8086* cpu) {
+	uint16_t regs[ITRACE_REGS];
+	get_regs(cpu, regs);
+
+	uint8_t* p = itrace->cursor;
+	uint8_t* mask_p = p;
+	uint16_t mask = 0;
+	p += 2;
+	for (int i = 0; i < ITRACE_REGS; ++i) {
+		if (regs[i] != itrace->regs[i]) {
+			mask |= 1 << i;
+			put_u16(p, regs[i]);
+			p += 2;
+		}
+	}
+	put_u16(mask_p, mask);
+	memcpy(itrace->regs, regs, sizeof(regs));
+
+	if (itrace->write_count != 0) {
+		itrace->record[0] |= ITRACE_WRITES;
+		*p++ = itrace->write_count;
+		memcpy(p, itrace->writes, (size_t)itrace->write_count * 4);
+		p += (size_t)itrace->write_count * 4;
+	}
+	if (itrace->overflow) {
+		itrace->record[0] |= ITRACE_OVERFLOW;
+	}
+
+	uint8_t* block = BLOCK(itrace->block);
+	itrace->used = (uint32_t)(p - block);
+	put_u32(block, itrace->used);
+	itrace->instructions++;
+	itrace->recording = 0;
+}
+
+int itrace_write(ITRACE* itrace, const char* path) {
+	uint8_t* current = BLOCK(itrace->block);
+	int has_current = (itrace->used > ITRACE_BLOCK_HEADER);
+
+	if (itrace->stream != NULL) {
+		int error = has_current && write_block(itrace, itrace->stream, current);
+		fclose(itrace->stream);
+		itrace->stream = NULL;
+		if (error) {
+			log_error("[ITRACE] Failed to write the stream\n");
+		}
+		return error;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		log_error("[ITRACE] Failed to open %s\n", path);
+		return 1;
+	}
+	int error = write_header(file);
+	uint32_t oldest = (itrace->block + itrace->block_count - itrace->blocks_full) % itrace->block_count;
+	for (uint32_t i = 0; i < itrace->blocks_full && !error; ++i) {
+		error = write_block(itrace, file, BLOCK((oldest + i) % itrace->block_count));
+	}
+	if (has_current && !error) {
+		error = write_block(itrace, file, current);
+	}
+	fclose(file);
+
+	if (error) {
+		log_error("[ITRACE] Failed to write %s\n", path);
+	}
+	else {
+		log_info("[ITRACE] Wrote %s\n", path);
+	}
+	return error;
+}
+
+/* Decoder; the disassembler reads the recorded instruction bytes */
+
+static uint32_t decode_address;
+static uint8_t decode_bytes[ITRACE_BYTES];
+
+static uint8_t decode_read_mem_byte(uint20_t address) {
+	uint32_t offset = (address - decode_address) & 0xFFFFF;
+	return (offset < ITRACE_BYTES) ? decode_bytes[offset] : 0;
+}
+
+static void print_regs(FILE* out, const uint16_t* regs, uint16_t mask) {
+	for (int i = 0; i < ITRACE_REGS; ++i) {
+		if (mask & (1 << i)) {
+			fprintf(out, " %s=%04X", reg_names[i], regs[i]);
+		}
+	}
+}
+
+/* Print the records of a block
+	Returns: 0 if success. 1 if the block is corrupt */
+static int decode_block(const uint8_t* block, uint32_t size, uint64_t* next_index, I8086* cpu, I8086_MNEM* mnem, FILE* out) {
+	uint32_t used = get_u32(block);
+	if (used > size || used < ITRACE_BLOCK_HEADER) {
+		return 1;
+	}
+	uint64_t index = get_u64(block + 4);
+	if (index != *next_index) {
+		fprintf(out, "; %llu instructions not in the trace\n", (unsigned long long)(index - *next_index));
+	}
+
+	uint16_t regs[ITRACE_REGS] = { 0 };
+	uint16_t cs = 0;
+	const uint8_t* p = block + ITRACE_BLOCK_HEADER;
+	const uint8_t* end = block + used;
+	while (p < end) {
+		if (end - p < 1 + 2 + ITRACE_BYTES + 2) {
+			return 1;
+		}
+		uint8_t flags = *p++;
+		if (flags & ITRACE_CS) {
+			cs = get_u16(p);
+			p += 2;
+		}
+		uint16_t ip = get_u16(p);
+		p += 2;
+		memcpy(decode_bytes, p, ITRACE_BYTES);
+		p += ITRACE_BYTES;
+		if (flags & ITRACE_KEY) {
+			if (end - p < ITRACE_REGS * 2) {
+				return 1;
+			}
+			for (int i = 0; i < ITRACE_REGS; ++i) {
+				regs[i] = get_u16(p);
+				p += 2;
+			}
+			fprintf(out, "; state");
+			print_regs(out, regs, 0xFFFF);
+			fprintf(out, "\n");
+		}
+
+		/* disassemble with the state before the instruction; the effective address is right */
+		decode_address = i8086_get_physical_address(cs, ip);
+		set_regs(cpu, regs);
+		cpu->segments[SEG_CS] = cs;
+		cpu->ip = ip;
+		i8086_mnem_at(mnem, cs, ip);
+		uint32_t len = mnem->counter;
+		int truncated = (len > ITRACE_BYTES); /* the bytes past ITRACE_BYTES decoded as 0 */
+		if (len == 0 || len > ITRACE_BYTES) {
+			len = ITRACE_BYTES;
+		}
+
+		fprintf(out, "%10llu  %04X:%04X  ", (unsigned long long)index, cs, ip);
+		for (uint32_t i = 0; i < ITRACE_BYTES; ++i) {
+			if (i < len) {
+				fprintf(out, "%02X", decode_bytes[i]);
+			}
+			else {
+				fprintf(out, "  ");
+			}
+		}
+		fprintf(out, "%s%-28s", truncated ? ".." : "  ", mnem->str);
+
+		if (end - p < 2) {
+			return 1;
+		}
+		uint16_t mask = get_u16(p);
+		p += 2;
+		for (int i = 0; i < ITRACE_REGS; ++i) {
+			if (mask & (1 << i)) {
+				if (end - p < 2) {
+					return 1;
+				}
+				regs[i] = get_u16(p);
+				p += 2;
+			}
+		}
+		print_regs(out, regs, mask);
+
+		if (flags & ITRACE_WRITES) {
+			if (end - p < 1 || end - p < 1 + p[0] * 4) {
+				return 1;
+			}
+			uint8_t count = *p++;
+			for (uint8_t i = 0; i < count; ++i) {
+				fprintf(out, " [%05X]=%02X", p[0] | (p[1] << 8) | (p[2] << 16), p[3]);
+				p += 4;
+			}
+		}
+		if (flags & ITRACE_OVERFLOW) {
+			fprintf(out, " [...]");
+		}
+		fprintf(out, "\n");
+		index++;
+	}
+	*next_index = index;
+	return 0;
+}
+
+int itrace_decode(const char* path, FILE* out) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		log_error("[ITRACE] Failed to open %s\n", path);
+		return 1;
+	}
+
+	uint8_t header[ITRACE_MAGIC_SIZE + 4];
+	if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, ITRACE_MAGIC, ITRACE_MAGIC_SIZE) != 0 || get_u32(header + ITRACE_MAGIC_SIZE) != ITRACE_BLOCK_SIZE) {
+		log_error("[ITRACE] %s is not an instruction trace\n", path);
+		fclose(file);
+		return 1;
+	}
+
+	uint8_t* block = malloc(ITRACE_BLOCK_SIZE);
+	uint8_t* stored = malloc(LZ_BOUND(ITRACE_BLOCK_SIZE));
+	if (block == NULL || stored == NULL) {
+		log_error("[ITRACE] Failed to allocate the block\n");
+		free(block);
+		free(stored);
+		fclose(file);
+		return 1;
+	}
+
+	I8086 cpu = { 0 };
+	cpu.funcs.read_mem_byte = decode_read_mem_byte;
+	I8086_MNEM mnem = { 0 };
+	mnem.state = &cpu;
+
+	int error = 0;
+	uint64_t next_index = 0;
+	uint8_t sizes[8];
+	while (fread(sizes, sizeof(sizes), 1, file) == 1) {
+		uint32_t size = get_u32(sizes);
+		uint32_t stored_size = get_u32(sizes + 4);
+		if (size > ITRACE_BLOCK_SIZE || stored_size > size || fread(stored, stored_size, 1, file) != 1) {
+			error = 1;
+			break;
+		}
+		if (stored_size < size) {
+			if (lz_decompress(stored, stored_size, block, ITRACE_BLOCK_SIZE) != size) {
+				error = 1;
+				break;
+			}
+		}
+		else {
+			memcpy(block, stored, size);
+		}
+		if (decode_block(block, size, &next_index, &cpu, &mnem, out)) {
+			error = 1;
+			break;
+		}
+	}
+	if (error) {
+		log_error("[ITRACE] %s is corrupt after instruction %llu\n", path, (unsigned long long)next_index);
+	}
+
+	free(block);
+	free(stored);
+	fclose(file);
+	return error;
+}
@@ -0,0 +1,88 @@
+/* itrace.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Instruction trace; CS:IP, the instruction bytes, the registers changed and the memory written per instruction,
+ * recorded into a ring of blocks and optionally streamed to a compressed file
+ */
+
+#ifndef ITRACE_H
+#define ITRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "i8086.h"
+
+#define ITRACE_BLOCK_SIZE   0x10000 /* records never span blocks; a block is the unit of the ring and of the file */
+#define ITRACE_RING_KB_DEFAULT 16384
+#define ITRACE_BYTES        8       /* instruction bytes recorded; the longest 8086 instruction with 2 prefixes. Longer ones are marked truncated when decoded */
+#define ITRACE_MAX_WRITES   32      /* memory writes recorded per instruction; the rest are dropped and flagged */
+#define ITRACE_REGS         12      /* AX CX DX BX SP BP SI DI ES SS DS FLAGS; CS:IP is in each record */
+#define ITRACE_RECORD_MAX   (1 + 2 + 2 + ITRACE_BYTES + ITRACE_REGS * 2 + 2 + ITRACE_REGS * 2 + 1 + ITRACE_MAX_WRITES * 4)
+#define ITRACE_BLOCK_HEADER 12      /* u32 used bytes, u64 index of the first instruction */
+
+/* Record flags */
+#define ITRACE_KEY      0x01 /* the full register state before the instruction follows; the first record of a block, or the registers were loaded outside of an instruction */
+#define ITRACE_CS       0x02 /* CS follows; set if CS is not the CS of the last record */
+#define ITRACE_WRITES   0x04 /* memory writes follow */
+#define ITRACE_OVERFLOW 0x08 /* more than ITRACE_MAX_WRITES writes; the rest were dropped */
+
+typedef struct ITRACE {
+	uint8_t enabled;
+	uint8_t recording;           /* an instruction is executing; its memory writes are recorded */
+	uint8_t* ring;               /* block_count blocks */
+	uint8_t* compressed;         /* LZ_BOUND(ITRACE_BLOCK_SIZE); a block compressed for writing */
+	uint32_t block_count;
+	uint32_t block;              /* the block being written */
+	uint32_t used;               /* bytes used in the block being written */
+	uint32_t blocks_full;        /* full blocks in the ring; up to block_count - 1 */
+	uint64_t instructions;       /* instructions recorded */
+
+	uint16_t regs[ITRACE_REGS];  /* register state after the last record */
+	uint16_t cs;                 /* CS of the last record */
+	uint8_t* record;             /* the record being written */
+	uint8_t* cursor;             /* the end of the record being written */
+	uint8_t write_count;
+	uint8_t overflow;
+	uint8_t writes[ITRACE_MAX_WRITES][4]; /* address (u24), value */
+
+	FILE* stream;                /* full blocks are written here as they fill; NULL = ring only */
+} ITRACE;
+
+/* Create the ring
+	itrace: the itrace instance
+	ring_kb: the ring size in KB; rounded up to whole blocks
+	stream_path: stream each block to this file as it fills. NULL = the ring is written at exit
+	Returns: 0 if success. Otherwise 1 */
+int itrace_create(ITRACE* itrace, uint32_t ring_kb, const char* stream_path);
+void itrace_destroy(ITRACE* itrace);
+
+/* Start a record; before the instruction executes
+	itrace: the itrace instance
+	cpu: the cpu
+	mem: guest memory; the instruction bytes are read from it */
+void itrace_begin(ITRACE* itrace, const I8086* cpu, const uint8_t* mem);
+
+/* Record a memory write; only while an instruction is being recorded
+	itrace: the itrace instance
+	address: the physical address
+	value: the value written */
+void itrace_add_write(ITRACE* itrace, uint32_t address, uint8_t value);
+
+/* End the record; after the instruction executes
+	itrace: the itrace instance
+	cpu: the cpu */
+void itrace_end(ITRACE* itrace, const I8086* cpu);
+
+/* Write the trace; the ring oldest first, or the rest of the stream
+	itrace: the itrace instance
+	path: the file to write the ring to. Unused if streaming
+	Returns: 0 if success. Otherwise 1 */
+int itrace_write(ITRACE* itrace, const char* path);
+
+/* Print a trace file as text; disassembled with i8086_mnem
+	path: the trace file
+	out: the output
+	Returns: 0 if success. Otherwise 1 */
+int itrace_decode(const char* path, FILE* out);
+
+#endif
@@ -0,0 +1,264 @@
+/* journal.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Input journal; records externally injected events stamped with the emulated cycle and replays them
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "journal.h"
+
+#include "frontend/utility/file.h"
+
+/* File format:
+ * "PCJ1" then events; type (u8), cycles since the previous event (varint), payload.
+ * The cycle count restarts at 0 after a reset event. */
+
+#define JOURNAL_MAGIC      "PCJ1"
+#define JOURNAL_MAGIC_SIZE 4
+#define JOURNAL_GROW_SIZE  4096
+
+#define LOG_CATEGORY LOG_CAT_MAIN
+#include "utility/log.h"
+
+static int reserve(JOURNAL* journal, size_t size) {
+	if (journal->size + size <= journal->capacity) {
+		return 0;
+	}
+	size_t capacity = journal->capacity + JOURNAL_GROW_SIZE + size;
+	uint8_t* buffer = realloc(journal->buffer, capacity);
+	if (buffer == NULL) {
+		log_error("[JOURNAL] Failed to allocate %zu bytes\n", capacity);
+		return 1;
+	}
+	journal->buffer = buffer;
+	journal->capacity = capacity;
+	return 0;
+}
+
+static void put_byte(JOURNAL* journal, uint8_t value) {
+	journal->buffer[journal->size++] = value;
+}
+static void put_varint(JOURNAL* journal, uint64_t value) {
+	/* 7 bits per byte; b7 set if more bytes follow */
+	while (value >= 0x80) {
+		put_byte(journal, (uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	put_byte(journal, (uint8_t)value);
+}
+
+static int get_byte(JOURNAL* journal, uint8_t* value) {
+	if (journal->offset >= journal->size) {
+		return 1;
+	}
+	*value = journal->buffer[journal->offset++];
+	return 0;
+}
+static int get_varint(JOURNAL* journal, uint64_t* value) {
+	uint8_t byte = 0;
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (get_byte(journal, &byte)) {
+			return 1;
+		}
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int decode_next(JOURNAL* journal) {
+	JOURNAL_EVENT* e = &journal->next;
+	uint64_t delta = 0;
+	uint64_t value = 0;
+
+	journal->pending = 0;
+	memset(e, 0, sizeof(JOURNAL_EVENT));
+
+	if (get_byte(journal, &e->type) || get_varint(journal, &delta)) {
+		return 1;
+	}
+	e->cycle = journal->last_cycle + delta;
+
+	switch (e->type) {
+		case JOURNAL_EVENT_KEY:
+			if (get_byte(journal, &e->scancode)) {
+				return 1;
+			}
+			break;
+
+		case JOURNAL_EVENT_RESET:
+			break;
+
+		case JOURNAL_EVENT_DISK_INSERT:
+		case JOURNAL_EVENT_HDD_INSERT:
+			if (get_byte(journal, &e->drive) || get_varint(journal, &value)) {
+				return 1;
+			}
+			if (value >= JOURNAL_PATH_LEN || journal->offset + value > journal->size) {
+				return 1;
+			}
+			memcpy(e->path, journal->buffer + journal->offset, (size_t)value);
+			e->path[value] = '\0';
+			journal->offset += (size_t)value;
+			break;
+
+		case JOURNAL_EVENT_DISK_EJECT:
+		case JOURNAL_EVENT_HDD_EJECT:
+			if (get_byte(journal, &e->drive)) {
+				return 1;
+			}
+			break;
+
+		case JOURNAL_EVENT_DISK_NEW:
+			if (get_byte(journal, &e->drive) || get_varint(journal, &value)) {
+				return 1;
+			}
+			e->size = (uint32_t)value;
+			break;
+
+		default:
+			log_warn("[JOURNAL] Unknown event type %02X at offset %zu\n", e->type, journal->offset);
+			return 1;
+	}
+
+	/* the emulated clock restarts at a reset */
+	journal->last_cycle = (e->type == JOURNAL_EVENT_RESET) ? 0 : e->cycle;
+	journal->pending = 1;
+	return 0;
+}
+
+static void free_buffer(JOURNAL* journal) {
+	if (journal->buffer != NULL) {
+		free(journal->buffer);
+		journal->buffer = NULL;
+	}
+	journal->size = 0;
+	journal->capacity = 0;
+	journal->offset = 0;
+	journal->last_cycle = 0;
+	journal->pending = 0;
+}
+
+int journal_record(JOURNAL* journal, const char* path) {
+	journal_stop(journal);
+
+	if (reserve(journal, JOURNAL_MAGIC_SIZE)) {
+		return 1;
+	}
+	memcpy(journal->buffer, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+	journal->size = JOURNAL_MAGIC_SIZE;
+
+	strncpy_s(journal->path, sizeof(journal->path), path, sizeof(journal->path) - 1);
+	journal->events = 0;
+	journal->mode = JOURNAL_MODE_RECORD;
+	log_info("[JOURNAL] Recording to %s\n", journal->path);
+	return 0;
+}
+
+int journal_replay(JOURNAL* journal, const char* path) {
+	journal_stop(journal);
+
+	void* buffer = NULL;
+	size_t size = 0;
+	if (file_read_alloc_buffer(path, &buffer, &size)) {
+		return 1; /* file_read_alloc_buffer() reports errors to console */
+	}
+	journal->buffer = buffer;
+	journal->size = size;
+	journal->capacity = size;
+
+	if (size < JOURNAL_MAGIC_SIZE || memcmp(journal->buffer, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0) {
+		log_error("[JOURNAL] %s is not a journal file\n", path);
+		free_buffer(journal);
+		return 1;
+	}
+	journal->offset = JOURNAL_MAGIC_SIZE;
+
+	strncpy_s(journal->path, sizeof(journal->path), path, sizeof(journal->path) - 1);
+	journal->events = 0;
+	journal->mode = JOURNAL_MODE_REPLAY;
+	decode_next(journal);
+	if (!journal->pending) {
+		journal_stop(journal); /* empty */
+		return 0;
+	}
+	log_info("[JOURNAL] Replaying %s\n", journal->path);
+	return 0;
+}
+
+int journal_stop(JOURNAL* journal) {
+	int error = 0;
+	if (journal->mode == JOURNAL_MODE_RECORD) {
+		error = file_write_from_buffer(journal->path, journal->buffer, journal->size);
+		log_info("[JOURNAL] Recorded %u events to %s\n", journal->events, journal->path);
+	}
+	else if (journal->mode == JOURNAL_MODE_REPLAY) {
+		log_info("[JOURNAL] Replayed %u events from %s\n", journal->events, journal->path);
+	}
+	journal->mode = JOURNAL_MODE_NONE;
+	free_buffer(journal);
+	return error;
+}
+
+void journal_add(JOURNAL* journal, const JOURNAL_EVENT* e) {
+	if (journal->mode != JOURNAL_MODE_RECORD) {
+		return;
+	}
+
+	size_t path_len = 0;
+	if (e->type == JOURNAL_EVENT_DISK_INSERT || e->type == JOURNAL_EVENT_HDD_INSERT) {
+		path_len = strnlen(e->path, JOURNAL_PATH_LEN - 1);
+	}
+
+	/* type, 2 varints, drive/scancode, path */
+	if (reserve(journal, 1 + 10 + 10 + 1 + path_len)) {
+		return;
+	}
+
+	put_byte(journal, e->type);
+	put_varint(journal, e->cycle - journal->last_cycle);
+
+	switch (e->type) {
+		case JOURNAL_EVENT_KEY:
+			put_byte(journal, e->scancode);
+			break;
+		case JOURNAL_EVENT_DISK_INSERT:
+		case JOURNAL_EVENT_HDD_INSERT:
+			put_byte(journal, e->drive);
+			put_varint(journal, path_len);
+			memcpy(journal->buffer + journal->size, e->path, path_len);
+			journal->size += path_len;
+			break;
+		case JOURNAL_EVENT_DISK_EJECT:
+		case JOURNAL_EVENT_HDD_EJECT:
+			put_byte(journal, e->drive);
+			break;
+		case JOURNAL_EVENT_DISK_NEW:
+			put_byte(journal, e->drive);
+			put_varint(journal, e->size);
+			break;
+	}
+
+	journal->last_cycle = (e->type == JOURNAL_EVENT_RESET) ? 0 : e->cycle;
+	journal->events++;
+}
+
+const JOURNAL_EVENT* journal_peek(JOURNAL* journal, uint64_t cycle) {
+	if (journal->mode != JOURNAL_MODE_REPLAY || !journal->pending || journal->next.cycle > cycle) {
+		return NULL;
+	}
+	return &journal->next;
+}
+
+void journal_pop(JOURNAL* journal) {
+	journal->events++;
+	if (decode_next(journal)) {
+		journal_stop(journal); /* end of the journal; input goes back to the frontend */
+	}
+}
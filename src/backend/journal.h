@@ -0,0 +1,80 @@
+/* journal.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Input journal; records externally injected events stamped with the emulated cycle and replays them
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JOURNAL_MODE_NONE   0
+#define JOURNAL_MODE_RECORD 1
+#define JOURNAL_MODE_REPLAY 2
+
+#define JOURNAL_EVENT_KEY         0x01 /* scancode */
+#define JOURNAL_EVENT_RESET       0x02
+#define JOURNAL_EVENT_DISK_INSERT 0x03 /* drive, path */
+#define JOURNAL_EVENT_DISK_EJECT  0x04 /* drive */
+#define JOURNAL_EVENT_DISK_NEW    0x05 /* drive, size */
+#define JOURNAL_EVENT_HDD_INSERT  0x06 /* drive, path */
+#define JOURNAL_EVENT_HDD_EJECT   0x07 /* drive */
+
+#define JOURNAL_PATH_LEN 256
+
+typedef struct JOURNAL_EVENT {
+	uint8_t type;     /* JOURNAL_EVENT_XXX */
+	uint64_t cycle;   /* emulated cycle; relative to the last reset */
+	uint8_t scancode;
+	uint8_t drive;
+	uint32_t size;
+	char path[JOURNAL_PATH_LEN];
+} JOURNAL_EVENT;
+
+typedef struct JOURNAL {
+	uint8_t mode;          /* JOURNAL_MODE_XXX */
+	char path[JOURNAL_PATH_LEN];
+	uint8_t* buffer;       /* encoded events */
+	size_t size;
+	size_t capacity;
+	size_t offset;         /* replay read offset */
+	uint64_t last_cycle;   /* cycle of the last encoded/decoded event */
+	uint32_t events;       /* events recorded/replayed */
+	uint8_t pending;       /* next holds the next event to replay */
+	JOURNAL_EVENT next;
+} JOURNAL;
+
+/* Start recording; the journal is written to path by journal_stop()
+	journal: the journal instance
+	path: the journal file
+	Returns: 0 if success. Otherwise 1 */
+int journal_record(JOURNAL* journal, const char* path);
+
+/* Start replaying a journal file
+	journal: the journal instance
+	path: the journal file
+	Returns: 0 if success. Otherwise 1 */
+int journal_replay(JOURNAL* journal, const char* path);
+
+/* Stop recording/replaying. A recording is written out
+	journal: the journal instance
+	Returns: 0 if success. 1 if the recording could not be written */
+int journal_stop(JOURNAL* journal);
+
+/* Append an event to the recording
+	journal: the journal instance
+	e: the event */
+void journal_add(JOURNAL* journal, const JOURNAL_EVENT* e);
+
+/* Get the next event to replay if it is due
+	journal: the journal instance
+	cycle: the current emulated cycle
+	Returns: the event or NULL if none is due. Valid until journal_pop() */
+const JOURNAL_EVENT* journal_peek(JOURNAL* journal, uint64_t cycle);
+
+/* Consume the event returned by journal_peek(). Replay stops after the last event
+	journal: the journal instance */
+void journal_pop(JOURNAL* journal);
+
+#endif
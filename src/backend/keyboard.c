@@ -10,22 +10,17 @@
 
 #include "backend/chipset/i8259_pic.h"
 
-#define KEYS_SIZE 10
+#define KEYS_SIZE 16
 
 #define KBD_IRQ 1
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_KBD
+#include "utility/log.h"
 
 static void reset_check(KBD* kbd) {
 	if (kbd->do_reset) {
 		kbd->do_reset = 0;
-		ring_buffer_reset(&kbd->key_buffer);
+		spsc_ring_buffer_clear(&kbd->key_queue);
 		kbd->data = 0xAA;
 		i8259_pic_request_interrupt(kbd->pic_p, KBD_IRQ);
 	}
@@ -34,9 +29,13 @@ static void reset_check(KBD* kbd) {
 void kbd_reset(KBD* kbd) {
 	kbd->do_reset = 0;
 	kbd->enabled = 0;
-	kbd->reset_elapsed = timing_get_ticks_ms();
+	kbd->reset_elapsed = timing_virtual_get_ticks_ms();
 	kbd->data = 0;
-	ring_buffer_reset(&kbd->key_buffer);
+	kbd->sync_ns = 0;
+	kbd->sync_prev_ns = 0;
+	kbd->sync_cycle = 0;
+	kbd->sync_cycles = 0;
+	spsc_ring_buffer_clear(&kbd->key_queue);
 }
 
 uint8_t kbd_get_data(KBD* kbd) {
@@ -56,11 +55,12 @@ void kbd_set_enable(KBD* kbd, uint8_t enable) {
 }
 
 void kbd_set_clk(KBD* kbd, uint8_t clk) {
+	/* the reset pulse is timed in emulated time */
 	if (clk == 0) {
-		kbd->reset_elapsed = timing_get_ticks_ms();
+		kbd->reset_elapsed = timing_virtual_get_ticks_ms();
 	}
 	else {
-		uint64_t ticks = timing_get_ticks_ms() - kbd->reset_elapsed;
+		uint64_t ticks = timing_virtual_get_ticks_ms() - kbd->reset_elapsed;
 		if (ticks > 10) {
 			kbd->do_reset = 1;
 		}
@@ -68,26 +68,92 @@ void kbd_set_clk(KBD* kbd, uint8_t clk) {
 	}
 }
 
-void kbd_tick(KBD* kbd) {
+static uint64_t key_due_cycle(KBD* kbd, uint64_t timestamp) {
+	/* Place the key at the same offset into the current frame as it was into the previous frame */
+	if (timestamp <= kbd->sync_prev_ns || kbd->sync_ns <= kbd->sync_prev_ns) {
+		return kbd->sync_cycle; /* late; deliver now */
+	}
+	uint64_t frame_ns = kbd->sync_ns - kbd->sync_prev_ns;
+	uint64_t offset_ns = timestamp - kbd->sync_prev_ns;
+	return kbd->sync_cycle + (uint64_t)((double)offset_ns * kbd->sync_cycles / frame_ns);
+}
+
+void kbd_deliver_key(KBD* kbd, uint8_t scancode) {
+	kbd->data = scancode;
+	i8259_pic_request_interrupt(kbd->pic_p, KBD_IRQ);
+	if (kbd->on_key != NULL) {
+		kbd->on_key(scancode);
+	}
+}
+
+void kbd_tick(KBD* kbd, uint64_t cycle) {
 	reset_check(kbd);
-	if (kbd->enabled && !ring_buffer_is_empty(&kbd->key_buffer)) {
-		kbd->data = ring_buffer_pop(&kbd->key_buffer);
-		i8259_pic_request_interrupt(kbd->pic_p, KBD_IRQ);
+	if (kbd->queue_disabled) {
+		spsc_ring_buffer_clear(&kbd->key_queue);
+	}
+	else if (kbd->enabled) {
+		KBD_KEY_EVENT e;
+		if (spsc_ring_buffer_peek(&kbd->key_queue, 0, &e) == 0) {
+			if (e.timestamp > kbd->sync_ns) {
+				return; /* queued during this frame; due next frame */
+			}
+			if (cycle < key_due_cycle(kbd, e.timestamp)) {
+				return;
+			}
+			spsc_ring_buffer_pop(&kbd->key_queue, NULL);
+			kbd_deliver_key(kbd, e.scancode);
+		}
 	}
 }
 
+void kbd_sync(KBD* kbd, uint64_t host_ns, uint64_t cycle, uint64_t cycles_per_frame) {
+	kbd->sync_prev_ns = kbd->sync_ns;
+	kbd->sync_ns = host_ns;
+	kbd->sync_cycle = cycle;
+	kbd->sync_cycles = cycles_per_frame;
+}
+
+int kbd_push_key(KBD* kbd, uint8_t scancode, uint64_t timestamp) {
+	KBD_KEY_EVENT e = {
+		.timestamp = timestamp,
+		.scancode = scancode,
+	};
+	if (spsc_ring_buffer_push(&kbd->key_queue, &e)) {
+		log_warn("[KBD] Key queue full; dropped %02X\n", scancode);
+		return 1;
+	}
+	return 0;
+}
+
+void kbd_save_state(KBD* kbd, KBD_STATE* state) {
+	state->enabled = kbd->enabled;
+	state->do_reset = kbd->do_reset;
+	state->data = kbd->data;
+	state->reset_elapsed = kbd->reset_elapsed;
+}
+void kbd_load_state(KBD* kbd, const KBD_STATE* state) {
+	kbd->enabled = state->enabled;
+	kbd->do_reset = state->do_reset;
+	kbd->data = state->data;
+	kbd->reset_elapsed = state->reset_elapsed;
+}
+
 int kbd_create(KBD* kbd) {
-	if (ring_buffer_create(&kbd->key_buffer, KEYS_SIZE)) {
-		dbg_print("[KBD] Failed to allocate key buffer\n");
+	if (spsc_ring_buffer_create(&kbd->key_queue, KEYS_SIZE, sizeof(KBD_KEY_EVENT))) {
+		log_error("[KBD] Failed to allocate key queue\n");
 		return 1;
 	}
 	return 0;
 }
 
 void kbd_destroy(KBD* kbd) {
-	ring_buffer_destroy(&kbd->key_buffer);
+	spsc_ring_buffer_destroy(&kbd->key_queue);
 }
 
 void kbd_init(KBD* kbd, I8259_PIC* pic) {
 	kbd->pic_p = pic;
 }
+
+void kbd_set_key_cb(KBD* kbd, on_key_cb on_key) {
+	kbd->on_key = on_key;
+}
@@ -12,20 +12,76 @@
 
 typedef struct I8259_PIC I8259_PIC;
 
+/* Key event; queued by the frontend, delivered by the emulator */
+typedef struct KBD_KEY_EVENT {
+	uint64_t timestamp; /* host time of the key press/release in ns */
+	uint8_t scancode;   /* pc scancode; bit 7 set on release */
+} KBD_KEY_EVENT;
+
+typedef void(*on_key_cb)(uint8_t scancode);
+
 typedef struct KBD {
 	uint8_t enabled;
 	uint8_t do_reset;
 	uint8_t data;
 	uint64_t reset_elapsed;
-	RING_BUFFER key_buffer;
+	SPSC_RING_BUFFER key_queue; /* KBD_KEY_EVENT; frontend thread -> emulation thread */
+	uint8_t queue_disabled;     /* keys come from kbd_deliver_key() only; the key queue is discarded */
+	on_key_cb on_key;           /* on key delivered cb */
 	I8259_PIC* pic_p;
+
+	/* Host time to emulated cycle mapping; set at the start of each emulated frame */
+	uint64_t sync_ns;           /* host time of the current frame */
+	uint64_t sync_prev_ns;      /* host time of the previous frame */
+	uint64_t sync_cycle;        /* emulated cycle of the current frame */
+	uint64_t sync_cycles;       /* emulated cycles in a frame */
 } KBD;
 
+/* Keyboard state for a snapshot; queued key events are not part of it */
+typedef struct KBD_STATE {
+	uint8_t enabled;
+	uint8_t do_reset;
+	uint8_t data;
+	uint64_t reset_elapsed;
+} KBD_STATE;
+
 uint8_t kbd_get_data(KBD* kbd);
 void kbd_set_enable(KBD* kbd, uint8_t enable);
 void kbd_set_clk(KBD* kbd, uint8_t clk);
 void kbd_reset(KBD*);
-void kbd_tick(KBD* kbd);
+
+/* Deliver the next due key event
+	kbd: the kbd instance
+	cycle: the current emulated cycle */
+void kbd_tick(KBD* kbd, uint64_t cycle);
+
+/* Map host time onto emulated cycles for the frame about to run. Key events from the
+	previous frame are delivered at the same offset into this frame; one frame of latency.
+	kbd: the kbd instance
+	host_ns: the host time of the frame
+	cycle: the emulated cycle the frame starts at
+	cycles_per_frame: the emulated cycles in a frame */
+void kbd_sync(KBD* kbd, uint64_t host_ns, uint64_t cycle, uint64_t cycles_per_frame);
+
+/* Queue a key event; Frontend thread. Lock-free
+	kbd: the kbd instance
+	scancode: the pc scancode; bit 7 set on release
+	timestamp: the host time of the event in ns
+	Returns: 0 if success. 1 if the queue is full */
+int kbd_push_key(KBD* kbd, uint8_t scancode, uint64_t timestamp);
+
+/* Deliver a key now, bypassing the key queue; Emulation thread
+	kbd: the kbd instance
+	scancode: the pc scancode; bit 7 set on release */
+void kbd_deliver_key(KBD* kbd, uint8_t scancode);
+
+/* Set the callback for when a key is delivered to the guest
+	kbd: the kbd instance
+	on_key: the callback */
+void kbd_set_key_cb(KBD* kbd, on_key_cb on_key);
+
+void kbd_save_state(KBD* kbd, KBD_STATE* state);
+void kbd_load_state(KBD* kbd, const KBD_STATE* state);
 
 int kbd_create(KBD* kbd);
 void kbd_destroy(KBD* kbd);
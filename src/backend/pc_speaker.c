@@ -0,0 +1,143 @@
+/* pc_speaker.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * PC Speaker; level transitions are logged with the cycle they happen at and synthesized in blocks
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "pc_speaker.h"
+#include "audio.h"
+#include "utility/blip_buffer.h"
+
+/* The devices only log edges; no work is done per instruction or per sample.
+ * pc_speaker_update() turns the block of edges into band-limited steps once per time slice. */
+
+#define BLOCK_MAX_SAMPLES (PC_SPEAKER_SAMPLE_RATE / 10) /* 100ms */
+
+#define LOG_CATEGORY LOG_CAT_AUDIO
+#include "utility/log.h"
+
+static float level_to_amplitude(uint8_t level) {
+	return level ? PC_SPEAKER_AMPLITUDE : -PC_SPEAKER_AMPLITUDE;
+}
+
+static void set_level(PC_SPEAKER* pc_speaker, uint64_t cycle) {
+	uint8_t level = (pc_speaker->input && pc_speaker->data);
+	if (level == pc_speaker->level) {
+		return;
+	}
+	pc_speaker->level = level;
+
+	if (pc_speaker->edges == NULL) {
+		return; /* no audio */
+	}
+	if (pc_speaker->edge_count == PC_SPEAKER_EDGE_MAX) {
+		pc_speaker_update(pc_speaker, cycle);
+	}
+	pc_speaker->edges[pc_speaker->edge_count].cycle = cycle;
+	pc_speaker->edges[pc_speaker->edge_count].level = level;
+	pc_speaker->edge_count++;
+}
+
+int pc_speaker_create(PC_SPEAKER* pc_speaker, double clock_hz) {
+	memset(pc_speaker, 0, sizeof(PC_SPEAKER));
+
+	pc_speaker->edges = calloc(PC_SPEAKER_EDGE_MAX, sizeof(PC_SPEAKER_EDGE));
+	if (pc_speaker->edges == NULL) {
+		log_error("[PC SPEAKER] Failed to allocate the edge log\n");
+		return 1;
+	}
+
+	pc_speaker->samples = calloc(BLOCK_MAX_SAMPLES, sizeof(int16_t));
+	if (pc_speaker->samples == NULL) {
+		log_error("[PC SPEAKER] Failed to allocate the sample buffer\n");
+		return 1;
+	}
+
+	if (blip_buffer_create(&pc_speaker->blip, clock_hz, PC_SPEAKER_SAMPLE_RATE, BLOCK_MAX_SAMPLES)) {
+		return 1; /* blip_buffer_create() reports errors to console */
+	}
+	return 0;
+}
+void pc_speaker_destroy(PC_SPEAKER* pc_speaker) {
+	blip_buffer_destroy(&pc_speaker->blip);
+	if (pc_speaker->edges != NULL) {
+		free(pc_speaker->edges);
+		pc_speaker->edges = NULL;
+	}
+	if (pc_speaker->samples != NULL) {
+		free(pc_speaker->samples);
+		pc_speaker->samples = NULL;
+	}
+	pc_speaker->edge_count = 0;
+}
+
+void pc_speaker_reset(PC_SPEAKER* pc_speaker) {
+	pc_speaker->input = 0;
+	pc_speaker->data = 0;
+	pc_speaker->level = 0;
+	pc_speaker_restart(pc_speaker, 0);
+}
+
+void pc_speaker_set_input(PC_SPEAKER* pc_speaker, uint8_t input, uint64_t cycle) {
+	pc_speaker->input = input;
+	set_level(pc_speaker, cycle);
+}
+void pc_speaker_set_data(PC_SPEAKER* pc_speaker, uint8_t data, uint64_t cycle) {
+	pc_speaker->data = data;
+	set_level(pc_speaker, cycle);
+}
+
+void pc_speaker_update(PC_SPEAKER* pc_speaker, uint64_t cycle) {
+	if (pc_speaker->edges == NULL) {
+		return;
+	}
+	if (!audio_is_enabled() || cycle < pc_speaker->block_cycle) {
+		pc_speaker_restart(pc_speaker, cycle);
+		return;
+	}
+
+	uint64_t clocks = cycle - pc_speaker->block_cycle;
+	if (clocks * pc_speaker->blip.samples_per_clock >= BLOCK_MAX_SAMPLES - BLIP_WIDTH) {
+		/* longer than the buffer; the emulator was paused or stepped. Nothing is heard */
+		pc_speaker_restart(pc_speaker, cycle);
+		return;
+	}
+
+	for (uint32_t i = 0; i < pc_speaker->edge_count; ++i) {
+		const PC_SPEAKER_EDGE* edge = &pc_speaker->edges[i];
+		if (edge->level != pc_speaker->out_level) {
+			float delta = level_to_amplitude(edge->level) - level_to_amplitude(pc_speaker->out_level);
+			blip_buffer_add_delta(&pc_speaker->blip, edge->cycle - pc_speaker->block_cycle, delta);
+			pc_speaker->out_level = edge->level;
+		}
+	}
+	blip_buffer_end_frame(&pc_speaker->blip, clocks);
+
+	uint32_t count = blip_buffer_read_samples(&pc_speaker->blip, pc_speaker->samples, BLOCK_MAX_SAMPLES);
+	audio_output(pc_speaker->samples, count);
+
+	pc_speaker->edge_count = 0;
+	pc_speaker->block_cycle = cycle;
+}
+
+void pc_speaker_restart(PC_SPEAKER* pc_speaker, uint64_t cycle) {
+	pc_speaker->edge_count = 0;
+	pc_speaker->block_cycle = cycle;
+	pc_speaker->out_level = pc_speaker->level;
+	blip_buffer_clear(&pc_speaker->blip);
+}
+
+void pc_speaker_save_state(PC_SPEAKER* pc_speaker, PC_SPEAKER_STATE* state) {
+	state->input = pc_speaker->input;
+	state->data = pc_speaker->data;
+}
+void pc_speaker_load_state(PC_SPEAKER* pc_speaker, const PC_SPEAKER_STATE* state, uint64_t cycle) {
+	pc_speaker->input = state->input;
+	pc_speaker->data = state->data;
+	pc_speaker->level = (state->input && state->data);
+	pc_speaker_restart(pc_speaker, cycle);
+}
@@ -0,0 +1,82 @@
+/* pc_speaker.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * PC Speaker; level transitions are logged with the cycle they happen at and synthesized in blocks
+ */
+
+#ifndef PC_SPEAKER_H
+#define PC_SPEAKER_H
+
+#include <stdint.h>
+
+#include "utility/blip_buffer.h"
+
+#define PC_SPEAKER_SAMPLE_RATE 48000
+#define PC_SPEAKER_EDGE_MAX    4096 /* edges per block; a full log is synthesized early */
+#define PC_SPEAKER_AMPLITUDE   6000.0f
+
+/* A level transition */
+typedef struct PC_SPEAKER_EDGE {
+	uint64_t cycle;  /* virtual clock */
+	uint8_t level;
+} PC_SPEAKER_EDGE;
+
+typedef struct PC_SPEAKER {
+	uint8_t input;  /* PIT timer 2 out */
+	uint8_t data;   /* PPI port B b1; speaker data */
+	uint8_t level;  /* speaker level; input AND data */
+
+	PC_SPEAKER_EDGE* edges; /* edges since block_cycle */
+	uint32_t edge_count;
+	uint64_t block_cycle;   /* cycle the block started at */
+	uint8_t out_level;      /* level the blip buffer is at */
+
+	BLIP_BUFFER blip;
+	int16_t* samples;
+} PC_SPEAKER;
+
+/* Speaker state */
+typedef struct PC_SPEAKER_STATE {
+	uint8_t input;
+	uint8_t data;
+} PC_SPEAKER_STATE;
+
+/* Create the speaker
+	pc_speaker: the speaker instance
+	clock_hz: the virtual clock rate the edges are stamped with
+	Returns: 0 if success. Otherwise 1 */
+int pc_speaker_create(PC_SPEAKER* pc_speaker, double clock_hz);
+void pc_speaker_destroy(PC_SPEAKER* pc_speaker);
+
+/* Reset the speaker; the level goes low
+	pc_speaker: the speaker instance */
+void pc_speaker_reset(PC_SPEAKER* pc_speaker);
+
+/* Set the PIT timer 2 out
+	pc_speaker: the speaker instance
+	input: the timer out
+	cycle: the virtual clock */
+void pc_speaker_set_input(PC_SPEAKER* pc_speaker, uint8_t input, uint64_t cycle);
+
+/* Set the speaker data bit
+	pc_speaker: the speaker instance
+	data: PPI port B b1
+	cycle: the virtual clock */
+void pc_speaker_set_data(PC_SPEAKER* pc_speaker, uint8_t data, uint64_t cycle);
+
+/* Synthesize the edges up to a cycle and output the samples through audio_output()
+	pc_speaker: the speaker instance
+	cycle: the virtual clock; the end of the block */
+void pc_speaker_update(PC_SPEAKER* pc_speaker, uint64_t cycle);
+
+/* Drop the edges and start a new block; the virtual clock jumped
+	pc_speaker: the speaker instance
+	cycle: the virtual clock */
+void pc_speaker_restart(PC_SPEAKER* pc_speaker, uint64_t cycle);
+
+/* Save/Load the speaker state
+	pc_speaker: the speaker instance
+	state: the state */
+void pc_speaker_save_state(PC_SPEAKER* pc_speaker, PC_SPEAKER_STATE* state);
+void pc_speaker_load_state(PC_SPEAKER* pc_speaker, const PC_SPEAKER_STATE* state, uint64_t cycle);
+
+#endif
@@ -0,0 +1,278 @@
+/* perf.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Performance counters; host time per subsystem, emulated speed and device access counts
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "perf.h"
+#include "timing.h"
+#include "utility/atomic.h"
+#include "io/memory_map.h"
+
+/* Reading the host clock costs about as much as a memory access. Only 1 in PERF_SAMPLE_STEPS steps is timed;
+ * the time of the timed steps is scaled up to all the steps of the frame. Access counts are exact. */
+
+#define TIMER_CALIBRATE_PAIRS 1000
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "utility/log.h"
+
+static const char* counter_names[PERF_COUNTERS] = {
+	"cpu", "mem", "io", "pit", "dma", "crtc", "disk", "other", "render"
+};
+
+static uint64_t calibrate_timer(void) {
+	uint64_t min = UINT64_MAX;
+	for (int i = 0; i < TIMER_CALIBRATE_PAIRS; ++i) {
+		uint64_t start = timing_get_ticks_ns();
+		uint64_t end = timing_get_ticks_ns();
+		if (end - start < min) {
+			min = end - start;
+		}
+	}
+	return min;
+}
+
+static int hist_bucket(uint64_t ns) {
+	uint64_t us = ns / 1000;
+	int bucket = 0;
+	while (us != 0 && bucket < PERF_HIST_BUCKETS - 1) {
+		us >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+int perf_create(PERF* perf, double clock_hz) {
+	memset(perf, 0, sizeof(PERF));
+
+	perf->io_reads = calloc(PERF_IO_PORTS, sizeof(uint32_t));
+	perf->io_writes = calloc(PERF_IO_PORTS, sizeof(uint32_t));
+	if (perf->io_reads == NULL || perf->io_writes == NULL) {
+		log_error("[PERF] Failed to allocate the port counts\n");
+		perf_destroy(perf);
+		return 1;
+	}
+
+	perf->clock_hz = clock_hz;
+	perf->timer_ns = calibrate_timer();
+	perf->frame_start_ns = timing_get_ticks_ns();
+	perf->enabled = 1;
+	return 0;
+}
+void perf_destroy(PERF* perf) {
+	perf->enabled = 0;
+	if (perf->io_reads != NULL) {
+		free(perf->io_reads);
+		perf->io_reads = NULL;
+	}
+	if (perf->io_writes != NULL) {
+		free(perf->io_writes);
+		perf->io_writes = NULL;
+	}
+}
+
+const char* perf_counter_name(int counter) {
+	if (counter < 0 || counter >= PERF_COUNTERS) {
+		return "?";
+	}
+	return counter_names[counter];
+}
+
+int perf_sample_step(PERF* perf) {
+	perf->frame_steps++;
+	if (perf->step != 0) {
+		perf->step--;
+		return 0;
+	}
+	perf->step = PERF_SAMPLE_STEPS - 1;
+	perf->frame_timed_steps++;
+	return 1;
+}
+
+uint64_t perf_add_ns(PERF* perf, int counter, uint64_t start_ns) {
+	uint64_t now = timing_get_ticks_ns();
+	uint64_t ns = now - start_ns;
+	perf->frame.ns[counter] += (ns > perf->timer_ns) ? ns - perf->timer_ns : 0;
+	return now;
+}
+
+void perf_add_render_ns(PERF* perf, uint64_t ns) {
+	if (ns > INT32_MAX) {
+		ns = INT32_MAX;
+	}
+	atomic32_fetch_add(&perf->render_ns, (int32_t)ns);
+}
+
+void perf_count_io(PERF* perf, uint16_t port, int write) {
+	if (write) {
+		perf->io_writes[port]++;
+	}
+	else {
+		perf->io_reads[port]++;
+	}
+}
+
+void perf_count_mem(PERF* perf, MEMORY_MAP* map, uint32_t address, int write) {
+	int i = memory_map_find_mregion(map, address);
+	if (i < 0 || i >= PERF_MREGION_MAX) {
+		return;
+	}
+	if (write) {
+		perf->mem_writes[i]++;
+	}
+	else {
+		perf->mem_reads[i]++;
+	}
+}
+
+static void end_frame(PERF* perf, uint64_t now) {
+	PERF_FRAME* frame = &perf->frame;
+	frame->host_ns = now - perf->frame_start_ns;
+	frame->instructions = perf->frame_steps;
+
+	/* scale the timed steps up to all steps */
+	if (perf->frame_timed_steps != 0) {
+		double scale = (double)perf->frame_steps / perf->frame_timed_steps;
+		for (int i = 0; i < PERF_COUNTERS; ++i) {
+			if (i != PERF_RENDER) {
+				frame->ns[i] = (uint64_t)(frame->ns[i] * scale);
+			}
+		}
+	}
+	frame->ns[PERF_RENDER] = (uint32_t)atomic32_exchange(&perf->render_ns, 0);
+
+	/* publish */
+	uint32_t count = (uint32_t)atomic32_load(&perf->frame_count);
+	perf->frames[count & (PERF_FRAME_HISTORY - 1)] = *frame;
+	atomic32_store(&perf->frame_count, (int32_t)(count + 1));
+
+	perf->total.host_ns += frame->host_ns;
+	perf->total.cycles += frame->cycles;
+	perf->total.instructions += frame->instructions;
+	for (int i = 0; i < PERF_COUNTERS; ++i) {
+		perf->total.ns[i] += frame->ns[i];
+		atomic32_fetch_add(&perf->hist[i][hist_bucket(frame->ns[i])], 1);
+	}
+
+	memset(frame, 0, sizeof(PERF_FRAME));
+	perf->frame_steps = 0;
+	perf->frame_timed_steps = 0;
+	perf->frame_start_ns = now;
+}
+
+void perf_update(PERF* perf, uint64_t cycles) {
+	if (cycles >= perf->last_cycles) {
+		perf->frame.cycles += cycles - perf->last_cycles;
+	}
+	perf->last_cycles = cycles; /* the virtual clock jumps back on a rewind */
+
+	uint64_t now = timing_get_ticks_ns();
+	if (now - perf->frame_start_ns >= PERF_FRAME_NS) {
+		end_frame(perf, now);
+	}
+}
+
+int perf_get_frame(PERF* perf, uint32_t age, PERF_FRAME* frame) {
+	uint32_t count = (uint32_t)atomic32_load(&perf->frame_count);
+	if (age >= count || age >= PERF_FRAME_HISTORY - 1) {
+		return 1;
+	}
+	uint32_t index = count - 1 - age;
+	*frame = perf->frames[index & (PERF_FRAME_HISTORY - 1)];
+
+	/* the writer is one slot ahead of the newest frame; the copy is good unless it lapped the slot */
+	count = (uint32_t)atomic32_load(&perf->frame_count);
+	if (count - index >= PERF_FRAME_HISTORY) {
+		return 1;
+	}
+	return 0;
+}
+
+void perf_get_speed(const PERF* perf, const PERF_FRAME* frame, double* mips, double* cycles_per_sec, double* ratio) {
+	double seconds = frame->host_ns / 1000000000.0;
+	if (seconds <= 0.0) {
+		*mips = 0.0;
+		*cycles_per_sec = 0.0;
+		*ratio = 0.0;
+		return;
+	}
+	*mips = frame->instructions / seconds / 1000000.0;
+	*cycles_per_sec = frame->cycles / seconds;
+	*ratio = *cycles_per_sec / perf->clock_hz;
+}
+
+int perf_write_json(PERF* perf, MEMORY_MAP* map, const char* path) {
+	FILE* file = stdout;
+	if (path != NULL) {
+		file = fopen(path, "w");
+		if (file == NULL) {
+			log_error("[PERF] Failed to open %s\n", path);
+			return 1;
+		}
+	}
+
+	double mips = 0.0;
+	double cycles_per_sec = 0.0;
+	double ratio = 0.0;
+	perf_get_speed(perf, &perf->total, &mips, &cycles_per_sec, &ratio);
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"clock_hz\": %.0f,\n", perf->clock_hz);
+	fprintf(file, "  \"frames\": %u,\n", (uint32_t)atomic32_load(&perf->frame_count));
+	fprintf(file, "  \"host_ns\": %llu,\n", (unsigned long long)perf->total.host_ns);
+	fprintf(file, "  \"cycles\": %llu,\n", (unsigned long long)perf->total.cycles);
+	fprintf(file, "  \"instructions\": %llu,\n", (unsigned long long)perf->total.instructions);
+	fprintf(file, "  \"mips\": %.3f,\n", mips);
+	fprintf(file, "  \"cycles_per_sec\": %.0f,\n", cycles_per_sec);
+	fprintf(file, "  \"realtime_ratio\": %.4f,\n", ratio);
+	fprintf(file, "  \"timer_ns\": %llu,\n", (unsigned long long)perf->timer_ns);
+
+	/* host time per subsystem and the histogram of the time per frame */
+	fprintf(file, "  \"subsystems\": {\n");
+	for (int i = 0; i < PERF_COUNTERS; ++i) {
+		fprintf(file, "    \"%s\": { \"ns\": %llu, \"frame_us_log2_hist\": [", counter_names[i], (unsigned long long)perf->total.ns[i]);
+		for (int j = 0; j < PERF_HIST_BUCKETS; ++j) {
+			fprintf(file, "%s%d", j ? ", " : "", atomic32_load(&perf->hist[i][j]));
+		}
+		fprintf(file, "] }%s\n", (i < PERF_COUNTERS - 1) ? "," : "");
+	}
+	fprintf(file, "  },\n");
+
+	/* ports with accesses */
+	fprintf(file, "  \"io\": [");
+	int first = 1;
+	for (uint32_t port = 0; port < PERF_IO_PORTS; ++port) {
+		if (perf->io_reads[port] != 0 || perf->io_writes[port] != 0) {
+			fprintf(file, "%s\n    { \"port\": \"0x%04X\", \"reads\": %u, \"writes\": %u }", first ? "" : ",", port, perf->io_reads[port], perf->io_writes[port]);
+			first = 0;
+		}
+	}
+	fprintf(file, "\n  ],\n");
+
+	/* mregions */
+	fprintf(file, "  \"mem\": [");
+	first = 1;
+	for (int i = 0; i < map->region_index && i < PERF_MREGION_MAX; ++i) {
+		MEMORY_REGION* region = memory_map_get_mregion(map, i);
+		if (region == NULL) {
+			continue;
+		}
+		fprintf(file, "%s\n    { \"region\": %d, \"start\": \"0x%05X\", \"size\": \"0x%05X\", \"reads\": %llu, \"writes\": %llu }", first ? "" : ",",
+			i, region->start, region->size, (unsigned long long)perf->mem_reads[i], (unsigned long long)perf->mem_writes[i]);
+		first = 0;
+	}
+	fprintf(file, "\n  ]\n");
+	fprintf(file, "}\n");
+
+	if (file != stdout) {
+		fclose(file);
+		log_info("[PERF] Wrote %s\n", path);
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/* perf.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Performance counters; host time per subsystem, emulated speed and device access counts
+ */
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+#include "utility/atomic.h"
+#include "io/memory_map.h"
+
+#define PERF_FRAME_HISTORY 128       /* frames kept; power of 2 */
+#define PERF_FRAME_NS      16666667  /* host time per frame; 60 HZ */
+#define PERF_SAMPLE_STEPS  64        /* 1 in N steps is timed */
+#define PERF_HIST_BUCKETS  24        /* log2 buckets of the time per frame in us */
+#define PERF_MREGION_MAX   8
+#define PERF_IO_PORTS      0x10000
+
+/* Subsystems host time is counted for */
+enum {
+	PERF_CPU = 0, /* cpu execute; less memory and io */
+	PERF_MEM,     /* memory map; cpu memory accesses */
+	PERF_IO,      /* io dispatch; cpu port accesses and the devices behind them */
+	PERF_PIT,
+	PERF_DMA,
+	PERF_CRTC,    /* mda/cga cards */
+	PERF_DISK,    /* fdc/xebec/vblk cards */
+	PERF_OTHER,   /* kbd, pic and the time slice loop */
+	PERF_RENDER,  /* display draw; render thread */
+	PERF_COUNTERS
+};
+
+/* A frame of counters */
+typedef struct PERF_FRAME {
+	uint64_t host_ns;       /* host time the frame took */
+	uint64_t cycles;        /* cpu cycles executed */
+	uint64_t instructions;  /* cpu instructions executed */
+	uint64_t ns[PERF_COUNTERS]; /* host time per subsystem */
+} PERF_FRAME;
+
+typedef struct PERF {
+	uint8_t enabled;
+	double clock_hz;        /* cpu clock; the real-time ratio is against this */
+	uint64_t timer_ns;      /* cost of a timing_get_ticks_ns() pair; taken off each timed section */
+
+	/* timed steps */
+	uint32_t step;          /* steps until the next timed step */
+	uint8_t timing;         /* the cpu is in a timed step; memory and io are timed */
+	uint32_t nested;        /* sections timed inside the cpu step */
+
+	/* current frame; written by the emulation thread */
+	PERF_FRAME frame;
+	uint64_t frame_start_ns;
+	uint64_t frame_steps;
+	uint64_t frame_timed_steps;
+	uint64_t last_cycles;   /* virtual clock at the last update */
+	ATOMIC32 render_ns;     /* added by the render thread */
+
+	/* history; single writer. frame_count is published after the frame is written */
+	PERF_FRAME frames[PERF_FRAME_HISTORY];
+	ATOMIC32 frame_count;
+	ATOMIC32 hist[PERF_COUNTERS][PERF_HIST_BUCKETS];
+
+	/* totals */
+	PERF_FRAME total;
+
+	/* access counts */
+	uint32_t* io_reads;     /* PERF_IO_PORTS */
+	uint32_t* io_writes;
+	uint64_t mem_reads[PERF_MREGION_MAX];
+	uint64_t mem_writes[PERF_MREGION_MAX];
+} PERF;
+
+/* Create the counters
+	perf: the perf instance
+	clock_hz: the cpu clock in Hz
+	Returns: 0 if success. Otherwise 1 */
+int perf_create(PERF* perf, double clock_hz);
+void perf_destroy(PERF* perf);
+
+/* Get the subsystem name
+	counter: PERF_XXX
+	Returns: the name */
+const char* perf_counter_name(int counter);
+
+/* Should this step be timed; 1 in PERF_SAMPLE_STEPS
+	perf: the perf instance
+	Returns: 1 if the step is timed. Otherwise 0 */
+int perf_sample_step(PERF* perf);
+
+/* Add host time to a subsystem in the current frame
+	perf: the perf instance
+	counter: PERF_XXX
+	start_ns: timing_get_ticks_ns() at the start of the section
+	Returns: the time now in ns */
+uint64_t perf_add_ns(PERF* perf, int counter, uint64_t start_ns);
+
+/* Add render time; called from the render thread
+	perf: the perf instance
+	ns: the host time the draw took */
+void perf_add_render_ns(PERF* perf, uint64_t ns);
+
+/* Count a port access
+	perf: the perf instance
+	port: the io port
+	write: 1 if a write */
+void perf_count_io(PERF* perf, uint16_t port, int write);
+
+/* Count a memory access
+	perf: the perf instance
+	map: the memory map
+	address: the address
+	write: 1 if a write */
+void perf_count_mem(PERF* perf, MEMORY_MAP* map, uint32_t address, int write);
+
+/* Add the cycles executed; end the frame when PERF_FRAME_NS of host time has elapsed. Called once per time slice
+	perf: the perf instance
+	cycles: the virtual clock */
+void perf_update(PERF* perf, uint64_t cycles);
+
+/* Get a frame from the history; lock free
+	perf: the perf instance
+	age: 0 = the last frame
+	frame: the frame
+	Returns: 0 if success. 1 if there is no such frame or it was overwritten while copying */
+int perf_get_frame(PERF* perf, uint32_t age, PERF_FRAME* frame);
+
+/* Get the emulated speed of a frame
+	perf: the perf instance
+	frame: the frame
+	mips: million instructions per host second
+	cycles_per_sec: cpu cycles per host second
+	ratio: cycles_per_sec / clock_hz; 1.0 = real time */
+void perf_get_speed(const PERF* perf, const PERF_FRAME* frame, double* mips, double* cycles_per_sec, double* ratio);
+
+/* Write the counters as JSON
+	perf: the perf instance
+	map: the memory map; the mregions the memory counts are for
+	path: the file to write. NULL = stdout
+	Returns: 0 if success. Otherwise 1 */
+int perf_write_json(PERF* perf, MEMORY_MAP* map, const char* path);
+
+#endif
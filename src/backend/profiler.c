@@ -0,0 +1,213 @@
+/* profiler.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Guest profiler; the CS:IP is sampled every N emulated cycles into a histogram over the 1MB address space
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "profiler.h"
+#include "i8086.h"
+#include "i8086_mnem.h"
+
+/* Nothing is done per instruction but count down the cycles; the work is per sample.
+ * A sample is attributed to an interrupt handler by the IVT at the time of the sample; the handler
+ * with the nearest entry point at or below the sampled address, within PROFILER_HANDLER_SPAN.
+ * Only the entry point is known, not where a handler ends; the attribution is an estimate and is reported
+ * as one (~int_XXh). Samples near no entry point are reported as unknown. */
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "utility/log.h"
+
+#define FOLDED_EXT ".folded"
+
+int profiler_create(PROFILER* profiler, uint32_t interval) {
+	memset(profiler, 0, sizeof(PROFILER));
+
+	profiler->counts = calloc(PROFILER_ADDRESS_SPACE, sizeof(uint32_t));
+	profiler->segments = calloc(PROFILER_ADDRESS_SPACE, sizeof(uint16_t));
+	profiler->vectors = malloc(PROFILER_ADDRESS_SPACE * sizeof(uint16_t));
+	if (profiler->counts == NULL || profiler->segments == NULL || profiler->vectors == NULL) {
+		log_error("[PROFILER] Failed to allocate the histogram\n");
+		profiler_destroy(profiler);
+		return 1;
+	}
+	memset(profiler->vectors, 0xFF, PROFILER_ADDRESS_SPACE * sizeof(uint16_t));
+
+	profiler->interval = (interval != 0) ? interval : PROFILER_INTERVAL_DEFAULT;
+	profiler->countdown = profiler->interval;
+	profiler->enabled = 1;
+	return 0;
+}
+void profiler_destroy(PROFILER* profiler) {
+	profiler->enabled = 0;
+	if (profiler->counts != NULL) {
+		free(profiler->counts);
+		profiler->counts = NULL;
+	}
+	if (profiler->segments != NULL) {
+		free(profiler->segments);
+		profiler->segments = NULL;
+	}
+	if (profiler->vectors != NULL) {
+		free(profiler->vectors);
+		profiler->vectors = NULL;
+	}
+}
+
+static uint16_t find_handler(uint32_t address, const uint8_t* ivt) {
+	uint16_t vector = PROFILER_NO_VECTOR;
+	uint32_t best = 0;
+	for (int i = 0; i < PROFILER_VECTORS; ++i) {
+		const uint8_t* entry = &ivt[i * 4];
+		uint16_t offset = entry[0] | (entry[1] << 8);
+		uint16_t segment = entry[2] | (entry[3] << 8);
+		if (offset == 0 && segment == 0) {
+			continue;
+		}
+		uint32_t handler = i8086_get_physical_address(segment, offset);
+		if (handler > address || address - handler >= PROFILER_HANDLER_SPAN) {
+			continue;
+		}
+		/* vectors that share an entry point go to the lowest */
+		if (vector == PROFILER_NO_VECTOR || handler > best) {
+			best = handler;
+			vector = (uint16_t)i;
+		}
+	}
+	return vector;
+}
+
+void profiler_sample(PROFILER* profiler, uint16_t cs, uint16_t ip, const uint8_t* ivt) {
+	profiler->countdown += profiler->interval;
+	if (profiler->countdown <= 0) {
+		/* a long stall (a trapped int 13h); one sample for it */
+		profiler->countdown = profiler->interval;
+	}
+
+	uint32_t address = i8086_get_physical_address(cs, ip) & (PROFILER_ADDRESS_SPACE - 1);
+	uint16_t vector = find_handler(address, ivt);
+
+	profiler->counts[address]++;
+	profiler->segments[address] = cs;
+	profiler->vectors[address] = vector;
+	profiler->samples++;
+	if (vector != PROFILER_NO_VECTOR) {
+		profiler->vector_samples[vector]++;
+	}
+	else {
+		profiler->unattributed++;
+	}
+}
+
+static double percent(uint64_t count, uint64_t total) {
+	return (total != 0) ? count * 100.0 / total : 0.0;
+}
+
+static const char* handler_name(uint16_t vector, char* str, size_t size) {
+	if (vector == PROFILER_NO_VECTOR) {
+		return "unknown";
+	}
+	snprintf(str, size, "~int_%02Xh", vector);
+	return str;
+}
+
+/* Get the hottest addresses, most samples first
+	Returns: the number of addresses */
+static int get_hot_addresses(PROFILER* profiler, uint32_t* top, int max) {
+	int n = 0;
+	for (uint32_t address = 0; address < PROFILER_ADDRESS_SPACE; ++address) {
+		uint32_t count = profiler->counts[address];
+		if (count == 0 || (n == max && count <= profiler->counts[top[n - 1]])) {
+			continue;
+		}
+		int i = (n < max) ? n++ : n - 1;
+		while (i > 0 && profiler->counts[top[i - 1]] < count) {
+			top[i] = top[i - 1];
+			i--;
+		}
+		top[i] = address;
+	}
+	return n;
+}
+
+static void write_flat(PROFILER* profiler, I8086_MNEM* mnem, FILE* file) {
+	fprintf(file, "samples: %llu\n", (unsigned long long)profiler->samples);
+	fprintf(file, "interval: %u cycles\n\n", profiler->interval);
+
+	fprintf(file, "~int_XXh: estimated; the vector with the nearest entry point at or below the address, within %uK\n\n", PROFILER_HANDLER_SPAN / 1024);
+	fprintf(file, "handler      samples       %%\n");
+	for (int i = 0; i < PROFILER_VECTORS; ++i) {
+		if (profiler->vector_samples[i] != 0) {
+			fprintf(file, "~int_%02Xh %11llu  %6.2f\n", i, (unsigned long long)profiler->vector_samples[i], percent(profiler->vector_samples[i], profiler->samples));
+		}
+	}
+	fprintf(file, "unknown  %11llu  %6.2f\n\n", (unsigned long long)profiler->unattributed, percent(profiler->unattributed, profiler->samples));
+
+	char name[16];
+	uint32_t top[PROFILER_REPORT_TOP];
+	int n = get_hot_addresses(profiler, top, PROFILER_REPORT_TOP);
+
+	fprintf(file, "addr   cs:ip          samples       %%  handler   instruction\n");
+	for (int i = 0; i < n; ++i) {
+		uint32_t address = top[i];
+		uint16_t segment = profiler->segments[address];
+		uint16_t offset = (uint16_t)(address - ((uint32_t)segment << 4));
+		i8086_mnem_at(mnem, segment, offset);
+		fprintf(file, "%05X  %04X:%04X  %11u  %6.2f  %-8s  %s\n", address, segment, offset, profiler->counts[address], percent(profiler->counts[address], profiler->samples),
+			handler_name(profiler->vectors[address], name, sizeof(name)), mnem->str);
+	}
+}
+
+static void write_folded(PROFILER* profiler, I8086_MNEM* mnem, FILE* file) {
+	/* handler;segment;cs:ip instruction count */
+	char name[16];
+	for (uint32_t address = 0; address < PROFILER_ADDRESS_SPACE; ++address) {
+		if (profiler->counts[address] == 0) {
+			continue;
+		}
+		uint16_t segment = profiler->segments[address];
+		uint16_t offset = (uint16_t)(address - ((uint32_t)segment << 4));
+		i8086_mnem_at(mnem, segment, offset);
+		for (char* c = mnem->str; *c != '\0'; ++c) {
+			if (*c == ';') {
+				*c = ',';
+			}
+		}
+		fprintf(file, "%s;seg_%04X;%04X:%04X %s %u\n", handler_name(profiler->vectors[address], name, sizeof(name)), segment, segment, offset, mnem->str, profiler->counts[address]);
+	}
+}
+
+int profiler_write_report(PROFILER* profiler, I8086_MNEM* mnem, const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		log_error("[PROFILER] Failed to open %s\n", path);
+		return 1;
+	}
+	write_flat(profiler, mnem, file);
+	fclose(file);
+	log_info("[PROFILER] Wrote %s\n", path);
+
+	size_t len = strlen(path) + sizeof(FOLDED_EXT);
+	char* folded_path = malloc(len);
+	if (folded_path == NULL) {
+		log_error("[PROFILER] Failed to allocate the path\n");
+		return 1;
+	}
+	snprintf(folded_path, len, "%s" FOLDED_EXT, path);
+
+	file = fopen(folded_path, "w");
+	if (file == NULL) {
+		log_error("[PROFILER] Failed to open %s\n", folded_path);
+		free(folded_path);
+		return 1;
+	}
+	write_folded(profiler, mnem, file);
+	fclose(file);
+	log_info("[PROFILER] Wrote %s\n", folded_path);
+	free(folded_path);
+	return 0;
+}
@@ -0,0 +1,55 @@
+/* profiler.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Guest profiler; the CS:IP is sampled every N emulated cycles into a histogram over the 1MB address space
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#include "i8086_mnem.h"
+
+#define PROFILER_ADDRESS_SPACE     0x100000
+#define PROFILER_INTERVAL_DEFAULT  1000   /* cycles between samples */
+#define PROFILER_VECTORS           256
+#define PROFILER_HANDLER_SPAN      0x2000 /* max distance from a handler entry a sample is attributed to it */
+#define PROFILER_NO_VECTOR         0xFFFF
+#define PROFILER_REPORT_TOP        64     /* hot addresses in the report */
+
+typedef struct PROFILER {
+	uint8_t enabled;
+	uint32_t interval;        /* cycles between samples */
+	int64_t countdown;        /* cycles until the next sample */
+	uint64_t samples;         /* samples taken */
+
+	uint32_t* counts;         /* samples per physical address; PROFILER_ADDRESS_SPACE */
+	uint16_t* segments;       /* CS of the last sample at the address */
+	uint16_t* vectors;        /* handler of the last sample at the address; PROFILER_NO_VECTOR = none */
+
+	uint64_t vector_samples[PROFILER_VECTORS]; /* samples attributed to each interrupt handler */
+	uint64_t unattributed;    /* samples not in a handler */
+} PROFILER;
+
+/* Create the profiler
+	profiler: the profiler instance
+	interval: cycles between samples; 0 = PROFILER_INTERVAL_DEFAULT
+	Returns: 0 if success. Otherwise 1 */
+int profiler_create(PROFILER* profiler, uint32_t interval);
+void profiler_destroy(PROFILER* profiler);
+
+/* Take a sample; called when countdown reaches 0
+	profiler: the profiler instance
+	cs: the code segment
+	ip: the instruction pointer
+	ivt: guest memory at 0000:0000; the interrupt vector table */
+void profiler_sample(PROFILER* profiler, uint16_t cs, uint16_t ip, const uint8_t* ivt);
+
+/* Write the report; a flat text report to path and collapsed stacks to path.folded
+	profiler: the profiler instance
+	mnem: the disassembler; annotates the hot addresses
+	path: the file to write
+	Returns: 0 if success. Otherwise 1 */
+int profiler_write_report(PROFILER* profiler, I8086_MNEM* mnem, const char* path);
+
+#endif
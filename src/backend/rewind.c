@@ -0,0 +1,233 @@
+/* rewind.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Rewind ring; periodic snapshots of the device state and the memory pages written since the last snapshot
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "rewind.h"
+#include "io/memory_map.h"
+
+/* The oldest snapshot is the memory in base. Each newer snapshot holds the pages written
+ * since the one before it; a snapshot is rebuilt from base plus the pages of every snapshot
+ * up to it. Dropping the oldest snapshot folds the next snapshot's pages into base. */
+
+#define KEYS_GROW 64
+
+#define LOG_CATEGORY LOG_CAT_MAIN
+#include "utility/log.h"
+
+#define SNAPSHOT(i) (&rewind->snapshots[(rewind->head + (i)) % REWIND_MAX_SNAPSHOTS])
+
+static void free_pages(REWIND* rewind, REWIND_SNAPSHOT* snapshot) {
+	rewind->used -= (size_t)snapshot->page_count * (MEMORY_MAP_PAGE_SIZE + sizeof(uint16_t));
+	if (snapshot->pages != NULL) {
+		free(snapshot->pages);
+		snapshot->pages = NULL;
+	}
+	if (snapshot->page_data != NULL) {
+		free(snapshot->page_data);
+		snapshot->page_data = NULL;
+	}
+	snapshot->page_count = 0;
+}
+static void free_snapshot(REWIND* rewind, REWIND_SNAPSHOT* snapshot) {
+	free_pages(rewind, snapshot);
+	if (snapshot->state != NULL) {
+		free(snapshot->state);
+		snapshot->state = NULL;
+		rewind->used -= rewind->state_size;
+	}
+}
+
+static void apply_pages(uint8_t* mem, const REWIND_SNAPSHOT* snapshot) {
+	for (uint32_t i = 0; i < snapshot->page_count; ++i) {
+		memcpy(mem + ((size_t)snapshot->pages[i] << MEMORY_MAP_PAGE_SHIFT), snapshot->page_data + ((size_t)i << MEMORY_MAP_PAGE_SHIFT), MEMORY_MAP_PAGE_SIZE);
+	}
+}
+
+static void drop_oldest(REWIND* rewind) {
+	/* fold the next snapshot into base; its pages are then in base */
+	free_snapshot(rewind, SNAPSHOT(0));
+	rewind->head = (rewind->head + 1) % REWIND_MAX_SNAPSHOTS;
+	rewind->count--;
+	if (rewind->count > 0) {
+		apply_pages(rewind->base, SNAPSHOT(0));
+		free_pages(rewind, SNAPSHOT(0));
+
+		/* keys before the oldest snapshot can not be replayed */
+		uint32_t i = 0;
+		while (i < rewind->key_count && rewind->keys[i].cycle < SNAPSHOT(0)->cycle) {
+			i++;
+		}
+		memmove(rewind->keys, rewind->keys + i, (rewind->key_count - i) * sizeof(REWIND_KEY));
+		rewind->key_count -= i;
+	}
+	else {
+		rewind->key_count = 0;
+	}
+}
+
+int rewind_create(REWIND* rewind, uint32_t mem_size, size_t state_size, size_t budget) {
+	memset(rewind, 0, sizeof(REWIND));
+	rewind->base = malloc(mem_size);
+	if (rewind->base == NULL) {
+		log_error("[REWIND] Failed to allocate %u bytes\n", mem_size);
+		return 1;
+	}
+	rewind->mem_size = mem_size;
+	rewind->state_size = state_size;
+	rewind->budget = budget;
+	rewind->used = mem_size;
+	return 0;
+}
+void rewind_destroy(REWIND* rewind) {
+	rewind_clear(rewind);
+	if (rewind->base != NULL) {
+		free(rewind->base);
+		rewind->base = NULL;
+	}
+	if (rewind->keys != NULL) {
+		free(rewind->keys);
+		rewind->keys = NULL;
+	}
+	rewind->key_capacity = 0;
+	rewind->used = 0;
+}
+
+void rewind_clear(REWIND* rewind) {
+	for (uint32_t i = 0; i < rewind->count; ++i) {
+		free_snapshot(rewind, SNAPSHOT(i));
+	}
+	rewind->count = 0;
+	rewind->head = 0;
+	rewind->key_count = 0;
+	rewind->key_index = 0;
+}
+
+int rewind_snapshot(REWIND* rewind, uint64_t cycle, MEMORY_MAP* map, const void* state) {
+	if (rewind->base == NULL) {
+		return 1;
+	}
+
+	if (rewind->count == REWIND_MAX_SNAPSHOTS) {
+		drop_oldest(rewind);
+	}
+
+	REWIND_SNAPSHOT* snapshot = SNAPSHOT(rewind->count);
+	memset(snapshot, 0, sizeof(REWIND_SNAPSHOT));
+	snapshot->cycle = cycle;
+
+	snapshot->state = malloc(rewind->state_size);
+	if (snapshot->state == NULL) {
+		return 1;
+	}
+	memcpy(snapshot->state, state, rewind->state_size);
+	rewind->used += rewind->state_size;
+
+	if (rewind->count == 0) {
+		/* the oldest snapshot is the whole memory */
+		memcpy(rewind->base, map->mem, rewind->mem_size);
+	}
+	else {
+		uint32_t page_count = 0;
+		for (uint32_t i = 0; i < map->page_count; ++i) {
+			page_count += (map->dirty[i] & MEMORY_MAP_DIRTY_SNAPSHOT) != 0;
+		}
+		if (page_count > 0) {
+			snapshot->pages = malloc(page_count * sizeof(uint16_t));
+			snapshot->page_data = malloc((size_t)page_count << MEMORY_MAP_PAGE_SHIFT);
+			if (snapshot->pages == NULL || snapshot->page_data == NULL) {
+				free_snapshot(rewind, snapshot);
+				return 1;
+			}
+			for (uint32_t i = 0; i < map->page_count; ++i) {
+				if (map->dirty[i] & MEMORY_MAP_DIRTY_SNAPSHOT) {
+					snapshot->pages[snapshot->page_count] = (uint16_t)i;
+					memcpy(snapshot->page_data + ((size_t)snapshot->page_count << MEMORY_MAP_PAGE_SHIFT), map->mem + ((size_t)i << MEMORY_MAP_PAGE_SHIFT), MEMORY_MAP_PAGE_SIZE);
+					snapshot->page_count++;
+				}
+			}
+			rewind->used += (size_t)page_count * (MEMORY_MAP_PAGE_SIZE + sizeof(uint16_t));
+		}
+	}
+	memory_map_clear_dirty(map, MEMORY_MAP_DIRTY_SNAPSHOT);
+	rewind->count++;
+
+	while (rewind->used > rewind->budget && rewind->count > 1) {
+		drop_oldest(rewind);
+	}
+	return 0;
+}
+
+int rewind_find(REWIND* rewind, uint64_t cycle) {
+	for (int i = (int)rewind->count - 1; i >= 0; --i) {
+		if (SNAPSHOT(i)->cycle <= cycle) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+REWIND_SNAPSHOT* rewind_get(REWIND* rewind, int index) {
+	return SNAPSHOT(index);
+}
+
+uint64_t rewind_restore(REWIND* rewind, int index, MEMORY_MAP* map, void* state) {
+	/* drop the snapshots after index */
+	while (rewind->count > (uint32_t)index + 1) {
+		rewind->count--;
+		free_snapshot(rewind, SNAPSHOT(rewind->count));
+	}
+
+	memcpy(map->mem, rewind->base, rewind->mem_size);
+	for (int i = 1; i <= index; ++i) {
+		apply_pages(map->mem, SNAPSHOT(i));
+	}
+	memory_map_mark_dirty(map);
+	memory_map_clear_dirty(map, MEMORY_MAP_DIRTY_SNAPSHOT);
+
+	REWIND_SNAPSHOT* snapshot = SNAPSHOT(index);
+	memcpy(state, snapshot->state, rewind->state_size);
+
+	/* replay the keys from the snapshot on */
+	rewind->key_index = 0;
+	while (rewind->key_index < rewind->key_count && rewind->keys[rewind->key_index].cycle < snapshot->cycle) {
+		rewind->key_index++;
+	}
+	return snapshot->cycle;
+}
+
+void rewind_add_key(REWIND* rewind, uint64_t cycle, uint8_t scancode) {
+	if (rewind->count == 0) {
+		return; /* nothing to replay it from */
+	}
+	if (rewind->key_count == rewind->key_capacity) {
+		REWIND_KEY* keys = realloc(rewind->keys, (rewind->key_capacity + KEYS_GROW) * sizeof(REWIND_KEY));
+		if (keys == NULL) {
+			return;
+		}
+		rewind->keys = keys;
+		rewind->key_capacity += KEYS_GROW;
+	}
+	rewind->keys[rewind->key_count].cycle = cycle;
+	rewind->keys[rewind->key_count].scancode = scancode;
+	rewind->key_count++;
+}
+
+const REWIND_KEY* rewind_next_key(REWIND* rewind, uint64_t cycle) {
+	if (rewind->key_index < rewind->key_count && rewind->keys[rewind->key_index].cycle <= cycle) {
+		return &rewind->keys[rewind->key_index++];
+	}
+	return NULL;
+}
+
+void rewind_truncate_keys(REWIND* rewind, uint64_t cycle) {
+	while (rewind->key_count > 0 && rewind->keys[rewind->key_count - 1].cycle >= cycle) {
+		rewind->key_count--;
+	}
+	rewind->key_index = rewind->key_count;
+}
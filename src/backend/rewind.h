@@ -0,0 +1,104 @@
+/* rewind.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Rewind ring; periodic snapshots of the device state and the memory pages written since the last snapshot
+ */
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "io/memory_map.h"
+
+#define REWIND_MAX_SNAPSHOTS 256
+
+typedef struct REWIND_SNAPSHOT {
+	uint64_t cycle;       /* virtual clock at the snapshot */
+	void* state;          /* device state; state_size bytes */
+	uint32_t page_count;  /* pages written since the previous snapshot */
+	uint16_t* pages;      /* page numbers */
+	uint8_t* page_data;   /* page contents at the snapshot */
+} REWIND_SNAPSHOT;
+
+/* Key delivered to the guest; keys are replayed when re-executing from a snapshot */
+typedef struct REWIND_KEY {
+	uint64_t cycle;
+	uint8_t scancode;
+} REWIND_KEY;
+
+typedef struct REWIND {
+	size_t budget;        /* memory budget in bytes */
+	size_t used;          /* memory used in bytes */
+	size_t state_size;    /* device state size */
+	uint32_t mem_size;
+	uint8_t* base;        /* memory at the oldest snapshot */
+	REWIND_SNAPSHOT snapshots[REWIND_MAX_SNAPSHOTS]; /* ring; oldest first */
+	uint32_t head;        /* oldest snapshot */
+	uint32_t count;
+
+	REWIND_KEY* keys;     /* keys delivered since the oldest snapshot */
+	uint32_t key_count;
+	uint32_t key_capacity;
+	uint32_t key_index;   /* next key to replay */
+} REWIND;
+
+/* Create the rewind ring
+	rewind: the rewind instance
+	mem_size: the size of the memory buffer
+	state_size: the size of the device state
+	budget: the memory budget in bytes; includes a copy of the memory buffer
+	Returns: 0 if success. Otherwise 1 */
+int rewind_create(REWIND* rewind, uint32_t mem_size, size_t state_size, size_t budget);
+void rewind_destroy(REWIND* rewind);
+
+/* Drop all snapshots and keys
+	rewind: the rewind instance */
+void rewind_clear(REWIND* rewind);
+
+/* Take a snapshot; the oldest snapshots are dropped to stay in the budget
+	rewind: the rewind instance
+	cycle: the virtual clock
+	map: the memory map; the page written flags are cleared
+	state: the device state
+	Returns: 0 if success. Otherwise 1 */
+int rewind_snapshot(REWIND* rewind, uint64_t cycle, MEMORY_MAP* map, const void* state);
+
+/* Find the newest snapshot at or before a cycle
+	rewind: the rewind instance
+	cycle: the target cycle
+	Returns: the snapshot index; 0 is the oldest. -1 if there is none */
+int rewind_find(REWIND* rewind, uint64_t cycle);
+
+/* Get a snapshot
+	rewind: the rewind instance
+	index: the snapshot index; 0 is the oldest
+	Returns: the snapshot */
+REWIND_SNAPSHOT* rewind_get(REWIND* rewind, int index);
+
+/* Restore a snapshot; the newer snapshots are dropped
+	rewind: the rewind instance
+	index: the snapshot index; 0 is the oldest
+	map: the memory map; memory is restored, the page written flags are cleared
+	state: the device state to restore to
+	Returns: the cycle of the snapshot */
+uint64_t rewind_restore(REWIND* rewind, int index, MEMORY_MAP* map, void* state);
+
+/* Log a key delivered to the guest
+	rewind: the rewind instance
+	cycle: the virtual clock
+	scancode: the pc scancode */
+void rewind_add_key(REWIND* rewind, uint64_t cycle, uint8_t scancode);
+
+/* Get the next key to replay if it is due
+	rewind: the rewind instance
+	cycle: the virtual clock
+	Returns: the key or NULL if none is due */
+const REWIND_KEY* rewind_next_key(REWIND* rewind, uint64_t cycle);
+
+/* Drop the keys at or after a cycle; re-execution stopped there and the guest takes a new path
+	rewind: the rewind instance
+	cycle: the virtual clock */
+void rewind_truncate_keys(REWIND* rewind, uint64_t cycle);
+
+#endif
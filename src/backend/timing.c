@@ -13,6 +13,11 @@ static TIMING_INIT_FRAME_STATE_CB init_frame_cb = NULL;
 static TIMING_FRAME_STATE_CB reset_frame_cb = NULL;
 static TIMING_FRAME_STATE_CB new_frame_cb   = NULL;
 static TIMING_FRAME_STATE_CB check_frame_cb = NULL;
+static TIMING_FRAME_REMAINING_CB frame_remaining_cb = NULL;
+static TIMING_SLEEP_CB sleep_cb = NULL;
+
+static uint64_t virtual_cycles = 0;
+static double virtual_clock_hz = 1.0;
 
 void timing_set_cb_get_ticks_ms(TIMING_GET_TICKS_CB cb) {
     ticks_ms_cb = cb;
@@ -38,6 +43,14 @@ void timing_set_cb_check_frame(TIMING_FRAME_STATE_CB cb) {
     check_frame_cb = cb;
 }
 
+void timing_set_cb_frame_remaining_ns(TIMING_FRAME_REMAINING_CB cb) {
+    frame_remaining_cb = cb;
+}
+
+void timing_set_cb_sleep_ns(TIMING_SLEEP_CB cb) {
+    sleep_cb = cb;
+}
+
 uint64_t timing_get_ticks_ms(void) {
     return ticks_ms_cb();
 }
@@ -46,6 +59,12 @@ uint64_t timing_get_ticks_ns(void) {
     return ticks_ns_cb();
 }
 
+void timing_sleep_ns(uint64_t ns) {
+    if (sleep_cb != NULL) {
+        sleep_cb(ns);
+    }
+}
+
 int timing_init_frame(FRAME_STATE* time, double target_ms) {
     return init_frame_cb(time, target_ms);
 }
@@ -58,3 +77,29 @@ int timing_new_frame(FRAME_STATE* time) {
 int timing_check_frame(FRAME_STATE* time) {
     return check_frame_cb(time);
 }
+uint64_t timing_frame_remaining_ns(FRAME_STATE* time) {
+    return frame_remaining_cb(time);
+}
+
+void timing_virtual_init(double clock_hz) {
+    virtual_clock_hz = clock_hz;
+    virtual_cycles = 0;
+}
+void timing_virtual_reset(void) {
+    virtual_cycles = 0;
+}
+void timing_virtual_advance(uint64_t cycles) {
+    virtual_cycles += cycles;
+}
+void timing_virtual_set_cycles(uint64_t cycles) {
+    virtual_cycles = cycles;
+}
+uint64_t timing_virtual_get_cycles(void) {
+    return virtual_cycles;
+}
+uint64_t timing_virtual_get_ticks_ms(void) {
+    return (uint64_t)(virtual_cycles * 1000.0 / virtual_clock_hz);
+}
+uint64_t timing_virtual_get_ticks_us(void) {
+    return (uint64_t)(virtual_cycles * 1000000.0 / virtual_clock_hz);
+}
@@ -11,6 +11,13 @@
 #define HZ_TO_MS(x) (1000.0 / (x))
 #define MS_TO_HZ(x) (1000.0 / (x))
 
+/* Catch up policy; what happens to the time a late frame ran over by */
+#define TIMING_CATCH_UP_NONE   0 /* drop it; runs slow while the host is late */
+#define TIMING_CATCH_UP_FULL   1 /* keep it all; runs fast until caught up */
+#define TIMING_CATCH_UP_CAPPED 2 /* keep up to TIMING_CATCH_UP_CAP frames of it */
+
+#define TIMING_CATCH_UP_CAP 5
+
 /* Frame State */
 typedef struct FRAME_STATE {
 	uint64_t start_frame_time; /* start time of current frame in ms. */
@@ -18,6 +25,8 @@ typedef struct FRAME_STATE {
 	double ms;                 /* current frame time in ms. */
 	double last_ms;            /* last frame time in ms. */
 	double target_ms;          /* target frame time in ms. */
+	uint8_t catch_up;          /* TIMING_CATCH_UP_XXX */
+	double rate;               /* host time scale; > 1 runs frames sooner. 1.0 = real time */
 } FRAME_STATE;
 
 /* get ticks callback */
@@ -29,6 +38,12 @@ typedef int(*TIMING_FRAME_STATE_CB)(FRAME_STATE* state);
 /* init frame state callback */
 typedef int(*TIMING_INIT_FRAME_STATE_CB)(FRAME_STATE* state, double target_ms);
 
+/* frame remaining callback */
+typedef uint64_t(*TIMING_FRAME_REMAINING_CB)(FRAME_STATE* state);
+
+/* sleep callback */
+typedef void(*TIMING_SLEEP_CB)(uint64_t ns);
+
 /* Set get_ticks_ms() callback */
 void timing_set_cb_get_ticks_ms(TIMING_GET_TICKS_CB get_ticks_ms);
 
@@ -47,12 +62,22 @@ void timing_set_cb_new_frame(TIMING_FRAME_STATE_CB cb);
 /* set check_frame() callback */
 void timing_set_cb_check_frame(TIMING_FRAME_STATE_CB cb);
 
+/* set frame_remaining_ns() callback */
+void timing_set_cb_frame_remaining_ns(TIMING_FRAME_REMAINING_CB cb);
+
+/* set sleep_ns() callback */
+void timing_set_cb_sleep_ns(TIMING_SLEEP_CB cb);
+
 /* Get ticks since startup in milliseconds */
 uint64_t timing_get_ticks_ms(void);
 
 /* Get ticks since startup in nanoseconds */
 uint64_t timing_get_ticks_ns(void);
 
+/* Sleep the calling thread; returns at once if no sleep callback is set
+	ns: the time to sleep in nanoseconds */
+void timing_sleep_ns(uint64_t ns);
+
 /* Init frame state; set target_ms */
 int timing_init_frame(FRAME_STATE* time, double target_ms);
 
@@ -66,4 +91,35 @@ int timing_new_frame(FRAME_STATE* time);
 	Returns: 1 if target_ms has elasped. otherwise 0. */
 int timing_check_frame(FRAME_STATE* time);
 
+/* Frame remaining; the time until target_ms elapses
+	Returns: the time in nanoseconds. 0 if target_ms has elapsed. */
+uint64_t timing_frame_remaining_ns(FRAME_STATE* time);
+
+/* Virtual clock; emulated time derived from the cpu cycles executed.
+ * Devices use this instead of the host clock so emulation does not depend on host speed. */
+
+/* Init the virtual clock
+	clock_hz: the cpu clock in Hz */
+void timing_virtual_init(double clock_hz);
+
+/* Reset the virtual clock to 0 */
+void timing_virtual_reset(void);
+
+/* Advance the virtual clock
+	cycles: the cpu cycles executed */
+void timing_virtual_advance(uint64_t cycles);
+
+/* Set the virtual clock; restoring a snapshot
+	cycles: the cpu cycles since reset */
+void timing_virtual_set_cycles(uint64_t cycles);
+
+/* Get the cpu cycles since reset */
+uint64_t timing_virtual_get_cycles(void);
+
+/* Get the emulated time since reset in milliseconds */
+uint64_t timing_virtual_get_ticks_ms(void);
+
+/* Get the emulated time since reset in microseconds */
+uint64_t timing_virtual_get_ticks_us(void);
+
 #endif
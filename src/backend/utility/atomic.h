@@ -0,0 +1,43 @@
+/* atomic.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * 32bit atomics; sequentially consistent
+ */
+
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include <stdint.h>
+
+typedef volatile int32_t ATOMIC32;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+static __inline int32_t atomic32_load(ATOMIC32* p) {
+	return _InterlockedCompareExchange((volatile long*)p, 0, 0);
+}
+static __inline void atomic32_store(ATOMIC32* p, int32_t value) {
+	_InterlockedExchange((volatile long*)p, value);
+}
+static __inline int32_t atomic32_exchange(ATOMIC32* p, int32_t value) {
+	return _InterlockedExchange((volatile long*)p, value);
+}
+static __inline int32_t atomic32_fetch_add(ATOMIC32* p, int32_t value) {
+	return _InterlockedExchangeAdd((volatile long*)p, value);
+}
+#else
+static inline int32_t atomic32_load(ATOMIC32* p) {
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static inline void atomic32_store(ATOMIC32* p, int32_t value) {
+	__atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+static inline int32_t atomic32_exchange(ATOMIC32* p, int32_t value) {
+	return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+}
+static inline int32_t atomic32_fetch_add(ATOMIC32* p, int32_t value) {
+	return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+#endif
+
+#endif
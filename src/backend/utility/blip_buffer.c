@@ -0,0 +1,123 @@
+/* blip_buffer.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Band-limited synthesis; steps in a clocked signal are resampled to the output rate without aliasing
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <math.h>
+
+#include "blip_buffer.h"
+
+/* Each step is added to the buffer as a windowed sinc impulse at its sub sample position.
+ * Reading sums the impulses; the sum is the band-limited signal, BLIP_WIDTH/2 samples late. */
+
+#define BLIP_CUTOFF 0.90f     /* fraction of nyquist */
+#define BLIP_LEAK   (1.0f / 4096.0f) /* integrator leak per sample; removes the DC level */
+
+#define PI 3.14159265358979323846
+
+#define LOG_CATEGORY LOG_CAT_AUDIO
+#include "log.h"
+
+static void build_kernel(BLIP_BUFFER* blip) {
+	for (int phase = 0; phase <= BLIP_PHASES; ++phase) {
+		double sum = 0.0;
+		for (int i = 0; i < BLIP_WIDTH; ++i) {
+			/* distance from the step to the sample */
+			double x = (i - (BLIP_WIDTH / 2 - 1)) - (double)phase / BLIP_PHASES;
+			double sinc = (x == 0.0) ? 1.0 : sin(PI * x * BLIP_CUTOFF) / (PI * x * BLIP_CUTOFF);
+			double n = (x + BLIP_WIDTH / 2.0) / BLIP_WIDTH; /* 0 - 1 across the window */
+			double window = 0.42 - 0.5 * cos(2.0 * PI * n) + 0.08 * cos(4.0 * PI * n); /* blackman */
+			blip->kernel[phase][i] = (float)(sinc * window);
+			sum += sinc * window;
+		}
+		/* each impulse sums to 1; a step adds exactly its delta to the level */
+		for (int i = 0; i < BLIP_WIDTH; ++i) {
+			blip->kernel[phase][i] = (float)(blip->kernel[phase][i] / sum);
+		}
+	}
+}
+
+int blip_buffer_create(BLIP_BUFFER* blip, double clock_rate, double sample_rate, uint32_t size) {
+	memset(blip, 0, sizeof(BLIP_BUFFER));
+	blip->buffer = calloc((size_t)size + BLIP_WIDTH, sizeof(float));
+	if (blip->buffer == NULL) {
+		log_error("[BLIP] Failed to allocate %u samples\n", size);
+		return 1;
+	}
+	blip->size = size;
+	blip->samples_per_clock = sample_rate / clock_rate;
+	build_kernel(blip);
+	return 0;
+}
+void blip_buffer_destroy(BLIP_BUFFER* blip) {
+	if (blip->buffer != NULL) {
+		free(blip->buffer);
+		blip->buffer = NULL;
+	}
+	blip->size = 0;
+	blip->avail = 0;
+}
+
+void blip_buffer_clear(BLIP_BUFFER* blip) {
+	if (blip->buffer != NULL) {
+		memset(blip->buffer, 0, ((size_t)blip->size + BLIP_WIDTH) * sizeof(float));
+	}
+	blip->offset = 0.0;
+	blip->avail = 0;
+	blip->integrator = 0.0f;
+}
+
+void blip_buffer_add_delta(BLIP_BUFFER* blip, uint64_t clock, float delta) {
+	double pos = blip->offset + clock * blip->samples_per_clock;
+	uint32_t index = (uint32_t)pos;
+	if (index >= blip->size) {
+		return; /* past the end of the buffer */
+	}
+	int phase = (int)((pos - index) * BLIP_PHASES + 0.5);
+	const float* kernel = blip->kernel[phase];
+	float* out = blip->buffer + index;
+	for (int i = 0; i < BLIP_WIDTH; ++i) {
+		out[i] += delta * kernel[i];
+	}
+}
+
+void blip_buffer_end_frame(BLIP_BUFFER* blip, uint64_t clocks) {
+	blip->offset += clocks * blip->samples_per_clock;
+	if (blip->offset > blip->size) {
+		blip->offset = blip->size;
+	}
+	blip->avail = (uint32_t)blip->offset;
+}
+
+uint32_t blip_buffer_read_samples(BLIP_BUFFER* blip, int16_t* out, uint32_t count) {
+	if (count > blip->avail) {
+		count = blip->avail;
+	}
+
+	float sum = blip->integrator;
+	for (uint32_t i = 0; i < count; ++i) {
+		sum += blip->buffer[i];
+		sum -= sum * BLIP_LEAK;
+		float s = sum;
+		if (s > 32767.0f) {
+			s = 32767.0f;
+		}
+		else if (s < -32768.0f) {
+			s = -32768.0f;
+		}
+		out[i] = (int16_t)s;
+	}
+	blip->integrator = sum;
+
+	/* shift out the samples read; the impulses past them stay */
+	uint32_t remain = blip->size + BLIP_WIDTH - count;
+	memmove(blip->buffer, blip->buffer + count, (size_t)remain * sizeof(float));
+	memset(blip->buffer + remain, 0, (size_t)count * sizeof(float));
+	blip->avail -= count;
+	blip->offset -= count;
+	return count;
+}
@@ -0,0 +1,55 @@
+/* blip_buffer.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Band-limited synthesis; steps in a clocked signal are resampled to the output rate without aliasing
+ */
+
+#ifndef BLIP_BUFFER_H
+#define BLIP_BUFFER_H
+
+#include <stdint.h>
+
+#define BLIP_PHASES 32 /* sub sample positions */
+#define BLIP_WIDTH  16 /* kernel width in samples */
+
+typedef struct BLIP_BUFFER {
+	double samples_per_clock;
+	double offset;        /* position of clock 0 of the current frame in samples */
+	float* buffer;        /* impulses; summed into samples when read */
+	uint32_t size;        /* max samples per frame */
+	uint32_t avail;       /* samples ready to read */
+	float integrator;     /* running sum of the impulses; the signal level */
+	float kernel[BLIP_PHASES + 1][BLIP_WIDTH];
+} BLIP_BUFFER;
+
+/* Create a blip buffer
+	blip: the blip buffer instance
+	clock_rate: the input clock in Hz
+	sample_rate: the output sample rate in Hz
+	size: max samples per frame
+	Returns: 0 if success. Otherwise 1 */
+int blip_buffer_create(BLIP_BUFFER* blip, double clock_rate, double sample_rate, uint32_t size);
+void blip_buffer_destroy(BLIP_BUFFER* blip);
+
+/* Drop all samples and impulses; the level goes back to 0
+	blip: the blip buffer instance */
+void blip_buffer_clear(BLIP_BUFFER* blip);
+
+/* Add a step to the signal
+	blip: the blip buffer instance
+	clock: the clock the step happens at; relative to the start of the frame
+	delta: the change in level */
+void blip_buffer_add_delta(BLIP_BUFFER* blip, uint64_t clock, float delta);
+
+/* End the frame; the samples before clocks are ready to read
+	blip: the blip buffer instance
+	clocks: the length of the frame in clocks */
+void blip_buffer_end_frame(BLIP_BUFFER* blip, uint64_t clocks);
+
+/* Read samples
+	blip: the blip buffer instance
+	out: the samples; signed 16 bit mono
+	count: max samples to read
+	Returns: the number of samples read */
+uint32_t blip_buffer_read_samples(BLIP_BUFFER* blip, int16_t* out, uint32_t count);
+
+#endif
@@ -0,0 +1,539 @@
+/* fat_dir.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Host directory as a FAT volume. Boot, FAT and directory sectors are synthesized
+ * on demand; file data sectors are read from the host files when asked for.
+ */
+
+#include <stdint.h>
+#include <malloc.h>
+#include <string.h>
+#include <time.h>
+#include <stdio.h>
+
+#include "fat_dir.h"
+#include "lba.h"
+#include "overlay.h"
+#include "frontend/utility/file.h"
+
+#define LOG_CATEGORY LOG_CAT_DISK
+#include "log.h"
+
+#define FAT_DIR_PATH_SIZE 256
+
+#define RESERVED_SECTORS  1
+#define FAT_COUNT         2
+#define DIR_ENTRY_SIZE    32
+#define FAT12_MAX_CLUSTERS 4084
+#define FAT16_MAX_CLUSTERS 65524
+
+#define ATTR_ARCHIVE      0x20
+#define ATTR_VOLUME_LABEL 0x08
+
+#define HDD_MEDIA         0xF8
+#define HDD_ROOT_ENTRIES  512
+#define HDD_CLUSTER_SIZE  4 /* sectors per cluster; 2K */
+
+#define PARTITION_FAT12   0x01
+#define PARTITION_FAT16   0x04 /* FAT16 < 32MB */
+
+#define NO_SECTOR 0xFFFFFFFF
+
+typedef struct FLOPPY_FORMAT {
+	uint32_t sectors;
+	uint8_t media;
+	uint8_t sectors_per_cluster;
+	uint16_t root_entries;
+} FLOPPY_FORMAT;
+
+static const FLOPPY_FORMAT floppy_format[] = {
+	{  320, 0xFE, 1,  64 }, /* 160KB */
+	{  360, 0xFC, 1,  64 }, /* 180KB */
+	{  640, 0xFF, 2, 112 }, /* 320KB */
+	{  720, 0xFD, 2, 112 }, /* 360KB */
+	{ 1440, 0xF9, 2, 112 }, /* 720KB */
+};
+static const uint32_t floppy_format_count = sizeof(floppy_format) / sizeof(FLOPPY_FORMAT);
+
+/* Print a message, wait for a key and reboot. The message address is patched in */
+static const uint8_t boot_code[] = {
+	0x31, 0xC0,       // xor ax, ax
+	0x8E, 0xD8,       // mov ds, ax
+	0xBE, 0x00, 0x00, // mov si, message
+	0x31, 0xDB,       // xor bx, bx
+	0xAC,             // lodsb
+	0x08, 0xC0,       // or al, al
+	0x74, 0x06,       // jz +6
+	0xB4, 0x0E,       // mov ah, 0Eh
+	0xCD, 0x10,       // int 10h
+	0xEB, 0xF5,       // jmp lodsb
+	0x31, 0xC0,       // xor ax, ax
+	0xCD, 0x16,       // int 16h
+	0xCD, 0x19,       // int 19h
+};
+static const char boot_message[] = "Non-system disk\r\nPress any key to reboot\r\n";
+
+static void write_u16(uint8_t* p, uint16_t value) {
+	p[0] = value & 0xFF;
+	p[1] = (value >> 8) & 0xFF;
+}
+static void write_u32(uint8_t* p, uint32_t value) {
+	write_u16(p, value & 0xFFFF);
+	write_u16(p + 2, (value >> 16) & 0xFFFF);
+}
+
+static void write_boot_code(uint8_t* sector, uint16_t offset) {
+	memcpy(sector + offset, boot_code, sizeof(boot_code));
+	uint16_t message = offset + sizeof(boot_code);
+	write_u16(sector + offset + 5, 0x7C00 + message);
+	memcpy(sector + message, boot_message, sizeof(boot_message));
+	sector[510] = 0x55;
+	sector[511] = 0xAA;
+}
+
+static void to_fat_name(const char* name, uint8_t name_length, char* out, uint8_t out_length) {
+	/* Uppercase; characters DOS does not allow become '_' */
+	memset(out, ' ', out_length);
+	for (uint8_t i = 0; i < name_length && i < out_length; ++i) {
+		char c = name[i];
+		if (c >= 'a' && c <= 'z') {
+			c -= 'a' - 'A';
+		}
+		else if (c <= ' ' || c >= 0x7F || strchr("\"*+,./:;<=>?[\\]|", c) != NULL) {
+			c = '_';
+		}
+		out[i] = c;
+	}
+}
+
+static int name_exists(FAT_DIR* fat_dir, const char* name) {
+	for (uint32_t i = 0; i < fat_dir->file_count; ++i) {
+		if (memcmp(fat_dir->files[i].name, name, 11) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void set_fat_name(FAT_DIR* fat_dir, FAT_DIR_FILE* file, const char* name) {
+	/* 8.3 name; the extension is the text after the last '.' */
+	size_t length = strlen(name);
+	const char* dot = strrchr(name, '.');
+	size_t base_length = (dot != NULL) ? (size_t)(dot - name) : length;
+
+	to_fat_name(name, (uint8_t)(base_length > 8 ? 8 : base_length), file->name, 8);
+	if (dot != NULL) {
+		to_fat_name(dot + 1, (uint8_t)(strlen(dot + 1) > 3 ? 3 : strlen(dot + 1)), file->name + 8, 3);
+	}
+	else {
+		memset(file->name + 8, ' ', 3);
+	}
+
+	/* Truncated or clashing names get a numeric tail; NAME~1 */
+	if (base_length > 8 || name_exists(fat_dir, file->name)) {
+		for (uint32_t n = 1; n < 10000; ++n) {
+			char tail[8] = { 0 };
+			int tail_length = snprintf(tail, sizeof(tail), "~%u", n);
+			size_t keep = 8 - tail_length;
+			if (keep > base_length) {
+				keep = base_length;
+			}
+			to_fat_name(name, (uint8_t)keep, file->name, 8);
+			memcpy(file->name + keep, tail, tail_length);
+			if (!name_exists(fat_dir, file->name)) {
+				break;
+			}
+		}
+	}
+}
+
+static void set_fat_time(FAT_DIR_FILE* file, time_t mtime) {
+	struct tm* tm = localtime(&mtime);
+	if (tm == NULL || tm->tm_year < 80) {
+		file->date = (1 << 5) | 1; /* 1980-01-01 */
+		file->time = 0;
+		return;
+	}
+	file->date = (uint16_t)(((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday);
+	file->time = (uint16_t)((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2));
+}
+
+static int add_file(const FILE_INFO* info, void* param) {
+	FAT_DIR* fat_dir = (FAT_DIR*)param;
+
+	/* Flat volume; subdirectories and dot files are not exposed */
+	if (info->is_directory || info->name[0] == '.') {
+		return 0;
+	}
+
+	if (fat_dir->file_count >= FAT_DIR_MAX_FILES) {
+		log_error("[FAT] Error: root directory full: %s\n", info->name);
+		return 1;
+	}
+
+	if (info->size > 0xFFFFFFFF) {
+		log_error("[FAT] Error: file too large: %s\n", info->name);
+		return 1;
+	}
+
+	FAT_DIR_FILE* file = &fat_dir->files[fat_dir->file_count];
+	memset(file, 0, sizeof(FAT_DIR_FILE));
+
+	size_t path_size = strlen(fat_dir->path) + 1 + strlen(info->name) + 1;
+	file->path = malloc(path_size);
+	if (file->path == NULL) {
+		log_error("[FAT] Error: could not alloc memory for file path\n");
+		return 1;
+	}
+	snprintf(file->path, path_size, "%s/%s", fat_dir->path, info->name);
+
+	file->size = (uint32_t)info->size;
+	set_fat_name(fat_dir, file, info->name);
+	set_fat_time(file, info->mtime);
+
+	fat_dir->file_count++;
+	return 0;
+}
+
+static void free_files(FAT_DIR* fat_dir) {
+	if (fat_dir->files != NULL) {
+		for (uint32_t i = 0; i < fat_dir->file_count; ++i) {
+			if (fat_dir->files[i].path != NULL) {
+				free(fat_dir->files[i].path);
+			}
+		}
+		free(fat_dir->files);
+		fat_dir->files = NULL;
+	}
+	fat_dir->file_count = 0;
+}
+
+int fat_dir_open(FAT_DIR* fat_dir, const char* path) {
+	fat_dir_close(fat_dir);
+
+	fat_dir->path = calloc(1, FAT_DIR_PATH_SIZE);
+	fat_dir->files = calloc(FAT_DIR_MAX_FILES, sizeof(FAT_DIR_FILE));
+	if (fat_dir->path == NULL || fat_dir->files == NULL) {
+		log_error("[FAT] Error: could not alloc memory for directory\n");
+		fat_dir_close(fat_dir);
+		return 1;
+	}
+
+	strncpy_s(fat_dir->path, FAT_DIR_PATH_SIZE, path, FAT_DIR_PATH_SIZE - 1);
+
+	/* Volume label; the host directory name */
+	const char* label = file_get_filename(fat_dir->path);
+	if (label[0] != '\0') {
+		to_fat_name(label, (uint8_t)(strlen(label) > 11 ? 11 : strlen(label)), fat_dir->label, 11);
+	}
+	else {
+		memcpy(fat_dir->label, "NO NAME    ", 11);
+	}
+
+	if (file_list_directory(fat_dir->path, add_file, fat_dir)) {
+		fat_dir_close(fat_dir);
+		return 1;
+	}
+
+	fat_dir->cached_sector = NO_SECTOR;
+	fat_dir->enabled = 1;
+
+	log_info("[FAT] OPEN: %s (%u files)\n", fat_dir->path, fat_dir->file_count);
+	return 0;
+}
+void fat_dir_close(FAT_DIR* fat_dir) {
+	file_close_handle(fat_dir->open_file);
+	fat_dir->open_file = NULL;
+	free_files(fat_dir);
+	if (fat_dir->path != NULL) {
+		free(fat_dir->path);
+		fat_dir->path = NULL;
+	}
+	fat_dir->enabled = 0;
+	fat_dir->cached_sector = NO_SECTOR;
+}
+
+int fat_dir_format(FAT_DIR* fat_dir, CHS geometry, uint8_t hdd) {
+	uint32_t sector_count = (uint32_t)geometry.c * geometry.h * geometry.s;
+	uint8_t sectors_per_cluster = 0;
+
+	if (hdd) {
+		fat_dir->partition_lba = geometry.s; /* partition starts on the second track */
+		fat_dir->media = HDD_MEDIA;
+		fat_dir->root_entries = HDD_ROOT_ENTRIES;
+		sectors_per_cluster = HDD_CLUSTER_SIZE;
+	}
+	else {
+		const FLOPPY_FORMAT* format = NULL;
+		for (uint32_t i = 0; i < floppy_format_count; ++i) {
+			if (floppy_format[i].sectors == sector_count) {
+				format = &floppy_format[i];
+				break;
+			}
+		}
+		if (format == NULL) {
+			return 1;
+		}
+		fat_dir->partition_lba = 0;
+		fat_dir->media = format->media;
+		fat_dir->root_entries = format->root_entries;
+		sectors_per_cluster = format->sectors_per_cluster;
+	}
+
+	if (fat_dir->file_count + 1 > fat_dir->root_entries) {
+		return 1; /* files + volume label */
+	}
+
+	uint32_t volume_sectors = sector_count - fat_dir->partition_lba;
+	uint32_t root_sectors = (fat_dir->root_entries * DIR_ENTRY_SIZE) / FAT_DIR_SECTOR_SIZE;
+
+	/* FAT16 only on fixed disks with too many clusters for FAT12 */
+	uint8_t fat16 = hdd && ((volume_sectors - RESERVED_SECTORS - root_sectors) / sectors_per_cluster) > FAT12_MAX_CLUSTERS;
+
+	/* The FAT size depends on the cluster count and the cluster count on the FAT size */
+	uint32_t fat_sectors = 1;
+	uint32_t cluster_count = 0;
+	for (;;) {
+		uint32_t data_sectors = volume_sectors - RESERVED_SECTORS - root_sectors - (FAT_COUNT * fat_sectors);
+		cluster_count = data_sectors / sectors_per_cluster;
+		uint32_t fat_bytes = fat16 ? ((cluster_count + 2) * 2) : ((((cluster_count + 2) * 3) + 1) / 2);
+		uint32_t needed = (fat_bytes + FAT_DIR_SECTOR_SIZE - 1) / FAT_DIR_SECTOR_SIZE;
+		if (needed <= fat_sectors) {
+			break;
+		}
+		fat_sectors = needed;
+	}
+
+	if (cluster_count > (fat16 ? FAT16_MAX_CLUSTERS : FAT12_MAX_CLUSTERS)) {
+		return 1;
+	}
+
+	/* Files are laid out contiguously in directory order */
+	uint32_t cluster_size = sectors_per_cluster * FAT_DIR_SECTOR_SIZE;
+	uint32_t next = 2;
+	for (uint32_t i = 0; i < fat_dir->file_count; ++i) {
+		FAT_DIR_FILE* file = &fat_dir->files[i];
+		file->clusters = (uint16_t)((file->size + cluster_size - 1) / cluster_size);
+		file->cluster = file->clusters ? (uint16_t)next : 0;
+		next += (file->size + cluster_size - 1) / cluster_size;
+		if (next - 2 > cluster_count) {
+			return 1;
+		}
+	}
+
+	chs_set(&fat_dir->geometry, geometry);
+	fat_dir->hdd = hdd;
+	fat_dir->fat16 = fat16;
+	fat_dir->sector_count = sector_count;
+	fat_dir->sectors_per_cluster = sectors_per_cluster;
+	fat_dir->fat_sectors = (uint16_t)fat_sectors;
+	fat_dir->cluster_count = cluster_count;
+	fat_dir->fat_start = RESERVED_SECTORS;
+	fat_dir->root_start = fat_dir->fat_start + (FAT_COUNT * fat_sectors);
+	fat_dir->data_start = fat_dir->root_start + root_sectors;
+	fat_dir->cached_sector = NO_SECTOR;
+
+	log_info("[FAT] FORMAT: FAT%d, C=%d, H=%d, S=%d, %u clusters of %u bytes, %u used\n",
+		fat16 ? 16 : 12, geometry.c, geometry.h, geometry.s, cluster_count, cluster_size, next - 2);
+	return 0;
+}
+
+static void write_chs(uint8_t* p, CHS chs) {
+	p[0] = chs.h;
+	p[1] = (chs.s & 0x3F) | ((chs.c >> 2) & 0xC0);
+	p[2] = chs.c & 0xFF;
+}
+
+static void build_mbr(FAT_DIR* fat_dir, uint8_t* sector) {
+	write_boot_code(sector, 0);
+
+	/* One primary partition covering the rest of the disk */
+	uint8_t* entry = sector + 0x1BE;
+	entry[0] = 0x00;
+	write_chs(entry + 1, lba_to_chs(fat_dir->geometry, fat_dir->partition_lba));
+	entry[4] = fat_dir->fat16 ? PARTITION_FAT16 : PARTITION_FAT12;
+	write_chs(entry + 5, lba_to_chs(fat_dir->geometry, fat_dir->sector_count - 1));
+	write_u32(entry + 8, fat_dir->partition_lba);
+	write_u32(entry + 12, fat_dir->sector_count - fat_dir->partition_lba);
+}
+
+static void build_boot_sector(FAT_DIR* fat_dir, uint8_t* sector) {
+	uint32_t volume_sectors = fat_dir->sector_count - fat_dir->partition_lba;
+
+	sector[0] = 0xEB; /* jmp short 3Eh */
+	sector[1] = 0x3C;
+	sector[2] = 0x90;
+	memcpy(sector + 0x03, "MSDOS5.0", 8);
+
+	/* BPB */
+	write_u16(sector + 0x0B, FAT_DIR_SECTOR_SIZE);
+	sector[0x0D] = fat_dir->sectors_per_cluster;
+	write_u16(sector + 0x0E, RESERVED_SECTORS);
+	sector[0x10] = FAT_COUNT;
+	write_u16(sector + 0x11, fat_dir->root_entries);
+	write_u16(sector + 0x13, volume_sectors > 0xFFFF ? 0 : (uint16_t)volume_sectors);
+	sector[0x15] = fat_dir->media;
+	write_u16(sector + 0x16, fat_dir->fat_sectors);
+	write_u16(sector + 0x18, fat_dir->geometry.s);
+	write_u16(sector + 0x1A, fat_dir->geometry.h);
+	write_u32(sector + 0x1C, fat_dir->partition_lba);
+	write_u32(sector + 0x20, volume_sectors > 0xFFFF ? volume_sectors : 0);
+
+	/* Extended BPB */
+	sector[0x24] = fat_dir->hdd ? 0x80 : 0x00;
+	sector[0x26] = 0x29;
+	write_u32(sector + 0x27, 0x1BC0FA7D); /* serial */
+	memcpy(sector + 0x2B, fat_dir->label, 11);
+	memcpy(sector + 0x36, fat_dir->fat16 ? "FAT16   " : "FAT12   ", 8);
+
+	write_boot_code(sector, 0x3E);
+}
+
+static uint32_t get_fat_entry(FAT_DIR* fat_dir, uint32_t cluster) {
+	uint32_t eoc = fat_dir->fat16 ? 0xFFFF : 0xFFF;
+	if (cluster == 0) {
+		return (eoc & ~0xFF) | fat_dir->media;
+	}
+	if (cluster == 1) {
+		return eoc;
+	}
+	for (uint32_t i = 0; i < fat_dir->file_count; ++i) {
+		FAT_DIR_FILE* file = &fat_dir->files[i];
+		if (file->clusters != 0 && cluster >= file->cluster && cluster < (uint32_t)file->cluster + file->clusters) {
+			return (cluster == (uint32_t)file->cluster + file->clusters - 1) ? eoc : cluster + 1;
+		}
+	}
+	return 0;
+}
+
+static void build_fat_sector(FAT_DIR* fat_dir, uint8_t* sector, uint32_t index) {
+	uint32_t offset = index * FAT_DIR_SECTOR_SIZE;
+	for (uint32_t i = 0; i < FAT_DIR_SECTOR_SIZE; ++i) {
+		uint32_t byte = offset + i;
+		if (fat_dir->fat16) {
+			uint32_t entry = get_fat_entry(fat_dir, byte / 2);
+			sector[i] = (byte & 1) ? (entry >> 8) & 0xFF : entry & 0xFF;
+		}
+		else {
+			/* 3 bytes hold 2 entries */
+			uint32_t pair = byte / 3;
+			uint32_t e0 = get_fat_entry(fat_dir, pair * 2);
+			uint32_t e1 = get_fat_entry(fat_dir, (pair * 2) + 1);
+			switch (byte % 3) {
+				case 0: sector[i] = e0 & 0xFF; break;
+				case 1: sector[i] = ((e0 >> 8) & 0x0F) | ((e1 & 0x0F) << 4); break;
+				case 2: sector[i] = (e1 >> 4) & 0xFF; break;
+			}
+		}
+	}
+}
+
+static void build_root_sector(FAT_DIR* fat_dir, uint8_t* sector, uint32_t index) {
+	const uint32_t entries_per_sector = FAT_DIR_SECTOR_SIZE / DIR_ENTRY_SIZE;
+	for (uint32_t i = 0; i < entries_per_sector; ++i) {
+		uint32_t n = (index * entries_per_sector) + i;
+		uint8_t* entry = sector + (i * DIR_ENTRY_SIZE);
+		if (n == 0) {
+			memcpy(entry, fat_dir->label, 11);
+			entry[11] = ATTR_VOLUME_LABEL;
+		}
+		else if (n - 1 < fat_dir->file_count) {
+			FAT_DIR_FILE* file = &fat_dir->files[n - 1];
+			memcpy(entry, file->name, 11);
+			entry[11] = ATTR_ARCHIVE;
+			write_u16(entry + 0x16, file->time);
+			write_u16(entry + 0x18, file->date);
+			write_u16(entry + 0x1A, file->cluster);
+			write_u32(entry + 0x1C, file->size);
+		}
+	}
+}
+
+static void build_data_sector(FAT_DIR* fat_dir, uint8_t* sector, uint32_t index) {
+	uint32_t cluster = (index / fat_dir->sectors_per_cluster) + 2;
+	for (uint32_t i = 0; i < fat_dir->file_count; ++i) {
+		FAT_DIR_FILE* file = &fat_dir->files[i];
+		if (file->clusters != 0 && cluster >= file->cluster && cluster < (uint32_t)file->cluster + file->clusters) {
+			/* Read the host file here; only when the guest asks */
+			uint32_t offset = (((cluster - file->cluster) * fat_dir->sectors_per_cluster) + (index % fat_dir->sectors_per_cluster)) * FAT_DIR_SECTOR_SIZE;
+			uint32_t size = file->size - offset;
+			if (size > FAT_DIR_SECTOR_SIZE) {
+				size = FAT_DIR_SECTOR_SIZE;
+			}
+			/* Sectors are read in order within a file; keep its handle open rather than reopen it per sector */
+			if (fat_dir->open_file == NULL || fat_dir->open_index != i) {
+				file_close_handle(fat_dir->open_file);
+				fat_dir->open_file = file_open_read(file->path);
+				fat_dir->open_index = i;
+			}
+			if (file_read_at(fat_dir->open_file, offset, sector, size, NULL)) {
+				log_error("[FAT] Error: could not read %s\n", file->path);
+			}
+			return;
+		}
+	}
+}
+
+static void build_sector(FAT_DIR* fat_dir, uint32_t lba) {
+	uint8_t* sector = fat_dir->sector;
+	memset(sector, 0, FAT_DIR_SECTOR_SIZE);
+
+	if (lba < fat_dir->partition_lba) {
+		if (lba == 0) {
+			build_mbr(fat_dir, sector);
+		}
+		return;
+	}
+
+	uint32_t s = lba - fat_dir->partition_lba;
+	if (s < fat_dir->fat_start) {
+		build_boot_sector(fat_dir, sector);
+	}
+	else if (s < fat_dir->root_start) {
+		build_fat_sector(fat_dir, sector, (s - fat_dir->fat_start) % fat_dir->fat_sectors);
+	}
+	else if (s < fat_dir->data_start) {
+		build_root_sector(fat_dir, sector, s - fat_dir->root_start);
+	}
+	else {
+		build_data_sector(fat_dir, sector, s - fat_dir->data_start);
+	}
+}
+
+const uint8_t* fat_dir_get_sector(FAT_DIR* fat_dir, size_t offset) {
+	uint32_t lba = (uint32_t)(offset / FAT_DIR_SECTOR_SIZE);
+	if (fat_dir->cached_sector != lba) {
+		build_sector(fat_dir, lba);
+		fat_dir->cached_sector = lba;
+	}
+	return fat_dir->sector;
+}
+
+void fat_dir_read(FAT_DIR* fat_dir, uint8_t* buffer, size_t buffer_size) {
+	for (size_t offset = 0; offset < buffer_size; offset += FAT_DIR_SECTOR_SIZE) {
+		size_t size = buffer_size - offset;
+		if (size > FAT_DIR_SECTOR_SIZE) {
+			size = FAT_DIR_SECTOR_SIZE;
+		}
+		memcpy(buffer + offset, fat_dir_get_sector(fat_dir, offset), size);
+	}
+}
+
+uint8_t fat_dir_read_byte(FAT_DIR* fat_dir, DISK_OVERLAY* overlay, size_t offset) {
+	if (overlay->enabled) {
+		const uint8_t* sector = overlay_get_sector(overlay, offset);
+		if (sector != NULL) {
+			return sector[offset % FAT_DIR_SECTOR_SIZE];
+		}
+	}
+	return fat_dir_get_sector(fat_dir, offset)[offset % FAT_DIR_SECTOR_SIZE];
+}
+int fat_dir_write_byte(FAT_DIR* fat_dir, DISK_OVERLAY* overlay, size_t offset, uint8_t value) {
+	if (!overlay->enabled) {
+		log_error("[FAT] Error: write to host directory without an overlay. offset = %zx\n", offset);
+		return 1;
+	}
+	if (overlay_get_sector(overlay, offset) == NULL) {
+		return overlay_write_byte_sector(overlay, fat_dir_get_sector(fat_dir, offset), offset, value);
+	}
+	return overlay_write_byte_sector(overlay, NULL, offset, value);
+}
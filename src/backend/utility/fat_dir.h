@@ -0,0 +1,87 @@
+/* fat_dir.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Host directory as a FAT volume. Boot, FAT and directory sectors are synthesized
+ * on demand; file data sectors are read from the host files when asked for.
+ */
+
+#ifndef FAT_DIR_H
+#define FAT_DIR_H
+
+#include <stdint.h>
+
+#include "backend/utility/lba.h"
+#include "backend/utility/overlay.h"
+
+#define FAT_DIR_SECTOR_SIZE 512
+#define FAT_DIR_MAX_FILES   511 /* largest root directory (512) less the volume label */
+
+typedef struct FAT_DIR_FILE {
+	char name[11];    /* 8.3 name; space padded */
+	char* path;       /* host path */
+	uint32_t size;
+	uint16_t date;
+	uint16_t time;
+	uint16_t cluster; /* first cluster; 0 if empty */
+	uint16_t clusters;
+} FAT_DIR_FILE;
+
+typedef struct FAT_DIR {
+	uint8_t enabled;
+	uint8_t fat16;
+	uint8_t hdd;                 /* volume is in a partition; sector 0 is an MBR */
+	char* path;                  /* host directory */
+	char label[11];              /* volume label; space padded */
+	FAT_DIR_FILE* files;
+	uint32_t file_count;
+
+	CHS geometry;
+	uint32_t sector_count;       /* disk sectors */
+	uint32_t partition_lba;      /* first sector of the volume */
+	uint8_t media;
+	uint8_t sectors_per_cluster;
+	uint16_t root_entries;
+	uint16_t fat_sectors;
+	uint32_t cluster_count;
+	uint32_t fat_start;          /* volume relative sectors */
+	uint32_t root_start;
+	uint32_t data_start;
+
+	void* open_file;             /* host file of the last data sector read; kept open until another file is read or the volume is closed */
+	uint32_t open_index;         /* index into files of open_file */
+
+	uint32_t cached_sector;      /* disk sector held in sector; 0xFFFFFFFF if none */
+	uint8_t sector[FAT_DIR_SECTOR_SIZE];
+} FAT_DIR;
+
+/* Scan a host directory. Only the files in the top level of the directory are exposed.
+	fat_dir: the fat_dir instance
+	path: the host directory
+	Returns: 0 if success. Otherwise 1 */
+int fat_dir_open(FAT_DIR* fat_dir, const char* path);
+void fat_dir_close(FAT_DIR* fat_dir);
+
+/* Lay out the volume for a disk geometry
+	fat_dir: the fat_dir instance
+	geometry: the disk geometry
+	hdd: 1 for a partitioned FAT16 fixed disk. 0 for a FAT12 floppy
+	Returns: 0 if success. 1 if the files do not fit */
+int fat_dir_format(FAT_DIR* fat_dir, CHS geometry, uint8_t hdd);
+
+/* Get the synthesized sector containing offset
+	fat_dir: the fat_dir instance
+	offset: a byte offset into the disk
+	Returns: the sector data; valid until the next call */
+const uint8_t* fat_dir_get_sector(FAT_DIR* fat_dir, size_t offset);
+
+/* Read the whole disk into a buffer
+	fat_dir: the fat_dir instance
+	buffer: the buffer
+	buffer_size: the buffer size */
+void fat_dir_read(FAT_DIR* fat_dir, uint8_t* buffer, size_t buffer_size);
+
+/* The volume is read-only; guest writes are kept in the overlay.
+	fat_dir_write_byte() Returns: 0 if success. Otherwise 1; no overlay, or the overlay could not grow */
+uint8_t fat_dir_read_byte(FAT_DIR* fat_dir, DISK_OVERLAY* overlay, size_t offset);
+int fat_dir_write_byte(FAT_DIR* fat_dir, DISK_OVERLAY* overlay, size_t offset, uint8_t value);
+
+#endif
@@ -0,0 +1,285 @@
+/* log.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Leveled logging; a level per category, rate limited per call site, written through a ring
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "log.h"
+#include "atomic.h"
+
+/* A message is formatted on the thread that logs it and queued in the ring; the drain thread prints it.
+ * Without a drain thread, messages print on the thread that logs them.
+ * A site is rate limited before its message is formatted; a site over its limit costs a compare and an add. */
+
+#define FNV_OFFSET 0x811C9DC5
+#define FNV_PRIME  0x01000193
+
+typedef struct LOG_ENTRY {
+	char text[LOG_TEXT_SIZE];
+} LOG_ENTRY;
+
+typedef struct LOG {
+	ATOMIC32 lock;      /* spin lock; guards the ring and the site list */
+	ATOMIC32 async;     /* queue messages for the drain thread */
+	uint32_t head;      /* next entry written */
+	uint32_t tail;      /* next entry drained */
+	uint32_t dropped;   /* messages dropped; the ring was full */
+	LOG_SITE* sites;    /* sites that have logged */
+	LOG_GET_TICKS_CB get_ticks_ms;
+	LOG_ENTRY ring[LOG_RING_SIZE];
+} LOG;
+
+static LOG logger = { 0 };
+
+uint8_t log_levels[LOG_CATEGORIES] = {
+	LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+	LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+	LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT, LOG_LEVEL_DEFAULT,
+	LOG_LEVEL_DEFAULT,
+};
+
+static const char* category_names[LOG_CATEGORIES] = {
+	"main", "mem", "io", "dma", "pit", "pic", "kbd", "fdc", "hdc", "disk", "audio", "tools", "frontend"
+};
+
+static const char* level_names[] = {
+	"none", "error", "warn", "info", "debug"
+};
+#define LOG_LEVELS (sizeof(level_names) / sizeof(level_names[0]))
+
+static void log_lock(void) {
+	while (atomic32_exchange(&logger.lock, 1) != 0) {
+	}
+}
+static void log_unlock(void) {
+	atomic32_store(&logger.lock, 0);
+}
+
+static uint32_t hash_text(const char* text) {
+	uint32_t hash = FNV_OFFSET;
+	while (*text != '\0') {
+		hash = (hash ^ (uint8_t)*text++) * FNV_PRIME;
+	}
+	return hash;
+}
+
+static const char* file_name(const char* path) {
+	const char* name = path;
+	for (const char* p = path; *p != '\0'; ++p) {
+		if (*p == '/' || *p == '\\') {
+			name = p + 1;
+		}
+	}
+	return name;
+}
+
+static void push(const char* text) {
+	if (!atomic32_load(&logger.async)) {
+		fputs(text, stdout);
+		return;
+	}
+
+	log_lock();
+	if (logger.head - logger.tail >= LOG_RING_SIZE) {
+		logger.dropped++;
+	}
+	else {
+		LOG_ENTRY* entry = &logger.ring[logger.head & (LOG_RING_SIZE - 1)];
+		strncpy_s(entry->text, LOG_TEXT_SIZE, text, LOG_TEXT_SIZE - 1);
+		logger.head++;
+	}
+	log_unlock();
+}
+
+/* Report the messages a site did not log; resets the counts */
+static void report(LOG_SITE* site) {
+	char text[LOG_TEXT_SIZE];
+	const char* name = file_name(site->file);
+	if (site->repeats > 0 && site->suppressed > 0) {
+		snprintf(text, sizeof(text), "[LOG] %s:%d: %u repeated, %u suppressed\n", name, site->line, site->repeats, site->suppressed);
+	}
+	else if (site->suppressed > 0) {
+		snprintf(text, sizeof(text), "[LOG] %s:%d: %u suppressed\n", name, site->line, site->suppressed);
+	}
+	else {
+		snprintf(text, sizeof(text), "[LOG] %s:%d: %u repeated\n", name, site->line, site->repeats);
+	}
+	site->repeats = 0;
+	site->suppressed = 0;
+	push(text);
+}
+
+void log_write(LOG_SITE* site, const char* x, ...) {
+	uint64_t now = 0;
+	if (!site->registered) {
+		log_lock();
+		site->next = logger.sites;
+		logger.sites = site;
+		log_unlock();
+		site->registered = 1;
+		if (logger.get_ticks_ms != NULL) {
+			now = logger.get_ticks_ms();
+		}
+	}
+	else {
+		/* Rate limit; nothing is formatted over the limit */
+		if (logger.get_ticks_ms != NULL) {
+			now = logger.get_ticks_ms();
+			if (now - site->window_ms >= LOG_BURST_MS) {
+				site->window_ms = now;
+				site->window_count = 0;
+			}
+			if (site->window_count >= LOG_BURST) {
+				site->suppressed++;
+				return;
+			}
+		}
+	}
+	site->window_count++;
+
+	char text[LOG_TEXT_SIZE];
+	va_list args;
+	va_start(args, x);
+	vsnprintf(text, sizeof(text), x, args);
+	va_end(args);
+
+	/* Dedup; a message identical to the last from this site is counted.
+	 * The count is reported at most every LOG_REPEAT_MS while the site keeps repeating */
+	uint32_t hash = hash_text(text);
+	if (hash == site->hash) {
+		site->repeats++;
+		if (logger.get_ticks_ms != NULL && now - site->report_ms >= LOG_REPEAT_MS) {
+			site->report_ms = now;
+			report(site);
+		}
+		return;
+	}
+	site->hash = hash;
+
+	if (site->repeats > 0 || site->suppressed > 0) {
+		report(site);
+	}
+	site->report_ms = now;
+	push(text);
+}
+
+void log_set_level(uint8_t cat, uint8_t level) {
+	if (cat < LOG_CATEGORIES) {
+		log_levels[cat] = level;
+	}
+}
+void log_set_all_levels(uint8_t level) {
+	for (int i = 0; i < LOG_CATEGORIES; ++i) {
+		log_levels[i] = level;
+	}
+}
+
+static int find_name(const char* const* names, int count, const char* name, size_t len) {
+	for (int i = 0; i < count; ++i) {
+		if (strlen(names[i]) == len && strncmp(names[i], name, len) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+uint8_t log_find_level(const char* name) {
+	int level = find_name(level_names, LOG_LEVELS, name, strlen(name));
+	return (level < 0) ? LOG_LEVEL_UNKNOWN : (uint8_t)level;
+}
+uint8_t log_find_category(const char* name) {
+	int cat = find_name(category_names, LOG_CATEGORIES, name, strlen(name));
+	return (cat < 0) ? LOG_CATEGORIES : (uint8_t)cat;
+}
+
+int log_parse_levels(const char* levels) {
+	const char* p = levels;
+	while (*p != '\0') {
+		const char* end = strchr(p, ',');
+		if (end == NULL) {
+			end = p + strlen(p);
+		}
+
+		const char* eq = memchr(p, '=', end - p);
+		if (eq == NULL) {
+			printf("[LOG] Expected <category>=<level>: %.*s\n", (int)(end - p), p);
+			return 1;
+		}
+
+		int level = find_name(level_names, LOG_LEVELS, eq + 1, end - (eq + 1));
+		if (level < 0) {
+			printf("[LOG] Unknown level: %.*s\n", (int)(end - (eq + 1)), eq + 1);
+			return 1;
+		}
+
+		if (eq - p == 3 && strncmp(p, "all", 3) == 0) {
+			log_set_all_levels((uint8_t)level);
+		}
+		else {
+			int cat = find_name(category_names, LOG_CATEGORIES, p, eq - p);
+			if (cat < 0) {
+				printf("[LOG] Unknown category: %.*s\n", (int)(eq - p), p);
+				return 1;
+			}
+			log_levels[cat] = (uint8_t)level;
+		}
+
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return 0;
+}
+
+void log_set_cb_get_ticks_ms(LOG_GET_TICKS_CB get_ticks_ms) {
+	logger.get_ticks_ms = get_ticks_ms;
+}
+
+void log_set_async(int async) {
+	atomic32_store(&logger.async, async);
+}
+
+void log_drain(void) {
+	LOG_ENTRY entry;
+	int printed = 0;
+	for (;;) {
+		log_lock();
+		uint32_t dropped = logger.dropped;
+		logger.dropped = 0;
+		int empty = (logger.tail == logger.head);
+		if (!empty) {
+			memcpy(&entry, &logger.ring[logger.tail & (LOG_RING_SIZE - 1)], sizeof(entry));
+			logger.tail++;
+		}
+		log_unlock();
+
+		if (dropped > 0) {
+			printf("[LOG] %u dropped; the ring was full\n", dropped);
+			printed = 1;
+		}
+		if (empty) {
+			break;
+		}
+		fputs(entry.text, stdout);
+		printed = 1;
+	}
+	if (printed) {
+		fflush(stdout);
+	}
+}
+
+void log_flush(void) {
+	/* Sites are only ever added at the head; the list from a snapshot of the head is stable */
+	log_lock();
+	LOG_SITE* site = logger.sites;
+	log_unlock();
+
+	for (; site != NULL; site = site->next) {
+		if (site->repeats > 0 || site->suppressed > 0) {
+			report(site);
+		}
+	}
+	log_drain();
+}
@@ -0,0 +1,132 @@
+/* log.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Leveled logging; a level per category, rate limited per call site, written through a ring
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+/* Levels; a message is logged if its level is at or below the level of its category */
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_UNKNOWN 0xFF
+
+/* Categories */
+#define LOG_CAT_MAIN     0 /* ibm_pc, journal, rewind, warm boot, bench */
+#define LOG_CAT_MEM      1 /* memory map */
+#define LOG_CAT_IO       2 /* isa bus */
+#define LOG_CAT_DMA      3
+#define LOG_CAT_PIT      4
+#define LOG_CAT_PIC      5
+#define LOG_CAT_KBD      6
+#define LOG_CAT_FDC      7 /* fdc, fdd */
+#define LOG_CAT_HDC      8 /* xebec, vblk */
+#define LOG_CAT_DISK     9 /* int 13h, overlays, host directories */
+#define LOG_CAT_AUDIO    10
+#define LOG_CAT_TOOLS    11 /* perf, trace, profiler, coverage, heatmap, itrace */
+#define LOG_CAT_FRONTEND 12
+#define LOG_CATEGORIES   13
+
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
+
+/* Per site rate limit; a site logs at most LOG_BURST messages per LOG_BURST_MS.
+ * The rest are counted and reported by the next message the site logs */
+#define LOG_BURST    20
+#define LOG_BURST_MS 1000
+
+/* A site repeating one message reports the count at least this often, not only when the message changes */
+#define LOG_REPEAT_MS 1000
+
+#define LOG_TEXT_SIZE 256  /* a message is truncated to this */
+#define LOG_RING_SIZE 1024 /* messages waiting to be drained; a power of 2 */
+
+/* The compile-time level; messages above it compile out. Define before including log.h to set it for a file */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/* The category of log_error() .. log_debug(). Define before including log.h to set it for a file */
+#ifndef LOG_CATEGORY
+#define LOG_CATEGORY LOG_CAT_MAIN
+#endif
+
+/* Call site state; one per log_print() */
+typedef struct LOG_SITE {
+	const char* file;
+	int line;
+	uint8_t registered;      /* in the site list; flushed at exit */
+	uint64_t window_ms;      /* start of the rate limit window */
+	uint32_t window_count;   /* messages in the window */
+	uint32_t suppressed;     /* messages dropped by the rate limit since the site last logged */
+	uint32_t repeats;        /* messages identical to the last since the site last logged */
+	uint32_t hash;           /* hash of the last message */
+	uint64_t report_ms;      /* when the site last printed or reported */
+	struct LOG_SITE* next;
+} LOG_SITE;
+
+/* get ticks callback */
+typedef uint64_t(*LOG_GET_TICKS_CB)(void);
+
+/* The runtime level of each category */
+extern uint8_t log_levels[LOG_CATEGORIES];
+
+/* Log a message; compiled out above LOG_COMPILE_LEVEL, one compare if below the runtime level.
+	Nothing is formatted if the site is over its rate limit */
+#define log_print(cat, level, x, ...) do { \
+	if ((level) <= LOG_COMPILE_LEVEL && (level) <= log_levels[cat]) { \
+		static LOG_SITE log_site = { __FILE__, __LINE__ }; \
+		log_write(&log_site, x, __VA_ARGS__); \
+	} \
+} while (0)
+
+#define log_error(x, ...) log_print(LOG_CATEGORY, LOG_LEVEL_ERROR, x, __VA_ARGS__)
+#define log_warn(x, ...)  log_print(LOG_CATEGORY, LOG_LEVEL_WARN,  x, __VA_ARGS__)
+#define log_info(x, ...)  log_print(LOG_CATEGORY, LOG_LEVEL_INFO,  x, __VA_ARGS__)
+#define log_debug(x, ...) log_print(LOG_CATEGORY, LOG_LEVEL_DEBUG, x, __VA_ARGS__)
+
+/* Write a message; use log_print()
+	site: the call site
+	x: printf format */
+void log_write(LOG_SITE* site, const char* x, ...);
+
+/* Set the level of a category
+	cat: LOG_CAT_XXX
+	level: LOG_LEVEL_XXX */
+void log_set_level(uint8_t cat, uint8_t level);
+
+/* Set the level of every category
+	level: LOG_LEVEL_XXX */
+void log_set_all_levels(uint8_t level);
+
+/* Set the levels of categories from a list; "fdc=debug,io=none"
+	levels: the list
+	Returns: 0 if success. Otherwise 1 */
+int log_parse_levels(const char* levels);
+
+/* Find a level by name
+	Returns: LOG_LEVEL_XXX. LOG_LEVEL_UNKNOWN if not found */
+uint8_t log_find_level(const char* name);
+
+/* Find a category by name
+	Returns: LOG_CAT_XXX. LOG_CATEGORIES if not found */
+uint8_t log_find_category(const char* name);
+
+/* Set get_ticks_ms() callback; the rate limit clock. NULL = no rate limit */
+void log_set_cb_get_ticks_ms(LOG_GET_TICKS_CB get_ticks_ms);
+
+/* Queue messages in the ring instead of printing them; a drain thread prints them
+	async: 1 = queue, 0 = print on the calling thread */
+void log_set_async(int async);
+
+/* Print the messages in the ring; called by the drain thread */
+void log_drain(void);
+
+/* Report the counts of every site that has messages suppressed or repeated, then drain */
+void log_flush(void);
+
+#endif
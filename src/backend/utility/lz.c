@@ -0,0 +1,134 @@
+/* lz.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * LZ77 block compression; greedy, one hash probe per position. Fast over ratio
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "lz.h"
+
+/* A block is a run of sequences:
+ * token (literal length << 4 | match length - LZ_MIN_MATCH), [literal length - 15 as 255s + rest],
+ * literals, offset (u16), [match length - 15 as 255s + rest].
+ * The last sequence is literals only; the block ends after them. */
+
+#define LZ_HASH_BITS  12
+#define LZ_MIN_MATCH  4
+#define LZ_MAX_OFFSET 0xFFFF
+#define LZ_NONE       0xFFFFFFFF
+
+static uint32_t hash4(const uint8_t* p) {
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t* put_length(uint8_t* dst, size_t len) {
+	while (len >= 255) {
+		*dst++ = 255;
+		len -= 255;
+	}
+	*dst++ = (uint8_t)len;
+	return dst;
+}
+
+static uint8_t* put_literals(uint8_t* dst, const uint8_t* literals, size_t len, size_t match_len) {
+	size_t ml = match_len - LZ_MIN_MATCH;
+	*dst++ = (uint8_t)(((len < 15) ? len : 15) << 4 | ((ml < 15) ? ml : 15));
+	if (len >= 15) {
+		dst = put_length(dst, len - 15);
+	}
+	memcpy(dst, literals, len);
+	return dst + len;
+}
+
+size_t lz_compress(const uint8_t* src, size_t size, uint8_t* dst) {
+	uint32_t table[1 << LZ_HASH_BITS];
+	memset(table, 0xFF, sizeof(table));
+
+	uint8_t* out = dst;
+	size_t anchor = 0;
+	size_t i = 0;
+	while (i + LZ_MIN_MATCH <= size) {
+		uint32_t h = hash4(src + i);
+		uint32_t candidate = table[h];
+		table[h] = (uint32_t)i;
+		if (candidate == LZ_NONE || i - candidate > LZ_MAX_OFFSET || memcmp(src + candidate, src + i, LZ_MIN_MATCH) != 0) {
+			i++;
+			continue;
+		}
+
+		size_t len = LZ_MIN_MATCH;
+		while (i + len < size && src[candidate + len] == src[i + len]) {
+			len++;
+		}
+
+		out = put_literals(out, src + anchor, i - anchor, len);
+		size_t offset = i - candidate;
+		*out++ = (uint8_t)offset;
+		*out++ = (uint8_t)(offset >> 8);
+		if (len - LZ_MIN_MATCH >= 15) {
+			out = put_length(out, len - LZ_MIN_MATCH - 15);
+		}
+		i += len;
+		anchor = i;
+	}
+
+	/* the last literals */
+	out = put_literals(out, src + anchor, size - anchor, LZ_MIN_MATCH);
+	return out - dst;
+}
+
+static int get_length(const uint8_t** p, const uint8_t* end, size_t* len) {
+	uint8_t b;
+	do {
+		if (*p >= end) {
+			return 1;
+		}
+		b = *(*p)++;
+		*len += b;
+	} while (b == 255);
+	return 0;
+}
+
+size_t lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size) {
+	const uint8_t* p = src;
+	const uint8_t* end = src + size;
+	size_t out = 0;
+	while (p < end) {
+		uint8_t token = *p++;
+		size_t len = token >> 4;
+		if (len == 15 && get_length(&p, end, &len)) {
+			return 0;
+		}
+		if (len > (size_t)(end - p) || len > dst_size - out) {
+			return 0;
+		}
+		memcpy(dst + out, p, len);
+		p += len;
+		out += len;
+		if (p == end) {
+			return out; /* the last sequence */
+		}
+
+		if (end - p < 2) {
+			return 0;
+		}
+		size_t offset = p[0] | (p[1] << 8);
+		p += 2;
+		len = token & 0x0F;
+		if (len == 15 && get_length(&p, end, &len)) {
+			return 0;
+		}
+		len += LZ_MIN_MATCH;
+		if (offset == 0 || offset > out || len > dst_size - out) {
+			return 0;
+		}
+		/* may overlap; byte at a time */
+		for (size_t i = 0; i < len; ++i, ++out) {
+			dst[out] = dst[out - offset];
+		}
+	}
+	return out;
+}
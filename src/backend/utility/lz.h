@@ -0,0 +1,30 @@
+/* lz.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * LZ77 block compression; greedy, one hash probe per position. Fast over ratio
+ */
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The worst case size of a compressed block; incompressible data grows slightly */
+#define LZ_BOUND(size) ((size) + (size) / 255 + 16)
+
+/* Compress a block
+	src: the data
+	size: the data size
+	dst: the compressed data; at least LZ_BOUND(size)
+	Returns: the compressed size */
+size_t lz_compress(const uint8_t* src, size_t size, uint8_t* dst);
+
+/* Decompress a block
+	src: the compressed data
+	size: the compressed size
+	dst: the data
+	dst_size: the size of dst
+	Returns: the data size. 0 if the block is corrupt or does not fit in dst */
+size_t lz_decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dst_size);
+
+#endif
@@ -0,0 +1,316 @@
+/* overlay.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Copy-on-write disk overlay. Reads fall through to a read-only base image;
+ * written sectors are kept in a sparse delta ( sector map + sector data )
+ */
+
+#include <stdint.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "overlay.h"
+#include "frontend/utility/file.h"
+
+#define LOG_CATEGORY LOG_CAT_DISK
+#include "log.h"
+
+#define OVERLAY_PATH_SIZE 256
+
+#define OVERLAY_MAGIC   0x594C564F /* 'OVLY' */
+#define OVERLAY_VERSION 0x00000001
+
+/* Delta file header; followed by <used> records of { uint32_t sector; uint8_t data[sector_size]; } */
+typedef struct OVERLAY_HEADER {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sector_size;
+	uint32_t sector_count;
+	uint32_t used;
+} OVERLAY_HEADER;
+
+static size_t record_size(DISK_OVERLAY* overlay) {
+	return sizeof(uint32_t) + overlay->sector_size;
+}
+
+static void reset_delta(DISK_OVERLAY* overlay) {
+	if (overlay->map != NULL) {
+		memset(overlay->map, 0, overlay->sector_count * sizeof(uint32_t));
+	}
+	overlay->used = 0;
+}
+
+static int grow_delta(DISK_OVERLAY* overlay) {
+	/* Double the slot count; starts at 16 sectors (8K) */
+	uint32_t capacity = overlay->capacity == 0 ? 16 : overlay->capacity * 2;
+	if (capacity > overlay->sector_count) {
+		capacity = overlay->sector_count;
+	}
+
+	void* new_data = realloc(overlay->data, (size_t)capacity * overlay->sector_size);
+	if (new_data == NULL) {
+		log_error("[OVERLAY] Error: could not alloc memory for delta\n");
+		return 1;
+	}
+
+	overlay->data = new_data;
+	overlay->capacity = capacity;
+	return 0;
+}
+
+static int alloc_sector(DISK_OVERLAY* overlay, const uint8_t* src, size_t size, uint32_t sector) {
+	if (overlay->used == overlay->capacity) {
+		if (grow_delta(overlay)) {
+			return 1;
+		}
+	}
+
+	uint32_t slot = overlay->used++;
+	uint8_t* dest = overlay->data + ((size_t)slot * overlay->sector_size);
+
+	/* Copy the base sector into the delta; the last sector may be short */
+	memcpy(dest, src, size);
+	memset(dest + size, 0, overlay->sector_size - size);
+
+	overlay->map[sector] = slot + 1;
+	return 0;
+}
+
+static int load_delta(DISK_OVERLAY* overlay) {
+	uint8_t* buffer = NULL;
+	size_t buffer_size = 0;
+
+	if (!file_get_file_size(overlay->path, &buffer_size)) {
+		/* No delta file yet; start with an empty delta */
+		return 0;
+	}
+
+	if (file_read_alloc_buffer(overlay->path, &buffer, &buffer_size)) {
+		return 1;
+	}
+
+	if (buffer_size < sizeof(OVERLAY_HEADER)) {
+		log_warn("[OVERLAY] Invalid delta file: %s\n", overlay->path);
+		free(buffer);
+		return 1;
+	}
+
+	OVERLAY_HEADER* header = (OVERLAY_HEADER*)buffer;
+	if (header->magic != OVERLAY_MAGIC || header->version != OVERLAY_VERSION) {
+		log_warn("[OVERLAY] Invalid delta file: %s\n", overlay->path);
+		free(buffer);
+		return 1;
+	}
+
+	if (header->sector_size != overlay->sector_size || header->sector_count != overlay->sector_count) {
+		log_warn("[OVERLAY] Delta does not match base image: %s\n", overlay->path);
+		free(buffer);
+		return 1;
+	}
+
+	if (sizeof(OVERLAY_HEADER) + (header->used * record_size(overlay)) > buffer_size) {
+		log_error("[OVERLAY] Truncated delta file: %s\n", overlay->path);
+		free(buffer);
+		return 1;
+	}
+
+	uint8_t* record = buffer + sizeof(OVERLAY_HEADER);
+	for (uint32_t i = 0; i < header->used; ++i) {
+		uint32_t sector = 0;
+		memcpy(&sector, record, sizeof(uint32_t));
+
+		if (sector < overlay->sector_count) {
+			if (overlay->map[sector] == 0) {
+				if (overlay->used == overlay->capacity && grow_delta(overlay)) {
+					free(buffer);
+					return 1;
+				}
+				overlay->map[sector] = ++overlay->used;
+			}
+			memcpy(overlay->data + ((size_t)(overlay->map[sector] - 1) * overlay->sector_size), record + sizeof(uint32_t), overlay->sector_size);
+		}
+
+		record += record_size(overlay);
+	}
+
+	free(buffer);
+	return 0;
+}
+
+int overlay_create(DISK_OVERLAY* overlay) {
+	overlay->path = calloc(1, OVERLAY_PATH_SIZE);
+	if (overlay->path == NULL) {
+		return 1;
+	}
+	overlay->enabled = 0;
+	overlay->dirty = 0;
+	overlay->map = NULL;
+	overlay->data = NULL;
+	overlay->used = 0;
+	overlay->capacity = 0;
+	return 0;
+}
+void overlay_destroy(DISK_OVERLAY* overlay) {
+	overlay_detach(overlay);
+	if (overlay->path != NULL) {
+		free(overlay->path);
+		overlay->path = NULL;
+	}
+}
+
+int overlay_attach(DISK_OVERLAY* overlay, const char* path, size_t base_size) {
+	overlay_detach(overlay);
+
+	overlay->base_size = base_size;
+	overlay->sector_size = OVERLAY_SECTOR_SIZE;
+	overlay->sector_count = (uint32_t)((base_size + OVERLAY_SECTOR_SIZE - 1) / OVERLAY_SECTOR_SIZE);
+
+	overlay->map = calloc(overlay->sector_count, sizeof(uint32_t));
+	if (overlay->map == NULL) {
+		log_error("[OVERLAY] Error: could not alloc memory for sector map\n");
+		return 1;
+	}
+
+	if (path != overlay->path) {
+		strncpy_s(overlay->path, OVERLAY_PATH_SIZE, path, OVERLAY_PATH_SIZE - 1);
+	}
+
+	if (load_delta(overlay)) {
+		overlay_detach(overlay);
+		return 1;
+	}
+
+	overlay->enabled = 1;
+	overlay->dirty = 0;
+
+	log_info("[OVERLAY] ATTACH: %s (%u sectors)\n", overlay->path, overlay->used);
+	return 0;
+}
+void overlay_detach(DISK_OVERLAY* overlay) {
+	if (overlay->map != NULL) {
+		free(overlay->map);
+		overlay->map = NULL;
+	}
+	if (overlay->data != NULL) {
+		free(overlay->data);
+		overlay->data = NULL;
+	}
+	overlay->used = 0;
+	overlay->capacity = 0;
+	overlay->sector_count = 0;
+	overlay->base_size = 0;
+	overlay->enabled = 0;
+	overlay->dirty = 0;
+}
+
+int overlay_save(DISK_OVERLAY* overlay) {
+	if (!overlay->enabled) {
+		return 1;
+	}
+
+	size_t buffer_size = sizeof(OVERLAY_HEADER) + (overlay->used * record_size(overlay));
+	uint8_t* buffer = malloc(buffer_size);
+	if (buffer == NULL) {
+		log_error("[OVERLAY] Error: could not alloc memory for delta file\n");
+		return 1;
+	}
+
+	OVERLAY_HEADER* header = (OVERLAY_HEADER*)buffer;
+	header->magic = OVERLAY_MAGIC;
+	header->version = OVERLAY_VERSION;
+	header->sector_size = overlay->sector_size;
+	header->sector_count = overlay->sector_count;
+	header->used = overlay->used;
+
+	/* Records are written in sector order */
+	uint8_t* record = buffer + sizeof(OVERLAY_HEADER);
+	for (uint32_t sector = 0; sector < overlay->sector_count; ++sector) {
+		if (overlay->map[sector] != 0) {
+			memcpy(record, &sector, sizeof(uint32_t));
+			memcpy(record + sizeof(uint32_t), overlay->data + ((size_t)(overlay->map[sector] - 1) * overlay->sector_size), overlay->sector_size);
+			record += record_size(overlay);
+		}
+	}
+
+	int result = file_write_from_buffer(overlay->path, buffer, buffer_size);
+	free(buffer);
+
+	if (result == 0) {
+		overlay->dirty = 0;
+	}
+	return result;
+}
+
+void overlay_apply(DISK_OVERLAY* overlay, uint8_t* buffer, size_t buffer_size) {
+	if (!overlay->enabled) {
+		return;
+	}
+
+	for (uint32_t sector = 0; sector < overlay->sector_count; ++sector) {
+		if (overlay->map[sector] != 0) {
+			size_t start = (size_t)sector * overlay->sector_size;
+			if (start >= buffer_size) {
+				break;
+			}
+			size_t size = overlay->sector_size;
+			if (start + size > buffer_size) {
+				size = buffer_size - start;
+			}
+			memcpy(buffer + start, overlay->data + ((size_t)(overlay->map[sector] - 1) * overlay->sector_size), size);
+		}
+	}
+}
+
+void overlay_discard(DISK_OVERLAY* overlay) {
+	if (!overlay->enabled) {
+		return;
+	}
+
+	reset_delta(overlay);
+	overlay->dirty = 1;
+}
+
+uint8_t overlay_read_byte(DISK_OVERLAY* overlay, const uint8_t* base, size_t offset) {
+	uint32_t slot = overlay->map[offset / overlay->sector_size];
+	if (slot == 0) {
+		return base[offset];
+	}
+	return overlay->data[((size_t)(slot - 1) * overlay->sector_size) + (offset % overlay->sector_size)];
+}
+int overlay_write_byte(DISK_OVERLAY* overlay, const uint8_t* base, size_t offset, uint8_t value) {
+	uint32_t sector = (uint32_t)(offset / overlay->sector_size);
+	if (overlay->map[sector] == 0) {
+		size_t start = (size_t)sector * overlay->sector_size;
+		size_t size = overlay->sector_size;
+		if (start + size > overlay->base_size) {
+			size = overlay->base_size - start;
+		}
+		if (alloc_sector(overlay, base + start, size, sector)) {
+			return 1;
+		}
+	}
+
+	overlay->data[((size_t)(overlay->map[sector] - 1) * overlay->sector_size) + (offset % overlay->sector_size)] = value;
+	overlay->dirty = 1;
+	return 0;
+}
+
+uint8_t* overlay_get_sector(DISK_OVERLAY* overlay, size_t offset) {
+	uint32_t slot = overlay->map[offset / overlay->sector_size];
+	if (slot == 0) {
+		return NULL;
+	}
+	return overlay->data + ((size_t)(slot - 1) * overlay->sector_size);
+}
+int overlay_write_byte_sector(DISK_OVERLAY* overlay, const uint8_t* sector_data, size_t offset, uint8_t value) {
+	uint32_t sector = (uint32_t)(offset / overlay->sector_size);
+	if (overlay->map[sector] == 0) {
+		if (alloc_sector(overlay, sector_data, overlay->sector_size, sector)) {
+			return 1;
+		}
+	}
+
+	overlay->data[((size_t)(overlay->map[sector] - 1) * overlay->sector_size) + (offset % overlay->sector_size)] = value;
+	overlay->dirty = 1;
+	return 0;
+}
@@ -0,0 +1,92 @@
+/* overlay.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Copy-on-write disk overlay. Reads fall through to a read-only base image;
+ * written sectors are kept in a sparse delta ( sector map + sector data )
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <stdint.h>
+
+#define OVERLAY_SECTOR_SIZE 512
+
+/* Overlay Struct */
+typedef struct DISK_OVERLAY {
+	uint8_t enabled;
+	uint8_t dirty;          /* delta modified since last load/save */
+	char* path;             /* delta file path */
+	size_t base_size;       /* size of the base image in bytes */
+	uint32_t sector_size;
+	uint32_t sector_count;  /* sectors in the base image */
+	uint32_t* map;          /* sector -> delta slot + 1; 0 = sector is in the base image */
+	uint8_t* data;          /* delta sector data */
+	uint32_t used;          /* delta slots in use */
+	uint32_t capacity;      /* delta slots allocated */
+} DISK_OVERLAY;
+
+/* Create the overlay; Allocs the path buffer
+	overlay: The overlay struct
+	Returns: 0 if success. Otherwise returns 1. (malloc error) */
+int overlay_create(DISK_OVERLAY* overlay);
+
+/* Destroy the overlay
+	overlay: The overlay struct */
+void overlay_destroy(DISK_OVERLAY* overlay);
+
+/* Attach a delta file to a base image. Loads the delta file if it exists.
+	overlay: The overlay struct
+	path: the delta file path
+	base_size: size of the base image in bytes
+	Returns: 0 if success. Otherwise returns 1. (malloc error, delta does not match the base image) */
+int overlay_attach(DISK_OVERLAY* overlay, const char* path, size_t base_size);
+
+/* Detach the overlay; Unsaved changes in the delta are lost.
+	overlay: The overlay struct */
+void overlay_detach(DISK_OVERLAY* overlay);
+
+/* Save the delta to the delta file
+	overlay: The overlay struct
+	Returns: 0 if success. Otherwise returns 1. */
+int overlay_save(DISK_OVERLAY* overlay);
+
+/* Apply the delta to a buffer
+	overlay: The overlay struct
+	buffer: the buffer to apply the delta to. (base image or a copy of it)
+	buffer_size: the size of the buffer */
+void overlay_apply(DISK_OVERLAY* overlay, uint8_t* buffer, size_t buffer_size);
+
+/* Discard all sectors in the delta. Reads fall through to the base image again.
+	overlay: The overlay struct */
+void overlay_discard(DISK_OVERLAY* overlay);
+
+/* Read a byte through the overlay
+	overlay: The overlay struct
+	base: the base image
+	offset: the byte offset
+	Returns: the byte from the delta if the sector was written. Otherwise the byte from the base image */
+uint8_t overlay_read_byte(DISK_OVERLAY* overlay, const uint8_t* base, size_t offset);
+
+/* Write a byte through the overlay; copies the base sector into the delta on first write.
+	overlay: The overlay struct
+	base: the base image
+	offset: the byte offset
+	value: the value to write
+	Returns: 0 if success. Otherwise returns 1. (malloc error) */
+int overlay_write_byte(DISK_OVERLAY* overlay, const uint8_t* base, size_t offset, uint8_t value);
+
+/* Get a sector from the delta; For bases that are not held in a buffer
+	overlay: The overlay struct
+	offset: a byte offset in the sector
+	Returns: the sector data if the sector was written. Otherwise NULL */
+uint8_t* overlay_get_sector(DISK_OVERLAY* overlay, size_t offset);
+
+/* Write a byte through the overlay; For bases that are not held in a buffer
+	overlay: The overlay struct
+	sector_data: the base content of the sector containing offset; copied into the delta on first write.
+	offset: the byte offset
+	value: the value to write
+	Returns: 0 if success. Otherwise returns 1. (malloc error) */
+int overlay_write_byte_sector(DISK_OVERLAY* overlay, const uint8_t* sector_data, size_t offset, uint8_t value);
+
+#endif
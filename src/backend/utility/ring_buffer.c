@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 #include <malloc.h>
+#include <string.h>
 
 #include "ring_buffer.h"
 
@@ -89,3 +90,101 @@ int ring_buffer_discard(RING_BUFFER* rb, int amount) {
 
 	return 0;
 }
+
+void ring_buffer_save_state(RING_BUFFER* rb, RING_BUFFER_STATE* state) {
+	int skip = rb->count > RING_BUFFER_STATE_SIZE ? rb->count - RING_BUFFER_STATE_SIZE : 0;
+	state->count = rb->count - skip;
+	for (int i = 0; i < state->count; ++i) {
+		ring_buffer_peek(rb, skip + i, &state->items[i]);
+	}
+}
+void ring_buffer_load_state(RING_BUFFER* rb, const RING_BUFFER_STATE* state) {
+	ring_buffer_reset(rb);
+	for (int i = 0; i < state->count; ++i) {
+		ring_buffer_push(rb, state->items[i]);
+	}
+}
+
+int spsc_ring_buffer_create(SPSC_RING_BUFFER* rb, uint32_t capacity, uint32_t item_size) {
+	if (rb == NULL || capacity == 0 || item_size == 0) {
+		return 1;
+	}
+
+	/* power of 2 so the wrapping head/tail counters can be masked */
+	uint32_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+
+	rb->buffer = calloc(size, item_size);
+	if (rb->buffer == NULL) {
+		return 1;
+	}
+
+	rb->capacity = size;
+	rb->item_size = item_size;
+	atomic32_store(&rb->head, 0);
+	atomic32_store(&rb->tail, 0);
+	return 0;
+}
+void spsc_ring_buffer_destroy(SPSC_RING_BUFFER* rb) {
+	if (rb != NULL) {
+
+		if (rb->buffer != NULL) {
+			free(rb->buffer);
+			rb->buffer = NULL;
+		}
+
+		rb->capacity = 0;
+		rb->item_size = 0;
+		atomic32_store(&rb->head, 0);
+		atomic32_store(&rb->tail, 0);
+	}
+}
+
+void spsc_ring_buffer_clear(SPSC_RING_BUFFER* rb) {
+	/* Only the consumer moves the head */
+	atomic32_store(&rb->head, atomic32_load(&rb->tail));
+}
+
+int spsc_ring_buffer_push(SPSC_RING_BUFFER* rb, const void* item) {
+	const uint32_t tail = (uint32_t)atomic32_load(&rb->tail);
+	const uint32_t head = (uint32_t)atomic32_load(&rb->head);
+	if (tail - head >= rb->capacity) {
+		return 1; /* full */
+	}
+
+	/* Write the item before publishing the tail */
+	memcpy(rb->buffer + (tail & (rb->capacity - 1)) * rb->item_size, item, rb->item_size);
+	atomic32_store(&rb->tail, (int32_t)(tail + 1));
+	return 0;
+}
+int spsc_ring_buffer_pop(SPSC_RING_BUFFER* rb, void* item) {
+	const uint32_t head = (uint32_t)atomic32_load(&rb->head);
+	const uint32_t tail = (uint32_t)atomic32_load(&rb->tail);
+	if (head == tail) {
+		return 1; /* empty */
+	}
+
+	/* Read the item before releasing the slot */
+	if (item != NULL) {
+		memcpy(item, rb->buffer + (head & (rb->capacity - 1)) * rb->item_size, rb->item_size);
+	}
+	atomic32_store(&rb->head, (int32_t)(head + 1));
+	return 0;
+}
+int spsc_ring_buffer_peek(SPSC_RING_BUFFER* rb, uint32_t head_offset, void* item) {
+	const uint32_t head = (uint32_t)atomic32_load(&rb->head);
+	const uint32_t tail = (uint32_t)atomic32_load(&rb->tail);
+	if (head_offset >= tail - head) {
+		return 1;
+	}
+
+	memcpy(item, rb->buffer + ((head + head_offset) & (rb->capacity - 1)) * rb->item_size, rb->item_size);
+	return 0;
+}
+uint32_t spsc_ring_buffer_count(SPSC_RING_BUFFER* rb) {
+	const uint32_t head = (uint32_t)atomic32_load(&rb->head);
+	const uint32_t tail = (uint32_t)atomic32_load(&rb->tail);
+	return tail - head;
+}
@@ -6,6 +6,10 @@
 #ifndef RING_BUFFER_H
 #define RING_BUFFER_H
 
+#include <stdint.h>
+
+#include "backend/utility/atomic.h"
+
 /* Ring Buffer Struct */
 typedef struct RING_BUFFER {
 	uint8_t* buffer;
@@ -58,4 +62,70 @@ int ring_buffer_is_empty(RING_BUFFER* rb);
 	Returns: 0 if success. Otherwise returns 1. (rb NULL, amount < 0) */
 int ring_buffer_discard(RING_BUFFER* rb, int amount);
 
+/* Ring Buffer contents for a snapshot */
+#define RING_BUFFER_STATE_SIZE 32
+typedef struct RING_BUFFER_STATE {
+	uint8_t items[RING_BUFFER_STATE_SIZE]; /* oldest first */
+	int count;
+} RING_BUFFER_STATE;
+
+/* Save the items in the buffer. Buffers larger than RING_BUFFER_STATE_SIZE keep the newest items
+	rb: The ring buffer struct
+	state: the state to save to */
+void ring_buffer_save_state(RING_BUFFER* rb, RING_BUFFER_STATE* state);
+
+/* Replace the items in the buffer
+	rb: The ring buffer struct
+	state: the state to load */
+void ring_buffer_load_state(RING_BUFFER* rb, const RING_BUFFER_STATE* state);
+
+/* Single producer, single consumer ring buffer. Lock-free; 
+ * the producer and the consumer may be on different threads.
+ * The producer owns the tail, the consumer owns the head. */
+typedef struct SPSC_RING_BUFFER {
+	uint8_t* buffer;
+	uint32_t item_size;
+	uint32_t capacity;  /* items; power of 2 */
+	ATOMIC32 head;      /* items popped; wraps */
+	ATOMIC32 tail;      /* items pushed; wraps */
+} SPSC_RING_BUFFER;
+
+/* Init the buffer; Allocs the buffer of <capacity> items of <item_size> bytes
+	rb: The ring buffer struct
+	capacity: the max item count; rounded up to a power of 2
+	item_size: the item size in bytes
+	Returns: 0 if success. Otherwise returns 1. (malloc error, rb NULL) */
+int spsc_ring_buffer_create(SPSC_RING_BUFFER* rb, uint32_t capacity, uint32_t item_size);
+
+/* Destroy the buffer; No other thread may be using the buffer
+	rb: The ring buffer struct */
+void spsc_ring_buffer_destroy(SPSC_RING_BUFFER* rb);
+
+/* Discard all items; Consumer thread
+	rb: The ring buffer struct */
+void spsc_ring_buffer_clear(SPSC_RING_BUFFER* rb);
+
+/* Push an item to the tail; Producer thread
+	rb: The ring buffer struct
+	item: the item to push; item_size bytes
+	Returns: 0 if success. 1 if the buffer is full (the item is dropped) */
+int spsc_ring_buffer_push(SPSC_RING_BUFFER* rb, const void* item);
+
+/* Pop the item off of the head; Consumer thread
+	rb: The ring buffer struct
+	item: the item popped; item_size bytes. Can be NULL ie; Dont return the item.
+	Returns: 0 if success. 1 if the buffer is empty */
+int spsc_ring_buffer_pop(SPSC_RING_BUFFER* rb, void* item);
+
+/* Peek at the item at head + offset; Consumer thread
+	rb: The ring buffer struct
+	head_offset: the offset from the head to peek at.
+	item: the item at the offset; item_size bytes.
+	Returns: 0 if the offset is in the vaild range of the queue. Otherwise returns 1. */
+int spsc_ring_buffer_peek(SPSC_RING_BUFFER* rb, uint32_t head_offset, void* item);
+
+/* Get the item count; a snapshot if called from the other thread
+	rb: The ring buffer struct */
+uint32_t spsc_ring_buffer_count(SPSC_RING_BUFFER* rb);
+
 #endif
@@ -0,0 +1,171 @@
+/* trace.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Trace events; scoped begin/end and guest events recorded per thread, written as Chrome trace_event JSON
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "trace.h"
+#include "atomic.h"
+#include "backend/timing.h"
+
+/* Each thread records into its own ring; recording takes no lock. The ring is allocated by the thread on its first event.
+ * The rings are read when tracing stops, after the threads have stopped. */
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define LOG_CATEGORY LOG_CAT_TOOLS
+#include "log.h"
+
+typedef struct TRACE_RING {
+	TRACE_EVENT* events;
+	uint32_t count;        /* events recorded; the ring holds the last TRACE_RING_EVENTS */
+	const char* thread_name;
+} TRACE_RING;
+
+uint32_t trace_mask = 0;
+
+static TRACE_RING rings[TRACE_MAX_THREADS];
+static ATOMIC32 ring_count = 0;
+static uint64_t start_ns = 0;
+
+static THREAD_LOCAL int thread_ring = 0; /* ring index + 1; 0 = not registered, -1 = no ring */
+
+static TRACE_RING* get_ring(void) {
+	if (thread_ring > 0) {
+		return &rings[thread_ring - 1];
+	}
+	if (thread_ring < 0) {
+		return NULL;
+	}
+
+	int32_t index = atomic32_fetch_add(&ring_count, 1);
+	if (index >= TRACE_MAX_THREADS) {
+		thread_ring = -1;
+		return NULL;
+	}
+
+	TRACE_RING* ring = &rings[index];
+	ring->events = calloc(TRACE_RING_EVENTS, sizeof(TRACE_EVENT));
+	if (ring->events == NULL) {
+		log_error("[TRACE] Failed to allocate the event ring\n");
+		thread_ring = -1;
+		return NULL;
+	}
+	thread_ring = index + 1;
+	return ring;
+}
+
+int trace_create(uint32_t mask) {
+	memset(rings, 0, sizeof(rings));
+	atomic32_store(&ring_count, 0);
+	start_ns = timing_get_ticks_ns();
+	trace_mask = mask;
+	return 0;
+}
+
+void trace_destroy(void) {
+	trace_mask = 0;
+	int32_t count = atomic32_load(&ring_count);
+	for (int32_t i = 0; i < count && i < TRACE_MAX_THREADS; ++i) {
+		if (rings[i].events != NULL) {
+			free(rings[i].events);
+			rings[i].events = NULL;
+		}
+	}
+	atomic32_store(&ring_count, 0);
+}
+
+void trace_set_thread_name(const char* name) {
+	if (trace_mask == 0) {
+		return;
+	}
+	TRACE_RING* ring = get_ring();
+	if (ring != NULL) {
+		ring->thread_name = name;
+	}
+}
+
+void trace_event(char phase, const char* name, const char* arg_name, uint32_t arg, uint8_t id) {
+	TRACE_RING* ring = get_ring();
+	if (ring == NULL) {
+		return;
+	}
+	TRACE_EVENT* e = &ring->events[ring->count & (TRACE_RING_EVENTS - 1)];
+	e->ns = timing_get_ticks_ns();
+	e->name = name;
+	e->arg_name = arg_name;
+	e->arg = arg;
+	e->phase = phase;
+	e->id = id;
+	ring->count++;
+}
+
+static void write_event(FILE* file, const TRACE_EVENT* e, int tid, int* first) {
+	double ts = (e->ns - start_ns) / 1000.0; /* us */
+	fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"ibm_pc\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", *first ? "" : ",", e->name, e->phase, ts, tid);
+	if (e->phase == TRACE_PHASE_INSTANT) {
+		fprintf(file, ",\"s\":\"t\"");
+	}
+	if (e->phase == TRACE_PHASE_ASYNC_BEGIN || e->phase == TRACE_PHASE_ASYNC_END) {
+		fprintf(file, ",\"id\":%u", e->id);
+	}
+	if (e->arg_name != NULL) {
+		fprintf(file, ",\"args\":{\"%s\":%u}", e->arg_name, e->arg);
+	}
+	fprintf(file, "}");
+	*first = 0;
+}
+
+int trace_write_json(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		log_error("[TRACE] Failed to open %s\n", path);
+		return 1;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	int first = 1;
+	int32_t count = atomic32_load(&ring_count);
+	for (int32_t i = 0; i < count && i < TRACE_MAX_THREADS; ++i) {
+		TRACE_RING* ring = &rings[i];
+		if (ring->events == NULL) {
+			continue;
+		}
+
+		int tid = i + 1;
+		if (ring->thread_name != NULL) {
+			fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",", tid, ring->thread_name);
+			first = 0;
+		}
+
+		/* oldest first; an end whose begin was overwritten is dropped */
+		uint32_t start = (ring->count > TRACE_RING_EVENTS) ? ring->count - TRACE_RING_EVENTS : 0;
+		int depth = 0;
+		for (uint32_t j = start; j < ring->count; ++j) {
+			const TRACE_EVENT* e = &ring->events[j & (TRACE_RING_EVENTS - 1)];
+			if (e->phase == TRACE_PHASE_BEGIN) {
+				depth++;
+			}
+			else if (e->phase == TRACE_PHASE_END) {
+				if (depth == 0) {
+					continue;
+				}
+				depth--;
+			}
+			write_event(file, e, tid, &first);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	log_info("[TRACE] Wrote %s\n", path);
+	return 0;
+}
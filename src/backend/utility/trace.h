@@ -0,0 +1,85 @@
+/* trace.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Trace events; scoped begin/end and guest events recorded per thread, written as Chrome trace_event JSON
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/* Comment out to compile the trace points out */
+#define TRACE
+
+#define TRACE_MAX_THREADS 8
+#define TRACE_RING_EVENTS (1 << 18) /* events per thread; the oldest are overwritten */
+
+/* Categories */
+#define TRACE_CAT_FRAME  0x01 /* time slices, display draw, window render */
+#define TRACE_CAT_DEVICE 0x02 /* device updates; every step */
+#define TRACE_CAT_GUEST  0x04 /* irq raise/ack, fdc commands, dma terminal count */
+#define TRACE_CAT_ALL    (TRACE_CAT_FRAME | TRACE_CAT_DEVICE | TRACE_CAT_GUEST)
+
+/* Async event ids; guest operations that span many steps */
+#define TRACE_ID_FDC   1
+#define TRACE_ID_XEBEC 2
+
+/* Event phase; Chrome trace_event ph */
+#define TRACE_PHASE_BEGIN       'B'
+#define TRACE_PHASE_END         'E'
+#define TRACE_PHASE_INSTANT     'i'
+#define TRACE_PHASE_ASYNC_BEGIN 'b'
+#define TRACE_PHASE_ASYNC_END   'e'
+
+typedef struct TRACE_EVENT {
+	uint64_t ns;          /* host time */
+	const char* name;     /* string literal */
+	const char* arg_name; /* string literal; NULL = no arg */
+	uint32_t arg;
+	char phase;           /* TRACE_PHASE_XXX */
+	uint8_t id;           /* async id */
+} TRACE_EVENT;
+
+/* Enabled categories; 0 = tracing disabled */
+extern uint32_t trace_mask;
+
+/* Start tracing
+	mask: the categories to record; TRACE_CAT_XXX
+	Returns: 0 if success. Otherwise 1 */
+int trace_create(uint32_t mask);
+
+/* Stop tracing and free the rings; the threads that recorded must have stopped */
+void trace_destroy(void);
+
+/* Name the calling thread in the trace
+	name: string literal */
+void trace_set_thread_name(const char* name);
+
+/* Record an event on the calling thread
+	phase: TRACE_PHASE_XXX
+	name: string literal
+	arg_name: string literal; NULL = no arg
+	arg: the arg value
+	id: the async id; 0 if not async */
+void trace_event(char phase, const char* name, const char* arg_name, uint32_t arg, uint8_t id);
+
+/* Write the recorded events as Chrome trace_event JSON; load in chrome://tracing or ui.perfetto.dev
+	path: the file to write
+	Returns: 0 if success. Otherwise 1 */
+int trace_write_json(const char* path);
+
+#ifdef TRACE
+#define TRACE_BEGIN(cat, name)                    do { if (trace_mask & (cat)) trace_event(TRACE_PHASE_BEGIN, name, NULL, 0, 0); } while (0)
+#define TRACE_END(cat, name)                      do { if (trace_mask & (cat)) trace_event(TRACE_PHASE_END, name, NULL, 0, 0); } while (0)
+#define TRACE_INSTANT(cat, name, arg_name, arg)   do { if (trace_mask & (cat)) trace_event(TRACE_PHASE_INSTANT, name, arg_name, arg, 0); } while (0)
+#define TRACE_ASYNC_BEGIN(cat, name, id, arg_name, arg) do { if (trace_mask & (cat)) trace_event(TRACE_PHASE_ASYNC_BEGIN, name, arg_name, arg, id); } while (0)
+#define TRACE_ASYNC_END(cat, name, id)            do { if (trace_mask & (cat)) trace_event(TRACE_PHASE_ASYNC_END, name, NULL, 0, id); } while (0)
+#else
+#define TRACE_BEGIN(cat, name)
+#define TRACE_END(cat, name)
+#define TRACE_INSTANT(cat, name, arg_name, arg)
+#define TRACE_ASYNC_BEGIN(cat, name, id, arg_name, arg)
+#define TRACE_ASYNC_END(cat, name, id)
+#endif
+
+#endif
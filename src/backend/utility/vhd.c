@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 #include <malloc.h>
+#include <string.h>
 
 #include "vhd.h"
 #include "lba.h"
@@ -26,12 +27,18 @@
 #define VHD_DISK_TYPE_REV2             0x00000006
 
 #define VHD_COOKIE      0x636F6E6563746978 /* 'conectix' */
+#define VHD_DYN_COOKIE  0x6378737061727365 /* 'cxsparse' */
 
 #define VHD_FORMAT_VER  0x00010000 /* 1.0 */
 
 #define VHD_CREATOR_APP 0x544F4D4F /* 'TOMO' */
 #define VHD_CREATOR_VER 0x00010000 /* 1.0 */
 
+#define VHD_DYN_HEADER_VER 0x00010000 /* 1.0 */
+#define VHD_BLOCK_SIZE     0x00200000 /* 2MB; default block size of a dynamic disk */
+#define VHD_BAT_UNUSED     0xFFFFFFFF /* Block is not allocated */
+#define VHD_SECTOR_SIZE    512
+
 typedef struct VHD_FOOTER {
     uint64_t cookie;              /* Used to uniquely identify the original creator of the hard disk image. */
     uint32_t features;            /* Used to indicate specific feature support. */
@@ -53,6 +60,32 @@ typedef struct VHD_FOOTER {
 
 static_assert(sizeof(VHD_FOOTER) == 512, "VHD_FOOTER not 512 bytes");
 
+typedef struct VHD_PARENT_LOCATOR {
+    uint32_t platform_code;
+    uint32_t platform_data_space;
+    uint32_t platform_data_length;
+    uint32_t reserved;
+    uint64_t platform_data_offset;
+} VHD_PARENT_LOCATOR;
+
+typedef struct VHD_DYNAMIC_HEADER {
+    uint64_t cookie;                         /* Holds the value 'cxsparse'. */
+    uint64_t data_offset;                    /* Unused. Should be set to 0xFFFFFFFFFFFFFFFF. */
+    uint64_t table_offset;                   /* Absolute byte offset of the Block Allocation Table (BAT) in the file. */
+    uint32_t header_version;                 /* Must be initialized to 0x00010000. */
+    uint32_t max_table_entries;              /* Maximum entries present in the BAT. */
+    uint32_t block_size;                     /* Size of the data section of a block. Does not include the sector bitmap. */
+    uint32_t checksum;                       /* Checksum of the dynamic header. */
+    uint8_t parent_unique_id[16];            /* Differencing disks only. */
+    uint32_t parent_timestamp;               /* Differencing disks only. */
+    uint32_t reserved1;
+    uint16_t parent_unicode_name[256];       /* Differencing disks only. */
+    VHD_PARENT_LOCATOR parent_locator[8];    /* Differencing disks only. */
+    uint8_t reserved2[256];
+} VHD_DYNAMIC_HEADER;
+
+static_assert(sizeof(VHD_DYNAMIC_HEADER) == 1024, "VHD_DYNAMIC_HEADER not 1024 bytes");
+
 static uint8_t byte_swap8(uint8_t v) {
     return v;
 }
@@ -83,24 +116,41 @@ static uint32_t calculate_checksum(const VHD_FOOTER* footer) {
     return ~checksum;
 }
 
-int vhd_create(CHS geometry, uint8_t** buffer, size_t* buffer_size) {
+static uint32_t calculate_dynamic_checksum(const VHD_DYNAMIC_HEADER* header) {
+    uint32_t checksum = 0;
+    for (int i = 0; i < sizeof(VHD_DYNAMIC_HEADER); ++i) {
+        if (i >= 0x24 && i < 0x28) {
+            continue; /* ignore checksum bits */
+        }
+        checksum += ((uint8_t*)header)[i];
+    }
+    return ~checksum;
+}
 
-    size_t total_sectors = (size_t)geometry.c * geometry.h * geometry.s;
-    size_t total_bytes = total_sectors * 512;
-    size_t total_size = total_bytes + sizeof(VHD_FOOTER);
+static size_t align_sector(size_t size) {
+    return (size + VHD_SECTOR_SIZE - 1) & ~(size_t)(VHD_SECTOR_SIZE - 1);
+}
 
-    uint8_t* vhd = calloc(1, total_size);
-    if (vhd == NULL) {
-        return 1;
-    }
+/* Size of the sector bitmap at the start of each block. padded to a sector boundary */
+static size_t get_bitmap_size(uint32_t block_size) {
+    return align_sector(block_size / VHD_SECTOR_SIZE / 8);
+}
 
-    VHD_FOOTER* footer = (VHD_FOOTER*)(vhd + total_bytes);
+static VHD_FOOTER* get_footer(uint8_t* buffer, size_t buffer_size) {
+    return (VHD_FOOTER*)(buffer + buffer_size - sizeof(VHD_FOOTER));
+}
 
+static VHD_DYNAMIC_HEADER* get_dynamic_header(uint8_t* buffer, size_t buffer_size) {
+    VHD_FOOTER* footer = get_footer(buffer, buffer_size);
+    return (VHD_DYNAMIC_HEADER*)(buffer + byte_swap64(footer->data_offset));
+}
+
+static void init_footer(VHD_FOOTER* footer, CHS geometry, size_t total_bytes, uint32_t disk_type, uint64_t data_offset) {
     /* VHD Footer is written in big-endian */
     footer->cookie = byte_swap64(VHD_COOKIE);                   // 'conectix'
     footer->features = byte_swap32(VHD_FEATURE_RESERVED);
     footer->file_format_version = byte_swap32(VHD_FORMAT_VER);  // 1.0
-    footer->data_offset = byte_swap64(0xFFFFFFFFFFFFFFFF);
+    footer->data_offset = byte_swap64(data_offset);
     footer->timestamp = byte_swap32(0);
     footer->creator_application = byte_swap32(VHD_CREATOR_APP); // 'TOMO'
     footer->creator_version = byte_swap32(VHD_CREATOR_VER);     // 1.0
@@ -110,9 +160,63 @@ int vhd_create(CHS geometry, uint8_t** buffer, size_t* buffer_size) {
     footer->disk_geometry.c = byte_swap16(geometry.c);
     footer->disk_geometry.h = byte_swap8(geometry.h);
     footer->disk_geometry.s = byte_swap8(geometry.s);
-    footer->disk_type = byte_swap32(VHD_DISK_TYPE_FIXED_HDD);
+    footer->disk_type = byte_swap32(disk_type);
     footer->saved_state = byte_swap8(0);
     footer->checksum = byte_swap32(calculate_checksum(footer));
+}
+
+int vhd_create(CHS geometry, uint8_t** buffer, size_t* buffer_size) {
+
+    size_t total_sectors = (size_t)geometry.c * geometry.h * geometry.s;
+    size_t total_bytes = total_sectors * 512;
+    size_t total_size = total_bytes + sizeof(VHD_FOOTER);
+
+    uint8_t* vhd = calloc(1, total_size);
+    if (vhd == NULL) {
+        return 1;
+    }
+
+    VHD_FOOTER* footer = (VHD_FOOTER*)(vhd + total_bytes);
+    init_footer(footer, geometry, total_bytes, VHD_DISK_TYPE_FIXED_HDD, 0xFFFFFFFFFFFFFFFF);
+
+    *buffer = vhd;
+    *buffer_size = total_size;
+    return 0;
+}
+
+int vhd_create_dynamic(CHS geometry, uint8_t** buffer, size_t* buffer_size) {
+
+    size_t total_sectors = (size_t)geometry.c * geometry.h * geometry.s;
+    size_t total_bytes = total_sectors * 512;
+
+    /* Layout: footer copy, dynamic header, BAT, footer. No blocks are allocated until written */
+    uint32_t max_table_entries = (uint32_t)((total_bytes + VHD_BLOCK_SIZE - 1) / VHD_BLOCK_SIZE);
+    size_t header_offset = sizeof(VHD_FOOTER);
+    size_t table_offset = header_offset + sizeof(VHD_DYNAMIC_HEADER);
+    size_t table_size = align_sector((size_t)max_table_entries * sizeof(uint32_t));
+    size_t total_size = table_offset + table_size + sizeof(VHD_FOOTER);
+
+    uint8_t* vhd = calloc(1, total_size);
+    if (vhd == NULL) {
+        return 1;
+    }
+
+    VHD_FOOTER* footer = (VHD_FOOTER*)(vhd + total_size - sizeof(VHD_FOOTER));
+    init_footer(footer, geometry, total_bytes, VHD_DISK_TYPE_DYNAMIC_HDD, header_offset);
+    memcpy(vhd, footer, sizeof(VHD_FOOTER));
+
+    /* Dynamic header is written in big-endian */
+    VHD_DYNAMIC_HEADER* header = (VHD_DYNAMIC_HEADER*)(vhd + header_offset);
+    header->cookie = byte_swap64(VHD_DYN_COOKIE);                    // 'cxsparse'
+    header->data_offset = byte_swap64(0xFFFFFFFFFFFFFFFF);
+    header->table_offset = byte_swap64(table_offset);
+    header->header_version = byte_swap32(VHD_DYN_HEADER_VER);        // 1.0
+    header->max_table_entries = byte_swap32(max_table_entries);
+    header->block_size = byte_swap32(VHD_BLOCK_SIZE);
+    header->checksum = byte_swap32(calculate_dynamic_checksum(header));
+
+    /* BAT; all blocks unallocated. padding is also 0xFF */
+    memset(vhd + table_offset, 0xFF, table_size);
 
     *buffer = vhd;
     *buffer_size = total_size;
@@ -125,6 +229,53 @@ void vhd_destroy(uint8_t* buffer) {
     }
 }
 
+static int verify_dynamic(uint8_t* buffer, size_t buffer_size) {
+    VHD_FOOTER* footer = get_footer(buffer, buffer_size);
+
+    uint64_t header_offset = byte_swap64(footer->data_offset);
+    if (header_offset + sizeof(VHD_DYNAMIC_HEADER) > buffer_size - sizeof(VHD_FOOTER)) {
+        return 1;
+    }
+
+    VHD_DYNAMIC_HEADER* header = (VHD_DYNAMIC_HEADER*)(buffer + header_offset);
+
+    if (header->cookie != byte_swap64(VHD_DYN_COOKIE)) {
+        return 1;
+    }
+
+    if (header->checksum != byte_swap32(calculate_dynamic_checksum(header))) {
+        return 1;
+    }
+
+    uint32_t block_size = byte_swap32(header->block_size);
+    if (block_size == 0 || (block_size % VHD_SECTOR_SIZE) != 0) {
+        return 1;
+    }
+
+    /* BAT must cover the whole disk */
+    uint32_t max_table_entries = byte_swap32(header->max_table_entries);
+    if ((uint64_t)max_table_entries * block_size < byte_swap64(footer->current_size)) {
+        return 1;
+    }
+
+    uint64_t table_offset = byte_swap64(header->table_offset);
+    if (table_offset + ((uint64_t)max_table_entries * sizeof(uint32_t)) > buffer_size - sizeof(VHD_FOOTER)) {
+        return 1;
+    }
+
+    /* Every allocated block must be inside the file */
+    uint32_t* bat = (uint32_t*)(buffer + table_offset);
+    size_t block_total = get_bitmap_size(block_size) + block_size;
+    for (uint32_t i = 0; i < max_table_entries; ++i) {
+        uint32_t entry = byte_swap32(bat[i]);
+        if (entry != VHD_BAT_UNUSED && ((uint64_t)entry * VHD_SECTOR_SIZE) + block_total > buffer_size - sizeof(VHD_FOOTER)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 int vhd_verify(uint8_t* buffer, size_t buffer_size) {
 
     if (buffer_size < sizeof(VHD_FOOTER)) {
@@ -141,6 +292,10 @@ int vhd_verify(uint8_t* buffer, size_t buffer_size) {
         return 1;
     }
 
+    if (footer->disk_type == byte_swap32(VHD_DISK_TYPE_DYNAMIC_HDD)) {
+        return verify_dynamic(buffer, buffer_size);
+    }
+
     if (footer->disk_type != byte_swap32(VHD_DISK_TYPE_FIXED_HDD)) {
         return 1;
     }
@@ -181,3 +336,115 @@ size_t vhd_get_file_size(uint8_t* buffer, size_t buffer_size) {
 
     return byte_swap64(footer->current_size);
 }
+
+int vhd_is_dynamic(uint8_t* buffer, size_t buffer_size) {
+    if (buffer_size < sizeof(VHD_FOOTER)) {
+        return 0;
+    }
+
+    VHD_FOOTER* footer = get_footer(buffer, buffer_size);
+    return footer->disk_type == byte_swap32(VHD_DISK_TYPE_DYNAMIC_HDD);
+}
+
+uint8_t vhd_read_byte(uint8_t* buffer, size_t buffer_size, size_t offset) {
+    if (!vhd_is_dynamic(buffer, buffer_size)) {
+        return buffer[offset];
+    }
+
+    VHD_DYNAMIC_HEADER* header = get_dynamic_header(buffer, buffer_size);
+    uint32_t block_size = byte_swap32(header->block_size);
+    uint32_t* bat = (uint32_t*)(buffer + byte_swap64(header->table_offset));
+
+    uint32_t entry = byte_swap32(bat[offset / block_size]);
+    if (entry == VHD_BAT_UNUSED) {
+        return 0; /* Unallocated blocks read as zero */
+    }
+
+    /* Sectors not marked in the sector bitmap were never written; they read as zero */
+    uint8_t* block_start = buffer + ((size_t)entry * VHD_SECTOR_SIZE);
+    size_t block_offset = offset % block_size;
+    size_t sector = block_offset / VHD_SECTOR_SIZE;
+    if ((block_start[sector / 8] & (0x80 >> (sector % 8))) == 0) {
+        return 0;
+    }
+
+    return block_start[get_bitmap_size(block_size) + block_offset];
+}
+
+static int allocate_block(uint8_t** buffer, size_t* buffer_size, size_t* buffer_capacity, uint32_t block) {
+    VHD_DYNAMIC_HEADER* header = get_dynamic_header(*buffer, *buffer_size);
+    uint32_t block_size = byte_swap32(header->block_size);
+    uint32_t max_table_entries = byte_swap32(header->max_table_entries);
+    size_t table_offset = (size_t)byte_swap64(header->table_offset);
+    size_t block_total = get_bitmap_size(block_size) + block_size;
+
+    /* The new block goes where the footer was; the footer moves to the end */
+    size_t block_offset = *buffer_size - sizeof(VHD_FOOTER);
+    size_t new_size = *buffer_size + block_total;
+
+    /* The buffer grows geometrically so the image is not copied on every new block;
+     * never past the size of the image with every block allocated */
+    uint8_t* new_buffer = *buffer;
+    if (new_size > *buffer_capacity) {
+        size_t max_size = *buffer_size + ((size_t)max_table_entries * block_total);
+        size_t new_capacity = *buffer_capacity * 2;
+        if (new_capacity > max_size) {
+            new_capacity = max_size;
+        }
+        if (new_capacity < new_size) {
+            new_capacity = new_size;
+        }
+        new_buffer = realloc(*buffer, new_capacity);
+        if (new_buffer == NULL) {
+            return 1;
+        }
+        *buffer_capacity = new_capacity;
+    }
+
+    memmove(new_buffer + new_size - sizeof(VHD_FOOTER), new_buffer + block_offset, sizeof(VHD_FOOTER));
+    memset(new_buffer + block_offset, 0, block_total);
+
+    uint32_t* bat = (uint32_t*)(new_buffer + table_offset);
+    bat[block] = byte_swap32((uint32_t)(block_offset / VHD_SECTOR_SIZE));
+
+    *buffer = new_buffer;
+    *buffer_size = new_size;
+    return 0;
+}
+
+int vhd_write_byte(uint8_t** buffer, size_t* buffer_size, size_t* buffer_capacity, size_t offset, uint8_t value) {
+    if (!vhd_is_dynamic(*buffer, *buffer_size)) {
+        (*buffer)[offset] = value;
+        return 0;
+    }
+
+    VHD_DYNAMIC_HEADER* header = get_dynamic_header(*buffer, *buffer_size);
+    uint32_t block_size = byte_swap32(header->block_size);
+    uint32_t* bat = (uint32_t*)(*buffer + byte_swap64(header->table_offset));
+    uint32_t block = (uint32_t)(offset / block_size);
+
+    if (byte_swap32(bat[block]) == VHD_BAT_UNUSED) {
+        if (value == 0) {
+            return 0; /* Unallocated blocks already read as zero */
+        }
+        if (allocate_block(buffer, buffer_size, buffer_capacity, block)) {
+            return 1;
+        }
+        header = get_dynamic_header(*buffer, *buffer_size);
+        bat = (uint32_t*)(*buffer + byte_swap64(header->table_offset));
+    }
+
+    uint8_t* block_start = *buffer + ((size_t)byte_swap32(bat[block]) * VHD_SECTOR_SIZE);
+    size_t block_offset = offset % block_size;
+
+    /* Mark the sector as present in the sector bitmap; msb first. A sector written for the first time
+     * starts as zero; the file may hold anything there */
+    size_t sector = block_offset / VHD_SECTOR_SIZE;
+    if ((block_start[sector / 8] & (0x80 >> (sector % 8))) == 0) {
+        memset(block_start + get_bitmap_size(block_size) + (sector * VHD_SECTOR_SIZE), 0, VHD_SECTOR_SIZE);
+        block_start[sector / 8] |= 0x80 >> (sector % 8);
+    }
+
+    block_start[get_bitmap_size(block_size) + block_offset] = value;
+    return 0;
+}
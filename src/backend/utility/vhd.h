@@ -7,7 +7,21 @@
 typedef struct CHS CHS;
 
 int vhd_create(CHS geometry, uint8_t** buffer, size_t* buffer_size);
+int vhd_create_dynamic(CHS geometry, uint8_t** buffer, size_t* buffer_size);
 void vhd_destroy(uint8_t* buffer);
 int vhd_verify(uint8_t* buffer, size_t buffer_size);
 CHS vhd_get_geometry(uint8_t* buffer, size_t buffer_size);
 size_t vhd_get_file_size(uint8_t* buffer, size_t buffer_size);
+int vhd_is_dynamic(uint8_t* buffer, size_t buffer_size);
+
+/* Read a byte of disk data. Dynamic disks resolve the offset through the BAT
+	offset: byte offset into the disk data
+	Returns: the byte. Unallocated blocks and sectors not in the sector bitmap read as zero */
+uint8_t vhd_read_byte(uint8_t* buffer, size_t buffer_size, size_t offset);
+
+/* Write a byte of disk data. Dynamic disks allocate the block on first write; the buffer may be reallocated
+	buffer_size: the image size; grows by a block when one is allocated
+	buffer_capacity: the allocated size of the buffer; grows geometrically
+	offset: byte offset into the disk data
+	Returns: 0 if success. Otherwise returns 1. (realloc error) */
+int vhd_write_byte(uint8_t** buffer, size_t* buffer_size, size_t* buffer_capacity, size_t offset, uint8_t value);
@@ -105,6 +105,14 @@ void cga_update(CGA* cga) {
 		if (cga->vcount >= vtotal) {
 			cga->vcount -= vtotal;
 		}
+
+		if (cga->vcount == vsync_pos && vtotal >= CRTC_6845_MIN_FRAME_LINES) {
+			/* blink is counted in frames; 16 on, 16 off */
+			cga->blink = (cga->blink + 1) & 0x1F;
+			if (cga->on_vsync != NULL) {
+				cga->on_vsync(cga);
+			}
+		}
 	}
 
 	// Update status bits
@@ -116,3 +124,7 @@ void cga_update(CGA* cga) {
 		cga->status |= CGA_STATUS_VRETRACE;
 	}	
 }
+
+void cga_set_vsync_cb(CGA* cga, on_vsync_cb on_vsync) {
+	cga->on_vsync = on_vsync;
+}
@@ -118,6 +118,7 @@ typedef struct CGA {
 	uint16_t hcount; /* horizontal pixel position */
 	uint16_t vcount; /* vertical line position */
 	uint64_t accum;  /* cycle accum */
+	on_vsync_cb on_vsync; /* on vsync cb */
 } CGA;
 
 /* hard reset CGA */
@@ -132,4 +133,7 @@ void cga_write_io_byte(CGA* cga, uint8_t io_address, uint8_t value);
 /* CGA Update */
 void cga_update(CGA* cga);
 
+/* Set on vsync callback */
+void cga_set_vsync_cb(CGA* cga, on_vsync_cb on_vsync);
+
 #endif
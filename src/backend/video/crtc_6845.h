@@ -95,6 +95,12 @@
 /* R17 8bit read-only */
 #define CRTC_6845_LIGHT_PEN_LO 0x11
 
+/* Frames shorter than this are the CRTC being programmed; not a real vsync */
+#define CRTC_6845_MIN_FRAME_LINES 100
+
+/* vsync callback; called with the video adapter at the start of vertical retrace */
+typedef void(*on_vsync_cb)(void* adapter);
+
 /* Cursor Attributes (R10) */
 #define CRTC_6845_CURSOR_ATTR_MASK       0x60 /* Attribute mask */
 #define CRTC_6845_CURSOR_ATTR_SOILD      0x00 /* non-blink */
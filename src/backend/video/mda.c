@@ -88,6 +88,14 @@ void mda_update(MDA* mda) {
 		if (mda->vcount >= vtotal) {
 			mda->vcount -= vtotal;
 		}
+
+		if (mda->vcount == vsync_pos && vtotal >= CRTC_6845_MIN_FRAME_LINES) {
+			/* blink is counted in frames; 16 on, 16 off */
+			mda->blink = (mda->blink + 1) & 0x1F;
+			if (mda->on_vsync != NULL) {
+				mda->on_vsync(mda);
+			}
+		}
 	}
 
 	mda->status &= ~(MDA_STATUS_HRETRACE | MDA_STATUS_VRETRACE);
@@ -98,3 +106,7 @@ void mda_update(MDA* mda) {
 		mda->status |= MDA_STATUS_VRETRACE;
 	}
 }
+
+void mda_set_vsync_cb(MDA* mda, on_vsync_cb on_vsync) {
+	mda->on_vsync = on_vsync;
+}
@@ -49,6 +49,7 @@ typedef struct MDA {
 	uint16_t hcount; /* horizontal pixel position */
 	uint16_t vcount; /* vertical line position */
 	uint64_t accum;  /* cycle accum */
+	on_vsync_cb on_vsync; /* on vsync cb */
 } MDA;
 
 /* hard reset mda */
@@ -63,4 +64,7 @@ void mda_write_io_byte(MDA* mda, uint8_t io_address, uint8_t value);
 /* MDA Update */
 void mda_update(MDA* mda);
 
+/* Set on vsync callback */
+void mda_set_vsync_cb(MDA* mda, on_vsync_cb on_vsync);
+
 #endif
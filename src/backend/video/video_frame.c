@@ -0,0 +1,43 @@
+/* video_frame.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Video frame snapshot; triple buffered handoff from the emulation thread to the render thread
+ */
+
+#include <stdint.h>
+
+#include "video_frame.h"
+#include "backend/utility/atomic.h"
+
+#define VIDEO_FRAME_INDEX_MASK 0x03
+#define VIDEO_FRAME_FRESH      0x04 /* middle holds a frame the reader has not seen */
+
+void video_frame_buffer_reset(VIDEO_FRAME_BUFFER* buffer) {
+	buffer->back = 0;
+	atomic32_store(&buffer->middle, 1);
+	buffer->front = 2;
+	buffer->published = 0;
+}
+
+VIDEO_FRAME* video_frame_buffer_get_back(VIDEO_FRAME_BUFFER* buffer) {
+	return &buffer->frames[buffer->back];
+}
+
+void video_frame_buffer_publish(VIDEO_FRAME_BUFFER* buffer) {
+	/* Swap back and middle; the old middle is reused if the reader never took it */
+	buffer->published++;
+	int32_t middle = atomic32_exchange(&buffer->middle, buffer->back | VIDEO_FRAME_FRESH);
+	buffer->back = middle & VIDEO_FRAME_INDEX_MASK;
+}
+
+int video_frame_buffer_is_fresh(VIDEO_FRAME_BUFFER* buffer) {
+	return (atomic32_load(&buffer->middle) & VIDEO_FRAME_FRESH) != 0;
+}
+
+const VIDEO_FRAME* video_frame_buffer_acquire(VIDEO_FRAME_BUFFER* buffer) {
+	/* Swap front and middle if there is a new frame; otherwise keep rendering front */
+	if (atomic32_load(&buffer->middle) & VIDEO_FRAME_FRESH) {
+		int32_t middle = atomic32_exchange(&buffer->middle, buffer->front);
+		buffer->front = middle & VIDEO_FRAME_INDEX_MASK;
+	}
+	return &buffer->frames[buffer->front];
+}
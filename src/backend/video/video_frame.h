@@ -0,0 +1,52 @@
+/* video_frame.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Video frame snapshot; triple buffered handoff from the emulation thread to the render thread
+ */
+
+#ifndef VIDEO_FRAME_H
+#define VIDEO_FRAME_H
+
+#include <stdint.h>
+
+#include "mda.h"
+#include "cga.h"
+#include "backend/utility/atomic.h"
+
+#define VIDEO_FRAME_VRAM_SIZE (CGA_MM_ADDRESS_MASK + 1) /* largest adapter; 16K */
+#define VIDEO_FRAME_COUNT     3
+
+/* A consistent copy of the video adapter state at vsync */
+typedef struct VIDEO_FRAME {
+	uint8_t video_adapter; /* VIDEO_ADAPTER_XXX */
+	uint32_t frame;        /* vsync count */
+	uint64_t ticks_ms;     /* emulated time at vsync; virtual clock */
+	MDA mda;               /* MDA registers; valid if video_adapter is MDA */
+	CGA cga;               /* CGA registers; valid if video_adapter is CGA */
+	uint8_t vram[VIDEO_FRAME_VRAM_SIZE];
+} VIDEO_FRAME;
+
+/* Triple buffer. The writer owns back, the reader owns front. middle is swapped atomically */
+typedef struct VIDEO_FRAME_BUFFER {
+	VIDEO_FRAME frames[VIDEO_FRAME_COUNT];
+	ATOMIC32 middle; /* index of the shared frame | VIDEO_FRAME_FRESH */
+	uint8_t back;    /* frame being written; emulation thread */
+	uint8_t front;   /* frame being rendered; render thread */
+	uint32_t published;
+} VIDEO_FRAME_BUFFER;
+
+void video_frame_buffer_reset(VIDEO_FRAME_BUFFER* buffer);
+
+/* Get the frame to write the next snapshot to; Emulation thread */
+VIDEO_FRAME* video_frame_buffer_get_back(VIDEO_FRAME_BUFFER* buffer);
+
+/* Publish the back frame; Emulation thread. Never blocks */
+void video_frame_buffer_publish(VIDEO_FRAME_BUFFER* buffer);
+
+/* Has a frame been published since the last acquire; Render thread */
+int video_frame_buffer_is_fresh(VIDEO_FRAME_BUFFER* buffer);
+
+/* Get the latest published frame; Render thread. Never blocks
+	Returns: the frame; valid until the next call */
+const VIDEO_FRAME* video_frame_buffer_acquire(VIDEO_FRAME_BUFFER* buffer);
+
+#endif
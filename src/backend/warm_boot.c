@@ -0,0 +1,117 @@
+/* warm_boot.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Warm boot cache; a snapshot of the machine after POST keyed by a hash of the machine config
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdio.h>
+
+#include "warm_boot.h"
+
+#include "frontend/utility/file.h"
+
+/* File format:
+ * "PCW1", key (u64), state size (u32), memory size (u32), state, memory.
+ * The state size changes with the build; a cache from another build is not loaded. */
+
+#define WARM_BOOT_MAGIC       "PCW1"
+#define WARM_BOOT_MAGIC_SIZE  4
+#define WARM_BOOT_HEADER_SIZE (WARM_BOOT_MAGIC_SIZE + 8 + 4 + 4)
+
+#define FNV_PRIME 0x100000001B3ULL
+
+#define LOG_CATEGORY LOG_CAT_MAIN
+#include "utility/log.h"
+
+static void put_u32(uint8_t* buffer, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static void put_u64(uint8_t* buffer, uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		buffer[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+static uint32_t get_u32(const uint8_t* buffer) {
+	uint32_t value = 0;
+	for (int i = 0; i < 4; ++i) {
+		value |= (uint32_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+static uint64_t get_u64(const uint8_t* buffer) {
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value |= (uint64_t)buffer[i] << (i * 8);
+	}
+	return value;
+}
+
+uint64_t warm_boot_hash(uint64_t hash, const void* data, size_t size) {
+	const uint8_t* bytes = data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+void warm_boot_get_path(char* path, size_t path_size, const char* dir, uint64_t key) {
+	snprintf(path, path_size, "%s/%016llX.pcw", dir, (unsigned long long)key);
+}
+
+int warm_boot_save(const char* path, uint64_t key, const void* state, size_t state_size, const uint8_t* mem, uint32_t mem_size) {
+	size_t size = WARM_BOOT_HEADER_SIZE + state_size + mem_size;
+	uint8_t* buffer = malloc(size);
+	if (buffer == NULL) {
+		log_error("[WARM BOOT] Failed to allocate %zu bytes\n", size);
+		return 1;
+	}
+
+	memcpy(buffer, WARM_BOOT_MAGIC, WARM_BOOT_MAGIC_SIZE);
+	put_u64(buffer + WARM_BOOT_MAGIC_SIZE, key);
+	put_u32(buffer + WARM_BOOT_MAGIC_SIZE + 8, (uint32_t)state_size);
+	put_u32(buffer + WARM_BOOT_MAGIC_SIZE + 12, mem_size);
+	memcpy(buffer + WARM_BOOT_HEADER_SIZE, state, state_size);
+	memcpy(buffer + WARM_BOOT_HEADER_SIZE + state_size, mem, mem_size);
+
+	int error = file_write_from_buffer(path, buffer, size);
+	free(buffer);
+	if (!error) {
+		log_info("[WARM BOOT] Saved %s\n", path);
+	}
+	return error;
+}
+
+int warm_boot_load(const char* path, uint64_t key, void* state, size_t state_size, uint8_t* mem, uint32_t mem_size) {
+	size_t size = 0;
+	if (!file_get_file_size(path, &size)) {
+		return 1; /* not cached */
+	}
+
+	void* buffer = NULL;
+	if (file_read_alloc_buffer(path, &buffer, &size)) {
+		return 1; /* file_read_alloc_buffer() reports errors to console */
+	}
+
+	const uint8_t* bytes = buffer;
+	if (size != WARM_BOOT_HEADER_SIZE + state_size + mem_size ||
+		memcmp(bytes, WARM_BOOT_MAGIC, WARM_BOOT_MAGIC_SIZE) != 0 ||
+		get_u64(bytes + WARM_BOOT_MAGIC_SIZE) != key ||
+		get_u32(bytes + WARM_BOOT_MAGIC_SIZE + 8) != state_size ||
+		get_u32(bytes + WARM_BOOT_MAGIC_SIZE + 12) != mem_size) {
+		log_warn("[WARM BOOT] %s does not match this build/config; cold booting\n", path);
+		free(buffer);
+		return 1;
+	}
+
+	memcpy(state, bytes + WARM_BOOT_HEADER_SIZE, state_size);
+	memcpy(mem, bytes + WARM_BOOT_HEADER_SIZE + state_size, mem_size);
+	free(buffer);
+	log_info("[WARM BOOT] Loaded %s\n", path);
+	return 0;
+}
@@ -0,0 +1,50 @@
+/* warm_boot.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Warm boot cache; a snapshot of the machine after POST keyed by a hash of the machine config
+ */
+
+#ifndef WARM_BOOT_H
+#define WARM_BOOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WARM_BOOT_HASH_INIT 0xCBF29CE484222325ULL /* FNV-1a 64 offset basis */
+
+#define WARM_BOOT_INT_DEFAULT 0x19 /* INT 19h; bootstrap loader */
+
+/* Hash data into a key; FNV-1a 64
+	hash: the hash so far; WARM_BOOT_HASH_INIT to start
+	data: the data
+	size: the data size
+	Returns: the new hash */
+uint64_t warm_boot_hash(uint64_t hash, const void* data, size_t size);
+
+/* Get the cache file for a key
+	path: the buffer to write the path to
+	path_size: the buffer size
+	dir: the cache directory
+	key: the config key */
+void warm_boot_get_path(char* path, size_t path_size, const char* dir, uint64_t key);
+
+/* Write a snapshot to the cache
+	path: the cache file
+	key: the config key
+	state: the device state
+	state_size: the device state size
+	mem: the memory buffer
+	mem_size: the memory buffer size
+	Returns: 0 if success. Otherwise 1 */
+int warm_boot_save(const char* path, uint64_t key, const void* state, size_t state_size, const uint8_t* mem, uint32_t mem_size);
+
+/* Read a snapshot from the cache
+	path: the cache file
+	key: the config key
+	state: the device state to read to
+	state_size: the device state size
+	mem: the memory buffer to read to
+	mem_size: the memory buffer size
+	Returns: 0 if success. 1 if there is no snapshot for the key */
+int warm_boot_load(const char* path, uint64_t key, void* state, size_t state_size, uint8_t* mem, uint32_t mem_size);
+
+#endif
@@ -9,22 +9,20 @@
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_video.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "sdl3_common.h"
 #include "sdl3_window.h"
 #include "sdl3_timing.h"
+#include "sdl3_emulation.h"
 
 #include "dbg_gui.h"
 
 #include "backend/ibm_pc.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
 
 enum {
 	IRQ_TIMER0 = 0x00,
@@ -64,6 +62,16 @@ double avg_frame_timer_get(const AVG_FRAME_TIMER* t) {
 
 void print_timer(int i, I8253_TIMER* timer, char* str);
 
+static void queue_text(DBG_GUI* gui, float x, float y) {
+	if (gui->line_count >= DBG_GUI_LINES) {
+		return;
+	}
+	DBG_GUI_LINE* line = &gui->lines[gui->line_count++];
+	line->x = x;
+	line->y = y;
+	memcpy(line->str, gui->str, sizeof(line->str));
+}
+
 static void print_video_adapter(WINDOW_INSTANCE* instance, DBG_GUI* gui, float x, float y) {
 	// print display adapter and mode
 	if (ibm_pc->config.video_adapter == VIDEO_ADAPTER_MDA_80X25) {
@@ -92,80 +100,190 @@ static void print_video_adapter(WINDOW_INSTANCE* instance, DBG_GUI* gui, float x
 	if (gui->win != NULL) {
 		sprintf(gui->str + strlen(gui->str), " @ %.2fhz", HZ_TO_MS(avg_frame_timer_get(&gui->win_avg_fps)));
 	}
-	SDL_RenderDebugText(instance->renderer, x, y, gui->str);
+	queue_text(gui, x, y);
+}
+#define PERF_AVG_FRAMES  30  /* frames the panel averages over */
+#define PERF_GRAPH_BARS  100 /* frames in the real-time ratio graph */
+#define PERF_GRAPH_H     40.0f
+#define PERF_TOP_PORTS   4
+
+/* the port and memory lines sit under the subsystem times */
+static float perf_ports_y(float y) {
+	return y + 10.0f + ((PERF_COUNTERS + 2) / 3) * 10.0f;
 }
-void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
 
-	// update stats
-	SDL_SetRenderDrawColor(instance->renderer, 0xFF, 0, 0, 0xFF);
-	
+static void print_perf_ports(DBG_GUI* gui) {
+	/* the busiest ports since start */
+	uint32_t top[PERF_TOP_PORTS] = { 0 };
+	uint32_t top_count[PERF_TOP_PORTS] = { 0 };
+	PERF* perf = &ibm_pc->perf;
+	for (uint32_t port = 0; port < PERF_IO_PORTS; ++port) {
+		uint32_t count = perf->io_reads[port] + perf->io_writes[port];
+		for (int i = 0; i < PERF_TOP_PORTS; ++i) {
+			if (count > top_count[i]) {
+				for (int j = PERF_TOP_PORTS - 1; j > i; --j) {
+					top[j] = top[j - 1];
+					top_count[j] = top_count[j - 1];
+				}
+				top[i] = port;
+				top_count[i] = count;
+				break;
+			}
+		}
+	}
+	sprintf(gui->str, "IO ");
+	for (int i = 0; i < PERF_TOP_PORTS && top_count[i] != 0; ++i) {
+		sprintf(gui->str + strlen(gui->str), " %03X:%uk", top[i], top_count[i] / 1000);
+	}
+}
+static void print_perf_mem(DBG_GUI* gui) {
+	PERF* perf = &ibm_pc->perf;
+	sprintf(gui->str, "MEM");
+	for (int i = 0; i < ibm_pc->mm.region_index && i < PERF_MREGION_MAX; ++i) {
+		uint64_t count = perf->mem_reads[i] + perf->mem_writes[i];
+		if (count != 0) {
+			sprintf(gui->str + strlen(gui->str), " %05X:%lluM", ibm_pc->mm.regions[i].start, count / 1000000);
+		}
+	}
+}
+static void draw_perf(WINDOW_INSTANCE* instance, DBG_GUI* gui, float y) {
+	PERF* perf = &ibm_pc->perf;
+
+	/* not under the emulation lock */
+
+	/* average the last frames; the history is read lock free */
+	PERF_FRAME avg = { 0 };
+	PERF_FRAME frame = { 0 };
+	for (uint32_t age = 0; age < PERF_AVG_FRAMES; ++age) {
+		if (perf_get_frame(perf, age, &frame)) {
+			break;
+		}
+		avg.host_ns += frame.host_ns;
+		avg.cycles += frame.cycles;
+		avg.instructions += frame.instructions;
+		for (int i = 0; i < PERF_COUNTERS; ++i) {
+			avg.ns[i] += frame.ns[i];
+		}
+	}
+
+	double mips = 0.0;
+	double cycles_per_sec = 0.0;
+	double ratio = 0.0;
+	perf_get_speed(perf, &avg, &mips, &cycles_per_sec, &ratio);
+
+	sprintf(gui->str, "%.2f MIPS %.3f MHz x%.2f real-time", mips, cycles_per_sec / MHZ2HZ, ratio);
+	SDL_RenderDebugText(instance->renderer, 10.0f, y, gui->str);
+	y += 10;
+
+	/* host time per subsystem; share of the host time */
+	for (int i = 0; i < PERF_COUNTERS; ++i) {
+		double pct = (avg.host_ns != 0) ? 100.0 * avg.ns[i] / avg.host_ns : 0.0;
+		sprintf(gui->str, "%-6s %5.1f%%", perf_counter_name(i), pct);
+		SDL_RenderDebugText(instance->renderer, 10.0f + (i % 3) * 150.0f, y + (i / 3) * 10.0f, gui->str);
+	}
+	y += ((PERF_COUNTERS + 2) / 3) * 10.0f;
+
+	/* the port and memory lines are queued by dbg_gui_draw() */
+	y += 25;
+
+	/* real-time ratio per frame; the line is real time */
+	float base = y + PERF_GRAPH_H;
+	for (uint32_t age = 0; age < PERF_GRAPH_BARS; ++age) {
+		if (perf_get_frame(perf, age, &frame)) {
+			break;
+		}
+		perf_get_speed(perf, &frame, &mips, &cycles_per_sec, &ratio);
+		float h = (float)(ratio * PERF_GRAPH_H / 2.0);
+		if (h > PERF_GRAPH_H) {
+			h = PERF_GRAPH_H;
+		}
+		SDL_FRect bar = { 10.0f + (PERF_GRAPH_BARS - 1 - age) * 3.0f, base - h, 2.0f, h };
+		SDL_RenderFillRect(instance->renderer, &bar);
+	}
+	SDL_RenderLine(instance->renderer, 10.0f, base - PERF_GRAPH_H / 2.0f, 10.0f + PERF_GRAPH_BARS * 3.0f, base - PERF_GRAPH_H / 2.0f);
+}
+
+static void dbg_gui_draw(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
+
 	// get avg fps
 	avg_frame_timer_add(&gui->emu_avg_fps, ibm_pc->time.last_ms);
 
 	// print cpu/pit info	
 		
 	sprintf(gui->str, "KBD %6llu cycles", ibm_pc->kbd_cycles);
-	SDL_RenderDebugText(instance->renderer, 10.0f, instance->transform.h - 70.0f, gui->str);
+	queue_text(gui, 10.0f, instance->transform.h - 70.0f);
 	
 	sprintf(gui->str, "DMA %6llu cycles", ibm_pc->dma_cycles);
-	SDL_RenderDebugText(instance->renderer, 10.0f, instance->transform.h - 60.0f, gui->str);
+	queue_text(gui, 10.0f, instance->transform.h - 60.0f);
 		
 	sprintf(gui->str, "PIT %6llu cycles", ibm_pc->pit_cycles);
-	SDL_RenderDebugText(instance->renderer, 10.0f, instance->transform.h - 40.0f, gui->str);
+	queue_text(gui, 10.0f, instance->transform.h - 40.0f);
 	
 	sprintf(gui->str, "CPU %6llu cycles @ %.2fhz", ibm_pc->cpu_cycles, HZ_TO_MS(avg_frame_timer_get(&gui->emu_avg_fps)));
-	SDL_RenderDebugText(instance->renderer, 10.0f, instance->transform.h - 30.0f, gui->str);
+	queue_text(gui, 10.0f, instance->transform.h - 30.0f);
 		
 	print_video_adapter(instance, gui, 10.0f, (instance->transform.h - 10.0f));
+
+	if (ibm_pc->perf.enabled) {
+		float y = perf_ports_y(instance->transform.h - 80.0f - DBG_GUI_PERF_H);
+		print_perf_ports(gui);
+		queue_text(gui, 10.0f, y);
+		print_perf_mem(gui);
+		queue_text(gui, 10.0f, y + 10.0f);
+	}
 	
 	float h = 10;
 
-	// print cpu registers/instuction
-	uint16_t ip = ibm_pc->cpu.ip;
+	// print cpu registers/instuction; decoded through a copy of the cpu that reads memory uncounted
+	I8086 cpu = ibm_pc->cpu;
+	cpu.funcs.read_mem_byte = ibm_pc_peek_mem_byte;
+	I8086_MNEM mnem = { 0 };
+	mnem.state = &cpu;
+	uint16_t ip = cpu.ip;
 	for (int i = 0; i < 10; ++i) {
-		i8086_mnem_at(&ibm_pc->mnem, ibm_pc->cpu.segments[SEG_CS], ip);
-		sprintf(gui->str, "%04X.%04X: %s", ibm_pc->mnem.segment, ip, ibm_pc->mnem.str);
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		i8086_mnem_at(&mnem, cpu.segments[SEG_CS], ip);
+		sprintf(gui->str, "%04X.%04X: %s", mnem.segment, ip, mnem.str);
+		queue_text(gui, 10.0f, h);
 		
-		for (uint16_t j = 0; j < ibm_pc->mnem.counter; ++j) {
-			sprintf(gui->str + (j * 3), " %02X", ibm_pc->cpu.funcs.read_mem_byte(i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ip + j)));
+		for (uint16_t j = 0; j < mnem.counter; ++j) {
+			sprintf(gui->str + (j * 3), " %02X", ibm_pc_peek_mem_byte(i8086_get_physical_address(cpu.segments[SEG_CS], ip + j)));
 		}
-		SDL_RenderDebugText(instance->renderer, 280.0f, h, gui->str);
+		queue_text(gui, 280.0f, h);
 		
 		h += 10;
-		ip += ibm_pc->mnem.counter;
+		ip += mnem.counter;
 	}
 
 	h += 5;
 	sprintf(gui->str, "AX %04X BX %04X",
 		ibm_pc->cpu.registers[REG_AX].r16, ibm_pc->cpu.registers[REG_BX].r16);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	sprintf(gui->str, "CX %04X DX %04X",
 		ibm_pc->cpu.registers[REG_CX].r16, ibm_pc->cpu.registers[REG_DX].r16);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	sprintf(gui->str, "SI %04X DI %04X",
 		ibm_pc->cpu.registers[REG_SI].r16, ibm_pc->cpu.registers[REG_DI].r16);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	sprintf(gui->str, "SP %04X BP %04X",
 		ibm_pc->cpu.registers[REG_SP].r16, ibm_pc->cpu.registers[REG_BP].r16);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	h += 5;
 	sprintf(gui->str, "ES %04X CS %04X",
 		ibm_pc->cpu.segments[SEG_ES], ibm_pc->cpu.segments[SEG_CS]);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	sprintf(gui->str, "DS %04X SS %04X",
 		ibm_pc->cpu.segments[SEG_DS], ibm_pc->cpu.segments[SEG_SS]);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	gui->str[0] = '\0';
@@ -237,23 +355,23 @@ void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
 	else {
 		strcat(gui->str, "   ");
 	}
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+	queue_text(gui, 10.0f, h);
 	h += 10;
 
 	float tmp_h = h;
 	if (ibm_pc->pic.irr & (1 << IRQ_TIMER0)) {
 		sprintf(gui->str, "IRQ_TIMER0 ");
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		queue_text(gui, 10.0f, h);
 		h += 10;
 	}
 	if (ibm_pc->pic.irr & (1 << IRQ_KBD)) {
 		sprintf(gui->str, "IRQ_KBD ");
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		queue_text(gui, 10.0f, h);
 		h += 10;
 	}
 	if (ibm_pc->pic.irr & (1 << IRQ_FDC)) {
 		sprintf(gui->str, "IRQ_FDC ");
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		queue_text(gui, 10.0f, h);
 		h += 10;
 	}
 
@@ -261,12 +379,12 @@ void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
 	h = tmp_h;
 	if (ibm_pc->cpu.intr) {
 		sprintf(gui->str, "INTR ");
-		SDL_RenderDebugText(instance->renderer, 50.0f, h, gui->str);
+		queue_text(gui, 50.0f, h);
 		h += 10;
 	}
 	if (ibm_pc->cpu.nmi) {
 		sprintf(gui->str, "NMI ");
-		SDL_RenderDebugText(instance->renderer, 50.0f, h, gui->str);
+		queue_text(gui, 50.0f, h);
 		h += 10;
 	}
 
@@ -277,24 +395,24 @@ void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
 	h += 5;	
 
 #if 1
-	int i = 0;
-	uint8_t c = 0;
-	while (ring_buffer_peek(&ibm_pc->kbd.key_buffer, i, &c) == 0) {
-		sprintf(gui->str, "(%x) KEY: %02X", i, c);
+	uint32_t i = 0;
+	KBD_KEY_EVENT key = { 0 };
+	while (spsc_ring_buffer_peek(&ibm_pc->kbd.key_queue, i, &key) == 0) {
+		sprintf(gui->str, "(%x) KEY: %02X", i, key.scancode);
 		i++;
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		queue_text(gui, 10.0f, h);
 		h += 10;
 	}
 
 	h += 5;
-	sprintf(gui->str, "Tail: %d, Head: %d, Count: %d ", ibm_pc->kbd.key_buffer.tail, ibm_pc->kbd.key_buffer.head, ibm_pc->kbd.key_buffer.count);
-	SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str); 
+	sprintf(gui->str, "Tail: %d, Head: %d, Count: %u ", ibm_pc->kbd.key_queue.tail, ibm_pc->kbd.key_queue.head, spsc_ring_buffer_count(&ibm_pc->kbd.key_queue));
+	queue_text(gui, 10.0f, h); 
 	h += 15;
 #endif
 
 	for (int t = 0; t < 3; ++t) {
 		print_timer(t, &ibm_pc->pit.timer[t], gui->str);
-		SDL_RenderDebugText(instance->renderer, 10.0f, h, gui->str);
+		queue_text(gui, 10.0f, h);
 		h += 10;
 	}
 }
@@ -357,3 +475,20 @@ void print_timer(int i, I8253_TIMER* timer, char* str) {
 			break;
 	}
 }
+
+void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui) {
+	/* the text is formatted from the live emulator state; rendered once the lock is released */
+	gui->line_count = 0;
+	emulation_lock();
+	dbg_gui_draw(instance, gui);
+	emulation_unlock();
+
+	SDL_SetRenderDrawColor(instance->renderer, 0xFF, 0, 0, 0xFF);
+	for (int i = 0; i < gui->line_count; ++i) {
+		SDL_RenderDebugText(instance->renderer, gui->lines[i].x, gui->lines[i].y, gui->lines[i].str);
+	}
+
+	if (ibm_pc->perf.enabled) {
+		draw_perf(instance, gui, instance->transform.h - 80.0f - DBG_GUI_PERF_H);
+	}
+}
@@ -10,6 +10,9 @@
 typedef struct WINDOW_INSTANCE WINDOW_INSTANCE;
 
 #define FRAME_HISTORY 60
+
+/* Performance counter panel height; added to the window when the counters are enabled */
+#define DBG_GUI_PERF_H 130
 typedef struct {
 	double frame_times[FRAME_HISTORY]; // ms per frame
 	int index;                         // current write position
@@ -17,11 +20,21 @@ typedef struct {
 	double sum;                        // rolling sum of frame times
 } AVG_FRAME_TIMER;
 
+/* Text lines formatted under the emulation lock and rendered after it is released */
+#define DBG_GUI_LINES 64
+typedef struct {
+	float x;
+	float y;
+	char str[128];
+} DBG_GUI_LINE;
+
 typedef struct DBG_GUI {
 	WINDOW_INSTANCE* win;
-	char str[64];
+	char str[128];
 	AVG_FRAME_TIMER emu_avg_fps;
 	AVG_FRAME_TIMER win_avg_fps;
+	DBG_GUI_LINE lines[DBG_GUI_LINES];
+	int line_count;
 } DBG_GUI;
 
 extern void dbg_gui_render(WINDOW_INSTANCE* instance, DBG_GUI* gui);
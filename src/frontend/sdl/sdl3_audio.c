@@ -0,0 +1,89 @@
+/* sdl3_audio.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Audio; samples from the emulation thread are queued to an SDL audio stream
+ */
+
+#include <stdint.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_audio.h>
+
+#include "sdl3_audio.h"
+
+#include "backend/audio.h"
+
+/* Bound the latency when the emulator runs ahead of the device */
+#define SDL_AUDIO_MAX_QUEUED_MS 100
+
+#define LOG_CATEGORY LOG_CAT_AUDIO
+#include "backend/utility/log.h"
+
+static SDL_AudioStream* stream = NULL;
+static int max_queued = 0; /* bytes */
+static int prime_size = 0; /* bytes */
+
+static void prime(void) {
+	/* Start at the target depth; the pacing only has to hold it */
+	int16_t silence[256] = { 0 };
+	int remain = prime_size;
+	while (remain > 0) {
+		int size = remain < (int)sizeof(silence) ? remain : (int)sizeof(silence);
+		SDL_PutAudioStreamData(stream, silence, size);
+		remain -= size;
+	}
+}
+
+int sdl_audio_create(int sample_rate) {
+	if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+		log_error("[AUDIO] Failed to init sub sysyem: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	SDL_AudioSpec spec = { 0 };
+	spec.format = SDL_AUDIO_S16;
+	spec.channels = 1;
+	spec.freq = sample_rate;
+
+	stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, NULL, NULL);
+	if (stream == NULL) {
+		log_error("[AUDIO] Failed to open audio device: %s\n", SDL_GetError());
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return 1;
+	}
+
+	max_queued = sample_rate * SDL_AUDIO_MAX_QUEUED_MS / 1000 * (int)sizeof(int16_t);
+	prime_size = (int)(sample_rate * AUDIO_TARGET_QUEUED_MS / 1000.0) * (int)sizeof(int16_t);
+	prime();
+	SDL_ResumeAudioStreamDevice(stream);
+	return 0;
+}
+
+void sdl_audio_destroy(void) {
+	if (stream != NULL) {
+		SDL_DestroyAudioStream(stream);
+		stream = NULL;
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+	}
+}
+
+void sdl_audio_output(const int16_t* samples, uint32_t count) {
+	/* SDL audio streams are thread safe; called on the emulation thread */
+	if (stream == NULL) {
+		return;
+	}
+	int queued = SDL_GetAudioStreamQueued(stream);
+	if (queued > max_queued) {
+		return;
+	}
+	if (queued == 0) {
+		prime(); /* underrun; paused or the host fell behind */
+	}
+	SDL_PutAudioStreamData(stream, samples, (int)(count * sizeof(int16_t)));
+}
+
+uint32_t sdl_audio_get_queued(void) {
+	if (stream == NULL) {
+		return 0;
+	}
+	return (uint32_t)SDL_GetAudioStreamQueued(stream) / sizeof(int16_t);
+}
@@ -0,0 +1,25 @@
+/* sdl3_audio.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Audio; samples from the emulation thread are queued to an SDL audio stream
+ */
+
+#ifndef SDL3_AUDIO_H
+#define SDL3_AUDIO_H
+
+#include <stdint.h>
+
+/* Open the default playback device
+	sample_rate: the sample rate of the samples; signed 16 bit mono
+	Returns: 1 if error; 0 if success */
+int sdl_audio_create(int sample_rate);
+
+/* Close the playback device */
+void sdl_audio_destroy(void);
+
+/* Queue samples; audio_output() callback. Dropped if more than SDL_AUDIO_MAX_QUEUED_MS is queued */
+void sdl_audio_output(const int16_t* samples, uint32_t count);
+
+/* Get the samples waiting to be played; audio get queued callback */
+uint32_t sdl_audio_get_queued(void);
+
+#endif
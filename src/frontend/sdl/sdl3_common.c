@@ -6,39 +6,35 @@
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_video.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <stdio.h>
 
 #include "sdl3_common.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
 
 /* SDL struct */
 int sdl_create(SDL** sdl) {
 	if (*sdl != NULL) {
-		dbg_print("Error: SDL instance already created\n");
+		log_error("Error: SDL instance already created\n");
 		return 1;
 	}
 
 	*sdl = calloc(1, sizeof(SDL));
 	if (*sdl == NULL) {
-		dbg_print("Failed to allocate SDL instance\n");
+		log_error("Failed to allocate SDL instance\n");
 		return 1;
 	}
 
 	// init SDL video 
 	if (!SDL_InitSubSystem(SDL_INIT_VIDEO)) {
-		dbg_print("Failed to init sub sysyem: %s\n", SDL_GetError());
+		log_error("Failed to init sub sysyem: %s\n", SDL_GetError());
 		return 1;
 	}
 
 	/* init TTF */
 	if (!TTF_Init()) {
-		dbg_print("Failed to init ttf: %s\n", SDL_GetError());
+		log_error("Failed to init ttf: %s\n", SDL_GetError());
 		return 1;
 	}
 
@@ -125,7 +121,7 @@ int sdl_add_cb_on_process_event(SDL* sdl, SDL_PROCESS_EVENT_CB cb, void* cb_para
 
 		void* new_param1 = realloc(sdl->on_process_event_param1, (sdl->on_process_event_count + 1) * sizeof(void*));
 		if (new_param1 == NULL) {
-			dbg_print("[SDL]  Failed to add on_process_event; Realloc failed\n");
+			log_error("[SDL]  Failed to add on_process_event; Realloc failed\n");
 			return -1;
 		}
 		
@@ -150,13 +146,13 @@ int sdl_add_cb_on_update(SDL* sdl, SDL_UPDATE_CB cb, void* cb_param1) {
 	if (index >= sdl->on_update_count) {
 		SDL_UPDATE_CB* new_cb = realloc(sdl->on_update, (sdl->on_update_count + 1) * sizeof(SDL_UPDATE_CB));
 		if (new_cb == NULL) {
-			dbg_print("[SDL] Failed to add on_update; Realloc failed\n");
+			log_error("[SDL] Failed to add on_update; Realloc failed\n");
 			return -1;
 		}
 
 		void* new_param1 = realloc(sdl->on_update_param1, (sdl->on_update_count + 1) * sizeof(void*));
 		if (new_param1 == NULL) {
-			dbg_print("[SDL] Failed to add on_update; Realloc failed\n");
+			log_error("[SDL] Failed to add on_update; Realloc failed\n");
 			return -1;
 		}
 
@@ -11,18 +11,16 @@
 #include "sdl3_window.h"
 #include "sdl3_font.h"
 #include "sdl3_typedefs.h"
+#include "sdl3_timing.h"
 
 #include "backend/video/mda.h"
 #include "backend/video/cga.h"
+#include "backend/video/video_frame.h"
 #include "backend/ibm_pc.h"
+#include "backend/utility/trace.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
 
 static void get_cell_position(const DISPLAY_INSTANCE* const display, const float offset_x, const float offset_y, const int x, const int y, SDL_FRect* const rect) {
 	rect->x = offset_x + (x * display->cell_w);
@@ -114,13 +112,14 @@ static void disabled_draw_screen(const DISPLAY_INSTANCE* const display) {
 	const COLOR_RGB col = { 0, 0, 0 };
 	fill_screen(display, col);
 }
-static int check_disable_wait(DISPLAY_INSTANCE* display, uint8_t hw_enable) {
+static int check_disable_wait(DISPLAY_INSTANCE* display, const VIDEO_FRAME* frame, uint8_t hw_enable) {
 	if (!display->config.allow_display_disable) {
 		return 0;
 	}
 
 	if (display->config.delay_display_disable) {
-		uint64_t now = timing_get_ticks_ms();
+		/* emulated time; the delay does not depend on host speed */
+		uint64_t now = frame->ticks_ms;
 
 		if (hw_enable) {
 			display->video_enabled = 1;
@@ -165,9 +164,9 @@ static void mda_draw_background(DISPLAY_INSTANCE* display, const SDL_FRect* rect
 	}
 	SDL_RenderFillRect(display->window->renderer, rect);
 }
-static void mda_draw_character(DISPLAY_INSTANCE* display, const SDL_FRect* rect, const uint8_t character, const uint8_t attribute) {
+static void mda_draw_character(DISPLAY_INSTANCE* display, const MDA* mda, const SDL_FRect* rect, const uint8_t character, const uint8_t attribute) {
 	/* only render character if not blinking or blink < blink_count (half time) */
-	if ((ibm_pc->mda.mode & MDA_MODE_BLINK_ENABLE) && (attribute & MDA_ATTRIBUTE_BLINK) && ibm_pc->mda.blink < 0x0F) {
+	if ((mda->mode & MDA_MODE_BLINK_ENABLE) && (attribute & MDA_ATTRIBUTE_BLINK) && mda->blink < 0x0F) {
 		return;
 	}
 
@@ -181,14 +180,14 @@ static void mda_draw_character(DISPLAY_INSTANCE* display, const SDL_FRect* rect,
 	SDL_SetTextureScaleMode(display->font_data->textures[character], display->config.texture_scale_mode);
 	SDL_RenderTexture(display->window->renderer, display->font_data->textures[character], NULL, rect);
 }
-static void mda_draw_cursor(DISPLAY_INSTANCE* display, const SDL_FRect* rect, const uint8_t attribute) {
+static void mda_draw_cursor(DISPLAY_INSTANCE* display, const MDA* mda, const SDL_FRect* rect, const uint8_t attribute) {
 
-	if ((ibm_pc->mda.crtc.cursor_start & CRTC_6845_CURSOR_ATTR_MASK) == CRTC_6845_CURSOR_ATTR_DISABLED) {
+	if ((mda->crtc.cursor_start & CRTC_6845_CURSOR_ATTR_MASK) == CRTC_6845_CURSOR_ATTR_DISABLED) {
 		return;
 	}
 
 	/* dont render cursor if blink rate < half time */
-	if ((ibm_pc->mda.blink & 0x1F) < 0x0F) {
+	if ((mda->blink & 0x1F) < 0x0F) {
 		return;
 	}
 
@@ -202,22 +201,19 @@ static void mda_draw_cursor(DISPLAY_INSTANCE* display, const SDL_FRect* rect, co
 	SDL_SetTextureScaleMode(display->font_data->textures['_'], display->config.texture_scale_mode);
 	SDL_RenderTexture(display->window->renderer, display->font_data->textures['_'], NULL, rect);
 }
-static void mda_text_draw_screen(DISPLAY_INSTANCE* display, MDA* mda) {
+static void mda_text_draw_screen(DISPLAY_INSTANCE* display, const MDA* mda, const uint8_t* vram) {
 
 	/* get cell dimensions */
 	float offset_x;
 	float offset_y;
 	get_cell_dimensions(display, mda->crtc.hdisp, mda->crtc.vdisp, &offset_x, &offset_y);
 
-	/* increment blink; count to 31 */
-	mda->blink = (mda->blink++) & 0x1F;
-
 	for (uint8_t row = 0; row < mda->crtc.vdisp; ++row) {
 		for (uint8_t column = 0; column < mda->crtc.hdisp; ++column) {
 			const uint16_t char_index = mda->crtc.start_address + row * mda->crtc.hdisp + column;
-			const uint32_t char_address = MDA_PHYS_ADDRESS(char_index * 2);
-			const uint8_t character = ibm_pc->cpu.funcs.read_mem_byte(char_address);
-			const uint8_t attribute = ibm_pc->cpu.funcs.read_mem_byte(char_address + 1);
+			const uint16_t char_address = char_index * 2;
+			const uint8_t character = vram[char_address & MDA_MM_ADDRESS_MASK];
+			const uint8_t attribute = vram[(char_address + 1) & MDA_MM_ADDRESS_MASK];
 			
 			/* get cell position */
 			SDL_FRect rect;
@@ -225,21 +221,45 @@ static void mda_text_draw_screen(DISPLAY_INSTANCE* display, MDA* mda) {
 			
 			/* draw text */
 			mda_draw_background(display, &rect, attribute);
-			mda_draw_character(display, &rect, character, attribute);
+			mda_draw_character(display, mda, &rect, character, attribute);
 
 			/* draw cursor */
 			if (char_index == mda->crtc.cursor_address) {
-				mda_draw_cursor(display, &rect, attribute);
+				mda_draw_cursor(display, mda, &rect, attribute);
 			}
 		}
 	}
 }
-static void mda_draw_screen(DISPLAY_INSTANCE* display, MDA* mda) {
-	if (check_disable_wait(display, mda->mode & MDA_MODE_VIDEO_ENABLE)) {
+static void mda_draw_frame(DISPLAY_INSTANCE* display, VIDEO_FRAME_BUFFER* frames) {
+	/* render the latest frame published by the emulation thread */
+	const VIDEO_FRAME* frame = video_frame_buffer_acquire(frames);
+	if (frame->video_adapter != VIDEO_ADAPTER_MDA_80X25) {
+		disabled_draw_screen(display);
+		return;
+	}
+
+	const MDA* mda = &frame->mda;
+	if (check_disable_wait(display, frame, mda->mode & MDA_MODE_VIDEO_ENABLE)) {
 		return;
 	}
 
-	mda_text_draw_screen(display, mda);
+	mda_text_draw_screen(display, mda, frame->vram);
+}
+static void mda_draw_screen(DISPLAY_INSTANCE* display, VIDEO_FRAME_BUFFER* frames) {
+	TRACE_BEGIN(TRACE_CAT_FRAME, "mda_draw_screen");
+	if (ibm_pc->perf.enabled || ibm_pc->bench.enabled) {
+		uint64_t start = sdl_timing_get_ticks_ns();
+		mda_draw_frame(display, frames);
+		uint64_t ns = sdl_timing_get_ticks_ns() - start;
+		if (ibm_pc->perf.enabled) {
+			perf_add_render_ns(&ibm_pc->perf, ns);
+		}
+		bench_add_render_ns(&ibm_pc->bench, ns);
+	}
+	else {
+		mda_draw_frame(display, frames);
+	}
+	TRACE_END(TRACE_CAT_FRAME, "mda_draw_screen");
 }
 
 /* CGA */
@@ -280,7 +300,7 @@ static const COLOR_RGB cga_colors[16] = {
 		{ 0xFF, 0xFF, 0xFF }, /* bright white */
 };
 
-static void cga_graphics_draw_lo_res(DISPLAY_INSTANCE* display, CGA* cga) {
+static void cga_graphics_draw_lo_res(DISPLAY_INSTANCE* display, const CGA* cga, const uint8_t* vram) {
 	const uint8_t palette0[8] = {
 		(cga->color & CGA_COLOR_BG),
 		CGA_COLOR_GREEN,
@@ -345,8 +365,8 @@ static void cga_graphics_draw_lo_res(DISPLAY_INSTANCE* display, CGA* cga) {
 		uint32_t row_offset = (y >> 1) * bytes_per_row;
 
 		for (int x = 0; x < bytes_per_row; ++x) {
-			uint32_t address = CGA_PHYS_ADDRESS(base + row_offset + x);
-			uint8_t byte = ibm_pc->cpu.funcs.read_mem_byte(address);
+			uint32_t address = (base + row_offset + x) & CGA_MM_ADDRESS_MASK;
+			uint8_t byte = vram[address];
 
 			for (int bit = 6; bit >= 0; bit -= 2) {
 				const uint8_t color_index = ((byte >> bit) & 0x3) | (cga->color & CGA_COLOR_BRIGHT_FG) >> 2;
@@ -362,7 +382,7 @@ static void cga_graphics_draw_lo_res(DISPLAY_INSTANCE* display, CGA* cga) {
 		}
 	}
 }
-static void cga_graphics_draw_hi_res(DISPLAY_INSTANCE* display, CGA* cga) {
+static void cga_graphics_draw_hi_res(DISPLAY_INSTANCE* display, const CGA* cga, const uint8_t* vram) {
 
 	const int width = 640;
 	const int height = 200;
@@ -385,8 +405,8 @@ static void cga_graphics_draw_hi_res(DISPLAY_INSTANCE* display, CGA* cga) {
 		uint32_t row_offset = (y >> 1) * bytes_per_row;
 
 		for (int x = 0; x < bytes_per_row; ++x) {
-			uint32_t address = CGA_PHYS_ADDRESS(base + row_offset + x);
-			uint8_t byte = ibm_pc->cpu.funcs.read_mem_byte(address);
+			uint32_t address = (base + row_offset + x) & CGA_MM_ADDRESS_MASK;
+			uint8_t byte = vram[address];
 
 			for (int bit = 7; bit >= 0; --bit) {
 				const uint8_t color_index = (byte >> bit) & 0x1;
@@ -403,26 +423,26 @@ static void cga_graphics_draw_hi_res(DISPLAY_INSTANCE* display, CGA* cga) {
 	}
 }
 
-static void cga_draw_background(DISPLAY_INSTANCE* display, const SDL_FRect* rect, const uint8_t attribute) {
+static void cga_draw_background(DISPLAY_INSTANCE* display, const CGA* cga, const SDL_FRect* rect, const uint8_t attribute) {
 	/* render background */
 	uint8_t index = (attribute & CGA_ATTRIBUTE_BG) >> 4;
-	if (ibm_pc->cga.mode & CGA_MODE_BLINK_ENABLE) {
+	if (cga->mode & CGA_MODE_BLINK_ENABLE) {
 		index &= 0x07; /* if MODE bit5 = 1, then ignore intensity bit (bit7) in attribute */
 	}
 	const COLOR_RGB col = cga_colors[index];
 	SDL_SetRenderDrawColor(display->window->renderer, col.r, col.g, col.b, 0xFF);
 	SDL_RenderFillRect(display->window->renderer, rect);
 }
-static void cga_draw_character(DISPLAY_INSTANCE* display, const SDL_FRect* rect, const uint8_t character, const uint8_t attribute) {
+static void cga_draw_character(DISPLAY_INSTANCE* display, const CGA* cga, const SDL_FRect* rect, const uint8_t character, const uint8_t attribute) {
 	
 	/* only render char if MODE bit5 = 1 and ATTRIBUTE bit7 = 1 and blink interval is half time */
-	if ((ibm_pc->cga.mode & CGA_MODE_BLINK_ENABLE) && (attribute & CGA_ATTRIBUTE_BLINK) && ibm_pc->cga.blink < 0x0F) {
+	if ((cga->mode & CGA_MODE_BLINK_ENABLE) && (attribute & CGA_ATTRIBUTE_BLINK) && cga->blink < 0x0F) {
 		return;
 	}
 
 	float scanline_ratio = 1.0;
 	if (display->config.scanline_emu) {
-		scanline_ratio = (ibm_pc->cga.crtc.max_scanline + 1) / 8.0f;
+		scanline_ratio = (cga->crtc.max_scanline + 1) / 8.0f;
 	}
 
 	// Get the actual texture dimensions
@@ -443,24 +463,24 @@ static void cga_draw_character(DISPLAY_INSTANCE* display, const SDL_FRect* rect,
 	SDL_SetTextureScaleMode(display->font_data->textures[character], display->config.texture_scale_mode);
 	SDL_RenderTexture(display->window->renderer, display->font_data->textures[character], &src, rect);
 }
-static void cga_draw_cursor(DISPLAY_INSTANCE* display, const SDL_FRect* rect, const uint8_t attribute) {
+static void cga_draw_cursor(DISPLAY_INSTANCE* display, const CGA* cga, const SDL_FRect* rect, const uint8_t attribute) {
 
 	/* The IBM CGA Adapter ignores the CRTCs internal blink rate logic.
 	 Bits 5,6 = b01 disables the cursor (The CRTC stops asserting CURSOR).
 	 Bits 5,6 = b00, b10, b11 all display the cursor and blinks at the same fixed hardware rate. */
 	
-	if ((ibm_pc->cga.crtc.cursor_start & CRTC_6845_CURSOR_ATTR_MASK) == CRTC_6845_CURSOR_ATTR_DISABLED) {
+	if ((cga->crtc.cursor_start & CRTC_6845_CURSOR_ATTR_MASK) == CRTC_6845_CURSOR_ATTR_DISABLED) {
 		return;
 	}
 
 	/* dont render cursor if blink rate < half time */
-	if ((ibm_pc->cga.blink & 0x1F) < 0x0F) {
+	if ((cga->blink & 0x1F) < 0x0F) {
 		return;
 	}
 
 	float scanline_ratio = 1.0;
 	if (display->config.scanline_emu) {
-		scanline_ratio = (ibm_pc->cga.crtc.max_scanline + 1) / 8.0f;
+		scanline_ratio = (cga->crtc.max_scanline + 1) / 8.0f;
 	}
 
 	SDL_FRect src = {
@@ -476,15 +496,12 @@ static void cga_draw_cursor(DISPLAY_INSTANCE* display, const SDL_FRect* rect, co
 	SDL_SetTextureScaleMode(display->font_data->textures['_'], display->config.texture_scale_mode);
 	SDL_RenderTexture(display->window->renderer, display->font_data->textures['_'], &src, rect);
 }
-static void cga_text_draw_screen(DISPLAY_INSTANCE* display, CGA* cga) {
+static void cga_text_draw_screen(DISPLAY_INSTANCE* display, const CGA* cga, const uint8_t* vram) {
 
 	/* get cell dimensions */
 	float offset_x;
 	float offset_y;
 	get_cell_dimensions(display, cga->crtc.hdisp, cga->crtc.vdisp, &offset_x, &offset_y);
-
-	/* increment blink; count to 31 */
-	cga->blink = (cga->blink++) & 0x1F;
 	
 #if 0
 	/* draw boarder */
@@ -504,80 +521,104 @@ static void cga_text_draw_screen(DISPLAY_INSTANCE* display, CGA* cga) {
 	for (uint8_t row = 0; row < cga->crtc.vdisp; ++row) {
 		for (uint8_t column = 0; column < cga->crtc.hdisp; ++column) {
 			const uint16_t char_index = cga->crtc.start_address + row * cga->crtc.hdisp + column;
-			const uint32_t char_address = CGA_PHYS_ADDRESS(char_index * 2);
-			const uint8_t character = ibm_pc->cpu.funcs.read_mem_byte(char_address);
-			const uint8_t attribute = ibm_pc->cpu.funcs.read_mem_byte(char_address + 1);
+			const uint16_t char_address = char_index * 2;
+			const uint8_t character = vram[char_address & CGA_MM_ADDRESS_MASK];
+			const uint8_t attribute = vram[(char_address + 1) & CGA_MM_ADDRESS_MASK];
 			
 			/* get cell position */
 			SDL_FRect rect;
 			get_cell_position(display, offset_x, offset_y, column, row, &rect);
 
 			/* draw text */
-			cga_draw_background(display, &rect, attribute);
-			cga_draw_character(display, &rect, character, attribute);
+			cga_draw_background(display, cga, &rect, attribute);
+			cga_draw_character(display, cga, &rect, character, attribute);
 
 			/* draw cursor */
 			if (char_index == cga->crtc.cursor_address) {
-				cga_draw_cursor(display, &rect, attribute);
+				cga_draw_cursor(display, cga, &rect, attribute);
 			}
 		}
 	}
 }
 
-static void cga_draw_screen(DISPLAY_INSTANCE* display, CGA* cga) {
-	if (check_disable_wait(display, cga->mode & CGA_MODE_VIDEO_ENABLE)) {
+static void cga_draw_frame(DISPLAY_INSTANCE* display, VIDEO_FRAME_BUFFER* frames) {
+	/* render the latest frame published by the emulation thread */
+	const VIDEO_FRAME* frame = video_frame_buffer_acquire(frames);
+	if (frame->video_adapter != VIDEO_ADAPTER_CGA_40X25 && frame->video_adapter != VIDEO_ADAPTER_CGA_80X25) {
+		disabled_draw_screen(display);
+		return;
+	}
+
+	const CGA* cga = &frame->cga;
+	if (check_disable_wait(display, frame, cga->mode & CGA_MODE_VIDEO_ENABLE)) {
 		return;
 	}
 	
 	if (cga->mode & CGA_MODE_GRAPHICS) {
 		if (cga->mode & CGA_MODE_GRAPHICS_RES_HI) {
-			cga_graphics_draw_hi_res(display, cga);
+			cga_graphics_draw_hi_res(display, cga, frame->vram);
 		}
 		else {
-			cga_graphics_draw_lo_res(display, cga);
+			cga_graphics_draw_lo_res(display, cga, frame->vram);
 		}
 	}
 	else {
-		cga_text_draw_screen(display, cga);
+		cga_text_draw_screen(display, cga, frame->vram);
 	}
 }
+static void cga_draw_screen(DISPLAY_INSTANCE* display, VIDEO_FRAME_BUFFER* frames) {
+	TRACE_BEGIN(TRACE_CAT_FRAME, "cga_draw_screen");
+	if (ibm_pc->perf.enabled || ibm_pc->bench.enabled) {
+		uint64_t start = sdl_timing_get_ticks_ns();
+		cga_draw_frame(display, frames);
+		uint64_t ns = sdl_timing_get_ticks_ns() - start;
+		if (ibm_pc->perf.enabled) {
+			perf_add_render_ns(&ibm_pc->perf, ns);
+		}
+		bench_add_render_ns(&ibm_pc->bench, ns);
+	}
+	else {
+		cga_draw_frame(display, frames);
+	}
+	TRACE_END(TRACE_CAT_FRAME, "cga_draw_screen");
+}
 
 void display_on_video_adapter_changed(DISPLAY_INSTANCE* display, const uint8_t video_adapter) {
 	if (display->window != NULL) {
 		switch (video_adapter) {
 			case VIDEO_ADAPTER_MDA_80X25:
 				sdl_timing_init_frame(&display->window->time, HZ_TO_MS(50.0));
-				window_instance_set_cb_on_render(display->window, display->on_render_index, mda_draw_screen, display, &ibm_pc->mda);
+				window_instance_set_cb_on_render(display->window, display->on_render_index, mda_draw_screen, display, &ibm_pc->video_frames);
 
 				if (display_generate_font_map(display, display->config.mda_font)) {
 					exit(1);
 				}
-				dbg_print("[DISPLAY] Video adapter: MDA\n");
+				log_info("[DISPLAY] Video adapter: MDA\n");
 				break;
 			case VIDEO_ADAPTER_CGA_40X25:
 			case VIDEO_ADAPTER_CGA_80X25:
 				sdl_timing_init_frame(&display->window->time, HZ_TO_MS(60.0));
-				window_instance_set_cb_on_render(display->window, display->on_render_index, cga_draw_screen, display, &ibm_pc->cga);
+				window_instance_set_cb_on_render(display->window, display->on_render_index, cga_draw_screen, display, &ibm_pc->video_frames);
 
 				if (display_generate_font_map(display, display->config.cga_font)) {
 					exit(1);
 				}
-				dbg_print("[DISPLAY] Video adapter: CGA\n");
+				log_info("[DISPLAY] Video adapter: CGA\n");
 				break;
 			case VIDEO_ADAPTER_NONE:
 				sdl_timing_init_frame(&display->window->time, HZ_TO_MS(60.0));
 				window_instance_set_cb_on_render(display->window, display->on_render_index, dummy_draw_screen, display, NULL);
-				dbg_print("[DISPLAY] Video adapter: DUMMY\n");
+				log_info("[DISPLAY] Video adapter: DUMMY\n");
 				break;
 		}
 	}
 	else {
-		dbg_print("[DISPLAY] Video adapter: HEADLESS\n");
+		log_info("[DISPLAY] Video adapter: HEADLESS\n");
 	}
 }
 int display_generate_font_map(DISPLAY_INSTANCE* display, const char* font_path) {
 	if (display == NULL) {
-		dbg_print("[DISPLAY] display is NULL\n");
+		log_error("[DISPLAY] display is NULL\n");
 		return 1;
 	}
 
@@ -595,27 +636,34 @@ int display_generate_font_map(DISPLAY_INSTANCE* display, const char* font_path)
 	return 0;
 }
 
+static int display_frame_ready(DISPLAY_INSTANCE* display) {
+	/* render right after the emulated vsync */
+	(void)display;
+	return video_frame_buffer_is_fresh(&ibm_pc->video_frames);
+}
+
 int display_set_window(DISPLAY_INSTANCE* display, WINDOW_INSTANCE* window) {
 	if (display->on_render_index == -1) {
 		display->window = window;
 		display->on_render_index = window_instance_add_cb_on_render(window, dummy_draw_screen, display, NULL);
+		window_instance_set_cb_render_ready(window, display_frame_ready, display);
 		return 0;
 	}
 	else {
-		dbg_print("[DISPLAY] Failed to set window on_render cb. CB already set.\n");
+		log_error("[DISPLAY] Failed to set window on_render cb. CB already set.\n");
 		return 1;
 	}
 }
 
 int display_create(DISPLAY_INSTANCE** display, WINDOW_INSTANCE* window) {
 	if (display == NULL) {
-		dbg_print("[DISPLAY] display is NULL\n");
+		log_error("[DISPLAY] display is NULL\n");
 		return 1;
 	}
 
 	*display = calloc(1, sizeof(DISPLAY_INSTANCE));
 	if (*display == NULL) {
-		dbg_print("[DISPLAY] Failed to allocate memory\n");
+		log_error("[DISPLAY] Failed to allocate memory\n");
 		return 1;
 	}
 	
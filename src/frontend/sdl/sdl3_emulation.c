@@ -0,0 +1,131 @@
+/* sdl3_emulation.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Emulation thread; runs the emulator update loop off the UI thread
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_atomic.h>
+
+#include "sdl3_emulation.h"
+#include "sdl3_timing.h"
+
+#include "backend/utility/trace.h"
+
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
+
+typedef struct EMULATION {
+	SDL_Thread* thread;
+	SDL_Mutex* lock;
+	SDL_Condition* handoff; /* signalled when a UI thread locker unlocks */
+	SDL_AtomicInt quit;
+	SDL_AtomicInt waiting; /* UI thread lockers waiting on the lock */
+	EMULATION_UPDATE_CB update;
+} EMULATION;
+
+static EMULATION emulation = { 0 };
+
+static int emulation_thread(void* param) {
+	(void)param;
+	trace_set_thread_name("emulation");
+
+	while (!SDL_GetAtomicInt(&emulation.quit)) {
+		SDL_LockMutex(emulation.lock);
+		uint64_t wait_ns = emulation.update();
+
+		/* Mutexes are not fair; hand the lock to a waiting locker and block until it unlocks.
+		 * The timeout bounds the wait if the signal is missed */
+		while (SDL_GetAtomicInt(&emulation.waiting) > 0 && !SDL_GetAtomicInt(&emulation.quit)) {
+			SDL_WaitConditionTimeout(emulation.handoff, emulation.lock, 1);
+		}
+		SDL_UnlockMutex(emulation.lock);
+
+		/* Sleep until the next update is due rather than spinning on the frame timer */
+		if (wait_ns > 0) {
+			sdl_timing_delay_ns(wait_ns);
+		}
+	}
+	return 0;
+}
+
+int emulation_create(EMULATION_UPDATE_CB update) {
+	if (emulation.lock != NULL) {
+		log_error("[EMULATION] Already created\n");
+		return 1;
+	}
+
+	emulation.lock = SDL_CreateMutex();
+	if (emulation.lock == NULL) {
+		log_error("[EMULATION] Failed to create mutex: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	emulation.handoff = SDL_CreateCondition();
+	if (emulation.handoff == NULL) {
+		log_error("[EMULATION] Failed to create condition: %s\n", SDL_GetError());
+		SDL_DestroyMutex(emulation.lock);
+		emulation.lock = NULL;
+		return 1;
+	}
+
+	emulation.thread = NULL;
+	emulation.update = update;
+	SDL_SetAtomicInt(&emulation.quit, 0);
+	SDL_SetAtomicInt(&emulation.waiting, 0);
+	return 0;
+}
+void emulation_destroy(void) {
+	emulation_stop();
+
+	if (emulation.handoff != NULL) {
+		SDL_DestroyCondition(emulation.handoff);
+		emulation.handoff = NULL;
+	}
+	if (emulation.lock != NULL) {
+		SDL_DestroyMutex(emulation.lock);
+		emulation.lock = NULL;
+	}
+	emulation.update = NULL;
+}
+
+int emulation_start(void) {
+	if (emulation.lock == NULL || emulation.update == NULL) {
+		log_error("[EMULATION] Not created\n");
+		return 1;
+	}
+
+	if (emulation.thread != NULL) {
+		return 0; /* already running */
+	}
+
+	SDL_SetAtomicInt(&emulation.quit, 0);
+	emulation.thread = SDL_CreateThread(emulation_thread, "emulation", NULL);
+	if (emulation.thread == NULL) {
+		log_error("[EMULATION] Failed to create thread: %s\n", SDL_GetError());
+		return 1;
+	}
+	return 0;
+}
+void emulation_stop(void) {
+	if (emulation.thread != NULL) {
+		SDL_SetAtomicInt(&emulation.quit, 1);
+		SDL_WaitThread(emulation.thread, NULL);
+		emulation.thread = NULL;
+	}
+}
+
+void emulation_lock(void) {
+	if (emulation.lock != NULL) {
+		SDL_AddAtomicInt(&emulation.waiting, 1);
+		SDL_LockMutex(emulation.lock);
+		SDL_AddAtomicInt(&emulation.waiting, -1);
+	}
+}
+void emulation_unlock(void) {
+	if (emulation.lock != NULL) {
+		SDL_UnlockMutex(emulation.lock);
+		SDL_SignalCondition(emulation.handoff);
+	}
+}
@@ -0,0 +1,36 @@
+/* sdl3_emulation.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Emulation thread
+ */
+
+#ifndef SDL3_EMULATION_H
+#define SDL3_EMULATION_H
+
+#include <stdint.h>
+
+/* Returns: the time in ns until the update is next due */
+typedef uint64_t(*EMULATION_UPDATE_CB)(void);
+
+/* Create the emulation thread state
+	update: called on the emulation thread with the emulation lock held. The thread sleeps for the time it returns
+	Returns: 1 if error; 0 if success */
+int emulation_create(EMULATION_UPDATE_CB update);
+
+/* Stop the emulation thread and destroy the state */
+void emulation_destroy(void);
+
+/* Start the emulation thread
+	Returns: 1 if error; 0 if success */
+int emulation_start(void);
+
+/* Stop the emulation thread; waits for the current update to finish */
+void emulation_stop(void);
+
+/* Lock the emulator state. Call before touching the emulator from the UI thread.
+	The emulation thread hands the lock to a waiting locker between updates and waits for it to unlock. Recursive. */
+void emulation_lock(void);
+
+/* Unlock the emulator state */
+void emulation_unlock(void);
+
+#endif
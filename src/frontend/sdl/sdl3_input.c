@@ -10,9 +10,10 @@
 #include "sdl3_common.h"
 #include "sdl3_window.h"
 #include "sdl3_keys.h"
+#include "sdl3_emulation.h"
 
 #include "backend/ibm_pc.h"
-#include "backend/utility/ring_buffer.h"
+#include "backend/keyboard.h"
 
 static void check_keys(WINDOW_INSTANCE* instance, SDL_Event* e) {
 
@@ -20,26 +21,32 @@ static void check_keys(WINDOW_INSTANCE* instance, SDL_Event* e) {
 		
 		case SDL_SCANCODE_F11:
 			if (e->key.down) {
-				ibm_pc_reset();
+				emulation_lock();
+				ibm_pc_event_reset();
+				emulation_unlock();
 			}
 			return; /* ignore key */
 
 		case SDL_SCANCODE_KP_ENTER:
 			if (e->key.down) {
+				emulation_lock();
 				if (ibm_pc->step) {
 					ibm_pc->step = 0;
 				}
 				else {
 					ibm_pc->step = 1;
 				}
+				emulation_unlock();
 			}
 			return; /* ignore key */
 				
 		case SDL_SCANCODE_KP_PLUS:
 			if (e->key.down) {
+				emulation_lock();
 				if (ibm_pc->step) {
 					ibm_pc->step = 2;
 				}
+				emulation_unlock();
 			}
 			return; /* ignore key */
 
@@ -61,11 +68,12 @@ static void check_keys(WINDOW_INSTANCE* instance, SDL_Event* e) {
 		return; /* ignore key; scancode is not a pc scancode */
 	}
 
+	/* The key queue is lock-free; SDL event timestamps share the SDL_GetTicksNS() clock */
 	if (e->key.down) {
-		ring_buffer_push(&ibm_pc->kbd.key_buffer, pc_scancode[e->key.scancode]);
+		kbd_push_key(&ibm_pc->kbd, pc_scancode[e->key.scancode], e->key.timestamp);
 	}
 	else {
-		ring_buffer_push(&ibm_pc->kbd.key_buffer, pc_scancode[e->key.scancode] | 0x80);
+		kbd_push_key(&ibm_pc->kbd, pc_scancode[e->key.scancode] | 0x80, e->key.timestamp);
 	}
 }
 
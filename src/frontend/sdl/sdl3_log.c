@@ -0,0 +1,65 @@
+/* sdl3_log.c
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Log drain thread; prints the log ring so the emulation thread never waits on the console
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_atomic.h>
+
+#include "sdl3_log.h"
+#include "sdl3_timing.h"
+
+#include "backend/utility/trace.h"
+
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
+
+#define LOG_DRAIN_MS 15
+
+typedef struct LOG_THREAD {
+	SDL_Thread* thread;
+	SDL_AtomicInt quit;
+} LOG_THREAD;
+
+static LOG_THREAD log_thread = { 0 };
+
+static int log_thread_main(void* param) {
+	(void)param;
+	trace_set_thread_name("log");
+
+	while (!SDL_GetAtomicInt(&log_thread.quit)) {
+		log_drain();
+		SDL_Delay(LOG_DRAIN_MS);
+	}
+	return 0;
+}
+
+int sdl_log_create(void) {
+	if (log_thread.thread != NULL) {
+		return 0; /* already running */
+	}
+
+	log_set_cb_get_ticks_ms(sdl_timing_get_ticks_ms);
+
+	SDL_SetAtomicInt(&log_thread.quit, 0);
+	log_thread.thread = SDL_CreateThread(log_thread_main, "log", NULL);
+	if (log_thread.thread == NULL) {
+		log_error("[LOG] Failed to create thread: %s\n", SDL_GetError());
+		return 1;
+	}
+	log_set_async(1);
+	return 0;
+}
+void sdl_log_destroy(void) {
+	if (log_thread.thread != NULL) {
+		SDL_SetAtomicInt(&log_thread.quit, 1);
+		SDL_WaitThread(log_thread.thread, NULL);
+		log_thread.thread = NULL;
+	}
+
+	/* Print what is left on this thread */
+	log_drain();
+	log_set_async(0);
+	log_flush();
+}
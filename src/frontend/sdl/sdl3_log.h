@@ -0,0 +1,16 @@
+/* sdl3_log.h
+ * Thomas J. Armytage 2025 ( https://github.com/tommojphillips/ )
+ * Log drain thread
+ */
+
+#ifndef SDL3_LOG_H
+#define SDL3_LOG_H
+
+/* Start the log drain thread; messages are queued from here on and printed off the logging threads
+	Returns: 1 if error; 0 if success */
+int sdl_log_create(void);
+
+/* Stop the log drain thread; the queued messages and the suppressed counts are printed */
+void sdl_log_destroy(void);
+
+#endif
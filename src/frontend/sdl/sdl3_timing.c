@@ -10,12 +10,6 @@
 #include "sdl3_timing.h"
 #include "backend/timing.h"
 
-/* Cap frame ms if run off */
-//#define CAP_MS
-
-/* Accum frame ms if run off */
-//#define ACCUM_MS
-
 TIMER_ID sdl_create_timer_ns(uint64_t interval_ns, TIMER_CALLBACK_NS callback, void* param) {
 	TIMER_ID id =  SDL_AddTimerNS(interval_ns, (SDL_NSTimerCallback)callback, param);
 	if (id == 0) {
@@ -50,6 +44,8 @@ int sdl_timing_init_frame(FRAME_STATE* time, double target_ms) {
 	time->start_frame_time = SDL_GetPerformanceCounter();
 	time->target_ms = target_ms;
 	time->freq = SDL_GetPerformanceFrequency();
+	time->catch_up = TIMING_CATCH_UP_NONE;
+	time->rate = 1.0;
 	return 0;
 }
 
@@ -64,7 +60,7 @@ int sdl_timing_reset_frame(FRAME_STATE* time) {
 int sdl_timing_new_frame(FRAME_STATE* time) {
 	/* Use Performance Counter */
 	uint64_t now = SDL_GetPerformanceCounter();
-	time->ms += ((double)(now - time->start_frame_time) / (double)time->freq * 1000.0);
+	time->ms += ((double)(now - time->start_frame_time) / (double)time->freq * 1000.0) * time->rate;
 	time->start_frame_time = now;
 	return 0;
 }
@@ -73,17 +69,38 @@ int sdl_timing_check_frame(FRAME_STATE* time) {
 	/* Use Performance Counter */
 	if (time->ms >= time->target_ms) {
 		time->last_ms = time->ms;
-#ifdef ACCUM_MS		
-		time->ms -= time->target_ms;
-#else
-		time->ms = 0;
-#endif
-#ifdef CAP_MS
-		if (time->ms > time->target_ms * 5) {
-			time->ms = time->target_ms * 5;
+
+		/* Carry the overrun into the next frame so late frames do not drift the average rate */
+		switch (time->catch_up) {
+			case TIMING_CATCH_UP_NONE:
+				time->ms = 0;
+				break;
+			case TIMING_CATCH_UP_FULL:
+				time->ms -= time->target_ms;
+				break;
+			case TIMING_CATCH_UP_CAPPED:
+				time->ms -= time->target_ms;
+				if (time->ms > time->target_ms * TIMING_CATCH_UP_CAP) {
+					time->ms = time->target_ms * TIMING_CATCH_UP_CAP;
+				}
+				break;
 		}
-#endif
 		return 1;
 	}
 	return 0;
 }
+
+uint64_t sdl_timing_frame_remaining_ns(FRAME_STATE* time) {
+	/* Use Performance Counter */
+	uint64_t now = SDL_GetPerformanceCounter();
+	double elapsed_ms = time->ms + ((double)(now - time->start_frame_time) / (double)time->freq * 1000.0) * time->rate;
+	if (elapsed_ms >= time->target_ms) {
+		return 0;
+	}
+	return (uint64_t)((time->target_ms - elapsed_ms) / time->rate * 1000000.0);
+}
+
+void sdl_timing_delay_ns(uint64_t ns) {
+	/* sleeps for most of the time and spins the last bit */
+	SDL_DelayPrecise(ns);
+}
@@ -42,4 +42,12 @@ int sdl_timing_new_frame(FRAME_STATE* time);
 	Returns: 1 if target_ms has elasped. otherwise 0. */
 int sdl_timing_check_frame(FRAME_STATE* time);
 
+/* Frame remaining; the time until target_ms elapses
+	Returns: the time in nanoseconds. 0 if target_ms has elapsed. */
+uint64_t sdl_timing_frame_remaining_ns(FRAME_STATE* time);
+
+/* Sleep until a frame is due; precise to well under a millisecond
+	ns: the time to sleep in nanoseconds */
+void sdl_timing_delay_ns(uint64_t ns);
+
 #endif
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <malloc.h>
+#include <math.h>
 
 #include <SDL3/SDL_mouse.h>
 #include <SDL3/SDL_scancode.h>
@@ -20,6 +21,7 @@
 #include "sdl3_display.h"
 #include "sdl3_keys.h"
 #include "sdl3_ui.h"
+#include "sdl3_emulation.h"
 
 #include "ui.h"
 
@@ -30,9 +32,16 @@
 #include "backend/fdc/fdd.h"
 #include "backend/hdc/xebec.h"
 #include "backend/hdc/xebec_hdd.h"
+#include "backend/hdc/vblk.h"
+#include "backend/journal.h"
+#include "backend/rewind.h"
+#include "backend/heatmap.h"
+#include "backend/disasm_cache.h"
+#include "backend/timing.h"
 #include "backend/utility/ring_buffer.h"
 
 #include "backend/io/isa_bus.h"
+#include "backend/io/memory_map.h"
 #include "backend/io/isa_cards.h"
 
 static void set_diag_context(UI_FILE_DIAG_CONTEXT* context, void* userparam, int index) {
@@ -43,34 +52,41 @@ static void set_diag_context(UI_FILE_DIAG_CONTEXT* context, void* userparam, int
 static void insert_disk(UI_FILE_DIAG_CONTEXT* context, const char* const* filelist, int filter) {
 	(void)filter;
 	if (*filelist == NULL) return;
-	fdd_eject_disk(&((FDC*)context->userparam)->fdd[context->index]);
-	fdd_insert_disk(&((FDC*)context->userparam)->fdd[context->index], *filelist);
+	emulation_lock();
+	ibm_pc_event_insert_disk((uint8_t)context->index, *filelist);
+	emulation_unlock();
 }
 static void save_disk(UI_FILE_DIAG_CONTEXT* context, const char* const* filelist, int filter) {
 	(void)filter;
 	if (*filelist == NULL) return;
+	emulation_lock();
 	fdd_save_as_disk(&((FDC*)context->userparam)->fdd[context->index], *filelist);
+	emulation_unlock();
 }
 
 static void insert_hdd(UI_FILE_DIAG_CONTEXT* context, const char* const* filelist, int filter) {
 	(void)filter;
 	if (*filelist == NULL) return;
-	xebec_hdc_eject_hdd(context->userparam, context->index);
-	xebec_hdc_insert_hdd(context->userparam, context->index, *filelist);
+	emulation_lock();
+	ibm_pc_event_insert_hdd((uint8_t)context->index, *filelist);
+	emulation_unlock();
 }
 static void save_hdd(UI_FILE_DIAG_CONTEXT* context, const char* const* filelist, int filter) {
 	(void)filter;
 	if (*filelist == NULL) return;
+	emulation_lock();
 	xebec_hdc_save_as_hdd(context->userparam, context->index, *filelist);
+	emulation_unlock();
 }
 
-static void draw_new_disk_submenu(FDD_DISK* fdd) {
+static void draw_new_disk_submenu(int disk) {
 	char str[32] = { 0 };
 	for (uint32_t i = 0; i < disk_geometry_count; ++i) {
 		sprintf(&str[0], "%zu KB", disk_geometry[i].size / 1024);
 		if (ui_menu_button(str, 0, 1)) {
-			fdd_eject_disk(fdd);
-			fdd_new_disk(fdd, disk_geometry[i].size);
+			emulation_lock();
+			ibm_pc_event_new_disk((uint8_t)disk, (uint32_t)disk_geometry[i].size);
+			emulation_unlock();
 		}
 	}
 }
@@ -85,22 +101,24 @@ static void draw_disk_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 	SDL_SetPointerProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_WINDOW_POINTER, instance->window);
 	SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_TITLE_STRING, "Load floppy disk");
 
-	if (ibm_pc->fdc.fdd[disk].path[0] == '\0') {
+	const UI_DRIVE_SNAPSHOT* fdd = &ui_context->menu.fdd[disk];
+
+	if (fdd->path[0] == '\0') {
 		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, ui_context->disk_directory);
 	}
 	else {
-		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, &ibm_pc->fdc.fdd[disk].path[0]);
+		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, &fdd->path[0]);
 	}
 
 	ui_begin_disabled(1);
-	if (ibm_pc->fdc.fdd[disk].status.inserted) {
-		ui_text("%s (%d KB)", file_get_filename(ibm_pc->fdc.fdd[disk].path), ibm_pc->fdc.fdd[disk].buffer_size / 1024);
+	if (fdd->inserted) {
+		ui_text("%s (%d KB)", file_get_filename(fdd->path), (int)(fdd->size / 1024));
 	}
 	else {
 		ui_text("No Disk Inserted");
 	}
 	ui_end_disabled();
-	if (ibm_pc->fdc.fdd[disk].status.dirty) {
+	if (fdd->dirty) {
 		ui_same_line();
 		ui_push_style_color(UI_COLOR_Text, 1, 0, 0, 1);
 		ui_text("*");
@@ -112,41 +130,70 @@ static void draw_disk_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 		SDL_ShowFileDialogWithProperties(SDL_FILEDIALOG_OPENFILE, insert_disk, &ui_context->diag_context, ui_context->diag_properties);
 	}
 	
-	if (ui_menu_button("Eject", 0, ibm_pc->fdc.fdd[disk].status.inserted)) {
-		fdd_eject_disk(&ibm_pc->fdc.fdd[disk]);
+	if (ui_menu_button("Eject", 0, fdd->inserted)) {
+		emulation_lock();
+		ibm_pc_event_eject_disk((uint8_t)disk);
+		emulation_unlock();
 	}
 
-	if (ui_menu_button("Save", 0, ibm_pc->fdc.fdd[disk].status.inserted && ibm_pc->fdc.fdd[disk].status.dirty)) {
+	if (ui_menu_button("Save", 0, fdd->inserted && fdd->dirty)) {
+		emulation_lock();
 		fdd_save_disk(&ibm_pc->fdc.fdd[disk]);
+		emulation_unlock();
 	}
 	
-	if (ui_menu_button("Save As..", 0, ibm_pc->fdc.fdd[disk].status.inserted)) {
+	if (ui_menu_button("Save As..", 0, fdd->inserted)) {
 		set_diag_context(&ui_context->diag_context, &ibm_pc->fdc, disk);
 		SDL_ShowFileDialogWithProperties(SDL_FILEDIALOG_SAVEFILE, save_disk, &ui_context->diag_context, ui_context->diag_properties);
 	}
 
-	ui_menu_checkbox_u8("Write Protect", &ibm_pc->fdc.fdd[disk].status.write_protect);
+	uint8_t write_protect = fdd->write_protect;
+	if (ui_menu_checkbox_u8("Write Protect", &write_protect)) {
+		emulation_lock();
+		ibm_pc->fdc.fdd[disk].status.write_protect = write_protect;
+		emulation_unlock();
+	}
+
+	if (fdd->overlay_enabled) {
+		ui_separator();
+		ui_begin_disabled(1);
+		ui_text("Overlay: %s (%u sectors)", file_get_filename(fdd->overlay_path), fdd->overlay_used);
+		ui_end_disabled();
+		if (ui_menu_button("Commit Overlay", 0, fdd->overlay_used > 0)) {
+			emulation_lock();
+			fdd_commit_overlay(&ibm_pc->fdc.fdd[disk]);
+			emulation_unlock();
+		}
+		if (ui_menu_button("Discard Overlay", 0, fdd->overlay_used > 0)) {
+			emulation_lock();
+			fdd_discard_overlay(&ibm_pc->fdc.fdd[disk]);
+			emulation_unlock();
+		}
+	}
 		
 	if (ui_begin_menu("New")) {
-		draw_new_disk_submenu(&ibm_pc->fdc.fdd[disk]);
+		draw_new_disk_submenu(disk);
 		ui_end_menu();
 	}
 
 	ui_separator();
 
+	uint8_t ready = fdd->ready;
 	ui_begin_disabled(1);
-	ui_menu_checkbox_u8("Ready", &ibm_pc->fdc.fdd[disk].status.ready);
+	ui_menu_checkbox_u8("Ready", &ready);
 	ui_end_disabled();
 }
 
-static int draw_hdd_type_select(int disk) {
+static int draw_hdd_type_select(UI_CONTEXT* ui_context, int disk) {
 	int sel = 0;
 	for (uint32_t i = 1; i < xebec_hdd_geometry_count; ++i) {
-		sel = ibm_pc->xebec.hdd[disk].override_geometry.type == xebec_hdd_geometry[i].type;
+		sel = ui_context->menu.hdd[disk].geometry_type == xebec_hdd_geometry[i].type;
 		if (ui_menu_button(xebec_hdd_geometry[i].name, sel, 1)) {
+			emulation_lock();
 			xebec_hdc_set_geometry_override_hdd(&ibm_pc->xebec, disk, (CHS) { 0, 0, 0 }, xebec_hdd_geometry[i].type);
 			xebec_hdc_set_geometry_hdd(&ibm_pc->xebec, disk, (CHS) { 0, 0, 0 });
 			xebec_hdc_set_dipswitch(&ibm_pc->xebec, disk, xebec_hdd_geometry[i].type);
+			emulation_unlock();
 			return 1;
 		}
 	}
@@ -156,8 +203,10 @@ static int draw_hdd_type_select(int disk) {
 static void draw_new_hdd_submenu(XEBEC_HDC* hdc, int hdd, XEBEC_FILE_TYPE file_type) {
 	for (uint32_t i = 1; i < xebec_hdd_geometry_count; ++i) {
 		if (ui_menu_button(xebec_hdd_geometry[i].name, 0, 1)) {
+			emulation_lock();
 			xebec_hdc_eject_hdd(hdc, hdd);
 			xebec_hdc_new_hdd(hdc, hdd, xebec_hdd_geometry[i].chs, file_type);
+			emulation_unlock();
 		}
 	}
 }
@@ -174,30 +223,34 @@ static void draw_hdd_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 	SDL_SetPointerProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_WINDOW_POINTER, instance->window);
 	SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_TITLE_STRING, "Load Hard disk");
 
-	if (ibm_pc->xebec.hdd[disk].path[0] == '\0') {
+	const UI_DRIVE_SNAPSHOT* hdd = &ui_context->menu.hdd[disk];
+
+	if (hdd->path[0] == '\0') {
 		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, ui_context->hdd_directory);
 	}
 	else {
-		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, &ibm_pc->xebec.hdd[disk].path[0]);
+		SDL_SetStringProperty(ui_context->diag_properties, SDL_PROP_FILE_DIALOG_LOCATION_STRING, &hdd->path[0]);
 	}
 
 	ui_begin_disabled(1);
-	if (ibm_pc->xebec.hdd[disk].inserted) {
-		ui_text("%s (%.2f MB)", file_get_filename(ibm_pc->xebec.hdd[disk].path), (float)ibm_pc->xebec.hdd[disk].file_size / 1024 / 1024);
+	if (hdd->inserted) {
+		ui_text("%s (%.2f MB)", file_get_filename(hdd->path), (float)hdd->size / 1024 / 1024);
 	}
 	else {
 		ui_text("No HDD Inserted");
 	}
 	ui_end_disabled();
-	if (ibm_pc->xebec.hdd[disk].dirty) {
+	if (hdd->dirty) {
 		ui_same_line();
 		ui_push_style_color(UI_COLOR_Text, 1, 0, 0, 1);
 		ui_text("*");
 		ui_pop_style_color(1);
 	}
 
-	if (ui_menu_button("Reload", 0, ibm_pc->xebec.hdd[disk].inserted)) {
+	if (ui_menu_button("Reload", 0, hdd->inserted)) {
+		emulation_lock();
 		xebec_hdc_reinsert_hdd(&ibm_pc->xebec, disk);
+		emulation_unlock();
 	}
 
 	if (ui_menu_button("Insert", 0, 1)) {
@@ -205,22 +258,44 @@ static void draw_hdd_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 		SDL_ShowFileDialogWithProperties(SDL_FILEDIALOG_OPENFILE, insert_hdd, &ui_context->diag_context, ui_context->diag_properties);
 	}
 
-	if (ui_menu_button("Eject", 0, ibm_pc->xebec.hdd[disk].inserted)) {
-		xebec_hdc_eject_hdd(&ibm_pc->xebec, disk);
+	if (ui_menu_button("Eject", 0, hdd->inserted)) {
+		emulation_lock();
+		ibm_pc_event_eject_hdd((uint8_t)disk);
+		emulation_unlock();
 	}
 
-	if (ui_menu_button("Save", 0, ibm_pc->xebec.hdd[disk].inserted && ibm_pc->xebec.hdd[disk].dirty)) {
+	if (ui_menu_button("Save", 0, hdd->inserted && hdd->dirty)) {
+		emulation_lock();
 		xebec_hdc_save_hdd(&ibm_pc->xebec, disk);
+		emulation_unlock();
 	}
 
-	if (ui_menu_button("Save As..", 0, ibm_pc->xebec.hdd[disk].inserted)) {
+	if (ui_menu_button("Save As..", 0, hdd->inserted)) {
 		set_diag_context(&ui_context->diag_context, &ibm_pc->xebec, disk);
 		SDL_ShowFileDialogWithProperties(SDL_FILEDIALOG_SAVEFILE, save_hdd, &ui_context->diag_context, ui_context->diag_properties);
 	}
 
-	if (ibm_pc->xebec.hdd[disk].file_type == XEBEC_FILE_TYPE_RAW) {
+	if (hdd->overlay_enabled) {
+		ui_separator();
+		ui_begin_disabled(1);
+		ui_text("Overlay: %s (%u sectors)", file_get_filename(hdd->overlay_path), hdd->overlay_used);
+		ui_end_disabled();
+		if (ui_menu_button("Commit Overlay", 0, hdd->overlay_used > 0)) {
+			emulation_lock();
+			xebec_hdc_commit_overlay_hdd(&ibm_pc->xebec, disk);
+			emulation_unlock();
+		}
+		if (ui_menu_button("Discard Overlay", 0, hdd->overlay_used > 0)) {
+			emulation_lock();
+			xebec_hdc_discard_overlay_hdd(&ibm_pc->xebec, disk);
+			emulation_unlock();
+		}
+		ui_separator();
+	}
+
+	if (hdd->file_type == XEBEC_FILE_TYPE_RAW) {
 		if (ui_begin_menu("Geometry")) {
-			draw_hdd_type_select(disk);
+			draw_hdd_type_select(ui_context, disk);
 			ui_end_menu();
 		}
 	}
@@ -230,6 +305,10 @@ static void draw_hdd_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 			draw_new_hdd_submenu(&ibm_pc->xebec, disk, XEBEC_FILE_TYPE_VHD);
 			ui_end_menu();
 		}
+		if (ui_begin_menu("Vhd (Dynamic)")) {
+			draw_new_hdd_submenu(&ibm_pc->xebec, disk, XEBEC_FILE_TYPE_VHD_DYNAMIC);
+			ui_end_menu();
+		}
 		if (ui_begin_menu("Raw")) {
 			draw_new_hdd_submenu(&ibm_pc->xebec, disk, XEBEC_FILE_TYPE_RAW);
 			ui_end_menu();
@@ -237,26 +316,53 @@ static void draw_hdd_submenu(UI_CONTEXT* ui_context, WINDOW_INSTANCE* instance,
 		ui_end_menu();
 	}
 }
+static void draw_vblk_submenu(UI_CONTEXT* ui_context) {
+	const UI_DRIVE_SNAPSHOT* vblk = &ui_context->menu.vblk;
+	ui_begin_disabled(1);
+	ui_text("%s (%.2f MB)", file_get_filename(vblk->path), (float)vblk->size / 1024 / 1024);
+	if (vblk->drive != 0) {
+		ui_text("INT 13h drive %02Xh", vblk->drive);
+	}
+	ui_end_disabled();
+	if (vblk->dirty) {
+		ui_same_line();
+		ui_push_style_color(UI_COLOR_Text, 1, 0, 0, 1);
+		ui_text("*");
+		ui_pop_style_color(1);
+	}
+
+	if (ui_menu_button("Save", 0, vblk->dirty)) {
+		emulation_lock();
+		vblk_save(&ibm_pc->vblk);
+		emulation_unlock();
+	}
+}
 static void draw_display_submenu(DISPLAY_INSTANCE* display) {
 	int sel = 0;
 	if (ui_begin_menu("Change Adapter")) {
 
 		sel = ibm_pc->config.video_adapter == VIDEO_ADAPTER_MDA_80X25;
 		if (ui_menu_button("MDA", sel, !sel)) {
+			emulation_lock();
 			display_on_video_adapter_changed(display, VIDEO_ADAPTER_MDA_80X25);
 			ibm_pc->config.video_adapter = VIDEO_ADAPTER_MDA_80X25;
+			emulation_unlock();
 		}
 
 		sel = ibm_pc->config.video_adapter == VIDEO_ADAPTER_CGA_80X25 || ibm_pc->config.video_adapter == VIDEO_ADAPTER_CGA_40X25;
 		if (ui_menu_button("CGA", sel, !sel)) {
+			emulation_lock();
 			display_on_video_adapter_changed(display, VIDEO_ADAPTER_CGA_80X25);
 			ibm_pc->config.video_adapter = VIDEO_ADAPTER_CGA_80X25;
+			emulation_unlock();
 		}
 
 		sel = ibm_pc->config.video_adapter == VIDEO_ADAPTER_RESERVED;
 		if (ui_menu_button("Extension", sel, !sel)) {
+			emulation_lock();
 			display_on_video_adapter_changed(display, VIDEO_ADAPTER_RESERVED);
 			ibm_pc->config.video_adapter = VIDEO_ADAPTER_RESERVED;
+			emulation_unlock();
 		}
 
 		ui_end_menu();
@@ -326,6 +432,14 @@ static void draw_display_submenu(DISPLAY_INSTANCE* display) {
 }
 static void draw_dipswitch_submenu(void) {
 
+	/* The switches are changed on a copy; written back under the emulation lock */
+	uint8_t model = ibm_pc->config.model;
+	uint8_t sw1 = ibm_pc->config.sw1;
+	uint8_t sw2 = ibm_pc->config.sw2;
+	uint8_t sw1_provided = ibm_pc->config.sw1_provided;
+	uint8_t sw2_provided = ibm_pc->config.sw2_provided;
+	int set_config = 0;
+
 	uint8_t sw1_mask = 0;
 	uint8_t sw1_dp_mask = 0;
 	uint8_t sw2_mask = 0;
@@ -343,7 +457,7 @@ static void draw_dipswitch_submenu(void) {
 
 	uint8_t sw = 0;
 
-	switch (ibm_pc->config.model) {
+	switch (model) {
 		case MODEL_5150_16_64:
 			sw1_mask = 0xFF;
 			sw2_mask = 0x0F;
@@ -353,8 +467,8 @@ static void draw_dipswitch_submenu(void) {
 			ram_inc_below_planar_max = 16;
 			ram_inc_above_planar_max = 32;
 			if (ui_menu_button("Model: IBM 5150 16KB-64KB ", 0, 1)) {
-				ibm_pc->config.model = MODEL_5150_64_256;
-				ibm_pc_set_config();
+				model = MODEL_5150_64_256;
+				set_config = 1;
 			}
 			break;
 
@@ -367,8 +481,8 @@ static void draw_dipswitch_submenu(void) {
 			ram_inc_below_planar_max = 64;
 			ram_inc_above_planar_max = 32;
 			if (ui_menu_button("Model: IBM 5150 64KB-256KB", 0, 1)) {
-				ibm_pc->config.model = MODEL_5160;
-				ibm_pc_set_config();
+				model = MODEL_5160;
+				set_config = 1;
 			}
 			break;
 
@@ -381,20 +495,20 @@ static void draw_dipswitch_submenu(void) {
 			ram_inc_below_planar_max = 64;
 			ram_inc_above_planar_max = 32;
 			if (ui_menu_button("Model: IBM 5160", 0, 1)) {
-				ibm_pc->config.model = MODEL_5150_16_64;
-				ibm_pc_set_config();
+				model = MODEL_5150_16_64;
+				set_config = 1;
 			}
 			break;
 	}
 
-	if (ibm_pc->config.sw1_provided) {
+	if (sw1_provided) {
 		sw1_dp_mask = sw1_mask; /* Enable sw1 dipswitch */
 	}
 	else {
 		sw1_dp_mask = 0; /* Disable sw1 dipswitch */
 	}
 
-	if (ibm_pc->config.sw2_provided) {
+	if (sw2_provided) {
 		sw2_dp_mask = sw2_mask; /* Enable sw2 dipswitch */
 	}
 	else {
@@ -405,116 +519,116 @@ static void draw_dipswitch_submenu(void) {
 	
 	ui_button("SW1: ");
 	ui_same_line_spacing(0);
-	sw = ~ibm_pc->config.sw1; /* invert sw like on planar */
+	sw = ~sw1; /* invert sw like on planar */
 	if (ui_dipswitch_u8("##sw1_dp", &sw, sw1_dp_mask)) {
-		ibm_pc->config.sw1 = ~sw; /* invert sw back if changed */
-		ibm_pc_set_config();
+		sw1 = ~sw; /* invert sw back if changed */
+		set_config = 1;
 	}
 	ui_same_line_spacing(0);
-	if (ibm_pc->config.sw1_provided) {
+	if (sw1_provided) {
 		if (ui_button("Manual##dp1")) {
-			ibm_pc->config.sw1_provided = 0;
+			sw1_provided = 0;
 		}
 	}
 	else {
 		if (ui_button("Auto##dp1")) {
-			ibm_pc->config.sw1_provided = 1;
+			sw1_provided = 1;
 		}
 	}
-	if (ibm_pc->config.model == MODEL_5150_16_64 || ibm_pc->config.model == MODEL_5150_64_256) {
+	if (model == MODEL_5150_16_64 || model == MODEL_5150_64_256) {
 		ui_button("SW2: ");
 		ui_same_line_spacing(0);
-		sw = ~ibm_pc->config.sw2; /* invert sw like on planar */
+		sw = ~sw2; /* invert sw like on planar */
 		if (ui_dipswitch_u8("##sw2_dp", &sw, sw2_dp_mask)) {
-			ibm_pc->config.sw2 = ~sw; /* invert sw back if changed */
-			ibm_pc_set_config();
+			sw2 = ~sw; /* invert sw back if changed */
+			set_config = 1;
 		}
 		ui_same_line_spacing(0);
-		if (ibm_pc->config.sw2_provided) {
+		if (sw2_provided) {
 			if (ui_button("Manual##dp2")) {
-				ibm_pc->config.sw2_provided = 0;
+				sw2_provided = 0;
 			}
 		}
 		else {
 			if (ui_button("Auto##dp2")) {
-				ibm_pc->config.sw2_provided = 1;
+				sw2_provided = 1;
 			}
 		}
 	}
 	else {
-		ibm_pc->config.sw2_provided = 0;
+		sw2_provided = 0;
 	}
 	ui_separator();
 	
-	if (!ibm_pc->config.sw1_provided) {
+	if (!sw1_provided) {
 		int sel = 0;
 
-		if (ibm_pc->config.model == MODEL_5160) {
-			sel = !(ibm_pc->config.sw1 & SW1_CONTINUOUSLY_POST);
+		if (model == MODEL_5160) {
+			sel = !(sw1 & SW1_CONTINUOUSLY_POST);
 			if (ui_menu_button("Continuous POST", sel, 1)) {
-				ibm_pc->config.sw1 ^= SW1_CONTINUOUSLY_POST;
-				ibm_pc_set_config();
+				sw1 ^= SW1_CONTINUOUSLY_POST;
+				set_config = 1;
 			}
 		}
 
 		if (ui_begin_menu("Adapter")) {
 
-			sel = (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_MDA_80X25;
+			sel = (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_MDA_80X25;
 			if (ui_menu_button("MDA", sel, !sel)) {
-				ibm_pc->config.sw1 &= ~SW1_DISPLAY_MASK;
-				ibm_pc->config.sw1 |= SW1_DISPLAY_MDA_80X25;
+				sw1 &= ~SW1_DISPLAY_MASK;
+				sw1 |= SW1_DISPLAY_MDA_80X25;
 			}
 
-			sel = (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_80X25;
+			sel = (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_80X25;
 			if (ui_menu_button("CGA 80", sel, !sel)) {
-				ibm_pc->config.sw1 &= ~SW1_DISPLAY_MASK;
-				ibm_pc->config.sw1 |= SW1_DISPLAY_CGA_80X25;
+				sw1 &= ~SW1_DISPLAY_MASK;
+				sw1 |= SW1_DISPLAY_CGA_80X25;
 			}
 
-			sel = (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_40X25;
+			sel = (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_40X25;
 			if (ui_menu_button("CGA 40", sel, !sel)) {
-				ibm_pc->config.sw1 &= ~SW1_DISPLAY_MASK;
-				ibm_pc->config.sw1 |= SW1_DISPLAY_CGA_40X25;
+				sw1 &= ~SW1_DISPLAY_MASK;
+				sw1 |= SW1_DISPLAY_CGA_40X25;
 			}
 
-			sel = (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_RESERVED;
+			sel = (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_RESERVED;
 			if (ui_menu_button("Extension", sel, !sel)) {
-				ibm_pc->config.sw1 &= ~SW1_DISPLAY_MASK;
-				ibm_pc->config.sw1 |= SW1_DISPLAY_RESERVED;
+				sw1 &= ~SW1_DISPLAY_MASK;
+				sw1 |= SW1_DISPLAY_RESERVED;
 			}
 
 			ui_end_menu();
 		}
 
 		if (ui_begin_menu("Floppy drives")) {
-			if (ibm_pc->config.model == MODEL_5150_16_64 || ibm_pc->config.model == MODEL_5150_64_256) {
-				sel = (ibm_pc->config.sw1 & SW1_HAS_FDC) == 0;
+			if (model == MODEL_5150_16_64 || model == MODEL_5150_64_256) {
+				sel = (sw1 & SW1_HAS_FDC) == 0;
 				if (ui_menu_button("0##floppy_drives", sel, !sel)) {
-					ibm_pc->config.sw1 &= ~SW1_HAS_FDC;
-					ibm_pc->config.sw1 &= ~SW1_DISKS_MASK;
-					ibm_pc_set_config();
+					sw1 &= ~SW1_HAS_FDC;
+					sw1 &= ~SW1_DISKS_MASK;
+					set_config = 1;
 				}
 
 
 				for (uint8_t k = 1; k <= 4; ++k) {
-					sel = (ibm_pc->config.sw1 & SW1_HAS_FDC) == SW1_HAS_FDC && (ibm_pc->config.sw1 & SW1_DISKS_MASK) == (k - 1) << 6;
+					sel = (sw1 & SW1_HAS_FDC) == SW1_HAS_FDC && (sw1 & SW1_DISKS_MASK) == (k - 1) << 6;
 					sprintf(&str[0], "%d##floppy_drives", k);
 					if (ui_menu_button(str, sel, !sel)) {
-						ibm_pc->config.sw1 |= SW1_HAS_FDC;
-						ibm_pc->config.sw1 &= ~SW1_DISKS_MASK;
-						ibm_pc->config.sw1 |= (k - 1) << 6;
-						ibm_pc_set_config();
+						sw1 |= SW1_HAS_FDC;
+						sw1 &= ~SW1_DISKS_MASK;
+						sw1 |= (k - 1) << 6;
+						set_config = 1;
 					}
 				}
 			}
 			else {
 				for (uint8_t k = 1; k <= 4; ++k) {
-					sel = (ibm_pc->config.sw1 & SW1_DISKS_MASK) == (k - 1) << 6;
+					sel = (sw1 & SW1_DISKS_MASK) == (k - 1) << 6;
 					sprintf(&str[0], "%d##floppy_drives", k);
 					if (ui_menu_button(str, sel, !sel)) {
-						ibm_pc->config.sw1 &= ~SW1_DISKS_MASK;
-						ibm_pc->config.sw1 |= (k - 1) << 6;
-						ibm_pc_set_config();
+						sw1 &= ~SW1_DISKS_MASK;
+						sw1 |= (k - 1) << 6;
+						set_config = 1;
 					}
 				}
 			}
@@ -524,18 +638,18 @@ static void draw_dipswitch_submenu(void) {
 		if (ui_begin_menu("Planar RAM")) {
 			for (uint20_t k = total_ram_min; k <= planar_ram_max; k += ram_inc_below_planar_max) {
 				sprintf(&str[0], "%u KB##planar_ram", k);
-				sel = k * 1024 == determine_planar_ram_size(ibm_pc->config.sw1);
+				sel = k * 1024 == determine_planar_ram_size(sw1);
 				if (ui_menu_button(str, sel, !sel)) {
-					ibm_pc->config.sw1 &= ~SW1_MEMORY_MASK;
-					ibm_pc->config.sw1 |= determine_planar_ram_sw(k * 1024);
+					sw1 &= ~SW1_MEMORY_MASK;
+					sw1 |= determine_planar_ram_sw(k * 1024);
 
 					/* IO RAM should only be set if planar RAM >= 64 */
 					if (k <= planar_ram_max) {
-						uint20_t planar_ram = determine_planar_ram_size(ibm_pc->config.sw1);
-						ibm_pc->config.sw2 = determine_io_ram_sw(planar_ram, 0);
+						uint20_t planar_ram = determine_planar_ram_size(sw1);
+						sw2 = determine_io_ram_sw(planar_ram, 0);
 					}
 
-					ibm_pc_set_config();
+					set_config = 1;
 				}
 			}
 
@@ -543,21 +657,21 @@ static void draw_dipswitch_submenu(void) {
 		}
 	}
 
-	if (!ibm_pc->config.sw2_provided) {
+	if (!sw2_provided) {
 
 		if (ui_begin_menu("IO RAM")) {
 			for (uint20_t k = 0; k <= total_ram_max - planar_ram_max; k += 32) {
 				sprintf(&str[0], "%u KB##io_ram", k);
-				int sel = k * 1024 == determine_io_ram_size(ibm_pc->config.sw1, ibm_pc->config.sw2);
+				int sel = k * 1024 == determine_io_ram_size(sw1, sw2);
 				if (ui_menu_button(str, sel, !sel)) {
-					uint20_t planar_ram = determine_planar_ram_size(ibm_pc->config.sw1);
-					ibm_pc->config.sw2 = determine_io_ram_sw(planar_ram, k * 1024);
+					uint20_t planar_ram = determine_planar_ram_size(sw1);
+					sw2 = determine_io_ram_sw(planar_ram, k * 1024);
 
 					/* Planar RAM should be set to 4 Banks if IO RAM > 0 */
 					if (k > 0) {
-						ibm_pc->config.sw1 |= SW1_MEMORY_64K;
+						sw1 |= SW1_MEMORY_64K;
 					}
-					ibm_pc_set_config();
+					set_config = 1;
 				}
 			}
 
@@ -565,23 +679,23 @@ static void draw_dipswitch_submenu(void) {
 		}
 	}
 
-	if (!ibm_pc->config.sw1_provided && !ibm_pc->config.sw2_provided) {
+	if (!sw1_provided && !sw2_provided) {
 		if (ui_begin_menu("Total RAM")) {
 			for (uint20_t k = total_ram_min; k <= total_ram_max;) {
 				sprintf(&str[0], "%u KB##total_ram", k);
-				int sel = k * 1024 == determine_planar_ram_size(ibm_pc->config.sw1) + determine_io_ram_size(ibm_pc->config.sw1, ibm_pc->config.sw2);
+				int sel = k * 1024 == determine_planar_ram_size(sw1) + determine_io_ram_size(sw1, sw2);
 				if (ui_menu_button(str, sel, !sel)) {
 
-					ibm_pc->config.sw1 &= ~SW1_MEMORY_MASK;
+					sw1 &= ~SW1_MEMORY_MASK;
 					if (k >= planar_ram_max) {
-						ibm_pc->config.sw1 |= determine_planar_ram_sw(planar_ram_max * 1024);
-						ibm_pc->config.sw2 = determine_io_ram_sw(planar_ram_max * 1024, (k - planar_ram_max) * 1024);
+						sw1 |= determine_planar_ram_sw(planar_ram_max * 1024);
+						sw2 = determine_io_ram_sw(planar_ram_max * 1024, (k - planar_ram_max) * 1024);
 					}
 					else {
-						ibm_pc->config.sw1 |= determine_planar_ram_sw(k * 1024);
-						ibm_pc->config.sw2 = determine_io_ram_sw(k * 1024, 0);
+						sw1 |= determine_planar_ram_sw(k * 1024);
+						sw2 = determine_io_ram_sw(k * 1024, 0);
 					}
-					ibm_pc_set_config();
+					set_config = 1;
 				}
 
 				if (k >= planar_ram_max) {
@@ -595,41 +709,55 @@ static void draw_dipswitch_submenu(void) {
 		}
 	}
 
-	if (!ibm_pc->config.sw1_provided || !ibm_pc->config.sw2_provided) {		
+	if (!sw1_provided || !sw2_provided) {		
 		ui_separator();
 	}
 		
-	if (ibm_pc->config.model == MODEL_5160) {
-		ui_text("Continuous POST: %s", (ibm_pc->config.sw1& SW1_CONTINUOUSLY_POST) ? "No" : "Yes");
+	if (model == MODEL_5160) {
+		ui_text("Continuous POST: %s", (sw1& SW1_CONTINUOUSLY_POST) ? "No" : "Yes");
 		ui_separator();
 	}
 
-	ui_text("Has FPU:         %s", (ibm_pc->config.sw1 & SW1_HAS_FPU) == SW1_HAS_FPU ? "Yes" : "No");
+	ui_text("Has FPU:         %s", (sw1 & SW1_HAS_FPU) == SW1_HAS_FPU ? "Yes" : "No");
 	ui_separator();
 	
-	ui_text("Adapter:         %s", (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_MDA_80X25 ? "MDA" : (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_80X25 ? "CGA 80" : (ibm_pc->config.sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_40X25 ? "CGA 40" : "Extension");
+	ui_text("Adapter:         %s", (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_MDA_80X25 ? "MDA" : (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_80X25 ? "CGA 80" : (sw1 & SW1_DISPLAY_MASK) == SW1_DISPLAY_CGA_40X25 ? "CGA 40" : "Extension");
 	ui_separator();
 
-	if (ibm_pc->config.model == MODEL_5150_16_64 || ibm_pc->config.model == MODEL_5150_64_256) {
-		if ((ibm_pc->config.sw1 & SW1_HAS_FDC) == SW1_HAS_FDC) {
+	if (model == MODEL_5150_16_64 || model == MODEL_5150_64_256) {
+		if ((sw1 & SW1_HAS_FDC) == SW1_HAS_FDC) {
 			ui_text("Has FDC:         Yes");
-			ui_text("Num Disks:       %s", (ibm_pc->config.sw1 & SW1_DISKS_MASK) == SW1_DISKS_1 ? "1" : (ibm_pc->config.sw1 & SW1_DISKS_MASK) == SW1_DISKS_2 ? "2" : (ibm_pc->config.sw1 & SW1_DISKS_MASK) == SW1_DISKS_3 ? "3" : "4");
+			ui_text("Num Disks:       %s", (sw1 & SW1_DISKS_MASK) == SW1_DISKS_1 ? "1" : (sw1 & SW1_DISKS_MASK) == SW1_DISKS_2 ? "2" : (sw1 & SW1_DISKS_MASK) == SW1_DISKS_3 ? "3" : "4");
 		}
 		else {
 			ui_text("Has FDC:         No");
 		}
 	}
 	else {
-		ui_text("Num Disks:       %s", (ibm_pc->config.sw1& SW1_DISKS_MASK) == SW1_DISKS_1 ? "1" : (ibm_pc->config.sw1 & SW1_DISKS_MASK) == SW1_DISKS_2 ? "2" : (ibm_pc->config.sw1 & SW1_DISKS_MASK) == SW1_DISKS_3 ? "3" : "4");
+		ui_text("Num Disks:       %s", (sw1& SW1_DISKS_MASK) == SW1_DISKS_1 ? "1" : (sw1 & SW1_DISKS_MASK) == SW1_DISKS_2 ? "2" : (sw1 & SW1_DISKS_MASK) == SW1_DISKS_3 ? "3" : "4");
 	}
 	ui_separator();
 	
-	uint20_t io_ram = determine_io_ram_size(ibm_pc->config.sw1, ibm_pc->config.sw2) / 1024;
-	uint20_t planar_ram = determine_planar_ram_size(ibm_pc->config.sw1) / 1024;
+	uint20_t io_ram = determine_io_ram_size(sw1, sw2) / 1024;
+	uint20_t planar_ram = determine_planar_ram_size(sw1) / 1024;
 
 	ui_text("Planar RAM:      %u KB", planar_ram);
 	ui_text("IO RAM:          %u KB", io_ram);
 	ui_text("Total RAM:       %u KB", planar_ram + io_ram);
+
+	if (set_config || model != ibm_pc->config.model || sw1 != ibm_pc->config.sw1 || sw2 != ibm_pc->config.sw2 ||
+		sw1_provided != ibm_pc->config.sw1_provided || sw2_provided != ibm_pc->config.sw2_provided) {
+		emulation_lock();
+		ibm_pc->config.model = model;
+		ibm_pc->config.sw1 = sw1;
+		ibm_pc->config.sw2 = sw2;
+		ibm_pc->config.sw1_provided = sw1_provided;
+		ibm_pc->config.sw2_provided = sw2_provided;
+		if (set_config) {
+			ibm_pc_set_config();
+		}
+		emulation_unlock();
+	}
 }
 
 static void set_breakpoint_from_int(uint32_t address, UI_CONTEXT* ui_context) {
@@ -639,21 +767,27 @@ static void set_breakpoint_from_int(uint32_t address, UI_CONTEXT* ui_context) {
 	else {
 		SDL_ultoa(address, ui_context->buffer, 16);
 	}
+	emulation_lock();
 	ibm_pc->breakpoint = address;
+	emulation_unlock();
 }
 
 static void set_breakpoint_from_str(UI_CONTEXT* ui_context) {
+	uint32_t breakpoint = 0;
 	const char* delim = SDL_strrchr(ui_context->buffer, ':');
 	if (delim == NULL) {
-		ibm_pc->breakpoint = SDL_strtoul(ui_context->buffer, NULL, 16) & 0xFFFF;
+		breakpoint = SDL_strtoul(ui_context->buffer, NULL, 16) & 0xFFFF;
 	}
 	else {
 		uint16_t seg = SDL_strtoul(ui_context->buffer, NULL, 16) & 0xFFFF;
 		uint16_t addr = SDL_strtoul(delim+1, NULL, 16) & 0xFFFF;
-		ibm_pc->breakpoint = i8086_get_physical_address(seg, addr);
+		breakpoint = i8086_get_physical_address(seg, addr);
 	}
+	emulation_lock();
+	ibm_pc->breakpoint = breakpoint;
+	emulation_unlock();
 
-	if (ibm_pc->breakpoint == 0) {
+	if (breakpoint == 0) {
 		ui_context->buffer[0] = '\0';
 	}
 }
@@ -666,19 +800,25 @@ static void to_upper(char* buffer) {
 		}
 	}
 }
-static void show_gpr_tooltip(int index) {
+static void show_gpr_tooltip(const I8086* cpu, int index) {
 	ui_set_item_tooltip("L = %02X   %d\nH = %02X   %d\nX = %04X %d",
-		ibm_pc->cpu.registers[index].l, ibm_pc->cpu.registers[index].l,
-		ibm_pc->cpu.registers[index].h, ibm_pc->cpu.registers[index].h,
-		ibm_pc->cpu.registers[index].r16, ibm_pc->cpu.registers[index].r16);
+		cpu->registers[index].l, cpu->registers[index].l,
+		cpu->registers[index].h, cpu->registers[index].h,
+		cpu->registers[index].r16, cpu->registers[index].r16);
+}
+static void show_r16_tooltip(const I8086* cpu, int index) {
+	ui_set_item_tooltip("%04X %d", cpu->registers[index].r16, cpu->registers[index].r16);
 }
-static void show_r16_tooltip(int index) {
-	ui_set_item_tooltip("%04X %d", ibm_pc->cpu.registers[index].r16, ibm_pc->cpu.registers[index].r16);
+static void set_step(uint8_t step) {
+	emulation_lock();
+	ibm_pc->step = step;
+	emulation_unlock();
 }
 
 static void draw_cpu_control(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
+	UI_SNAPSHOT* snapshot = &ui_context->snapshot;
 
-	if (ibm_pc->step) {
+	if (snapshot->step) {
 		ui_text("Single stepping");
 	}
 	else {
@@ -687,133 +827,158 @@ static void draw_cpu_control(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display)
 
 	ui_separator();
 
-	if (ibm_pc->step) {
+	if (snapshot->step) {
 		if (ui_button("Continue")) {
-			ibm_pc->step = 0;
+			set_step(0);
 		}
 		ui_same_line();
 		if (ui_button("Step into")) {
-			ibm_pc->step = 2;
+			set_step(2);
 		}
 		ui_same_line();
-		i8086_mnem(&ibm_pc->mnem);
 		if (ui_button("Step over")) {
-			if (ibm_pc->mnem.step_over_has_target) {
+			emulation_lock();
+			if (snapshot->mnem.step_over_has_target) {
 				ibm_pc->step = 0;
-				ibm_pc->step_over_target = i8086_mnem_get_step_over_target(&ibm_pc->mnem);
+				ibm_pc->step_over_target = i8086_mnem_get_step_over_target(&snapshot->mnem);
 			}
 			else {
 				ibm_pc->step = 2;
 			}
+			emulation_unlock();
 		}
-		if (ibm_pc->mnem.step_over_has_target) {
-			ui_set_item_tooltip("Target: %05X", i8086_mnem_get_step_over_target(&ibm_pc->mnem));
+		if (snapshot->mnem.step_over_has_target) {
+			ui_set_item_tooltip("Target: %05X", i8086_mnem_get_step_over_target(&snapshot->mnem));
 		}
 	}
 	else {
 		if (ui_button("Break All")) {
-			ibm_pc->step = 1;
+			set_step(1);
 		}
 	}
 
 	if (ui_text_input("Breakpoint", ui_context->buffer, 10)) {
 		set_breakpoint_from_str(ui_context);
 	}
+
+	if (ibm_pc->rewind.base != NULL) {
+		ui_separator();
+
+		const uint64_t cycles = snapshot->cycles;
+		const uint64_t oldest = snapshot->rewind_oldest;
+		ui_text("Rewind: %.1f s (%u snapshots, %zu KB)", (double)(cycles - oldest) / CPU_CLOCK, snapshot->rewind_count, snapshot->rewind_used / 1024);
+
+		ui_begin_disabled(snapshot->rewind_count == 0 || snapshot->journal_mode != JOURNAL_MODE_NONE);
+		if (ui_button("Step back")) {
+			emulation_lock();
+			ibm_pc_step_back();
+			emulation_unlock();
+		}
+		ui_same_line();
+		if (ui_button("Back 1s")) {
+			uint64_t target = cycles > (uint64_t)CPU_CLOCK ? cycles - (uint64_t)CPU_CLOCK : 0;
+			emulation_lock();
+			ibm_pc_rewind_to(target > oldest ? target : oldest);
+			emulation_unlock();
+		}
+		ui_end_disabled();
+	}
 }
 static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
+	const I8086* cpu = &ui_context->snapshot.cpu;
+	I8086_MNEM* mnem = &ui_context->snapshot.mnem;
 	VECTOR4 vec4 = { 0.2f, 1.0f, 0.35f, 1.0f };
 
 	ui_text_colored_vec(&vec4, "AX");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_AX].r16);
-	show_gpr_tooltip(REG_AX);
+	ui_text("%04X", cpu->registers[REG_AX].r16);
+	show_gpr_tooltip(cpu, REG_AX);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "BX");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_BX].r16);
-	show_gpr_tooltip(REG_BX);
+	ui_text("%04X", cpu->registers[REG_BX].r16);
+	show_gpr_tooltip(cpu, REG_BX);
 
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "PSW   ");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.status.word);
+	ui_text("%04X", cpu->status.word);
 
 	ui_text_colored_vec(&vec4, "CX");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_CX].r16);
-	show_gpr_tooltip(REG_CX);
+	ui_text("%04X", cpu->registers[REG_CX].r16);
+	show_gpr_tooltip(cpu, REG_CX);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "DX");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_DX].r16);
-	show_gpr_tooltip(REG_DX);
+	ui_text("%04X", cpu->registers[REG_DX].r16);
+	show_gpr_tooltip(cpu, REG_DX);
 
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "IP    ");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.ip);
+	ui_text("%04X", cpu->ip);
 
 	ui_text_colored_vec(&vec4, "SI");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_SI].r16);
-	show_r16_tooltip(REG_SI);
+	ui_text("%04X", cpu->registers[REG_SI].r16);
+	show_r16_tooltip(cpu, REG_SI);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "DI");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_DI].r16);
-	show_r16_tooltip(REG_DI);
+	ui_text("%04X", cpu->registers[REG_DI].r16);
+	show_r16_tooltip(cpu, REG_DI);
 
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "SS:BP");
 	ui_same_line();
-	ui_text("%05X", i8086_get_physical_address(ibm_pc->cpu.segments[SEG_SS], ibm_pc->cpu.registers[REG_BP].r16));
+	ui_text("%05X", i8086_get_physical_address(cpu->segments[SEG_SS], cpu->registers[REG_BP].r16));
 
 	ui_text_colored_vec(&vec4, "SP");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_SP].r16);
+	ui_text("%04X", cpu->registers[REG_SP].r16);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "BP");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.registers[REG_BP].r16);
+	ui_text("%04X", cpu->registers[REG_BP].r16);
 
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "SS:SP");
 	ui_same_line();
-	ui_text("%05X", i8086_get_physical_address(ibm_pc->cpu.segments[SEG_SS], ibm_pc->cpu.registers[REG_SP].r16));
+	ui_text("%05X", i8086_get_physical_address(cpu->segments[SEG_SS], cpu->registers[REG_SP].r16));
 
 	ui_text_colored_vec(&vec4, "ES");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.segments[SEG_ES]);
+	ui_text("%04X", cpu->segments[SEG_ES]);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "CS");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.segments[SEG_CS]);
+	ui_text("%04X", cpu->segments[SEG_CS]);
 
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "CS:IP");
 	ui_same_line();
-	ui_text("%05X", i8086_get_physical_address(ibm_pc->cpu.segments[SEG_CS], ibm_pc->cpu.ip));
+	ui_text("%05X", i8086_get_physical_address(cpu->segments[SEG_CS], cpu->ip));
 
 	ui_text_colored_vec(&vec4, "DS");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.segments[SEG_DS]);
+	ui_text("%04X", cpu->segments[SEG_DS]);
 	ui_same_line();
 	ui_text_colored_vec(&vec4, "SS");
 	ui_same_line();
-	ui_text("%04X", ibm_pc->cpu.segments[SEG_SS]);
+	ui_text("%04X", cpu->segments[SEG_SS]);
 
-	i8086_mnem(&ibm_pc->mnem);
-	if (ibm_pc->mnem.has_ea) {
-		to_upper(ibm_pc->mnem.ea_str);
+	if (mnem->has_ea) {
+		to_upper(mnem->ea_str);
 		ui_same_line();
-		ui_text_colored_vec(&vec4, ibm_pc->mnem.ea_str);
+		ui_text_colored_vec(&vec4, mnem->ea_str);
 		ui_same_line();
-		ui_text("%05X", i8086_get_physical_address(ibm_pc->mnem.ea_segment, ibm_pc->mnem.ea_offset));
+		ui_text("%05X", i8086_get_physical_address(mnem->ea_segment, mnem->ea_offset));
 	}
 
 	ui_separator();
 
-	if (ibm_pc->cpu.status.cf) {
+	if (cpu->status.cf) {
 		ui_text("C ");
 	}
 	else {
@@ -822,7 +987,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Carry flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.pf) {
+	if (cpu->status.pf) {
 		ui_text("P ");
 	}
 	else {
@@ -831,7 +996,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Parity flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.af) {
+	if (cpu->status.af) {
 		ui_text("A ");
 	}
 	else {
@@ -840,7 +1005,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Aux Carry flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.zf) {
+	if (cpu->status.zf) {
 		ui_text("Z ");
 	}
 	else {
@@ -849,7 +1014,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Zero flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.sf) {
+	if (cpu->status.sf) {
 		ui_text("S ");
 	}
 	else {
@@ -858,7 +1023,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Sign flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.of) {
+	if (cpu->status.of) {
 		ui_text("O ");
 	}
 	else {
@@ -867,7 +1032,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Overflow flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.df) {
+	if (cpu->status.df) {
 		ui_text("D ");
 	}
 	else {
@@ -876,7 +1041,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Direction flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.in) {
+	if (cpu->status.in) {
 		ui_text("I ");
 	}
 	else {
@@ -885,7 +1050,7 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Interrupt flag");
 
 	ui_same_line();
-	if (ibm_pc->cpu.status.tf) {
+	if (cpu->status.tf) {
 		ui_text("T ");
 	}
 	else {
@@ -894,95 +1059,224 @@ static void draw_cpu_state(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_set_item_tooltip("Trap flag");
 }
 static void draw_cpu_disassembly(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
-	uint16_t ip = ibm_pc->cpu.ip;
-	uint16_t cs = ibm_pc->cpu.segments[SEG_CS];
-	uint32_t phys_address = 0;
-	uint32_t next_step_over = 0;
-	uint8_t has_step_over = 0;
-	uint32_t next_step_into = 0;
-	uint8_t has_step_into = 0;
-	for (int i = 0; i < 100; ++i) {
-		i8086_mnem_at(&ibm_pc->mnem, cs, ip);
-		if (i == 0) {
-			has_step_over = ibm_pc->mnem.step_over_has_target;
-			next_step_over = i8086_mnem_get_step_over_target(&ibm_pc->mnem);
-			has_step_into = ibm_pc->mnem.step_into_has_target;
-			next_step_into = i8086_mnem_get_step_into_target(&ibm_pc->mnem);
+	UI_SNAPSHOT* snapshot = &ui_context->snapshot;
+	DISASM_CACHE* disasm = &ui_context->disasm;
+	uint16_t cs = disasm->cs;
+
+	/* The step targets depend on the registers; the current instruction is decoded with the snapshot */
+	uint8_t has_step_over = snapshot->mnem.step_over_has_target;
+	uint32_t next_step_over = i8086_mnem_get_step_over_target(&snapshot->mnem);
+	uint8_t has_step_into = snapshot->mnem.step_into_has_target;
+	uint32_t next_step_into = i8086_mnem_get_step_into_target(&snapshot->mnem);
+
+	/* The rows in view are decoded with the snapshot; rows scrolled into view are drawn from the next frame */
+	int rows = 0;
+	int start = 0;
+	int end = 0;
+	ui_list_clipper_begin(DISASM_CACHE_ROWS);
+	while (ui_list_clipper_step(&start, &end)) {
+		if (end > rows) {
+			rows = end;
 		}
-		phys_address = i8086_get_physical_address(cs, ip);
-		ui_push_id(i);
-		ui_push_style_color(UI_COLOR_ButtonActive, 1, 0, 0, 1);
-		if (ui_draw_circle("###breakpoint", 5, 64, phys_address == ibm_pc->breakpoint)) {
-			if (phys_address == ibm_pc->breakpoint) {
-				set_breakpoint_from_int(0, ui_context);
+		for (int i = start; i < end && i < disasm->count; ++i) {
+			const DISASM_ROW* row = &disasm->rows[i];
+			uint32_t phys_address = i8086_get_physical_address(cs, row->ip);
+			ui_push_id(i);
+			ui_push_style_color(UI_COLOR_ButtonActive, 1, 0, 0, 1);
+			if (ui_draw_circle("###breakpoint", 5, 64, phys_address == snapshot->breakpoint)) {
+				if (phys_address == snapshot->breakpoint) {
+					set_breakpoint_from_int(0, ui_context);
+				}
+				else {
+					set_breakpoint_from_int(phys_address, ui_context);
+				}
 			}
-			else {
-				set_breakpoint_from_int(phys_address, ui_context);
+			ui_set_item_tooltip("Set Breakpoint");
+			ui_pop_style_color(1);
+			ui_pop_id();
+
+			ui_same_line();
+			ui_text_colored(0.2f, 1.0f, 0.35f, 1.0f, "%04X:%04X", cs, row->ip);
+			ui_set_item_tooltip("%05X", phys_address);
+			ui_same_line_spacing(10);
+			VECTOR4 vec4 = { 1, 1, 1, 1 };
+			if (has_step_over && next_step_over == phys_address) {
+				vec4.x = 0.65f;
+				vec4.y = 0.0f;
+				vec4.z = 0.65f;
+				vec4.w = 1.0f;
+			}
+			if (has_step_into && next_step_into == phys_address) {
+				vec4.x = 0.65f;
+				vec4.y = 0.0f;
+				vec4.z = 0.65f;
+				vec4.w = 1.0f;
+			}
+			ui_text_colored_vec(&vec4, "%s", row->str);
+			if (row->has_ea || row->has_target) {
+				if (ui_begin_item_tooltip()) {
+					/* The effective address and the targets depend on the registers; decoded while hovered */
+					I8086_MNEM mnem = { 0 };
+					mnem.state = &snapshot->cpu;
+					uint8_t value = 0;
+					emulation_lock();
+					i8086_mnem_at(&mnem, cs, row->ip);
+					if (mnem.has_ea) {
+						value = memory_map_read_byte(&ibm_pc->mm, i8086_get_physical_address(mnem.ea_segment, mnem.ea_offset));
+					}
+					emulation_unlock();
+					if (mnem.has_ea) {
+						to_upper(mnem.ea_str);
+						uint20_t addr = i8086_get_physical_address(mnem.ea_segment, mnem.ea_offset);
+						ui_text("%s %04X:%04X (%05X) = %02X", mnem.ea_str, mnem.ea_segment, mnem.ea_offset, addr, value);
+					}
+					if (mnem.step_into_has_target) {
+						uint20_t addr = i8086_get_physical_address(mnem.step_into_segment, mnem.step_into_offset);
+						ui_text("Into: %04X:%04X (%05X)", mnem.step_into_segment, mnem.step_into_offset, addr);
+					}
+					if (mnem.step_over_has_target) {
+						uint20_t addr = i8086_get_physical_address(mnem.step_over_segment, mnem.step_over_offset);
+						ui_text("Over: %04X:%04X (%05X)", mnem.step_over_segment, mnem.step_over_offset, addr);
+					}
+					ui_end_item_tooltip();
+				}
 			}
 		}
-		ui_set_item_tooltip("Set Breakpoint");
-		ui_pop_style_color(1);
-		ui_pop_id();
-		
-		ui_same_line();
-		ui_text_colored(0.2f, 1.0f, 0.35f, 1.0f, "%04X:%04X", ibm_pc->mnem.segment, ip);
-		ui_set_item_tooltip("%05X", phys_address);
-		ui_same_line_spacing(10);
-		VECTOR4 vec4 = { 1, 1, 1, 1 };
-		if (has_step_over && next_step_over == phys_address) {
-			vec4.x = 0.65f;
-			vec4.y = 0.0f;
-			vec4.z = 0.65f;
-			vec4.w = 1.0f;
+	}
+	ui_context->disasm_rows = rows;
+}
+static void draw_cpu_ivt(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
+	UI_SNAPSHOT* snapshot = &ui_context->snapshot;
+	int start = 0;
+	int end = 0;
+	ui_list_clipper_begin(256);
+	while (ui_list_clipper_step(&start, &end)) {
+		if (ui_context->ivt_start == ui_context->ivt_end || start < ui_context->ivt_start) {
+			ui_context->ivt_start = start;
 		}
-		if (has_step_into && next_step_into == phys_address) {
-			vec4.x = 0.65f;
-			vec4.y = 0.0f;
-			vec4.z = 0.65f;
-			vec4.w = 1.0f;
+		if (end > ui_context->ivt_end) {
+			ui_context->ivt_end = end;
 		}
-		ui_text_colored_vec(&vec4, "%s", ibm_pc->mnem.str);
-		if (ibm_pc->mnem.has_ea || ibm_pc->mnem.step_over_has_target || ibm_pc->mnem.step_into_has_target) {
-			if (ui_begin_item_tooltip()) {
-				if (ibm_pc->mnem.has_ea) {
-					to_upper(ibm_pc->mnem.ea_str);
-					uint20_t addr = i8086_get_physical_address(ibm_pc->mnem.ea_segment, ibm_pc->mnem.ea_offset);
-					ui_text("%s %04X:%04X (%05X) = %02X", ibm_pc->mnem.ea_str, ibm_pc->mnem.ea_segment, ibm_pc->mnem.ea_offset, addr, ibm_pc->cpu.funcs.read_mem_byte(addr));
-				}
-				if (ibm_pc->mnem.step_into_has_target) {
-					uint20_t addr = i8086_get_physical_address(ibm_pc->mnem.step_into_segment, ibm_pc->mnem.step_into_offset);
-					ui_text("Into: %04X:%04X (%05X)", ibm_pc->mnem.step_into_segment, ibm_pc->mnem.step_into_offset, addr);
+		for (int i = start; i < end; ++i) {
+			uint16_t offset = snapshot->ivt[i][0];
+			uint16_t segment = snapshot->ivt[i][1];
+			uint20_t phys_address = i8086_get_physical_address(segment, offset);
+			ui_push_id(i);
+			if (ui_draw_circle("###breakpoint", 5, 64, phys_address == snapshot->breakpoint)) {
+				if (phys_address == snapshot->breakpoint) {
+					set_breakpoint_from_int(0, ui_context);
 				}
-				if (ibm_pc->mnem.step_over_has_target) {
-					uint20_t addr = i8086_get_physical_address(ibm_pc->mnem.step_over_segment, ibm_pc->mnem.step_over_offset);
-					ui_text("Over: %04X:%04X (%05X)", ibm_pc->mnem.step_over_segment, ibm_pc->mnem.step_over_offset, addr);
+				else {
+					set_breakpoint_from_int(phys_address, ui_context);
 				}
-				ui_end_item_tooltip();
 			}
+			ui_set_item_tooltip("Set Breakpoint");
+			ui_pop_id();
+
+			ui_same_line();
+			ui_text_colored(0.2f, 1.0f, 0.35f, 1.0f, "IVT %02X [%04X:%04X]", i, segment, offset);
 		}
-		ip += ibm_pc->mnem.counter;
 	}
 }
-static void draw_cpu_ivt(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
-	for (int i = 0; i < 255; ++i) {
-		uint16_t offset = ibm_pc->cpu.funcs.read_mem_byte((4 * i) + 0) | (ibm_pc->cpu.funcs.read_mem_byte((4 * i) + 1) << 8);
-		uint16_t segment = ibm_pc->cpu.funcs.read_mem_byte((4 * i) + 2) | (ibm_pc->cpu.funcs.read_mem_byte((4 * i) + 3) << 8);
-		uint20_t phys_address = i8086_get_physical_address(segment, offset);
-		ui_push_id(i);
-		if (ui_draw_circle("###breakpoint", 5, 64, phys_address == ibm_pc->breakpoint)) {
-			if (phys_address == ibm_pc->breakpoint) {
-				set_breakpoint_from_int(0, ui_context);
-			}
-			else {
-				set_breakpoint_from_int(phys_address, ui_context);
-			}
-		}
-		ui_set_item_tooltip("Set Breakpoint");
-		ui_pop_id();
 
-		ui_same_line();
-		ui_text_colored(0.2f, 1.0f, 0.35f, 1.0f, "IVT %02X [%04X:%04X]", i, segment, offset);
+#define HEATMAP_COLUMNS   64 /* 16K per row */
+#define HEATMAP_CELL_SIZE 5.0f
+
+static uint8_t heat_level(uint32_t count, float scale) {
+	/* log scale; the hottest block is 255 */
+	if (count == 0) {
+		return 0;
 	}
+	float level = 32.0f + logf(1.0f + count) * scale;
+	return (level > 255.0f) ? 255 : (uint8_t)level;
+}
+static void draw_memory_heatmap(UI_CONTEXT* ui_context) {
+	static uint32_t colors[HEATMAP_BLOCKS];
+	/* The counts are read unlocked; a count raced with the emulation thread is a frame stale at most */
+	HEATMAP* heatmap = &ibm_pc->heatmap;
+
+	ui_checkbox(UI_CHECKBOX_LEFT, "Read", &ui_context->heatmap_view[HEATMAP_READ]);
+	ui_same_line();
+	ui_checkbox(UI_CHECKBOX_LEFT, "Write", &ui_context->heatmap_view[HEATMAP_WRITE]);
+	ui_same_line();
+	ui_checkbox(UI_CHECKBOX_LEFT, "Execute", &ui_context->heatmap_view[HEATMAP_EXECUTE]);
+
+	/* writes are red, reads green, executes blue */
+	float scale[HEATMAP_KINDS];
+	for (int kind = 0; kind < HEATMAP_KINDS; ++kind) {
+		uint32_t max = heatmap_get_max(heatmap, kind);
+		scale[kind] = (max != 0 && ui_context->heatmap_view[kind]) ? 223.0f / logf(1.0f + max) : 0.0f;
+	}
+	for (int i = 0; i < HEATMAP_BLOCKS; ++i) {
+		uint32_t r = heat_level(heatmap->counts[HEATMAP_WRITE][i], scale[HEATMAP_WRITE]);
+		uint32_t g = heat_level(heatmap->counts[HEATMAP_READ][i], scale[HEATMAP_READ]);
+		uint32_t b = heat_level(heatmap->counts[HEATMAP_EXECUTE][i], scale[HEATMAP_EXECUTE]);
+		colors[i] = 0xFF000000 | (b << 16) | (g << 8) | r;
+	}
+
+	int block = ui_draw_cell_grid("###heatmap", colors, HEATMAP_COLUMNS, HEATMAP_BLOCKS / HEATMAP_COLUMNS, HEATMAP_CELL_SIZE);
+	if (block >= 0) {
+		uint32_t address = (uint32_t)block << HEATMAP_BLOCK_SHIFT;
+		ui_set_tooltip("%05X-%05X\nRead:    %u\nWrite:   %u\nExecute: %u", address, address + HEATMAP_BLOCK_SIZE - 1,
+			heatmap->counts[HEATMAP_READ][block], heatmap->counts[HEATMAP_WRITE][block], heatmap->counts[HEATMAP_EXECUTE][block]);
+	}
+	ui_text_disabled("256 bytes per cell, 16K per row. Counts halve in about 0.5s");
+}
+
+static void copy_path(char* dst, const char* src) {
+	if (src == NULL) {
+		dst[0] = '\0';
+	}
+	else {
+		strncpy_s(dst, UI_PATH_SIZE, src, UI_PATH_SIZE - 1);
+	}
+}
+static void snapshot_overlay(UI_DRIVE_SNAPSHOT* drive, const DISK_OVERLAY* overlay) {
+	drive->overlay_enabled = overlay->enabled;
+	drive->overlay_used = overlay->used;
+	copy_path(drive->overlay_path, overlay->enabled ? overlay->path : NULL);
+}
+static void take_menu_snapshot(UI_CONTEXT* ui_context) {
+	UI_MENU_SNAPSHOT* menu = &ui_context->menu;
+
+	/* Held only for the copy; the menus lock again only to change the emulator */
+	emulation_lock();
+
+	for (int i = 0; i < 4; ++i) {
+		const FDD_DISK* fdd = &ibm_pc->fdc.fdd[i];
+		UI_DRIVE_SNAPSHOT* drive = &menu->fdd[i];
+		copy_path(drive->path, fdd->path);
+		drive->size = fdd->buffer_size;
+		drive->inserted = fdd->status.inserted;
+		drive->dirty = fdd->status.dirty;
+		drive->ready = fdd->status.ready;
+		drive->write_protect = fdd->status.write_protect;
+		snapshot_overlay(drive, &fdd->overlay);
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		const XEBEC_HDD* hdd = &ibm_pc->xebec.hdd[i];
+		UI_DRIVE_SNAPSHOT* drive = &menu->hdd[i];
+		copy_path(drive->path, hdd->path);
+		drive->size = hdd->file_size;
+		drive->inserted = hdd->inserted;
+		drive->dirty = hdd->dirty;
+		drive->file_type = (uint8_t)hdd->file_type;
+		drive->geometry_type = (uint8_t)hdd->override_geometry.type;
+		snapshot_overlay(drive, &hdd->overlay);
+	}
+
+	copy_path(menu->vblk.path, ibm_pc->vblk.path);
+	menu->vblk.size = ibm_pc->vblk.buffer_size;
+	menu->vblk.inserted = ibm_pc->vblk.inserted;
+	menu->vblk.dirty = ibm_pc->vblk.dirty;
+	menu->vblk.drive = ibm_pc->vblk.drive;
+
+	menu->journal_mode = ibm_pc->journal.mode;
+	menu->journal_events = ibm_pc->journal.events;
+	copy_path(menu->journal_path, ibm_pc->journal.path);
+
+	emulation_unlock();
 }
 
 static void draw_main_menu(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
@@ -1017,6 +1311,8 @@ static void draw_main_menu(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	}
 	
 	if (ui_context->menu_slide > 0.005f) {
+		take_menu_snapshot(ui_context);
+
 		// Apply slide offset from the LAST frame.
 		ui_set_next_window_position(0, ui_context->slide_offset);
 		ui_set_next_window_size((float)display->window->transform.w, menu_height);
@@ -1042,12 +1338,27 @@ static void draw_main_menu(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 
 			if (ui_begin_menu("Machine")) {
 				if (ui_menu_item("Restart")) {
-					ibm_pc_reset();
+					emulation_lock();
+					ibm_pc_event_reset();
+					emulation_unlock();
 				}
 				if (ui_menu_item("Ctrl-Alt-Del")) {
-					ring_buffer_push(&ibm_pc->kbd.key_buffer, pc_scancode[SDL_SCANCODE_LCTRL]);
-					ring_buffer_push(&ibm_pc->kbd.key_buffer, pc_scancode[SDL_SCANCODE_LALT]);
-					ring_buffer_push(&ibm_pc->kbd.key_buffer, pc_scancode[SDL_SCANCODE_DELETE]);
+					const uint64_t now = SDL_GetTicksNS();
+					kbd_push_key(&ibm_pc->kbd, pc_scancode[SDL_SCANCODE_LCTRL], now);
+					kbd_push_key(&ibm_pc->kbd, pc_scancode[SDL_SCANCODE_LALT], now);
+					kbd_push_key(&ibm_pc->kbd, pc_scancode[SDL_SCANCODE_DELETE], now);
+				}
+				if (ui_context->menu.journal_mode != JOURNAL_MODE_NONE) {
+					ui_begin_disabled(1);
+					ui_text("%s %s (%u events)", ui_context->menu.journal_mode == JOURNAL_MODE_RECORD ? "Recording" : "Replaying",
+						file_get_filename(ui_context->menu.journal_path), ui_context->menu.journal_events);
+					ui_end_disabled();
+					if (ui_menu_item("Stop Journal")) {
+						emulation_lock();
+						journal_stop(&ibm_pc->journal);
+						ibm_pc->kbd.queue_disabled = 0;
+						emulation_unlock();
+					}
 				}
 				if (ui_menu_item("Exit")) {
 					window_instance_close(display->window);
@@ -1104,6 +1415,13 @@ static void draw_main_menu(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 				}
 			}
 
+			if (isa_bus_is_card_installed(&ibm_pc->isa_bus, ISA_CARD_VBLK) && ui_context->menu.vblk.inserted) {
+				if (ui_begin_menu("VBLK")) {
+					draw_vblk_submenu(ui_context);
+					ui_end_menu();
+				}
+			}
+
 			if (ui_begin_menu("Display")) {
 				draw_display_submenu(display);
 				ui_end_menu();
@@ -1141,12 +1459,22 @@ static void draw_main_menu(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 		ui_begin("CPU IVT", &ui_context->dbg, 0);
 		draw_cpu_ivt(ui_context, display);
 		ui_end();
+
+		if (ibm_pc->heatmap.enabled) {
+			ui_begin("Memory Heatmap", &ui_context->dbg, 0);
+			draw_memory_heatmap(ui_context);
+			ui_end();
+		}
 	}
 }
 
 void ui_context_create(UI_CONTEXT* ui_context) {
 	ui_context->menu_slide = 0;
 	ui_context->slide_offset = 0;
+	disasm_cache_reset(&ui_context->disasm);
+	ui_context->heatmap_view[HEATMAP_READ] = 1;
+	ui_context->heatmap_view[HEATMAP_WRITE] = 1;
+	ui_context->heatmap_view[HEATMAP_EXECUTE] = 1;
 	set_diag_context(&ui_context->diag_context, NULL, 0);
 
 	ui_context->diag_properties = SDL_CreateProperties();
@@ -1190,8 +1518,47 @@ void ui_context_destroy(UI_CONTEXT* ui_context) {
 
 
 }
+static void take_snapshot(UI_CONTEXT* ui_context) {
+	UI_SNAPSHOT* snapshot = &ui_context->snapshot;
+
+	/* Held only for the copy; the windows draw from the snapshot and lock again only to change the emulator */
+	emulation_lock();
+
+	snapshot->cpu = ibm_pc->cpu;
+	snapshot->cpu.funcs.read_mem_byte = ibm_pc_peek_mem_byte;
+	snapshot->mnem.state = &snapshot->cpu;
+	snapshot->step = ibm_pc->step;
+	snapshot->breakpoint = ibm_pc->breakpoint;
+	snapshot->cycles = timing_virtual_get_cycles();
+	snapshot->rewind_count = ibm_pc->rewind.count;
+	snapshot->rewind_used = ibm_pc->rewind.used;
+	snapshot->rewind_oldest = (ibm_pc->rewind.count > 0) ? rewind_get(&ibm_pc->rewind, 0)->cycle : snapshot->cycles;
+	snapshot->journal_mode = ibm_pc->journal.mode;
+
+	for (int i = ui_context->ivt_start; i < ui_context->ivt_end; ++i) {
+		snapshot->ivt[i][0] = memory_map_read_byte(&ibm_pc->mm, (4 * i) + 0) | (memory_map_read_byte(&ibm_pc->mm, (4 * i) + 1) << 8);
+		snapshot->ivt[i][1] = memory_map_read_byte(&ibm_pc->mm, (4 * i) + 2) | (memory_map_read_byte(&ibm_pc->mm, (4 * i) + 3) << 8);
+	}
+
+	disasm_cache_sync(&ui_context->disasm, &ibm_pc->mm, snapshot->cpu.segments[SEG_CS], snapshot->cpu.ip);
+	if (ui_context->disasm_rows > 0) {
+		disasm_cache_get(&ui_context->disasm, &snapshot->mnem, &ibm_pc->mm, ui_context->disasm_rows - 1);
+	}
+
+	/* Decoded last; the rows above leave the mnem at the last row */
+	i8086_mnem(&snapshot->mnem);
+
+	emulation_unlock();
+}
+
 void ui_update(UI_CONTEXT* ui_context, DISPLAY_INSTANCE* display) {
 	ui_new_frame();
+	if (ui_context->dbg) {
+		take_snapshot(ui_context);
+	}
+	/* The IVT window records the rows it draws; none if it is closed */
+	ui_context->ivt_start = 0;
+	ui_context->ivt_end = 0;
 	draw_main_menu(ui_context, display);
 	ui_render();
 }
@@ -5,6 +5,14 @@
 #ifndef SDL3_UI
 #define SDL3_UI
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i8086.h"
+#include "i8086_mnem.h"
+
+#include "backend/disasm_cache.h"
+
 typedef struct DISPLAY_INSTANCE DISPLAY_INSTANCE;
 typedef struct SDL_DialogFileFilter SDL_DialogFileFilter;
 
@@ -14,6 +22,48 @@ typedef struct UI_FILE_DIAG_CONTEXT {
 	int flag;
 } UI_FILE_DIAG_CONTEXT;
 
+/* The emulator state the debug windows draw; copied under the emulation lock once a frame */
+typedef struct UI_SNAPSHOT {
+	I8086 cpu;              /* memory reads go to the memory map uncounted */
+	I8086_MNEM mnem;        /* decodes for cpu; the current instruction is decoded when the snapshot is taken */
+	uint8_t step;
+	uint32_t breakpoint;
+	uint64_t cycles;        /* the virtual clock */
+	uint64_t rewind_oldest; /* the virtual clock of the oldest rewind snapshot */
+	uint32_t rewind_count;
+	size_t rewind_used;
+	uint8_t journal_mode;
+	uint16_t ivt[256][2];   /* offset, segment; only the rows in view are current */
+} UI_SNAPSHOT;
+
+#define UI_PATH_SIZE 256
+
+/* A drive as the menus draw it */
+typedef struct UI_DRIVE_SNAPSHOT {
+	char path[UI_PATH_SIZE];
+	char overlay_path[UI_PATH_SIZE];
+	size_t size;            /* the image size */
+	uint32_t overlay_used;  /* delta sectors */
+	uint8_t inserted;
+	uint8_t dirty;
+	uint8_t ready;
+	uint8_t write_protect;
+	uint8_t overlay_enabled;
+	uint8_t file_type;      /* XEBEC_FILE_TYPE_XXX */
+	uint8_t geometry_type;  /* the override geometry */
+	uint8_t drive;          /* the INT 13h drive; vblk */
+} UI_DRIVE_SNAPSHOT;
+
+/* The emulator state the menus draw; copied under the emulation lock each frame the menu bar is shown */
+typedef struct UI_MENU_SNAPSHOT {
+	UI_DRIVE_SNAPSHOT fdd[4];
+	UI_DRIVE_SNAPSHOT hdd[2];
+	UI_DRIVE_SNAPSHOT vblk;
+	uint8_t journal_mode;
+	uint32_t journal_events;
+	char journal_path[UI_PATH_SIZE];
+} UI_MENU_SNAPSHOT;
+
 typedef struct UI_CONTEXT {
 	float menu_slide;
 	float slide_offset;
@@ -23,6 +73,13 @@ typedef struct UI_CONTEXT {
 	char* disk_directory;
 	char* hdd_directory;
 	int dbg;
+	int heatmap_view[3]; /* show reads, writes, executes */
+	DISASM_CACHE disasm; /* the disassembly view */
+	int disasm_rows;     /* rows in view last frame; decoded with the snapshot */
+	int ivt_start;       /* IVT rows in view last frame; read with the snapshot */
+	int ivt_end;
+	UI_SNAPSHOT snapshot;
+	UI_MENU_SNAPSHOT menu;
 	char buffer[32];
 } UI_CONTEXT;
 
@@ -9,23 +9,21 @@
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_video.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <stdio.h>
 
 #include "sdl3_window.h"
 #include "sdl3_timing.h"
 #include "sdl3_font.h"
 
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#include <stdio.h>
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
-#else
-#define dbg_print(x, ...)
-#endif
+#include "backend/utility/trace.h"
+
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
 
 /* Window Instance */
 int window_instance_create(WINDOW_MANAGER* manager, WINDOW_INSTANCE** instance) {
 	if (manager == NULL) {
-		dbg_print("Failed to create window instance. Window manager is NULL\n");
+		log_error("Failed to create window instance. Window manager is NULL\n");
 		return 1;
 	}
 
@@ -42,7 +40,7 @@ int window_instance_create(WINDOW_MANAGER* manager, WINDOW_INSTANCE** instance)
 	if (index < 0) {
 		index = manager->instance_index;
 		if (index >= manager->instance_count) {
-			dbg_print("Failed to create window instance. Window instance index out of range.\n");
+			log_error("Failed to create window instance. Window instance index out of range.\n");
 			return 1;
 		}
 		manager->instance_index++;
@@ -57,12 +55,12 @@ int window_instance_create(WINDOW_MANAGER* manager, WINDOW_INSTANCE** instance)
 int window_instance_destroy(WINDOW_INSTANCE* instance) {
 
 	if (instance == NULL) {
-		dbg_print("Failed to destroy window instance. Window instance is NULL\n");
+		log_error("Failed to destroy window instance. Window instance is NULL\n");
 		return 1;
 	}
 
 	if (instance->manager == NULL) {
-		dbg_print("Failed to destroy window instance. Window manager is NULL\n");
+		log_error("Failed to destroy window instance. Window manager is NULL\n");
 		return 1;
 	}
 
@@ -101,43 +99,43 @@ int window_instance_destroy(WINDOW_INSTANCE* instance) {
 int window_instance_open(WINDOW_INSTANCE* instance) {
 
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to open window instance. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to open window instance. Window instance is NULL\n");
 		return 1;
 	}
 	
 	if (instance->manager == NULL) {
-		dbg_print("[WINDOW] Failed to open window instance. Window manager is NULL\n");
+		log_error("[WINDOW] Failed to open window instance. Window manager is NULL\n");
 		return 1;
 	}
 
 	if ((instance->window_state & WINDOW_INSTANCE_STATE_CREATED) == 0) {
-		dbg_print("[WINDOW] Failed to open window instance. Window instance not created\n");
+		log_error("[WINDOW] Failed to open window instance. Window instance not created\n");
 		return 1;
 	}
 
 	if (instance->window_state & WINDOW_INSTANCE_STATE_OPEN) {
-		dbg_print("[WINDOW] Failed to open window instance. Window instance already open\n");
+		log_error("[WINDOW] Failed to open window instance. Window instance already open\n");
 		return 1;
 	}
 
 	/* init window */
 	instance->window = SDL_CreateWindow(instance->title, instance->transform.w, instance->transform.h, SDL_WINDOW_RESIZABLE);
 	if (instance->window == NULL) {
-		dbg_print("[WINDOW] Failed to open window instance. Could not create window: %s\n", SDL_GetError());
+		log_error("[WINDOW] Failed to open window instance. Could not create window: %s\n", SDL_GetError());
 		return 1;
 	}
 
 	/* create renderer */
 	instance->renderer = SDL_CreateRenderer(instance->window, NULL);
 	if (instance->renderer == NULL) {
-		dbg_print("[WINDOW] Failed to open window instance. Could not create renderer: %s\n", SDL_GetError());
+		log_error("[WINDOW] Failed to open window instance. Could not create renderer: %s\n", SDL_GetError());
 		return 1;
 	}
 
 	/* get window id */
 	instance->window_id = SDL_GetWindowID(instance->window);
 	if (instance->window_id == 0) {
-		dbg_print("[WINDOW] Failed to open window instance. Could not get window id: %s\n", SDL_GetError());
+		log_error("[WINDOW] Failed to open window instance. Could not get window id: %s\n", SDL_GetError());
 		return 1;
 	}
 
@@ -152,12 +150,12 @@ int window_instance_open(WINDOW_INSTANCE* instance) {
 int window_instance_close(WINDOW_INSTANCE* instance) {
 
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to close window instance. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to close window instance. Window instance is NULL\n");
 		return 1;
 	}
 
 	if (instance->manager == NULL) {
-		dbg_print("[WINDOW] Failed to close window instance. Window manager is NULL\n");
+		log_error("[WINDOW] Failed to close window instance. Window manager is NULL\n");
 		return 1;
 	}
 
@@ -200,6 +198,19 @@ static void window_instance_process_event(WINDOW_INSTANCE* instance, SDL_Event*
 			instance->transform.x = e->window.data1;
 			instance->transform.y = e->window.data2;
 			break;
+
+		case SDL_EVENT_WINDOW_MINIMIZED:
+		case SDL_EVENT_WINDOW_HIDDEN:
+		case SDL_EVENT_WINDOW_OCCLUDED:
+			instance->window_state |= WINDOW_INSTANCE_STATE_HIDDEN;
+			break;
+
+		case SDL_EVENT_WINDOW_RESTORED:
+		case SDL_EVENT_WINDOW_MAXIMIZED:
+		case SDL_EVENT_WINDOW_SHOWN:
+		case SDL_EVENT_WINDOW_EXPOSED:
+			instance->window_state &= ~WINDOW_INSTANCE_STATE_HIDDEN;
+			break;
 	}
 
 	// call on_process_event() for window instance
@@ -208,16 +219,29 @@ static void window_instance_process_event(WINDOW_INSTANCE* instance, SDL_Event*
 	}
 }
 
-static void window_instance_render(WINDOW_INSTANCE* instance) {
+static int window_instance_should_render(WINDOW_INSTANCE* instance) {
+	if (instance->render_ready != NULL && instance->render_ready(instance->render_ready_param1)) {
+		/* new content; render now and restart the frame timer from here */
+		sdl_timing_reset_frame(&instance->time);
+		return 1;
+	}
+
 	sdl_timing_new_frame(&instance->time);
-	if (sdl_timing_check_frame(&instance->time)) {
+	if (instance->throttle != NULL && instance->time.ms < instance->throttle_ms && instance->throttle(instance->throttle_param1)) {
+		return 0; /* throttled; the frame timer runs on to throttle_ms */
+	}
+	return sdl_timing_check_frame(&instance->time);
+}
+static void window_instance_render(WINDOW_INSTANCE* instance) {
+	if (window_instance_should_render(instance)) {
+		TRACE_BEGIN(TRACE_CAT_FRAME, "window_instance_render");
 
 		// clear render buffer
 		SDL_SetRenderDrawColor(instance->renderer, 0xE0, 0xE0, 0xE0, 0xFF);
 		SDL_RenderClear(instance->renderer);
 
 		// call on_render() for window instance
-		for (int i = 0; i < instance->on_process_event_index; ++i) {
+		for (int i = 0; i < instance->on_render_index; ++i) {
 			void* param1 = instance->on_render_param1[i];
 			if (param1 == NULL) {
 				param1 = instance;
@@ -225,7 +249,10 @@ static void window_instance_render(WINDOW_INSTANCE* instance) {
 			instance->on_render[i](param1, instance->on_render_param2[i]);
 		}
 
+		TRACE_BEGIN(TRACE_CAT_FRAME, "SDL_RenderPresent");
 		SDL_RenderPresent(instance->renderer);
+		TRACE_END(TRACE_CAT_FRAME, "SDL_RenderPresent");
+		TRACE_END(TRACE_CAT_FRAME, "window_instance_render");
 	}
 }
 
@@ -275,7 +302,7 @@ void window_instance_toggle_full_screen(WINDOW_INSTANCE* instance) {
 
 int window_instance_add_cb_on_process_event(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB_ON_PROCESS_EVENT cb) {
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to add cb on_process_event. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to add cb on_process_event. Window instance is NULL\n");
 		return -1;
 	}
 
@@ -298,7 +325,7 @@ int window_instance_add_cb_on_process_event(WINDOW_INSTANCE* instance, WINDOW_IN
 }
 int window_instance_add_cb_on_render(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB cb, void* cb_param1, void* cb_param2) {
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to add cb on_render. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to add cb on_render. Window instance is NULL\n");
 		return -1;
 	}
 
@@ -307,19 +334,19 @@ int window_instance_add_cb_on_render(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_
 	if (index >= instance->on_render_count) {
 		WINDOW_INSTANCE_CB* new_cb = realloc(instance->on_render, (instance->on_render_count + 1) * sizeof(WINDOW_INSTANCE_CB));
 		if (new_cb == NULL) {
-			dbg_print("[WINDOW] Failed to add cb on_render. Realloc failed for on_render\n");
+			log_error("[WINDOW] Failed to add cb on_render. Realloc failed for on_render\n");
 			return -1;
 		}
 			
 		void* new_param1 = realloc(instance->on_render_param1, (instance->on_render_count + 1) * sizeof(void*));
 		if (new_param1 == NULL) {
-			dbg_print("[WINDOW] Failed to add cb on_render. Realloc failed for on_render_param1\n");
+			log_error("[WINDOW] Failed to add cb on_render. Realloc failed for on_render_param1\n");
 			return -1;
 		}
 			
 		void* new_param2 = realloc(instance->on_render_param2, (instance->on_render_count + 1) * sizeof(void*));
 		if (new_param2 == NULL) {
-			dbg_print("[WINDOW] Failed to add cb on_render. Realloc failed for on_render_param2\n");
+			log_error("[WINDOW] Failed to add cb on_render. Realloc failed for on_render_param2\n");
 			return -1;
 		}
 
@@ -338,12 +365,12 @@ int window_instance_add_cb_on_render(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_
 
 int window_instance_set_cb_on_process_event(WINDOW_INSTANCE* instance, int index, WINDOW_INSTANCE_CB_ON_PROCESS_EVENT cb) {
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to set cb on_process_event. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to set cb on_process_event. Window instance is NULL\n");
 		return 1;
 	}
 	
 	if (index >= instance->on_process_event_index) {
-		dbg_print("[WINDOW] Failed to set cb on_process_event. Index out of range\n");
+		log_error("[WINDOW] Failed to set cb on_process_event. Index out of range\n");
 		return 1;
 	}
 
@@ -352,12 +379,12 @@ int window_instance_set_cb_on_process_event(WINDOW_INSTANCE* instance, int index
 }
 int window_instance_set_cb_on_render(WINDOW_INSTANCE* instance, int index, WINDOW_INSTANCE_CB cb, void* cb_param1, void* cb_param2) {
 	if (instance == NULL) {
-		dbg_print("[WINDOW] Failed to set cb on_render. Window instance is NULL\n");
+		log_error("[WINDOW] Failed to set cb on_render. Window instance is NULL\n");
 		return 1;
 	}
 
 	if (index >= instance->on_render_index) {
-		dbg_print("[WINDOW] Failed to set cb on_render. Index out of range\n");
+		log_error("[WINDOW] Failed to set cb on_render. Index out of range\n");
 		return 1;
 	}
 
@@ -367,29 +394,52 @@ int window_instance_set_cb_on_render(WINDOW_INSTANCE* instance, int index, WINDO
 	return 0;
 }
 
+int window_instance_set_cb_render_ready(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB_RENDER_READY cb, void* cb_param1) {
+	if (instance == NULL) {
+		log_error("[WINDOW] Failed to set cb render_ready. Window instance is NULL\n");
+		return 1;
+	}
+
+	instance->render_ready = cb;
+	instance->render_ready_param1 = cb_param1;
+	return 0;
+}
+
+int window_instance_set_cb_throttle(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB_RENDER_READY cb, void* cb_param1, double throttle_ms) {
+	if (instance == NULL) {
+		log_error("[WINDOW] Failed to set cb throttle. Window instance is NULL\n");
+		return 1;
+	}
+
+	instance->throttle = cb;
+	instance->throttle_param1 = cb_param1;
+	instance->throttle_ms = throttle_ms;
+	return 0;
+}
+
 /* Window Instance Manager */
 int window_manager_create(WINDOW_MANAGER** manager, uint16_t window_count) {
 	if (*manager != NULL) {
-		dbg_print("[WINDOW MANAGER] Failed to create window manager. manager not NULL\n");
+		log_error("[WINDOW MANAGER] Failed to create window manager. manager not NULL\n");
 		return 1;
 	}
 
 	*manager = calloc(1, sizeof(WINDOW_MANAGER));
 	if (*manager == NULL) {
-		dbg_print("[WINDOW MANAGER] Failed to create window manager. Could not allocate memory for window manager\n");
+		log_error("[WINDOW MANAGER] Failed to create window manager. Could not allocate memory for window manager\n");
 		return 1;
 	}
 
 	/* init text engine */
 	(*manager)->text_engine = TTF_CreateSurfaceTextEngine();
 	if ((*manager)->text_engine == NULL) {
-		dbg_print("[WINDOW MANAGER] Failed to create window manager. Could not init text engine: %s\n", SDL_GetError());
+		log_error("[WINDOW MANAGER] Failed to create window manager. Could not init text engine: %s\n", SDL_GetError());
 		return 1;
 	}
 
 	(*manager)->instances = calloc(window_count, sizeof(WINDOW_INSTANCE));
 	if ((*manager)->instances == NULL) {
-		dbg_print("[WINDOW MANAGER] Failed to create window manager. Could not allocate memory for window instances\n");
+		log_error("[WINDOW MANAGER] Failed to create window manager. Could not allocate memory for window instances\n");
 		return 1;
 	}
 	(*manager)->instance_count = window_count;
@@ -441,7 +491,8 @@ int window_manager_process_event(WINDOW_MANAGER* manager, SDL_Event* e) {
 }
 void window_manager_update(WINDOW_MANAGER* manager) {
 	for (int i = 0; i < manager->instance_index; ++i) {
-		if (manager->instances[i].window_state & WINDOW_INSTANCE_STATE_OPEN) {
+		/* a window that can not be seen is not rendered; it renders as soon as it is shown again */
+		if ((manager->instances[i].window_state & (WINDOW_INSTANCE_STATE_OPEN | WINDOW_INSTANCE_STATE_HIDDEN)) == WINDOW_INSTANCE_STATE_OPEN) {
 			window_instance_render(&manager->instances[i]);
 		}
 	}
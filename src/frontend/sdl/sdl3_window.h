@@ -19,6 +19,7 @@ typedef struct TTF_Font TTF_Font;
 #define WINDOW_INSTANCE_STATE_FULL_SCREEN 0x1
 #define WINDOW_INSTANCE_STATE_OPEN        0x2
 #define WINDOW_INSTANCE_STATE_CREATED     0x4
+#define WINDOW_INSTANCE_STATE_HIDDEN      0x8 /* minimized, hidden or occluded; not rendered */
 
 typedef struct WINDOW_INSTANCE WINDOW_INSTANCE;
 typedef struct FONT_TEXTURE_DATA FONT_TEXTURE_DATA;
@@ -44,6 +45,8 @@ typedef void(*WINDOW_INSTANCE_CB_ON_PROCESS_EVENT)(WINDOW_INSTANCE* instance, SD
 
 typedef void(*WINDOW_INSTANCE_CB)(void* param1, void* param2);
 
+typedef int(*WINDOW_INSTANCE_CB_RENDER_READY)(void* param1);
+
 /* Window Instance */
 typedef struct WINDOW_INSTANCE {
 	/* Window */
@@ -64,6 +67,13 @@ typedef struct WINDOW_INSTANCE {
 	WINDOW_INSTANCE_CB_ON_PROCESS_EVENT* on_process_event;
 	int32_t on_process_event_count;
 	int32_t on_process_event_index;
+
+	WINDOW_INSTANCE_CB_RENDER_READY render_ready; /* render as soon as new content is ready */
+	void* render_ready_param1;
+
+	WINDOW_INSTANCE_CB_RENDER_READY throttle; /* render every throttle_ms while it returns non-zero */
+	void* throttle_param1;
+	double throttle_ms;
 	
 	FRAME_STATE time;
 	
@@ -148,6 +158,23 @@ int window_instance_set_cb_on_process_event(WINDOW_INSTANCE* instance, int index
  Returns:   1 if error, 0 if success */
 int window_instance_set_cb_on_render(WINDOW_INSTANCE* instance, int index, WINDOW_INSTANCE_CB cb, void* cb_param1, void* cb_param2);
 
+/* Set the render_ready callback. When it returns non-zero the window renders straight away and the frame timer restarts;
+ the frame timer still renders the window if no new content arrives.
+ instance:  The window instance
+ cb:        The callback function. NULL to render on the frame timer only.
+ cb_param1: The callback param1.
+ Returns:   1 if error, 0 if success */
+int window_instance_set_cb_render_ready(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB_RENDER_READY cb, void* cb_param1);
+
+/* Set the throttle callback. While it returns non-zero the window renders every throttle_ms instead of every frame;
+ render_ready still renders the window as soon as new content is ready.
+ instance:    The window instance
+ cb:          The callback function. NULL to never throttle.
+ cb_param1:   The callback param1.
+ throttle_ms: The frame time while throttled. Longer than the frame time of the window.
+ Returns:     1 if error, 0 if success */
+int window_instance_set_cb_throttle(WINDOW_INSTANCE* instance, WINDOW_INSTANCE_CB_RENDER_READY cb, void* cb_param1, double throttle_ms);
+
 /* Create Window Manager.
  manager:      The window manager
  window_count: The amount of window instances to allocate memory for. 
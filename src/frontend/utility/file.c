@@ -7,15 +7,17 @@
 #include <string.h>
 #include <sys/stat.h>
 
-#include "file.h"
-
-#define DBG_PRINT
-#ifdef DBG_PRINT
-#define dbg_print(x, ...) printf(x, __VA_ARGS__)
+#ifdef _WIN32
+#include <io.h>
 #else
-#define dbg_print(x, ...)
+#include <dirent.h>
 #endif
 
+#include "file.h"
+
+#define LOG_CATEGORY LOG_CAT_FRONTEND
+#include "backend/utility/log.h"
+
 #define file_tell  ftell
 #define file_open  fopen
 #define file_close fclose
@@ -29,13 +31,13 @@ int file_read_into_buffer(const char* path, void* buff, const size_t buff_size,
 	size_t size = 0;
 
 	if (path == NULL) {
-		dbg_print("Error: path was null: %s\n", path);
+		log_error("Error: path was null: %s\n", path);
 		return 1;
 	}
 
 	file = file_open(path, "rb");
 	if (file == NULL) {
-		dbg_print("Error: could not open file: %s\n", path);
+		log_error("Error: could not open file: %s\n", path);
 		return 1;
 	}
 
@@ -48,19 +50,19 @@ int file_read_into_buffer(const char* path, void* buff, const size_t buff_size,
 	}
 
 	if (expected_size != 0 && size != expected_size) {
-		dbg_print("Error: invalid file size. Expected %zu bytes. Got %zu bytes\n", expected_size, size);
+		log_error("Error: invalid file size. Expected %zu bytes. Got %zu bytes\n", expected_size, size);
 		file_close(file);
 		return 1;
 	}
 
 	if (offset + size > buff_size) {
-		dbg_print("Error: file is too big for buffer. Offset: %zx. File size: %zu bytes. Buffer size: %zu bytes\n", offset, size, buff_size);
+		log_error("Error: file is too big for buffer. Offset: %zx. File size: %zu bytes. Buffer size: %zu bytes\n", offset, size, buff_size);
 		file_close(file);
 		return 1;
 	}
 
 	size_t bytes_read = file_read((uint8_t*)buff + offset, 1, size, file);
-	dbg_print("0x%05zX -> %s (%zu bytes)\n", offset, path, bytes_read);
+	log_info("0x%05zX -> %s (%zu bytes)\n", offset, path, bytes_read);
 	file_close(file);
 	file = NULL;
 	return 0;
@@ -71,13 +73,13 @@ int file_read_alloc_buffer(const char* path, void** buff, size_t* file_size) {
 	size_t size = 0;
 
 	if (path == NULL) {
-		dbg_print("Error: path was null: %s\n", path);
+		log_error("Error: path was null: %s\n", path);
 		return 1;
 	}
 
 	file = file_open(path, "rb");
 	if (file == NULL) {
-		dbg_print("Error: could not open file: %s\n", path);
+		log_error("Error: could not open file: %s\n", path);
 		return 1;
 	}
 
@@ -91,7 +93,7 @@ int file_read_alloc_buffer(const char* path, void** buff, size_t* file_size) {
 
 	*buff = calloc(1, size);
 	if (*buff == NULL) {
-		dbg_print("Error: could not alloc memory for file: %s\n", path);
+		log_error("Error: could not alloc memory for file: %s\n", path);
 		return 1;
 	}
 
@@ -105,13 +107,13 @@ int file_write_from_buffer(const char* path, void* buff, const size_t buff_size)
 	file_t* file = NULL;
 
 	if (path == NULL) {
-		dbg_print("Error: path was null: %s\n", path);
+		log_error("Error: path was null: %s\n", path);
 		return 1;
 	}
 
 	file = file_open(path, "wb");
 	if (file == NULL) {
-		dbg_print("Error: could not open file: %s\n", path);
+		log_error("Error: could not open file: %s\n", path);
 		return 1;
 	}
 
@@ -173,3 +175,112 @@ int file_get_file_size(const char* path, size_t* file_size) {
 	*file_size = st.st_size;
 	return 1;
 }
+
+int file_get_modified_time(const char* path, time_t* mtime) {
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		*mtime = 0;
+		return 0;
+	}
+	*mtime = st.st_mtime;
+	return 1;
+}
+
+int file_is_directory(const char* path) {
+	struct stat st;
+	if (path == NULL || stat(path, &st) != 0) {
+		return 0;
+	}
+	return (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+void* file_open_read(const char* path) {
+	if (path == NULL) {
+		log_error("Error: path was null: %s\n", path);
+		return NULL;
+	}
+
+	file_t* file = file_open(path, "rb");
+	if (file == NULL) {
+		log_error("Error: could not open file: %s\n", path);
+		return NULL;
+	}
+	return file;
+}
+int file_read_at(void* file, const size_t offset, void* buff, const size_t size, size_t* bytes_read) {
+	if (file == NULL) {
+		return 1;
+	}
+
+	if (file_seek((file_t*)file, (long)offset, SEEK_SET) != 0) {
+		return 1;
+	}
+
+	size_t count = file_read(buff, 1, size, (file_t*)file);
+	if (bytes_read != NULL) {
+		*bytes_read = count;
+	}
+	return 0;
+}
+void file_close_handle(void* file) {
+	if (file != NULL) {
+		file_close((file_t*)file);
+	}
+}
+
+int file_list_directory(const char* path, FILE_LIST_CB cb, void* param) {
+	FILE_INFO info = { 0 };
+	char full_path[512] = { 0 };
+	int result = 0;
+
+	if (path == NULL) {
+		log_error("Error: path was null: %s\n", path);
+		return 1;
+	}
+
+#ifdef _WIN32
+	struct __finddata64_t data;
+	snprintf(full_path, sizeof(full_path), "%s\\*", path);
+	intptr_t handle = _findfirst64(full_path, &data);
+	if (handle == -1) {
+		log_error("Error: could not open directory: %s\n", path);
+		return 1;
+	}
+	do {
+		info.name = data.name;
+		info.size = (size_t)data.size;
+		info.mtime = (time_t)data.time_write;
+		info.is_directory = (data.attrib & _A_SUBDIR) != 0;
+		result = cb(&info, param);
+		if (result) {
+			break;
+		}
+	} while (_findnext64(handle, &data) == 0);
+	_findclose(handle);
+#else
+	DIR* dir = opendir(path);
+	if (dir == NULL) {
+		log_error("Error: could not open directory: %s\n", path);
+		return 1;
+	}
+	struct dirent* entry = NULL;
+	while ((entry = readdir(dir)) != NULL) {
+		struct stat st;
+		snprintf(full_path, sizeof(full_path), "%s/%s", path, entry->d_name);
+		if (stat(full_path, &st) != 0) {
+			continue;
+		}
+		info.name = entry->d_name;
+		info.size = st.st_size;
+		info.mtime = st.st_mtime;
+		info.is_directory = (st.st_mode & S_IFMT) == S_IFDIR;
+		result = cb(&info, param);
+		if (result) {
+			break;
+		}
+	}
+	closedir(dir);
+#endif
+
+	return result;
+}
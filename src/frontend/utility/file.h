@@ -6,6 +6,17 @@
 #define FILE_UTIL_H
 
 #include <stdint.h>
+#include <time.h>
+
+typedef struct FILE_INFO {
+	const char* name; /* file name; no path */
+	size_t size;
+	time_t mtime;     /* last modified */
+	uint8_t is_directory;
+} FILE_INFO;
+
+/* Directory listing callback; Return non-zero to stop the listing. file_list_directory() returns it */
+typedef int(*FILE_LIST_CB)(const FILE_INFO* info, void* param);
 
 int file_read_into_buffer(const char* path, void* buff, const size_t buff_size, const size_t offset, size_t* file_size, const size_t expected_size);
 int file_read_alloc_buffer(const char* path, void** buff, size_t* file_size);
@@ -13,5 +24,14 @@ int file_write_from_buffer(const char* path, void* buff, const size_t buff_size)
 const char* file_get_filename(const char* path);
 const char* file_get_extension(const char* path);
 int file_get_file_size(const char* path, size_t* file_size);
+int file_get_modified_time(const char* path, time_t* mtime);
+int file_is_directory(const char* path);
+
+/* A file kept open between reads; file_open_read() returns NULL on error */
+void* file_open_read(const char* path);
+int file_read_at(void* file, const size_t offset, void* buff, const size_t size, size_t* bytes_read);
+void file_close_handle(void* file);
+
+int file_list_directory(const char* path, FILE_LIST_CB cb, void* param);
 
 #endif
@@ -16,9 +16,17 @@
 #include "frontend/sdl/sdl3_display.h"
 #include "frontend/sdl/dbg_gui.h"
 #include "frontend/sdl/sdl3_ui.h"
+#include "frontend/sdl/sdl3_emulation.h"
+#include "frontend/sdl/sdl3_audio.h"
+#include "frontend/sdl/sdl3_log.h"
 
 #include "backend/ibm_pc.h"
 #include "backend/timing.h"
+#include "backend/audio.h"
+#include "backend/bench.h"
+#include "backend/itrace.h"
+#include "backend/utility/trace.h"
+#include "backend/utility/log.h"
 
 #include "ui.h"
 #include "args.h"
@@ -29,6 +37,13 @@
 #define gui_boarder_w_l 15 /* boarder width left */
 #define gui_boarder_w_t 25 /* boarder width top */
 
+#define dbg_gui_throttle_hz 10.0 /* the debug window refresh while the emulator runs */
+
+static int emulator_running(void* param1) {
+	(void)param1;
+	return !ibm_pc->step;
+}
+
 int main(int argc, char** argv) {
 	
 	SDL* sdl = NULL;
@@ -83,7 +98,24 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
-	if (ibm_pc->config.video_adapter != VIDEO_ADAPTER_NONE) {
+	/* Log levels; the category levels override the level of every category */
+	log_set_all_levels(ibm_pc->config.log_level);
+	if (log_parse_levels(ibm_pc->config.log_categories)) {
+		exit(1);
+	}
+
+	/* Print an instruction trace */
+	if (args.itrace_decode != NULL) {
+		exit(itrace_decode(args.itrace_decode, stdout));
+	}
+
+	/* Benchmark; headless unless the scenario renders */
+	int bench = (ibm_pc->config.bench_scenario != BENCH_NONE);
+	if (bench && bench_configure()) {
+		exit(1);
+	}
+
+	if (ibm_pc->config.video_adapter != VIDEO_ADAPTER_NONE && (!bench || bench_needs_window())) {
 		/* Create Main Window */
 		if (window_instance_create(window_manager, &win1)) {
 			exit(1);
@@ -114,9 +146,10 @@ int main(int argc, char** argv) {
 		}
 		win2->title = "dbg";
 		sdl_timing_init_frame(&win2->time, HZ_TO_MS(60.0));
-		window_instance_set_transform(win2, gui_boarder_w_l, SDL_WINDOWPOS_CENTERED, dbg_gui_w, dbg_gui_h);
+		window_instance_set_transform(win2, gui_boarder_w_l, SDL_WINDOWPOS_CENTERED, dbg_gui_w, dbg_gui_h + (ibm_pc->config.perf ? DBG_GUI_PERF_H : 0));
 		window_instance_add_cb_on_process_event(win2, input_process_event);
 		window_instance_add_cb_on_render(win2, dbg_gui_render, NULL, &dbg_gui);
+		window_instance_set_cb_throttle(win2, emulator_running, NULL, HZ_TO_MS(dbg_gui_throttle_hz));
 		window_instance_open(win2);
 	}
 
@@ -127,22 +160,58 @@ int main(int argc, char** argv) {
 	timing_set_cb_reset_frame(sdl_timing_reset_frame);
 	timing_set_cb_new_frame(sdl_timing_new_frame);
 	timing_set_cb_check_frame(sdl_timing_check_frame);
+	timing_set_cb_frame_remaining_ns(sdl_timing_frame_remaining_ns);
+	timing_set_cb_sleep_ns(sdl_timing_delay_ns);
 
-	/* Setup audio callbacks for backend */
-	//audio_set_cb_(sdl_audio_);
+	/* Setup audio callbacks for backend; the pc speaker is silent if there is no audio device */
+	if (args.audio && !bench && sdl_audio_create(PC_SPEAKER_SAMPLE_RATE) == 0) {
+		audio_set_cb_output(sdl_audio_output);
+		audio_set_cb_get_queued(sdl_audio_get_queued);
+	}
 	
 	/* Initialize IBM PC */
 	ibm_pc_init();
+	trace_set_thread_name("main");
 
 	/* Hard Reset IBM PC */
 	ibm_pc_reset();
 
-	while (!sdl->quit) {
-		sdl_update(sdl);
-		ibm_pc_update();
+	/* Print the log off the emulation thread from here on */
+	if (sdl_log_create()) {
+		exit(1);
+	}
+
+	int exit_code = 0;
+	if (bench) {
+		/* Run the scenario on this thread on virtual time; a cold POST, no journal */
+		bench_start();
+		while (!sdl->quit && !bench_update()) {
+			sdl_update(sdl);
+		}
+		exit_code = bench_finish();
+	}
+	else {
+		/* Skip POST if the warm boot cache has a snapshot for this config */
+		ibm_pc_warm_boot();
+
+		/* Record or replay the input journal from the reset state */
+		ibm_pc_start_journal();
+
+		/* Run the emulator on its own thread; the display renders the frames it publishes at vsync */
+		if (emulation_create(ibm_pc_update) || emulation_start()) {
+			sdl_log_destroy();
+			exit(1);
+		}
+
+		while (!sdl->quit) {
+			sdl_update(sdl);
+			SDL_Delay(1);
+		}
 	}
 
 	/* Clean up */
+	emulation_destroy();
+	sdl_audio_destroy();
 	ui_destroy();
 	ui_context_destroy(&ui_context);
 
@@ -150,7 +219,8 @@ int main(int argc, char** argv) {
 	ibm_pc_destroy();
 	display_destroy(display);
 	window_manager_destroy(window_manager);
+	sdl_log_destroy();
 	sdl_destroy(sdl);
 
-	return 0;
+	return exit_code;
 }